@@ -81,7 +81,7 @@ namespace ignimbrite {
         mNextPoolSize *= POOL_SIZE_FACTOR;
         mMaxSetsCount += descriptorsCount;
 
-        VkDescriptorPoolSize poolSizes[2];
+        VkDescriptorPoolSize poolSizes[3];
         uint32 poolSizesCount = 0;
 
         if (mProperties.uniformBuffersCount > 0) {
@@ -90,6 +90,12 @@ namespace ignimbrite {
             poolSizesCount += 1;
         }
 
+        if (mProperties.dynamicUniformBuffersCount > 0) {
+            poolSizes[poolSizesCount].descriptorCount = mProperties.dynamicUniformBuffersCount * descriptorsCount;
+            poolSizes[poolSizesCount].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            poolSizesCount += 1;
+        }
+
         if (mProperties.samplersCount > 0) {
             poolSizes[poolSizesCount].descriptorCount = mProperties.samplersCount * descriptorsCount;
             poolSizes[poolSizesCount].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
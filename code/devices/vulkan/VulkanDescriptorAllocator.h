@@ -22,6 +22,8 @@ namespace ignimbrite {
         uint32 samplersCount = 0;
         /** Uniform buffers per descriptor set */
         uint32 uniformBuffersCount = 0;
+        /** Uniform buffers with dynamic offsets per descriptor set */
+        uint32 dynamicUniformBuffersCount = 0;
     };
 
     /**
@@ -11,6 +11,7 @@
 #define IGNIMBRITE_VULKANDRAWLIST_H
 
 #include <VulkanContext.h>
+#include <IRenderDevice.h>
 #include <vector>
 
 namespace ignimbrite {
@@ -20,29 +21,118 @@ namespace ignimbrite {
         VulkanDrawListStateControl() {
             frameBufferAttached = false;
             pipelineAttached = false;
+            pipelineReady = true;
             indexBufferAttached = false;
             vertexBufferAttached = false;
+            renderPassPending = false;
+            secondaryContents = false;
 
             commandBuffer = VK_NULL_HANDLE;
             pipelineLayout = VK_NULL_HANDLE;
+            renderPass = VK_NULL_HANDLE;
+            framebuffer = VK_NULL_HANDLE;
+            renderArea = {};
+            viewport = {};
+            scissor = {};
+
+            resetBindings();
         }
 
         void resetFlags() {
             frameBufferAttached = false;
             pipelineAttached = false;
+            pipelineReady = true;
             indexBufferAttached = false;
             vertexBufferAttached = false;
+            renderPassPending = false;
+            secondaryContents = false;
+
+            resetBindings();
+        }
+
+        /** Forget bound objects, therefore next binds are not filtered */
+        void resetBindings() {
+            pipeline = VK_NULL_HANDLE;
+            descriptorSet = VK_NULL_HANDLE;
+            dynamicOffsets.clear();
+            indexBuffer = VK_NULL_HANDLE;
+            indexBufferOffset = 0;
+            indexType = VK_INDEX_TYPE_MAX_ENUM;
+
+            for (uint32 i = 0; i < MAX_VERTEX_BUFFER_BINDINGS; i++) {
+                vertexBuffers[i] = VK_NULL_HANDLE;
+                vertexBuffersOffsets[i] = 0;
+            }
         }
 
+        /** Number of vertex buffer bindings, which binds are filtered */
+        static const uint32 MAX_VERTEX_BUFFER_BINDINGS = 8;
+
         bool frameBufferAttached : 1;
         bool pipelineAttached : 1;
+        /** Attached pipeline is compiled, draws are skipped otherwise */
+        bool pipelineReady : 1;
         bool indexBufferAttached : 1;
         bool vertexBufferAttached : 1;
+        /** Render pass is begun with the first command, since its contents could be inline or secondary lists */
+        bool renderPassPending : 1;
+        /** Render pass contents are recorded in secondary draw lists */
+        bool secondaryContents : 1;
 
         /** Draw list to be filled */
         VkCommandBuffer commandBuffer;
         /** Currently attached layout, needed for uniform set binding */
         VkPipelineLayout pipelineLayout;
+
+        /** Attached framebuffer info, inherited by secondary draw lists */
+        VkRenderPass renderPass;
+        VkFramebuffer framebuffer;
+        VkRect2D renderArea;
+        VkViewport viewport;
+        VkRect2D scissor;
+
+        /** Currently bound objects (shadow state to drop redundant binds) */
+        VkPipeline pipeline;
+        VkDescriptorSet descriptorSet;
+        std::vector<uint32> dynamicOffsets;
+        VkBuffer indexBuffer;
+        uint32 indexBufferOffset;
+        VkIndexType indexType;
+        VkBuffer vertexBuffers[MAX_VERTEX_BUFFER_BINDINGS];
+        uint32 vertexBuffersOffsets[MAX_VERTEX_BUFFER_BINDINGS];
+
+        IRenderDevice::DrawListStatistics statistics;
+    };
+
+    /**
+     * Pool of the command buffers for single frame. Buffers are not freed, but
+     * recycled all at once with the pool reset, when the frame is finished.
+     */
+    struct VulkanCommandPool {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> commandBuffers;
+        /** Number of the buffers, used since last reset */
+        uint32 used = 0;
+    };
+
+    /** Recorded secondary draw list, valid until its frame is finished (or until destruction if reusable) */
+    struct VulkanSecondaryDrawList {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        /** Pool of the thread, which recorded this list (for reusable list) */
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        bool reusable = false;
+        IRenderDevice::DrawListStatistics statistics;
+    };
+
+    /** Data of the thread, which records secondary draw lists */
+    struct VulkanDrawListThread {
+        /** Pools for single frame lists of each frame slot */
+        VulkanCommandPool framePools[IRenderDevice::MAX_FRAMES_IN_FLIGHT];
+        /** Pool for lists, executed in many frames */
+        VkCommandPool reusableCommandPool = VK_NULL_HANDLE;
+        /** Currently recorded list */
+        VulkanDrawListStateControl state;
+        bool reusable = false;
     };
 
 } // namespace ignimbrite
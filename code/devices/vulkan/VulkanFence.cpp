@@ -46,6 +46,11 @@ using namespace ignimbrite ;
             VK_RESULT_ASSERT(result, "Failed to reset fence");
         }
 
+        bool VulkanFence::isSignaled() {
+            auto &context = VulkanContext::getInstance();
+            return vkGetFenceStatus(context.device, mFence) == VK_SUCCESS;
+        }
+
         /** @return Vulkan fence handler */
         VkFence VulkanFence::get() {
             return mFence;
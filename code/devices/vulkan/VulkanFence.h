@@ -28,6 +28,9 @@ namespace ignimbrite {
 
         void reset() ;
 
+        /** @return True if fence is set (does not block) */
+        bool isSignaled() ;
+
         /** @return Vulkan fence handler */
         VkFence get() ;
     private:
@@ -0,0 +1,70 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_VULKANFRAME_H
+#define IGNIMBRITE_VULKANFRAME_H
+
+#include <VulkanObjects.h>
+#include <VulkanFence.h>
+#include <VulkanDrawList.h>
+#include <vector>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Frame in flight slot
+     *
+     * Fence of the slot is signaled, when GPU finishes the frame. After that
+     * command pools of the frame and objects, destroyed while the frame
+     * could still reference them, are released and the slot is reused.
+     */
+    struct VulkanFrame {
+
+        struct Buffer {
+            VkBuffer buffer;
+            VulkanAllocation allocation;
+        };
+
+        struct Image {
+            VkImage image;
+            VkImageView imageView;
+            VulkanAllocation allocation;
+        };
+
+        struct UniformSet {
+            ID<IRenderDevice::UniformLayout> uniformLayout;
+            VkDescriptorSet descriptorSets[IRenderDevice::MAX_FRAMES_IN_FLIGHT];
+            uint32 descriptorSetsCount;
+        };
+
+        struct CommandBuffer {
+            VkCommandBuffer commandBuffer;
+            VkCommandPool commandPool;
+        };
+
+        VulkanFence fence;
+
+        /** Pool of the primary draw lists, reset when the frame is finished */
+        VulkanCommandPool commandPool;
+        /** Not reusable secondary draw lists, recorded in this frame */
+        std::vector<ID<IRenderDevice::DrawList>> drawLists;
+
+        /** Destroyed objects, released when the frame is finished (sets before its layouts) */
+        std::vector<Buffer> buffers;
+        std::vector<Image> images;
+        std::vector<UniformSet> uniformSets;
+        std::vector<ID<IRenderDevice::UniformLayout>> uniformLayouts;
+        std::vector<VulkanGraphicsPipeline> pipelines;
+        std::vector<VkFramebuffer> framebuffers;
+        std::vector<CommandBuffer> reusableDrawLists;
+    };
+
+} // namespace ignimbrite
+
+#endif //IGNIMBRITE_VULKANFRAME_H
@@ -14,9 +14,12 @@
 #include <Optional.h>
 #include <VulkanDescriptorAllocator.h>
 #include <vk_mem_alloc.h>
+#include <memory>
 
 namespace ignimbrite {
 
+    struct VulkanPipelineJob;
+
     struct VulkanVertexLayout {
         std::vector<VkVertexInputBindingDescription> vkBindings;
         std::vector<VkVertexInputAttributeDescription> vkAttributes;
@@ -28,18 +31,37 @@ namespace ignimbrite {
         VmaAllocation vmaAllocation;
     };
 
+    /**
+     * Memory of the buffer with copy for each frame in flight (static buffers have single copy).
+     * Frame writes only its own copy, other copies are updated from the CPU
+     * shadow data, when their frame slots are reused (see VulkanRenderDevice::beginFrame).
+     */
+    struct VulkanBufferCopies {
+        VkBuffer buffers[IRenderDevice::MAX_FRAMES_IN_FLIGHT] = {};
+        VulkanAllocation allocations[IRenderDevice::MAX_FRAMES_IN_FLIGHT] = {};
+        /** Version of the data in each copy */
+        uint32 versions[IRenderDevice::MAX_FRAMES_IN_FLIGHT] = {};
+        uint32 count = 1;
+        /** Version of the shadow data */
+        uint32 version = 0;
+        /** True if buffer is in the dirty list of the device (some copies are outdated) */
+        bool dirty = false;
+        std::vector<uint8> shadow;
+
+        /** @return Copy to be used by the frame slot */
+        VkBuffer get(uint32 frameIndex) const { return buffers[count > 1 ? frameIndex : 0]; }
+    };
+
     struct VulkanVertexBuffer {
         BufferUsage usage;
         uint32 size;
-        VkBuffer vkBuffer;
-        VulkanAllocation allocation;
+        VulkanBufferCopies copies;
     };
 
     struct VulkanIndexBuffer {
         BufferUsage usage;
         uint32 size;
-        VkBuffer vkBuffer;
-        VulkanAllocation allocation;
+        VulkanBufferCopies copies;
     };
 
     struct VulkanTextureObject {
@@ -60,18 +82,32 @@ namespace ignimbrite {
     struct VulkanUniformBuffer {
         BufferUsage usage;
         uint32 size;
-        VkBuffer buffer;
-        VulkanAllocation allocation;
+        VulkanBufferCopies copies;
+        /** Persistently mapped memory (null if buffer is not mapped) */
+        uint8* mapped = nullptr;
     };
 
     struct VulkanUniformLayout {
         VulkanDescriptorAllocator allocator;
         VulkanDescriptorProperties properties;
+        /** Bindings of the buffers with dynamic offsets */
+        std::vector<uint32> dynamicBindings;
+        /** Push constants ranges of the pipeline layout */
+        std::vector<VkPushConstantRange> pushConstantRanges;
+        /** Bindings and push constants, identical layouts have equal keys */
+        String key;
     };
 
     struct VulkanUniformSet {
         ID<IRenderDevice::UniformLayout> uniformLayout;
-        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        /** Set for each frame slot, if it references buffers with per frame copies */
+        VkDescriptorSet descriptorSets[IRenderDevice::MAX_FRAMES_IN_FLIGHT] = {};
+        uint32 descriptorSetsCount = 1;
+        /** Number of the dynamic offsets, required to bind this set */
+        uint32 dynamicOffsetsCount = 0;
+
+        /** @return Set to be bound by the frame slot */
+        VkDescriptorSet get(uint32 frameIndex) const { return descriptorSets[descriptorSetsCount > 1 ? frameIndex : 0]; }
     };
 
     struct VulkanShader {
@@ -81,11 +117,21 @@ namespace ignimbrite {
 
     struct VulkanShaderProgram {
         std::vector<VulkanShader> shaders;
+        /** Stages and code of the shaders, identical programs have equal keys */
+        String key;
     };
 
+    /**
+     * Pipeline is shared by all the creations with identical description (key),
+     * and destroyed with the last reference.
+     */
     struct VulkanGraphicsPipeline {
         VkPipeline pipeline = VK_NULL_HANDLE;
         VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        /** Background compilation (pipeline is null, until job is resolved) */
+        std::shared_ptr<VulkanPipelineJob> job;
+        String key;
+        uint32 references = 1;
     };
 
 } // namespace ignimbrite
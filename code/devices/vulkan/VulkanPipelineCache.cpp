@@ -0,0 +1,177 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <VulkanPipelineCache.h>
+#include <VulkanErrors.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace ignimbrite {
+
+    /** Header of the cache data: size, version, vendor id, device id and cache UUID */
+    static const size_t CACHE_HEADER_SIZE = 4 * sizeof(uint32) + VK_UUID_SIZE;
+
+    static VkPipelineCache createCache(const std::vector<uint8> &data) {
+        auto &context = VulkanContext::getInstance();
+
+        VkPipelineCacheCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = data.size();
+        createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        VkPipelineCache cache;
+        VkResult result = vkCreatePipelineCache(context.device, &createInfo, nullptr, &cache);
+        VK_RESULT_ASSERT(result, "Failed to create pipeline cache");
+
+        return cache;
+    }
+
+    VulkanPipelineCache::VulkanPipelineCache() {
+        mCache = createCache({});
+    }
+
+    VulkanPipelineCache::~VulkanPipelineCache() {
+        save();
+        vkDestroyPipelineCache(mContext.device, mCache, nullptr);
+    }
+
+    bool VulkanPipelineCache::load(const String &path) {
+        mPath = path;
+        mLoaded = false;
+
+        std::ifstream file(path, std::ios::binary);
+
+        if (!file.is_open())
+            return false;
+
+        std::vector<uint8> data(std::istreambuf_iterator<char>(file), {});
+
+        if (!isCompatible(data))
+            return false;
+
+        // Pipelines of the current cache are kept in the loaded one
+        VkPipelineCache loaded = createCache(data);
+        VkResult result = vkMergePipelineCaches(mContext.device, loaded, 1, &mCache);
+        VK_RESULT_ASSERT(result, "Failed to merge pipeline caches");
+
+        vkDestroyPipelineCache(mContext.device, mCache, nullptr);
+        mCache = loaded;
+        mLoaded = true;
+
+        return true;
+    }
+
+    bool VulkanPipelineCache::save() {
+        if (mPath.empty())
+            return false;
+
+        size_t size = getDataSize();
+        std::vector<uint8> data(size);
+
+        VkResult result = vkGetPipelineCacheData(mContext.device, mCache, &size, data.data());
+        if (result != VK_SUCCESS)
+            return false;
+
+        // Cache file is never seen partially written: data is written into temporary file first
+        String tmpPath = mPath + ".tmp";
+
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            file.write((const char*) data.data(), (std::streamsize) size);
+            file.close();
+
+            if (file.fail()) {
+                std::remove(tmpPath.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(tmpPath.c_str(), mPath.c_str()) != 0) {
+            // Rename does not replace existing file on some platforms
+            std::remove(mPath.c_str());
+
+            if (std::rename(tmpPath.c_str(), mPath.c_str()) != 0) {
+                std::remove(tmpPath.c_str());
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    VkPipeline VulkanPipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo &pipelineInfo) {
+        size_t sizeBefore;
+        uint32 creation;
+        bool exclusive;
+
+        {
+            std::lock_guard<std::mutex> lock(mStatisticsMutex);
+            mActiveCreations += 1;
+            mStartedCreations += 1;
+            creation = mStartedCreations;
+            exclusive = mActiveCreations == 1;
+            sizeBefore = getDataSize();
+        }
+
+        VkPipeline pipeline;
+        VkResult result = vkCreateGraphicsPipelines(mContext.device, mCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+        {
+            std::lock_guard<std::mutex> lock(mStatisticsMutex);
+            mActiveCreations -= 1;
+
+            // Data size is changed only by this pipeline, if no other creation overlapped with it
+            exclusive = exclusive && mStartedCreations == creation;
+
+            if (result == VK_SUCCESS) {
+                if (!exclusive) {
+                    mConcurrent += 1;
+                } else if (getDataSize() > sizeBefore) {
+                    mMisses += 1;
+                } else {
+                    mHits += 1;
+                }
+            }
+        }
+
+        if (result != VK_SUCCESS) {
+            throw VulkanException("Failed to create graphics pipeline");
+        }
+
+        return pipeline;
+    }
+
+    bool VulkanPipelineCache::isCompatible(const std::vector<uint8> &data) const {
+        if (data.size() < CACHE_HEADER_SIZE)
+            return false;
+
+        uint32 header[4];
+        std::memcpy(header, data.data(), sizeof(header));
+
+        const auto &properties = mContext.deviceProperties;
+        const uint8 *uuid = data.data() + sizeof(header);
+
+        return header[0] >= CACHE_HEADER_SIZE &&
+               header[0] <= data.size() &&
+               header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               header[2] == properties.vendorID &&
+               header[3] == properties.deviceID &&
+               std::memcmp(uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    size_t VulkanPipelineCache::getDataSize() const {
+        size_t size = 0;
+        VkResult result = vkGetPipelineCacheData(mContext.device, mCache, &size, nullptr);
+        VK_RESULT_ASSERT(result, "Failed to get pipeline cache data size");
+
+        return size;
+    }
+
+} // namespace ignimbrite
@@ -0,0 +1,81 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_VULKANPIPELINECACHE_H
+#define IGNIMBRITE_VULKANPIPELINECACHE_H
+
+#include <IncludeStd.h>
+#include <VulkanContext.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Pipeline cache, persistent between launches
+     *
+     * Cache data is loaded from the file, if its header matches vendor,
+     * device and pipeline cache UUID of the current physical device
+     * (driver update changes UUID, therefore outdated data is ignored).
+     * Data is written into temporary file, which then replaces the cache file.
+     *
+     * Cache hit is detected by the size of the cache data: creation of the
+     * pipeline, which is not in the cache, adds new data. Pipelines could be
+     * created from several threads at once, but size is changed by all of them,
+     * therefore creations, which overlap with others, are counted as concurrent
+     * instead of hits or misses. Load and save must not overlap with creation.
+     */
+    class VulkanPipelineCache {
+    public:
+        VulkanPipelineCache();
+        /** Saves data if file path is set */
+        ~VulkanPipelineCache();
+
+        /**
+         * Set file of the cache and load its data, if it is valid.
+         * Pipelines, created before, are merged with loaded data.
+         * @return True if data was loaded
+         */
+        bool load(const String &path);
+
+        /** Write cache data into file, @return False if path is not set or data was not written */
+        bool save();
+
+        /** Create graphics pipeline with this cache and count cache hit or miss */
+        VkPipeline createGraphicsPipeline(const VkGraphicsPipelineCreateInfo &pipelineInfo);
+
+        VkPipelineCache get() const { return mCache; }
+        const String &getPath() const { return mPath; }
+        uint32 getHits() const { return mHits.load(); }
+        uint32 getMisses() const { return mMisses.load(); }
+        uint32 getConcurrent() const { return mConcurrent.load(); }
+        bool isLoaded() const { return mLoaded; }
+
+    private:
+        /** @return True if data header is created by the current device and driver */
+        bool isCompatible(const std::vector<uint8> &data) const;
+        size_t getDataSize() const;
+
+        VulkanContext &mContext = VulkanContext::getInstance();
+        VkPipelineCache mCache = VK_NULL_HANDLE;
+        String mPath;
+        std::atomic<uint32> mHits{0};
+        std::atomic<uint32> mMisses{0};
+        std::atomic<uint32> mConcurrent{0};
+        /** Creations in progress and started since cache creation (guarded by statistics mutex) */
+        uint32 mActiveCreations = 0;
+        uint32 mStartedCreations = 0;
+        std::mutex mStatisticsMutex;
+        bool mLoaded = false;
+    };
+
+} // namespace ignimbrite
+
+#endif //IGNIMBRITE_VULKANPIPELINECACHE_H
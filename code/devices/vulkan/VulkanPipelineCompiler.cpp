@@ -0,0 +1,127 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <VulkanPipelineCompiler.h>
+#include <VulkanErrors.h>
+
+namespace ignimbrite {
+
+    VulkanPipelineCompiler::VulkanPipelineCompiler(VulkanPipelineCache &cache) : mCache(cache), mPending(0) {
+
+    }
+
+    VulkanPipelineCompiler::~VulkanPipelineCompiler() {
+        stopWorkers();
+    }
+
+    void VulkanPipelineCompiler::setThreadsCount(uint32 threadsCount) {
+        if (threadsCount == getThreadsCount())
+            return;
+
+        stopWorkers();
+        startWorkers(threadsCount);
+    }
+
+    void VulkanPipelineCompiler::submit(const std::shared_ptr<VulkanPipelineJob> &job) {
+        if (mWorkers.empty()) {
+            compile(*job);
+            job->finished.store(true);
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mQueue.push_back(job);
+            mPending += 1;
+        }
+
+        mJobSubmitted.notify_one();
+    }
+
+    void VulkanPipelineCompiler::wait(const VulkanPipelineJob &job) {
+        if (job.finished.load())
+            return;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJobFinished.wait(lock, [&](){ return job.finished.load(); });
+    }
+
+    void VulkanPipelineCompiler::waitIdle() {
+        if (mPending.load() == 0)
+            return;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJobFinished.wait(lock, [this](){ return mPending.load() == 0; });
+    }
+
+    void VulkanPipelineCompiler::compile(VulkanPipelineJob &job) {
+        try {
+            job.pipeline = mCache.createGraphicsPipeline(job.state.pipelineInfo);
+        }
+        catch (const VulkanException &) {
+            job.pipeline = VK_NULL_HANDLE;
+            job.failed = true;
+        }
+    }
+
+    void VulkanPipelineCompiler::startWorkers(uint32 workersCount) {
+        mShutdown = false;
+        mWorkers.reserve(workersCount);
+
+        for (uint32 i = 0; i < workersCount; i++) {
+            mWorkers.emplace_back(&VulkanPipelineCompiler::workerMain, this);
+        }
+    }
+
+    void VulkanPipelineCompiler::stopWorkers() {
+        // Pending jobs are compiled before workers exit
+        waitIdle();
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mShutdown = true;
+        }
+
+        mJobSubmitted.notify_all();
+
+        for (auto& worker: mWorkers) {
+            worker.join();
+        }
+
+        mWorkers.clear();
+    }
+
+    void VulkanPipelineCompiler::workerMain() {
+        while (true) {
+            std::shared_ptr<VulkanPipelineJob> job;
+
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mJobSubmitted.wait(lock, [this](){ return mShutdown || !mQueue.empty(); });
+
+                if (mQueue.empty())
+                    return;
+
+                job = std::move(mQueue.front());
+                mQueue.pop_front();
+            }
+
+            compile(*job);
+
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                job->finished.store(true);
+                mPending -= 1;
+            }
+
+            mJobFinished.notify_all();
+        }
+    }
+
+} // namespace ignimbrite
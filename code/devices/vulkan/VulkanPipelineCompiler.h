@@ -0,0 +1,111 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_VULKANPIPELINECOMPILER_H
+#define IGNIMBRITE_VULKANPIPELINECOMPILER_H
+
+#include <VulkanObjects.h>
+#include <VulkanPipelineCache.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ignimbrite {
+
+    /**
+     * Create info of the graphics pipeline with all the state it references.
+     * Pointers of the create info reference members, therefore state is not movable.
+     */
+    struct VulkanPipelineState {
+        VulkanPipelineState() = default;
+        VulkanPipelineState(const VulkanPipelineState &other) = delete;
+        VulkanPipelineState &operator=(const VulkanPipelineState &other) = delete;
+
+        std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+        /** Copy of the layout, which could be destroyed while pipeline is compiled */
+        VulkanVertexLayout vertexLayout;
+        VkPipelineVertexInputStateCreateInfo vertexInput = {};
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+        VkViewport viewport = {};
+        VkRect2D scissor = {};
+        VkPipelineViewportStateCreateInfo viewportState = {};
+        VkPipelineRasterizationStateCreateInfo rasterizer = {};
+        std::vector<VkDynamicState> dynamicStates;
+        VkPipelineDynamicStateCreateInfo dynamicState = {};
+        VkPipelineMultisampleStateCreateInfo multisampleState = {};
+        std::vector<VkPipelineColorBlendAttachmentState> attachments;
+        VkPipelineColorBlendStateCreateInfo colorBlending = {};
+        VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
+        VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    };
+
+    /** Pipeline compilation on the worker thread */
+    struct VulkanPipelineJob {
+        VulkanPipelineState state;
+        /** Compiled pipeline (valid, when job is finished and not failed) */
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        bool failed = false;
+        std::atomic<bool> finished;
+
+        VulkanPipelineJob() : finished(false) {}
+    };
+
+    /**
+     * @brief Background compilation of the graphics pipelines
+     *
+     * Jobs are compiled in order of submission by the worker threads with shared
+     * pipeline cache. If there are no workers, job is compiled on submission.
+     * Objects, referenced by the pending jobs (shader modules, render passes),
+     * must not be destroyed until the jobs are finished.
+     */
+    class VulkanPipelineCompiler {
+    public:
+        explicit VulkanPipelineCompiler(VulkanPipelineCache &cache);
+        ~VulkanPipelineCompiler();
+
+        VulkanPipelineCompiler(const VulkanPipelineCompiler& other) = delete;
+        VulkanPipelineCompiler& operator=(const VulkanPipelineCompiler& other) = delete;
+
+        /** Set number of worker threads (0 for compilation on the calling thread), waits for pending jobs */
+        void setThreadsCount(uint32 threadsCount);
+        uint32 getThreadsCount() const { return (uint32) mWorkers.size(); }
+
+        /** Compile pipeline of the job (job is finished immediately if there are no workers) */
+        void submit(const std::shared_ptr<VulkanPipelineJob> &job);
+        /** Wait until the job is finished */
+        void wait(const VulkanPipelineJob &job);
+        /** Wait for all the submitted jobs */
+        void waitIdle();
+
+        /** @return Number of submitted not finished jobs */
+        uint32 getPendingCount() const { return mPending.load(); }
+
+    private:
+        void compile(VulkanPipelineJob &job);
+        void workerMain();
+        void startWorkers(uint32 workersCount);
+        void stopWorkers();
+
+        VulkanPipelineCache &mCache;
+
+        std::vector<std::thread> mWorkers;
+        std::deque<std::shared_ptr<VulkanPipelineJob>> mQueue;
+        std::mutex mMutex;
+        std::condition_variable mJobSubmitted;
+        std::condition_variable mJobFinished;
+        std::atomic<uint32> mPending;
+        bool mShutdown = false;
+    };
+
+} // namespace ignimbrite
+
+#endif //IGNIMBRITE_VULKANPIPELINECOMPILER_H
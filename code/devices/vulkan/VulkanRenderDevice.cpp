@@ -12,6 +12,8 @@
 #include <VulkanUtils.h>
 #include <vulkan/vulkan.h>
 #include <exception>
+#include <algorithm>
+#include <cstring>
 #include <array>
 
 namespace ignimbrite {
@@ -29,6 +31,160 @@ namespace ignimbrite {
     using Surface = IRenderDevice::Surface;
     using Texture = IRenderDevice::Texture;
     using Sampler = IRenderDevice::Sampler;
+    using DrawList = IRenderDevice::DrawList;
+
+    /** Device and thread data of the secondary draw list, recorded by the calling thread */
+    static thread_local const VulkanRenderDevice* gThreadDrawListDevice = nullptr;
+    static thread_local VulkanDrawListThread* gThreadDrawList = nullptr;
+
+    static void setViewportAndScissor(VulkanDrawListStateControl &state, const IRenderDevice::Region &area) {
+        state.viewport.x = area.xOffset;
+        state.viewport.y = area.yOffset;
+        state.viewport.width = area.extent.x;
+        state.viewport.height = area.extent.y;
+        state.viewport.minDepth = 0.0f;
+        state.viewport.maxDepth = 1.0f;
+
+        state.scissor.extent.width = area.extent.x;
+        state.scissor.extent.height = area.extent.y;
+        state.scissor.offset.x = area.xOffset;
+        state.scissor.offset.y = area.yOffset;
+    }
+
+    static void addStatistics(IRenderDevice::DrawListStatistics &to, const IRenderDevice::DrawListStatistics &from) {
+        to.pipelineBinds += from.pipelineBinds;
+        to.pipelineBindsSkipped += from.pipelineBindsSkipped;
+        to.uniformSetBinds += from.uniformSetBinds;
+        to.uniformSetBindsSkipped += from.uniformSetBindsSkipped;
+        to.vertexBufferBinds += from.vertexBufferBinds;
+        to.vertexBufferBindsSkipped += from.vertexBufferBindsSkipped;
+        to.indexBufferBinds += from.indexBufferBinds;
+        to.indexBufferBindsSkipped += from.indexBufferBindsSkipped;
+        to.drawsSkipped += from.drawsSkipped;
+    }
+
+    /** Append bytes of the values to the description key (values must have no padding) */
+    template <typename T>
+    static void appendKey(String &key, const T *values, size_t count) {
+        key.append((const char *) values, sizeof(T) * count);
+    }
+
+    template <typename T>
+    static void appendKey(String &key, const T &value) {
+        appendKey(key, &value, 1);
+    }
+
+    static void appendKey(String &key, const String &value) {
+        appendKey(key, (uint32) value.size());
+        key.append(value);
+    }
+
+    /** Shader stages, vertex input and fixed function state of the pipeline */
+    static void createPipelineState(VulkanPipelineState &state,
+                                    PrimitiveTopology topology,
+                                    const VulkanShaderProgram &program,
+                                    const VulkanVertexLayout &vertexLayout,
+                                    const IRenderDevice::PipelineRasterizationDesc &rasterizationDesc) {
+        state.shaderStages.reserve(program.shaders.size());
+
+        for (const auto &shader: program.shaders) {
+            VkPipelineShaderStageCreateInfo createInfo = {};
+            createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            createInfo.stage = shader.shaderStage;
+            createInfo.module = shader.module;
+            createInfo.pName = "main";
+            createInfo.pSpecializationInfo = nullptr;
+
+            state.shaderStages.push_back(createInfo);
+        }
+
+        state.vertexLayout = vertexLayout;
+        VulkanUtils::createVertexInputState(state.vertexLayout, state.vertexInput);
+        VulkanUtils::createInputAssembly(topology, state.inputAssembly);
+        VulkanUtils::createViewportState(state.viewport, state.scissor, state.viewportState);
+        VulkanUtils::createRasterizationState(rasterizationDesc, state.rasterizer);
+
+        state.dynamicStates = {
+                VkDynamicState::VK_DYNAMIC_STATE_VIEWPORT,
+                VkDynamicState::VK_DYNAMIC_STATE_SCISSOR,
+                VkDynamicState::VK_DYNAMIC_STATE_LINE_WIDTH
+        };
+
+        state.dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        state.dynamicState.pDynamicStates = state.dynamicStates.data();
+        state.dynamicState.dynamicStateCount = (uint32) state.dynamicStates.size();
+
+        VulkanUtils::createMultisampleState(state.multisampleState);
+
+        auto &pipelineInfo = state.pipelineInfo;
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = (uint32) state.shaderStages.size();
+        pipelineInfo.pStages = state.shaderStages.data();
+        pipelineInfo.pVertexInputState = &state.vertexInput;
+        pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+        pipelineInfo.pViewportState = &state.viewportState;
+        pipelineInfo.pRasterizationState = &state.rasterizer;
+        pipelineInfo.pMultisampleState = &state.multisampleState;
+        pipelineInfo.pColorBlendState = &state.colorBlending;
+        pipelineInfo.pDynamicState = &state.dynamicState;
+        pipelineInfo.subpass = 0;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+        pipelineInfo.basePipelineIndex = -1; // Optional
+    }
+
+    /**
+     * Key of the pipeline description: programs and layouts are compared by contents,
+     * render pass by the owner object (framebuffer format or surface).
+     */
+    template <typename T>
+    static String getPipelineKey(const VulkanPipelineState &state,
+                                 const VulkanShaderProgram &program,
+                                 const VulkanUniformLayout &uniformLayout,
+                                 ID<T> renderPassOwner) {
+        String key;
+        appendKey(key, program.key);
+        appendKey(key, uniformLayout.key);
+        appendKey(key, renderPassOwner.getIndex());
+        appendKey(key, renderPassOwner.getGeneration());
+
+        const auto &bindings = state.vertexLayout.vkBindings;
+        const auto &attributes = state.vertexLayout.vkAttributes;
+        appendKey(key, (uint32) bindings.size());
+        appendKey(key, bindings.data(), bindings.size());
+        appendKey(key, (uint32) attributes.size());
+        appendKey(key, attributes.data(), attributes.size());
+        appendKey(key, state.inputAssembly.topology);
+
+        const auto &rasterizer = state.rasterizer;
+        appendKey(key, rasterizer.polygonMode);
+        appendKey(key, rasterizer.cullMode);
+        appendKey(key, rasterizer.frontFace);
+        appendKey(key, rasterizer.lineWidth);
+
+        const auto &colorBlending = state.colorBlending;
+        appendKey(key, colorBlending.logicOpEnable);
+        appendKey(key, colorBlending.logicOp);
+        appendKey(key, colorBlending.blendConstants, 4);
+        appendKey(key, colorBlending.attachmentCount);
+        appendKey(key, colorBlending.pAttachments, colorBlending.attachmentCount);
+
+        const auto *depthStencil = state.pipelineInfo.pDepthStencilState;
+        appendKey(key, (uint32) (depthStencil != nullptr));
+
+        if (depthStencil != nullptr) {
+            appendKey(key, depthStencil->depthTestEnable);
+            appendKey(key, depthStencil->depthWriteEnable);
+            appendKey(key, depthStencil->depthCompareOp);
+            appendKey(key, depthStencil->depthBoundsTestEnable);
+            appendKey(key, depthStencil->stencilTestEnable);
+            appendKey(key, depthStencil->front);
+            appendKey(key, depthStencil->back);
+            appendKey(key, depthStencil->minDepthBounds);
+            appendKey(key, depthStencil->maxDepthBounds);
+        }
+
+        return key;
+    }
 
     VulkanRenderDevice::VulkanRenderDevice(uint32 extensionsCount, const char *const *extensions, bool enableValidation) {
         mContext.enableValidationLayers = enableValidation;
@@ -40,10 +196,45 @@ namespace ignimbrite {
         mContext.createAllocator();
         mContext.createCommandPools();
 
+        mUploadManager.reset(new VulkanUploadManager());
+        mPipelineCache.reset(new VulkanPipelineCache());
+        mPipelineCompiler.reset(new VulkanPipelineCompiler(*mPipelineCache));
+
+        // Secondary draw lists could be always recorded on the calling thread
+        setDrawListThreadsCount(1);
+
+        mFrames.resize(MAX_FRAMES_IN_FLIGHT);
+
+        for (auto &frame: mFrames) {
+            auto graphicsFamily = mContext.familyIndices.graphicsFamily.get();
+            frame.commandPool.commandPool = VulkanUtils::createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, graphicsFamily);
+        }
+
         VulkanUtils::getSupportedFormats(mSupportedTextureDataFormats);
     }
 
     VulkanRenderDevice::~VulkanRenderDevice() {
+        synchronize();
+
+        for (auto &frame: mFrames) {
+            vkDestroyCommandPool(mContext.device, frame.commandPool.commandPool, nullptr);
+        }
+
+        mFrames.clear();
+
+        for (auto &thread: mDrawListThreads) {
+            for (auto &pool: thread.framePools) {
+                vkDestroyCommandPool(mContext.device, pool.commandPool, nullptr);
+            }
+
+            vkDestroyCommandPool(mContext.device, thread.reusableCommandPool, nullptr);
+        }
+
+        mUploadManager.reset();
+        // Workers use pipeline cache, therefore are stopped first
+        mPipelineCompiler.reset();
+        mPipelineCache.reset();
+
         mContext.destroyCommandPools();
         mContext.destroyAllocator();
         mContext.destroyLogicalDevice();
@@ -90,27 +281,7 @@ namespace ignimbrite {
         vertexBuffer.size = size;
         vertexBuffer.usage = type;
 
-        VkBufferUsageFlagBits usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-
-        if (type == BufferUsage::Dynamic) {
-            VulkanUtils::createBuffer(size,
-                                      usage,
-                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                      vertexBuffer.vkBuffer,
-                                      vertexBuffer.allocation
-            );
-            if (data != nullptr) {
-                VulkanUtils::updateBufferMemory(vertexBuffer.allocation, 0, size, data);
-            }
-        } else {
-            VulkanUtils::createBufferLocal(
-                    data,
-                    size,
-                    usage,
-                    vertexBuffer.vkBuffer,
-                    vertexBuffer.allocation
-            );
-        }
+        createBufferCopies(vertexBuffer.copies, type, size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, data);
 
         return mVertexBuffers.move(vertexBuffer);
     }
@@ -120,68 +291,144 @@ namespace ignimbrite {
         indexBuffer.size = size;
         indexBuffer.usage = type;
 
-        VkBufferUsageFlagBits usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-
-        if (type == BufferUsage::Dynamic) {
-            VulkanUtils::createBuffer(size,
-                                      usage,
-                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                      indexBuffer.vkBuffer,
-                                      indexBuffer.allocation
-            );
-            if (data != nullptr) {
-                VulkanUtils::updateBufferMemory(indexBuffer.allocation, 0, size, data);
-            }
-        } else {
-            VulkanUtils::createBufferLocal(data, size, usage, indexBuffer.vkBuffer,
-                                           indexBuffer.allocation);
-        }
+        createBufferCopies(indexBuffer.copies, type, size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, data);
 
         return mIndexBuffers.move(indexBuffer);
     }
 
     void VulkanRenderDevice::updateVertexBuffer(ID<VertexBuffer> bufferId, uint32 size, uint32 offset, const void *data) {
-        const VulkanVertexBuffer &buffer = mVertexBuffers.get(bufferId);
-
-        if (buffer.usage != BufferUsage::Dynamic) {
-            throw VulkanException("Attempt to update static vertex buffer");
-        }
+        VulkanVertexBuffer &buffer = mVertexBuffers.get(bufferId);
 
         if (size + offset > buffer.size) {
             throw VulkanException("Attempt to update out-of-buffer memory region for vertex buffer");
         }
 
-        VulkanUtils::updateBufferMemory(buffer.allocation, offset, size, data);
+        if (buffer.usage != BufferUsage::Dynamic) {
+            mUploadManager->updateBuffer(buffer.copies.buffers[0], size, offset, data);
+            return;
+        }
+
+        if (updateBufferCopies(buffer.copies, size, offset, data)) {
+            mDirtyVertexBuffers.push_back(bufferId);
+        }
     }
 
     void VulkanRenderDevice::updateIndexBuffer(ID<IndexBuffer> bufferId, uint32 size, uint32 offset, const void *data) {
-        const VulkanIndexBuffer &buffer = mIndexBuffers.get(bufferId);
-
-        if (buffer.usage != BufferUsage::Dynamic) {
-            throw VulkanException("Attempt to update static index buffer");
-        }
+        VulkanIndexBuffer &buffer = mIndexBuffers.get(bufferId);
 
         if (size + offset > buffer.size) {
             throw VulkanException("Attempt to update out-of-buffer memory region for index buffer");
         }
 
-        VulkanUtils::updateBufferMemory(buffer.allocation, offset, size, data);
+        if (buffer.usage != BufferUsage::Dynamic) {
+            mUploadManager->updateBuffer(buffer.copies.buffers[0], size, offset, data);
+            return;
+        }
+
+        if (updateBufferCopies(buffer.copies, size, offset, data)) {
+            mDirtyIndexBuffers.push_back(bufferId);
+        }
     }
 
     void VulkanRenderDevice::destroyVertexBuffer(ID<VertexBuffer> bufferId) {
         VulkanVertexBuffer &buffer = mVertexBuffers.get(bufferId);
-        VulkanUtils::destroyBuffer(buffer.vkBuffer, buffer.allocation);
+        destroyBufferCopies(buffer.copies);
 
         mVertexBuffers.remove(bufferId);
     }
 
     void VulkanRenderDevice::destroyIndexBuffer(ID<IndexBuffer> bufferId) {
         VulkanIndexBuffer &buffer = mIndexBuffers.get(bufferId);
-        VulkanUtils::destroyBuffer(buffer.vkBuffer, buffer.allocation);
+        destroyBufferCopies(buffer.copies);
 
         mIndexBuffers.remove(bufferId);
     }
 
+    void VulkanRenderDevice::createBufferCopies(VulkanBufferCopies &copies, BufferUsage usage, uint32 size,
+                                                VkBufferUsageFlags usageFlags, const void *data) {
+        if (usage != BufferUsage::Dynamic) {
+            // Static buffer is updated only by copies, therefore it is placed in device local memory
+            VulkanUtils::createBuffer(size,
+                                      usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                      copies.buffers[0],
+                                      copies.allocations[0]
+            );
+            copies.count = 1;
+
+            mUploadManager->uploadBuffer(copies.buffers[0], size, data);
+            return;
+        }
+
+        copies.count = MAX_FRAMES_IN_FLIGHT;
+        copies.shadow.resize(size, 0);
+
+        if (data != nullptr) {
+            std::memcpy(copies.shadow.data(), data, size);
+        }
+
+        for (uint32 i = 0; i < copies.count; i++) {
+            VulkanUtils::createBuffer(size,
+                                      usageFlags,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                      copies.buffers[i],
+                                      copies.allocations[i]
+            );
+            if (data != nullptr) {
+                VulkanUtils::updateBufferMemory(copies.allocations[i], 0, size, data);
+            }
+        }
+    }
+
+    bool VulkanRenderDevice::updateBufferCopies(VulkanBufferCopies &copies, uint32 size, uint32 offset, const void *data) {
+        uint32 slot = copies.count > 1 ? mFrameIndex : 0;
+        bool outdated = copies.versions[slot] != copies.version;
+
+        if (!copies.shadow.empty()) {
+            std::memcpy(copies.shadow.data() + offset, data, size);
+        }
+
+        // Copy of the slot is synchronized on frame begin, but could be outdated by the update outside of the frame
+        if (outdated) {
+            VulkanUtils::updateBufferMemory(copies.allocations[slot], 0, copies.shadow.size(), copies.shadow.data());
+        } else {
+            VulkanUtils::updateBufferMemory(copies.allocations[slot], offset, size, data);
+        }
+
+        copies.version += 1;
+        copies.versions[slot] = copies.version;
+
+        if (copies.count > 1 && !copies.dirty) {
+            copies.dirty = true;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool VulkanRenderDevice::syncBufferCopy(VulkanBufferCopies &copies, uint32 frameIndex) {
+        if (copies.versions[frameIndex] != copies.version) {
+            VulkanUtils::updateBufferMemory(copies.allocations[frameIndex], 0, copies.shadow.size(), copies.shadow.data());
+            copies.versions[frameIndex] = copies.version;
+        }
+
+        for (uint32 i = 0; i < copies.count; i++) {
+            if (copies.versions[i] != copies.version)
+                return false;
+        }
+
+        copies.dirty = false;
+        return true;
+    }
+
+    void VulkanRenderDevice::destroyBufferCopies(VulkanBufferCopies &copies) {
+        auto &frame = mFrames[mFrameIndex];
+
+        for (uint32 i = 0; i < copies.count; i++) {
+            frame.buffers.push_back({copies.buffers[i], copies.allocations[i]});
+        }
+    }
+
     ID<Texture> VulkanRenderDevice::createTexture(const IRenderDevice::TextureDesc &textureDesc) {
         VkFormat format = VulkanDefinitions::dataFormat(textureDesc.format);
         VkImageType imageType = VulkanDefinitions::imageType(textureDesc.type);
@@ -287,25 +534,28 @@ namespace ignimbrite {
 
         } else {
 
-            // create texture image with mipmaps and allocate memory
-            if (!isCubemap) {
-                VulkanUtils::createTextureImage(
-                        textureDesc.data, textureDesc.size,
-                        textureDesc.width, textureDesc.height, textureDesc.depth,
-                        textureDesc.mipmaps,
-                        imageType, format, VK_IMAGE_TILING_OPTIMAL,
-                        texture.image, texture.allocation, texture.layout
-                );
-            } else {
-                VulkanUtils::createCubemapImage(
-                        textureDesc.data, textureDesc.size,
-                        textureDesc.width, textureDesc.height, textureDesc.depth,
-                        textureDesc.mipmaps, cubemapLayerSize,
-                        imageType, format, VK_IMAGE_TILING_OPTIMAL,
-                        texture.image, texture.allocation, texture.layout
-                );
+            if (isCubemap && cubemapLayerSize * 6 > textureDesc.size) {
+                throw std::runtime_error("Cubemap dataSize must not be greater than (6 * cubemapLayerSize)");
             }
 
+            // create texture image with mipmaps and allocate memory
+            VulkanUtils::createImage(
+                    textureDesc.width, textureDesc.height, textureDesc.depth,
+                    textureDesc.mipmaps, isCubemap, imageType, format, VK_IMAGE_TILING_OPTIMAL,
+                    // for copying and sampling in shaders
+                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    texture.image, texture.allocation
+            );
+
+            // Image is usable by draw lists, submitted after the upload batch
+            mUploadManager->uploadImage(
+                    texture.image, format, VulkanDefinitions::getFormatSize(textureDesc.format),
+                    textureDesc.width, textureDesc.height, textureDesc.depth,
+                    textureDesc.mipmaps, isCubemap ? 6 : 1, cubemapLayerSize,
+                    textureDesc.size, textureDesc.data, texture.layout
+            );
+
             VkImageSubresourceRange subresourceRange;
             subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             subresourceRange.baseMipLevel = 0;
@@ -331,11 +581,10 @@ namespace ignimbrite {
     }
 
     void VulkanRenderDevice::destroyTexture(ID<Texture> textureId) {
-        auto &device = mContext.device;
         VulkanTextureObject &imo = mTextureObjects.get(textureId);
 
-        vkDestroyImageView(device, imo.imageView, nullptr);
-        VulkanUtils::destroyImage(imo.image, imo.allocation);
+        // Image could be still sampled by frames in flight
+        mFrames[mFrameIndex].images.push_back({imo.image, imo.imageView, imo.allocation});
 
         mTextureObjects.remove(textureId);
     }
@@ -462,6 +711,7 @@ namespace ignimbrite {
 
     void VulkanRenderDevice::destroyFramebufferFormat(ID<FramebufferFormat> framebufferFormat) {
         auto &format = mFrameBufferFormats.get(framebufferFormat);
+        waitCompiledPipelines();
         vkDestroyRenderPass(mContext.device, format.renderPass, nullptr);
 
         mFrameBufferFormats.remove(framebufferFormat);
@@ -521,7 +771,7 @@ namespace ignimbrite {
 
     void VulkanRenderDevice::destroyFramebuffer(ID<Framebuffer> framebufferId) {
         VulkanFramebuffer fbo = mFrameBuffers.get(framebufferId);
-        vkDestroyFramebuffer(mContext.device, fbo.framebuffer, nullptr);
+        mFrames[mFrameIndex].framebuffers.push_back(fbo.framebuffer);
 
         mFrameBuffers.remove(framebufferId);
     }
@@ -535,15 +785,25 @@ namespace ignimbrite {
         uint32 buffersCount = uniformBuffers.size();
         uint32 texturesCount = uniformTextures.size();
 
-        if (buffersCount != properties.uniformBuffersCount || texturesCount != properties.samplersCount) {
+        if (buffersCount != properties.uniformBuffersCount + properties.dynamicUniformBuffersCount ||
+            texturesCount != properties.samplersCount) {
             throw VulkanException("Incompatible uniform layout and uniform set descriptor");
         }
 
-        if (properties.uniformBuffersCount == 0 && properties.samplersCount == 0) {
+        if (buffersCount == 0 && properties.samplersCount == 0) {
             throw VulkanException("Uniform layout has not textures and buffers to be bounded");
         }
 
-        VkDescriptorSet descriptorSet = layout.allocator.allocateSet();
+        // Set is created for each frame slot, if it references buffers with per frame copies
+        VulkanUniformSet uniformSet = {};
+        uniformSet.uniformLayout = uniformLayout;
+        uniformSet.dynamicOffsetsCount = (uint32) layout.dynamicBindings.size();
+
+        for (auto &buffer: uniformBuffers) {
+            if (mUniformBuffers.get(buffer.buffer).copies.count > 1) {
+                uniformSet.descriptorSetsCount = MAX_FRAMES_IN_FLIGHT;
+            }
+        }
 
         std::vector<VkWriteDescriptorSet> writeDescSets;
         writeDescSets.reserve(buffersCount + texturesCount);
@@ -554,64 +814,75 @@ namespace ignimbrite {
         std::vector<VkDescriptorImageInfo> imagesInfo;
         imagesInfo.reserve(texturesCount);
 
-        for (auto &buffer: uniformBuffers) {
-            VkDescriptorBufferInfo bufferInfo;
-            bufferInfo.buffer = mUniformBuffers.get(buffer.buffer).buffer;
-            bufferInfo.offset = buffer.offset;
-            bufferInfo.range = buffer.range;
-
-            buffersInfo.push_back(bufferInfo);
-
-            VkWriteDescriptorSet writeDescriptor;
-            writeDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writeDescriptor.pNext = nullptr;
-            writeDescriptor.dstSet = descriptorSet;
-            writeDescriptor.dstArrayElement = 0;
-            writeDescriptor.dstBinding = buffer.binding;
-            writeDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            writeDescriptor.descriptorCount = 1;
-            writeDescriptor.pBufferInfo = &buffersInfo.back();
+        for (uint32 i = 0; i < uniformSet.descriptorSetsCount; i++) {
+            VkDescriptorSet descriptorSet = layout.allocator.allocateSet();
+            uniformSet.descriptorSets[i] = descriptorSet;
+
+            writeDescSets.clear();
+            buffersInfo.clear();
+            imagesInfo.clear();
+
+            for (auto &buffer: uniformBuffers) {
+                VkDescriptorBufferInfo bufferInfo;
+                bufferInfo.buffer = mUniformBuffers.get(buffer.buffer).copies.get(i);
+                bufferInfo.offset = buffer.offset;
+                bufferInfo.range = buffer.range;
+
+                buffersInfo.push_back(bufferInfo);
+
+                VkWriteDescriptorSet writeDescriptor;
+                writeDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDescriptor.pNext = nullptr;
+                writeDescriptor.dstSet = descriptorSet;
+                writeDescriptor.dstArrayElement = 0;
+                writeDescriptor.dstBinding = buffer.binding;
+                writeDescriptor.descriptorType = std::binary_search(layout.dynamicBindings.begin(), layout.dynamicBindings.end(), buffer.binding) ?
+                        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                writeDescriptor.descriptorCount = 1;
+                writeDescriptor.pBufferInfo = &buffersInfo.back();
+
+                writeDescSets.push_back(writeDescriptor);
+            }
 
-            writeDescSets.push_back(writeDescriptor);
-        }
+            for (auto &texture: uniformTextures) {
+                const auto &textureObject = mTextureObjects.get(texture.texture);
 
-        for (auto &texture: uniformTextures) {
-            const auto &textureObject = mTextureObjects.get(texture.texture);
+                VkDescriptorImageInfo imageInfo;
+                imageInfo.sampler = mSamplers.get(texture.sampler);
+                imageInfo.imageView = textureObject.imageView;
+                imageInfo.imageLayout = textureObject.layout;
 
-            VkDescriptorImageInfo imageInfo;
-            imageInfo.sampler = mSamplers.get(texture.sampler);
-            imageInfo.imageView = textureObject.imageView;
-            imageInfo.imageLayout = textureObject.layout;
+                imagesInfo.push_back(imageInfo);
 
-            imagesInfo.push_back(imageInfo);
+                VkWriteDescriptorSet writeDescriptor;
+                writeDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDescriptor.pNext = nullptr;
+                writeDescriptor.dstSet = descriptorSet;
+                writeDescriptor.dstArrayElement = 0;
+                writeDescriptor.dstBinding = texture.binding;
+                writeDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writeDescriptor.descriptorCount = 1;
+                writeDescriptor.pImageInfo = &imagesInfo.back();
 
-            VkWriteDescriptorSet writeDescriptor;
-            writeDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writeDescriptor.pNext = nullptr;
-            writeDescriptor.dstSet = descriptorSet;
-            writeDescriptor.dstArrayElement = 0;
-            writeDescriptor.dstBinding = texture.binding;
-            writeDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            writeDescriptor.descriptorCount = 1;
-            writeDescriptor.pImageInfo = &imagesInfo.back();
+                writeDescSets.push_back(writeDescriptor);
+            }
 
-            writeDescSets.push_back(writeDescriptor);
+            vkUpdateDescriptorSets(mContext.device, (uint32) writeDescSets.size(), writeDescSets.data(), 0, nullptr);
         }
 
-        vkUpdateDescriptorSets(mContext.device, (uint32) writeDescSets.size(), writeDescSets.data(), 0, nullptr);
-
-        VulkanUniformSet uniformSet = {};
-        uniformSet.uniformLayout = uniformLayout;
-        uniformSet.descriptorSet = descriptorSet;
-
         return mUniformSets.move(uniformSet);
     }
 
     void VulkanRenderDevice::destroyUniformSet(ID<UniformSet> setId) {
         auto &uniformSet = mUniformSets.get(setId);
-        auto &layout = mUniformLayouts.get(uniformSet.uniformLayout);
 
-        layout.allocator.freeSet(uniformSet.descriptorSet);
+        // Freed sets are reused by allocator, therefore released only when frames finished
+        VulkanFrame::UniformSet set = {};
+        set.uniformLayout = uniformSet.uniformLayout;
+        set.descriptorSetsCount = uniformSet.descriptorSetsCount;
+        std::copy(uniformSet.descriptorSets, uniformSet.descriptorSets + uniformSet.descriptorSetsCount, set.descriptorSets);
+        mFrames[mFrameIndex].uniformSets.push_back(set);
+
         mUniformSets.remove(setId);
     }
 
@@ -627,6 +898,8 @@ namespace ignimbrite {
         std::vector<VkDescriptorSetLayoutBinding> bindings;
         bindings.reserve(texturesCount + buffersCount);
 
+        std::vector<uint32> dynamicBindings;
+
         for (const auto &texture: textures) {
             VkDescriptorSetLayoutBinding binding = {};
             binding.binding = texture.binding;
@@ -642,11 +915,30 @@ namespace ignimbrite {
             VkDescriptorSetLayoutBinding binding = {};
             binding.binding = buffer.binding;
             binding.descriptorCount = 1;
-            binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            binding.descriptorType = buffer.dynamic ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
             binding.stageFlags = VulkanDefinitions::shaderStageFlags(buffer.flags);
             binding.pImmutableSamplers = nullptr;
 
             bindings.push_back(binding);
+
+            if (buffer.dynamic) {
+                dynamicBindings.push_back(buffer.binding);
+            }
+        }
+
+        // Dynamic offsets are consumed in order of the bindings
+        std::sort(dynamicBindings.begin(), dynamicBindings.end());
+
+        std::vector<VkPushConstantRange> pushConstantRanges;
+        pushConstantRanges.reserve(layoutDesc.pushConstants.size());
+
+        for (const auto &pushConstant: layoutDesc.pushConstants) {
+            VkPushConstantRange range = {};
+            range.stageFlags = VulkanDefinitions::shaderStageFlags(pushConstant.flags);
+            range.offset = pushConstant.offset;
+            range.size = pushConstant.size;
+
+            pushConstantRanges.push_back(range);
         }
 
         VkDescriptorSetLayoutCreateInfo createInfo = {};
@@ -660,18 +952,30 @@ namespace ignimbrite {
         VulkanUniformLayout uniformLayout;
         uniformLayout.properties.layout = descriptorSetLayout;
         uniformLayout.properties.samplersCount = texturesCount;
-        uniformLayout.properties.uniformBuffersCount = buffersCount;
+        uniformLayout.properties.uniformBuffersCount = buffersCount - (uint32) dynamicBindings.size();
+        uniformLayout.properties.dynamicUniformBuffersCount = (uint32) dynamicBindings.size();
         uniformLayout.allocator.setProperties(uniformLayout.properties);
+        uniformLayout.dynamicBindings = std::move(dynamicBindings);
+        uniformLayout.pushConstantRanges = std::move(pushConstantRanges);
+
+        for (const auto &binding: bindings) {
+            appendKey(uniformLayout.key, binding.binding);
+            appendKey(uniformLayout.key, binding.descriptorType);
+            appendKey(uniformLayout.key, binding.descriptorCount);
+            appendKey(uniformLayout.key, binding.stageFlags);
+        }
+
+        const auto &ranges = uniformLayout.pushConstantRanges;
+        appendKey(uniformLayout.key, ranges.data(), ranges.size());
 
         return mUniformLayouts.move(uniformLayout);
     }
 
     void VulkanRenderDevice::destroyUniformLayout(ID<UniformLayout> layout) {
-        auto &uniformLayout = mUniformLayouts.get(layout);
-        auto &properties = uniformLayout.properties;
+        VK_TRUE_ASSERT(mUniformLayouts.contains(layout), "Attempt to destroy unknown uniform layout");
 
-        vkDestroyDescriptorSetLayout(mContext.device, properties.layout, nullptr);
-        mUniformLayouts.remove(layout);
+        // Layout owns descriptor pools of its sets, therefore it is kept until sets are released
+        mFrames[mFrameIndex].uniformLayouts.push_back(layout);
     }
 
     ID<UniformBuffer> VulkanRenderDevice::createUniformBuffer(BufferUsage usage, uint32 size, const void *data) {
@@ -679,43 +983,87 @@ namespace ignimbrite {
         uniformBuffer.usage = usage;
         uniformBuffer.size = size;
 
-        if (usage == BufferUsage::Static) {
-            VulkanUtils::createBufferLocal(data, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                           uniformBuffer.buffer, uniformBuffer.allocation);
-        } else if (usage == BufferUsage::Dynamic) {
-            VkMemoryPropertyFlags memoryPropertyFlags =
-                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-            VulkanUtils::createBuffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                      memoryPropertyFlags, uniformBuffer.buffer, uniformBuffer.allocation);
-            VulkanUtils::updateBufferMemory(uniformBuffer.allocation, 0, size, data);
-        } else {
+        if (usage != BufferUsage::Static && usage != BufferUsage::Dynamic) {
             throw VulkanException("Undefined uniform buffer usage");
         }
 
+        createBufferCopies(uniformBuffer.copies, usage, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, data);
+
         return mUniformBuffers.move(uniformBuffer);
     }
 
     void VulkanRenderDevice::updateUniformBuffer(ID<UniformBuffer> buffer, uint32 size, uint32 offset, const void *data) {
-        const VulkanUniformBuffer &uniformBuffer = mUniformBuffers.get(buffer);
+        VulkanUniformBuffer &uniformBuffer = mUniformBuffers.get(buffer);
+
+        if (offset + size > uniformBuffer.size) {
+            throw VulkanException("Attempt to update out-of-buffer memory region for uniform buffer");
+        }
 
         if (uniformBuffer.usage != BufferUsage::Dynamic) {
-            throw VulkanException("Attempt to update static uniform buffer");
+            mUploadManager->updateBuffer(uniformBuffer.copies.buffers[0], size, offset, data);
+            return;
         }
 
-        if (offset + size > uniformBuffer.size) {
-            throw VulkanException("Attempt to update out-of-buffer memory region for uniform buffer");
+        if (uniformBuffer.mapped != nullptr) {
+            std::memcpy(uniformBuffer.mapped + offset, data, size);
+            return;
         }
 
-        VulkanUtils::updateBufferMemory(uniformBuffer.allocation, offset, size, data);
+        if (updateBufferCopies(uniformBuffer.copies, size, offset, data)) {
+            mDirtyUniformBuffers.push_back(buffer);
+        }
     }
 
     void VulkanRenderDevice::destroyUniformBuffer(ID<UniformBuffer> bufferId) {
         VulkanUniformBuffer &uniformBuffer = mUniformBuffers.get(bufferId);
-        VulkanUtils::destroyBuffer(uniformBuffer.buffer, uniformBuffer.allocation);
+
+        if (uniformBuffer.mapped != nullptr) {
+            vmaUnmapMemory(mContext.vmAllocator, uniformBuffer.copies.allocations[0].vmaAllocation);
+        }
+
+        destroyBufferCopies(uniformBuffer.copies);
 
         mUniformBuffers.remove(bufferId);
     }
 
+    uint8 *VulkanRenderDevice::mapUniformBuffer(ID<UniformBuffer> bufferId) {
+        VulkanUniformBuffer &uniformBuffer = mUniformBuffers.get(bufferId);
+
+        if (uniformBuffer.usage != BufferUsage::Dynamic) {
+            throw VulkanException("Attempt to map static uniform buffer");
+        }
+
+        if (uniformBuffer.mapped == nullptr) {
+            auto &copies = uniformBuffer.copies;
+
+            // Mapped memory is written directly, therefore the buffer has single copy
+            for (uint32 i = 1; i < copies.count; i++) {
+                VulkanUtils::destroyBuffer(copies.buffers[i], copies.allocations[i]);
+            }
+
+            copies.count = 1;
+            copies.dirty = false;
+            copies.shadow.clear();
+            copies.shadow.shrink_to_fit();
+
+            void *mappedData;
+            VkResult result = vmaMapMemory(mContext.vmAllocator, copies.allocations[0].vmaAllocation, &mappedData);
+            VK_RESULT_ASSERT(result, "Failed to map uniform buffer memory");
+
+            uniformBuffer.mapped = (uint8 *) mappedData;
+        }
+
+        return uniformBuffer.mapped;
+    }
+
+    uint32 VulkanRenderDevice::getUniformBufferOffsetAlignment() {
+        return (uint32) mContext.deviceProperties.limits.minUniformBufferOffsetAlignment;
+    }
+
+    uint32 VulkanRenderDevice::getMaxPushConstantsSize() {
+        return (uint32) mContext.deviceProperties.limits.maxPushConstantsSize;
+    }
+
     ID<ShaderProgram> VulkanRenderDevice::createShaderProgram(const ProgramDesc &programDesc) {
         VulkanShaderProgram program = {};
         program.shaders.reserve(programDesc.shaders.size());
@@ -738,6 +1086,10 @@ namespace ignimbrite {
             shader.shaderStage = VulkanDefinitions::shaderStageBit(desc.type);
 
             program.shaders.push_back(shader);
+
+            appendKey(program.key, shader.shaderStage);
+            appendKey(program.key, (uint32) desc.source.size());
+            appendKey(program.key, desc.source.data(), desc.source.size());
         }
 
         return mShaderPrograms.move(program);
@@ -745,6 +1097,7 @@ namespace ignimbrite {
 
     void VulkanRenderDevice::destroyShaderProgram(ID<ShaderProgram> program) {
         auto &vulkanProgram = mShaderPrograms.get(program);
+        waitCompiledPipelines();
 
         for (auto &shader: vulkanProgram.shaders) {
             vkDestroyShaderModule(mContext.device, shader.module, nullptr);
@@ -779,96 +1132,35 @@ namespace ignimbrite {
             throw VulkanException("Specified framebuffer format does not support depth/stencil buffer usage");
         }
 
-        VkResult result;
-        VkPipeline pipeline;
-        VkPipelineLayout pipelineLayout;
-
-        VulkanUtils::createPipelineLayout(vkUniformLayout, pipelineLayout);
-
-        std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
-        shaderStages.reserve(vkProgram.shaders.size());
-
-        for (const auto &shader: vkProgram.shaders) {
-            VkPipelineShaderStageCreateInfo createInfo = {};
-            createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            createInfo.stage = shader.shaderStage;
-            createInfo.module = shader.module;
-            createInfo.pName = "main";
-            createInfo.pSpecializationInfo = nullptr;
+        auto job = std::make_shared<VulkanPipelineJob>();
+        auto &state = job->state;
+        createPipelineState(state, topology, vkProgram, vkVertexLayout, rasterizationDesc);
 
-            shaderStages.push_back(createInfo);
+        state.attachments.resize(blendStateDesc.attachments.size());
+        for (uint32 i = 0; i < state.attachments.size(); i++) {
+            VulkanUtils::createColorBlendAttachmentState(blendStateDesc.attachments[i], state.attachments[i]);
         }
 
-        VkPipelineVertexInputStateCreateInfo vertexInput = {};
-        VulkanUtils::createVertexInputState(vkVertexLayout, vertexInput);
+        VulkanUtils::createColorBlendState(blendStateDesc, (uint32) state.attachments.size(), state.attachments.data(), state.colorBlending);
 
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-        VulkanUtils::createInputAssembly(topology, inputAssembly);
-
-        VkViewport viewport = {};
-        VkRect2D scissor = {};
-        VkPipelineViewportStateCreateInfo viewportState = {};
-        VulkanUtils::createViewportState(viewport, scissor, viewportState);
-
-        VkPipelineRasterizationStateCreateInfo rasterizer = {};
-        VulkanUtils::createRasterizationState(rasterizationDesc, rasterizer);
-
-        VkDynamicState states[] = {
-                VkDynamicState::VK_DYNAMIC_STATE_VIEWPORT,
-                VkDynamicState::VK_DYNAMIC_STATE_SCISSOR,
-                VkDynamicState::VK_DYNAMIC_STATE_LINE_WIDTH
-        };
-
-        VkPipelineDynamicStateCreateInfo dynamicState = {};
-        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-        dynamicState.pDynamicStates = states;
-        dynamicState.dynamicStateCount = sizeof(states) / sizeof(VkDynamicState);
-
-        VkPipelineMultisampleStateCreateInfo multisampleState = {};
-        VulkanUtils::createMultisampleState(multisampleState);
-
-        std::vector<VkPipelineColorBlendAttachmentState> attachments(blendStateDesc.attachments.size());
-        for (uint32 i = 0; i < attachments.size(); i++) {
-            VulkanUtils::createColorBlendAttachmentState(blendStateDesc.attachments[i], attachments[i]);
-        }
-
-        VkPipelineColorBlendStateCreateInfo colorBlending = {};
-        VulkanUtils::createColorBlendState(blendStateDesc, (uint32) attachments.size(), attachments.data(), colorBlending);
-
-        VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
         if (depthStencilStateDesc.depthTestEnable || depthStencilStateDesc.stencilTestEnable) {
-            VulkanUtils::createDepthStencilState(depthStencilStateDesc, depthStencilState);
+            VulkanUtils::createDepthStencilState(depthStencilStateDesc, state.depthStencilState);
         }
 
-        VkGraphicsPipelineCreateInfo pipelineInfo = {};
-        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = (uint32) shaderStages.size();
-        pipelineInfo.pStages = shaderStages.data();
-        pipelineInfo.pVertexInputState = &vertexInput;
-        pipelineInfo.pInputAssemblyState = &inputAssembly;
-        pipelineInfo.pViewportState = &viewportState;
-        pipelineInfo.pRasterizationState = &rasterizer;
-        pipelineInfo.pMultisampleState = &multisampleState;
-        pipelineInfo.pColorBlendState = &colorBlending;
-        pipelineInfo.pDepthStencilState = depthStencilStateDesc.depthTestEnable ? &depthStencilState : nullptr;
-        pipelineInfo.pDynamicState = &dynamicState;
-        pipelineInfo.layout = pipelineLayout;
-        pipelineInfo.renderPass = vkFramebufferFormat.renderPass;
-        pipelineInfo.subpass = 0;
-        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-        pipelineInfo.basePipelineIndex = -1; // Optional
+        state.pipelineInfo.pDepthStencilState = depthStencilStateDesc.depthTestEnable ? &state.depthStencilState : nullptr;
+        state.pipelineInfo.renderPass = vkFramebufferFormat.renderPass;
 
-        result = vkCreateGraphicsPipelines(mContext.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+        auto key = getPipelineKey(state, vkProgram, vkUniformLayout, framebufferFormat);
+        auto shared = findGraphicsPipeline(key);
 
-        if (result != VK_SUCCESS) {
-            throw VulkanException("Failed to create graphics pipeline");
+        if (shared.isNotNull()) {
+            return shared;
         }
 
-        VulkanGraphicsPipeline graphicsPipeline;
-        graphicsPipeline.pipeline = pipeline;
-        graphicsPipeline.pipelineLayout = pipelineLayout;
+        VkPipelineLayout pipelineLayout;
+        VulkanUtils::createPipelineLayout(vkUniformLayout, pipelineLayout);
 
-        return mGraphicsPipelines.move(graphicsPipeline);
+        return addGraphicsPipeline(std::move(key), pipelineLayout, std::move(job), true);
     }
 
     ID<GraphicsPipeline> VulkanRenderDevice::createGraphicsPipeline(
@@ -886,121 +1178,161 @@ namespace ignimbrite {
         auto &vkSurface = mSurfaces.get(surface);
         auto &vkFramebufferFormat = vkSurface.swapChain.framebufferFormat;
 
-        VkResult result;
-        VkPipeline pipeline;
-        VkPipelineLayout pipelineLayout;
+        auto job = std::make_shared<VulkanPipelineJob>();
+        auto &state = job->state;
+        createPipelineState(state, topology, vkProgram, vkVertexLayout, rasterizationDesc);
 
+        state.attachments.resize(1);
+        VulkanUtils::createColorBlendAttachmentState(blendStateDesc.attachment, state.attachments[0]);
+        VulkanUtils::createSurfaceColorBlendState(blendStateDesc, state.attachments.data(), state.colorBlending);
+
+        auto &depthStencilState = state.depthStencilState;
+        if (depthStencilStateDesc.depthTestEnable || depthStencilStateDesc.stencilTestEnable) {
+            VulkanUtils::createDepthStencilState(depthStencilStateDesc, depthStencilState);
+        } else {
+            depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+            depthStencilState.depthTestEnable = VK_FALSE;
+            depthStencilState.depthWriteEnable = VK_FALSE;
+            depthStencilState.depthBoundsTestEnable = VK_FALSE;
+            depthStencilState.stencilTestEnable = VK_FALSE;
+        }
+
+        state.pipelineInfo.pDepthStencilState = &depthStencilState;
+        state.pipelineInfo.renderPass = vkFramebufferFormat.renderPass;
+
+        auto key = getPipelineKey(state, vkProgram, vkUniformLayout, surface);
+        auto shared = findGraphicsPipeline(key);
+
+        if (shared.isNotNull()) {
+            return shared;
+        }
+
+        VkPipelineLayout pipelineLayout;
         VulkanUtils::createPipelineLayout(vkUniformLayout, pipelineLayout);
 
-        std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
-        shaderStages.reserve(vkProgram.shaders.size());
+        // Surface render pass is recreated on resize, therefore pipeline is compiled in place
+        return addGraphicsPipeline(std::move(key), pipelineLayout, std::move(job), false);
+    }
 
-        for (const auto &shader: vkProgram.shaders) {
-            VkPipelineShaderStageCreateInfo createInfo = {};
-            createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            createInfo.stage = shader.shaderStage;
-            createInfo.module = shader.module;
-            createInfo.pName = "main";
-            createInfo.pSpecializationInfo = nullptr;
+    void VulkanRenderDevice::destroyGraphicsPipeline(ID<GraphicsPipeline> pipeline) {
+        auto &vulkanPipeline = mGraphicsPipelines.get(pipeline);
+        VK_TRUE_ASSERT(vulkanPipeline.references > 0, "Attempt to destroy released pipeline");
+        vulkanPipeline.references -= 1;
 
-            shaderStages.push_back(createInfo);
+        if (vulkanPipeline.references > 0)
+            return;
+
+        mPipelinesByKey.erase(vulkanPipeline.key);
+
+        if (vulkanPipeline.job != nullptr) {
+            // Compilation could not be cancelled, compiled pipeline is destroyed with others
+            mPipelineCompiler->wait(*vulkanPipeline.job);
+            vulkanPipeline.pipeline = vulkanPipeline.job->pipeline;
+            vulkanPipeline.job.reset();
+
+            auto &compiling = mCompilingPipelines;
+            compiling.erase(std::remove(compiling.begin(), compiling.end(), pipeline), compiling.end());
         }
 
-        VkPipelineVertexInputStateCreateInfo vertexInput = {};
-        VulkanUtils::createVertexInputState(vkVertexLayout, vertexInput);
+        mFrames[mFrameIndex].pipelines.push_back(vulkanPipeline);
+
+        mGraphicsPipelines.remove(pipeline);
+    }
 
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-        VulkanUtils::createInputAssembly(topology, inputAssembly);
+    void VulkanRenderDevice::setPipelineCompileThreadsCount(uint32 threadsCount) {
+        mPipelineCompiler->setThreadsCount(threadsCount);
+    }
 
-        VkViewport viewport = {};
-        VkRect2D scissor = {};
-        VkPipelineViewportStateCreateInfo viewportState = {};
-        VulkanUtils::createViewportState(viewport, scissor, viewportState);
+    bool VulkanRenderDevice::isGraphicsPipelineReady(ID<GraphicsPipeline> pipeline) {
+        return getCompiledPipeline(mGraphicsPipelines.get(pipeline)) != VK_NULL_HANDLE;
+    }
 
-        VkPipelineRasterizationStateCreateInfo rasterizer = {};
-        VulkanUtils::createRasterizationState(rasterizationDesc, rasterizer);
+    ID<GraphicsPipeline> VulkanRenderDevice::findGraphicsPipeline(const String &key) {
+        auto found = mPipelinesByKey.find(key);
 
-        VkDynamicState states[] = {
-                VkDynamicState::VK_DYNAMIC_STATE_VIEWPORT,
-                VkDynamicState::VK_DYNAMIC_STATE_SCISSOR,
-                VkDynamicState::VK_DYNAMIC_STATE_LINE_WIDTH
-        };
+        if (found == mPipelinesByKey.end())
+            return ID<GraphicsPipeline>();
 
-        VkPipelineDynamicStateCreateInfo dynamicState = {};
-        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-        dynamicState.pDynamicStates = states;
-        dynamicState.dynamicStateCount = sizeof(states) / sizeof(VkDynamicState);
+        mGraphicsPipelines.get(found->second).references += 1;
+        mSharedPipelines += 1;
 
-        VkPipelineMultisampleStateCreateInfo multisampleState = {};
-        VulkanUtils::createMultisampleState(multisampleState);
+        return found->second;
+    }
 
-        VkPipelineColorBlendAttachmentState attachment;
-        VulkanUtils::createColorBlendAttachmentState(blendStateDesc.attachment, attachment);
+    ID<GraphicsPipeline> VulkanRenderDevice::addGraphicsPipeline(String key, VkPipelineLayout pipelineLayout,
+                                                                 std::shared_ptr<VulkanPipelineJob> job, bool background) {
+        job->state.pipelineInfo.layout = pipelineLayout;
 
-        VkPipelineColorBlendStateCreateInfo colorBlending = {};
-        VulkanUtils::createSurfaceColorBlendState(blendStateDesc, &attachment, colorBlending);
+        VulkanGraphicsPipeline graphicsPipeline;
+        graphicsPipeline.pipelineLayout = pipelineLayout;
+        graphicsPipeline.key = key;
 
-        VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
-        if (depthStencilStateDesc.depthTestEnable || depthStencilStateDesc.stencilTestEnable) {
-            VulkanUtils::createDepthStencilState(depthStencilStateDesc, depthStencilState);
+        bool compiling = background && mPipelineCompiler->getThreadsCount() > 0;
+
+        if (compiling) {
+            mPipelineCompiler->submit(job);
+            graphicsPipeline.job = std::move(job);
         } else {
-            depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-            depthStencilState.depthTestEnable = VK_FALSE;
-            depthStencilState.depthWriteEnable = VK_FALSE;
-            depthStencilState.depthBoundsTestEnable = VK_FALSE;
-            depthStencilState.stencilTestEnable = VK_FALSE;
+            graphicsPipeline.pipeline = mPipelineCache->createGraphicsPipeline(job->state.pipelineInfo);
         }
 
-        VkGraphicsPipelineCreateInfo pipelineInfo = {};
-        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = (uint32) shaderStages.size();
-        pipelineInfo.pStages = shaderStages.data();
-        pipelineInfo.pVertexInputState = &vertexInput;
-        pipelineInfo.pInputAssemblyState = &inputAssembly;
-        pipelineInfo.pViewportState = &viewportState;
-        pipelineInfo.pRasterizationState = &rasterizer;
-        pipelineInfo.pMultisampleState = &multisampleState;
-        pipelineInfo.pColorBlendState = &colorBlending;
-        pipelineInfo.pDepthStencilState = &depthStencilState;
-        pipelineInfo.pDynamicState = &dynamicState;
-        pipelineInfo.layout = pipelineLayout;
-        pipelineInfo.renderPass = vkFramebufferFormat.renderPass;
-        pipelineInfo.subpass = 0;
-        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-        pipelineInfo.basePipelineIndex = -1; // Optional
-
-        result = vkCreateGraphicsPipelines(mContext.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+        auto id = mGraphicsPipelines.move(graphicsPipeline);
+        mPipelinesByKey.emplace(std::move(key), id);
 
-        if (result != VK_SUCCESS) {
-            throw VulkanException("Failed to create graphics pipeline");
+        if (compiling) {
+            mCompilingPipelines.push_back(id);
         }
 
-        VulkanGraphicsPipeline graphicsPipeline;
-        graphicsPipeline.pipeline = pipeline;
-        graphicsPipeline.pipelineLayout = pipelineLayout;
+        return id;
+    }
+
+    void VulkanRenderDevice::resolveCompiledPipelines() {
+        size_t pending = 0;
+
+        for (auto id: mCompilingPipelines) {
+            auto &graphicsPipeline = mGraphicsPipelines.get(id);
+            auto &job = *graphicsPipeline.job;
+
+            if (!job.finished.load()) {
+                mCompilingPipelines[pending++] = id;
+                continue;
+            }
+
+            // Failed pipeline stays null, therefore its draws are always skipped (reported in statistics)
+            mFailedPipelines += job.failed ? 1 : 0;
+            graphicsPipeline.pipeline = job.pipeline;
+            graphicsPipeline.job.reset();
+        }
 
-        return mGraphicsPipelines.move(graphicsPipeline);
+        mCompilingPipelines.resize(pending);
     }
 
-    void VulkanRenderDevice::destroyGraphicsPipeline(ID<GraphicsPipeline> pipeline) {
-        auto &vulkanPipeline = mGraphicsPipelines.get(pipeline);
+    void VulkanRenderDevice::waitCompiledPipelines() {
+        mPipelineCompiler->waitIdle();
+    }
 
-        vkDestroyPipeline(mContext.device, vulkanPipeline.pipeline, nullptr);
-        vkDestroyPipelineLayout(mContext.device, vulkanPipeline.pipelineLayout, nullptr);
+    VkPipeline VulkanRenderDevice::getCompiledPipeline(const VulkanGraphicsPipeline &graphicsPipeline) {
+        if (graphicsPipeline.pipeline != VK_NULL_HANDLE)
+            return graphicsPipeline.pipeline;
 
-        mGraphicsPipelines.remove(pipeline);
+        // Job could be finished, but not resolved until next frame
+        const auto &job = graphicsPipeline.job;
+        return job != nullptr && job->finished.load() ? job->pipeline : VK_NULL_HANDLE;
     }
 
     void VulkanRenderDevice::drawListBegin() {
+        VK_TRUE_ASSERT(gThreadDrawListDevice != this, "Primary draw list could not be recorded while thread records secondary one");
         mDrawListState = {};
-        mDrawListState.commandBuffer = VulkanUtils::beginTmpCommandBuffer(mContext.graphicsTmpCommandPool);
+        mDrawListState.commandBuffer = getCommandBuffer(mFrames[mFrameIndex].commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        VulkanUtils::beginCommandBuffer(mDrawListState.commandBuffer);
 
         vkCmdSetLineWidth(mDrawListState.commandBuffer, 1);
     }
 
     void VulkanRenderDevice::drawListEnd() {
+        VK_TRUE_ASSERT(gThreadDrawListDevice != this, "Secondary draw list must be ended with drawListEndSecondary");
         VkCommandBuffer commandBuffer = mDrawListState.commandBuffer;
-        vkCmdEndRenderPass(commandBuffer);
+        endRenderPass();
         vkEndCommandBuffer(commandBuffer);
         mDrawQueue.push_back(commandBuffer);
     }
@@ -1009,25 +1341,22 @@ namespace ignimbrite {
             ID<Surface> surfaceId,
             const IRenderDevice::Color &color,
             const IRenderDevice::Region &area) {
+        VK_TRUE_ASSERT(gThreadDrawListDevice != this, "Surface could not be bound in secondary draw list");
+
         // End previous render pass, if exists
-        if (mDrawListState.frameBufferAttached) {
-            vkCmdEndRenderPass(mDrawListState.commandBuffer);
-        }
+        endRenderPass();
 
         // Reset state
         mDrawListState.resetFlags();
 
         VulkanSurface &surface = mSurfaces.get(surfaceId);
         const float clearDepth = 1.0f;
-        const uint32 clearStencil = 0;
 
-        VkCommandBuffer cmd = mDrawListState.commandBuffer;
-        VkFramebuffer framebuffer = surface.swapChain.framebuffers[surface.currentImageIndex];
+        if (std::find(mFrameSurfaces.begin(), mFrameSurfaces.end(), surfaceId) == mFrameSurfaces.end()) {
+            mFrameSurfaces.push_back(surfaceId);
+        }
 
-        uint32 viewportOffsetX = area.xOffset;
-        uint32 viewportOffsetY = area.yOffset;
-        uint32 viewportWidth = area.extent.x;
-        uint32 viewportHeight = area.extent.y;
+        const uint32 clearStencil = 0;
 
         VkClearValue clearValues[2];
         clearValues[0].color.float32[0] = color.components[0];
@@ -1037,37 +1366,18 @@ namespace ignimbrite {
         clearValues[1].depthStencil.depth = clearDepth;
         clearValues[1].depthStencil.stencil = clearStencil;
 
-        VkRenderPassBeginInfo renderPassBeginInfo{};
-        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassBeginInfo.renderPass = surface.swapChain.framebufferFormat.renderPass;
-        renderPassBeginInfo.renderArea.offset.x = 0;
-        renderPassBeginInfo.renderArea.offset.y = 0;
-
-        renderPassBeginInfo.renderArea.extent.width = surface.width;
-        renderPassBeginInfo.renderArea.extent.height = surface.height;
-        renderPassBeginInfo.clearValueCount = 2;
-        renderPassBeginInfo.pClearValues = clearValues;
-        renderPassBeginInfo.framebuffer = framebuffer;
-
-        vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-        VkViewport viewport;
-        viewport.x = viewportOffsetX;
-        viewport.y = viewportOffsetY;
-        viewport.width = viewportWidth;
-        viewport.height = viewportHeight;
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(cmd, 0, 1, &viewport);
-
-        VkRect2D scissor;
-        scissor.extent.width = viewportWidth;
-        scissor.extent.height = viewportHeight;
-        scissor.offset.x = viewportOffsetX;
-        scissor.offset.y = viewportOffsetY;
-        vkCmdSetScissor(cmd, 0, 1, &scissor);
+        mClearValues.assign(clearValues, clearValues + 2);
+
+        mDrawListState.renderPass = surface.swapChain.framebufferFormat.renderPass;
+        mDrawListState.framebuffer = surface.swapChain.framebuffers[surface.currentImageIndex];
+        mDrawListState.renderArea.offset = {0, 0};
+        mDrawListState.renderArea.extent = {surface.width, surface.height};
 
+        setViewportAndScissor(mDrawListState, area);
+
+        // Render pass itself is begun with the first command
         mDrawListState.frameBufferAttached = true;
+        mDrawListState.renderPassPending = true;
     }
 
     void VulkanRenderDevice::drawListBindFramebuffer(
@@ -1075,27 +1385,20 @@ namespace ignimbrite {
             const std::vector<Color> &colors,
             float32 clearDepth, uint32 clearStencil,
             const IRenderDevice::Region &area) {
+        VK_TRUE_ASSERT(gThreadDrawListDevice != this, "Framebuffer could not be bound in secondary draw list");
+
         // End previous render pass, if exists
-        if (mDrawListState.frameBufferAttached) {
-            vkCmdEndRenderPass(mDrawListState.commandBuffer);
-        }
+        endRenderPass();
 
         // Reset state
         mDrawListState.resetFlags();
 
         VulkanFramebuffer &fbo = mFrameBuffers.get(framebufferId);
         VulkanFrameBufferFormat &fboFormat = mFrameBufferFormats.get(fbo.framebufferFormatId);
-        VkCommandBuffer cmd = mDrawListState.commandBuffer;
-
-        uint32 viewportOffsetX = area.xOffset;
-        uint32 viewportOffsetY = area.yOffset;
-        uint32 viewportWidth = area.extent.x;
-        uint32 viewportHeight = area.extent.y;
 
         uint32 colorValuesCount = (uint32) colors.size();
-        uint32 clearValuesCount = colorValuesCount + 1;
         mClearValues.clear();
-        mClearValues.reserve(colorValuesCount);
+        mClearValues.reserve(colorValuesCount + 1);
 
         for (size_t i = 0; i < colorValuesCount; i++) {
             VkClearValue colorClearValue = {};
@@ -1111,37 +1414,16 @@ namespace ignimbrite {
         depthStencilClearValues.depthStencil = {clearDepth, clearStencil};
         mClearValues.push_back(depthStencilClearValues);
 
-        VkRenderPassBeginInfo renderPassBeginInfo = {};
-        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassBeginInfo.renderPass = fboFormat.renderPass;
-        renderPassBeginInfo.renderArea.offset.x = 0;
-        renderPassBeginInfo.renderArea.offset.y = 0;
+        mDrawListState.renderPass = fboFormat.renderPass;
+        mDrawListState.framebuffer = fbo.framebuffer;
+        mDrawListState.renderArea.offset = {0, 0};
+        mDrawListState.renderArea.extent = {fbo.width, fbo.height};
 
-        renderPassBeginInfo.renderArea.extent.width = fbo.width;
-        renderPassBeginInfo.renderArea.extent.height = fbo.height;
-        renderPassBeginInfo.clearValueCount = clearValuesCount;
-        renderPassBeginInfo.pClearValues = mClearValues.data();
-        renderPassBeginInfo.framebuffer = fbo.framebuffer;
-
-        vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-        VkViewport viewport;
-        viewport.x = viewportOffsetX;
-        viewport.y = viewportOffsetY;
-        viewport.width = viewportWidth;
-        viewport.height = viewportHeight;
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(cmd, 0, 1, &viewport);
-
-        VkRect2D scissor;
-        scissor.extent.width = viewportWidth;
-        scissor.extent.height = viewportHeight;
-        scissor.offset.x = viewportOffsetX;
-        scissor.offset.y = viewportOffsetY;
-        vkCmdSetScissor(cmd, 0, 1, &scissor);
+        setViewportAndScissor(mDrawListState, area);
 
+        // Render pass itself is begun with the first command
         mDrawListState.frameBufferAttached = true;
+        mDrawListState.renderPassPending = true;
     }
 
     void VulkanRenderDevice::drawListBindFramebuffer(
@@ -1152,48 +1434,394 @@ namespace ignimbrite {
     }
 
     void VulkanRenderDevice::drawListBindPipeline(ID<GraphicsPipeline> graphicsPipelineId) {
-        VK_TRUE_ASSERT(mDrawListState.frameBufferAttached, "No framebuffer attached");
+        auto &state = getDrawListState();
+        VK_TRUE_ASSERT(state.frameBufferAttached, "No framebuffer attached");
         const auto &graphicsPipeline = mGraphicsPipelines.get(graphicsPipelineId);
-        vkCmdBindPipeline(mDrawListState.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.pipeline);
-        mDrawListState.pipelineLayout = graphicsPipeline.pipelineLayout;
-        mDrawListState.pipelineAttached = true;
+        auto pipeline = getCompiledPipeline(graphicsPipeline);
+        state.statistics.pipelineBinds += 1;
+
+        if (pipeline != VK_NULL_HANDLE && state.pipeline == pipeline) {
+            state.statistics.pipelineBindsSkipped += 1;
+            return;
+        }
+
+        // Descriptor set is disturbed, if pipeline layouts are not identical
+        if (state.pipelineLayout != graphicsPipeline.pipelineLayout) {
+            state.descriptorSet = VK_NULL_HANDLE;
+        }
+
+        // Pipeline is compiled in background: layout is still valid for uniform binds, but draws are skipped
+        if (pipeline != VK_NULL_HANDLE) {
+            vkCmdBindPipeline(state.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        }
+
+        state.pipeline = pipeline;
+        state.pipelineLayout = graphicsPipeline.pipelineLayout;
+        state.pipelineAttached = true;
+        state.pipelineReady = pipeline != VK_NULL_HANDLE;
     }
 
     void VulkanRenderDevice::drawListBindUniformSet(ID<UniformSet> uniformSetId) {
-        VK_TRUE_ASSERT(mDrawListState.pipelineAttached, "No pipeline attached");
+        auto &state = getDrawListState();
+        VK_TRUE_ASSERT(state.pipelineAttached, "No pipeline attached");
         const auto &uniformSet = mUniformSets.get(uniformSetId);
-        vkCmdBindDescriptorSets(mDrawListState.commandBuffer,
+
+        if (uniformSet.dynamicOffsetsCount > 0) {
+            // Dynamic buffers are bound from its descriptor offsets
+            std::vector<uint32> zeroOffsets(uniformSet.dynamicOffsetsCount, 0);
+            drawListBindUniformSet(uniformSetId, zeroOffsets);
+            return;
+        }
+
+        auto descriptorSet = uniformSet.get(mFrameIndex);
+        state.statistics.uniformSetBinds += 1;
+
+        if (state.descriptorSet == descriptorSet) {
+            state.statistics.uniformSetBindsSkipped += 1;
+            return;
+        }
+
+        state.descriptorSet = descriptorSet;
+        state.dynamicOffsets.clear();
+
+        vkCmdBindDescriptorSets(state.commandBuffer,
                                 VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                mDrawListState.pipelineLayout,
+                                state.pipelineLayout,
                                 0, 1,
-                                &uniformSet.descriptorSet,
+                                &descriptorSet,
                                 0, nullptr);
     }
 
+    void VulkanRenderDevice::drawListBindUniformSet(ID<UniformSet> uniformSetId, const std::vector<uint32> &dynamicOffsets) {
+        auto &state = getDrawListState();
+        VK_TRUE_ASSERT(state.pipelineAttached, "No pipeline attached");
+        const auto &uniformSet = mUniformSets.get(uniformSetId);
+        VK_TRUE_ASSERT(uniformSet.dynamicOffsetsCount == dynamicOffsets.size(), "Incompatible dynamic offsets count");
+        auto descriptorSet = uniformSet.get(mFrameIndex);
+        state.statistics.uniformSetBinds += 1;
+
+        if (state.descriptorSet == descriptorSet && state.dynamicOffsets == dynamicOffsets) {
+            state.statistics.uniformSetBindsSkipped += 1;
+            return;
+        }
+
+        state.descriptorSet = descriptorSet;
+        state.dynamicOffsets = dynamicOffsets;
+
+        vkCmdBindDescriptorSets(state.commandBuffer,
+                                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                state.pipelineLayout,
+                                0, 1,
+                                &descriptorSet,
+                                (uint32) dynamicOffsets.size(), dynamicOffsets.data());
+    }
+
+    void VulkanRenderDevice::drawListPushConstants(ShaderStageFlags flags, uint32 offset, uint32 size, const void *data) {
+        auto &state = getDrawListState();
+        VK_TRUE_ASSERT(state.pipelineAttached, "No pipeline attached");
+        vkCmdPushConstants(state.commandBuffer,
+                           state.pipelineLayout,
+                           VulkanDefinitions::shaderStageFlags(flags),
+                           offset, size, data);
+    }
+
     void VulkanRenderDevice::drawListBindIndexBuffer(ID<IndexBuffer> indexBufferId, IndicesType indicesType, uint32 offset) {
-        VK_TRUE_ASSERT(mDrawListState.frameBufferAttached, "No pipeline attached");
-        const auto &indexBuffer = mIndexBuffers.get(indexBufferId);
-        vkCmdBindIndexBuffer(mDrawListState.commandBuffer, indexBuffer.vkBuffer, offset, VulkanDefinitions::indexType(indicesType));
-        mDrawListState.indexBufferAttached = true;
+        auto &state = getDrawListState();
+        VK_TRUE_ASSERT(state.frameBufferAttached, "No pipeline attached");
+        auto indexBuffer = mIndexBuffers.get(indexBufferId).copies.get(mFrameIndex);
+        auto indexType = VulkanDefinitions::indexType(indicesType);
+        state.statistics.indexBufferBinds += 1;
+
+        if (state.indexBuffer == indexBuffer && state.indexBufferOffset == offset &&
+            state.indexType == indexType) {
+            state.statistics.indexBufferBindsSkipped += 1;
+            return;
+        }
+
+        vkCmdBindIndexBuffer(state.commandBuffer, indexBuffer, offset, indexType);
+        state.indexBuffer = indexBuffer;
+        state.indexBufferOffset = offset;
+        state.indexType = indexType;
+        state.indexBufferAttached = true;
     }
 
     void VulkanRenderDevice::drawListBindVertexBuffer(ID<VertexBuffer> vertexBufferId, uint32 binding, uint32 offset) {
-        VK_TRUE_ASSERT(mDrawListState.frameBufferAttached, "No pipeline attached");
-        const auto &vertexBuffer = mVertexBuffers.get(vertexBufferId);
+        auto &state = getDrawListState();
+        VK_TRUE_ASSERT(state.frameBufferAttached, "No pipeline attached");
+        auto vertexBuffer = mVertexBuffers.get(vertexBufferId).copies.get(mFrameIndex);
+        state.statistics.vertexBufferBinds += 1;
+
+        bool filtered = binding < VulkanDrawListStateControl::MAX_VERTEX_BUFFER_BINDINGS;
+
+        if (filtered && state.vertexBuffers[binding] == vertexBuffer &&
+            state.vertexBuffersOffsets[binding] == offset) {
+            state.statistics.vertexBufferBindsSkipped += 1;
+            return;
+        }
+
         VkDeviceSize offsets[1] = { offset };
-        vkCmdBindVertexBuffers(mDrawListState.commandBuffer, binding, 1, &vertexBuffer.vkBuffer, offsets);
-        mDrawListState.vertexBufferAttached = true;
+        vkCmdBindVertexBuffers(state.commandBuffer, binding, 1, &vertexBuffer, offsets);
+        state.vertexBufferAttached = true;
+
+        if (filtered) {
+            state.vertexBuffers[binding] = vertexBuffer;
+            state.vertexBuffersOffsets[binding] = offset;
+        }
     }
 
     void VulkanRenderDevice::drawListDraw(uint32 verticesCount, uint32 instancesCount) {
-        VK_TRUE_ASSERT(mDrawListState.vertexBufferAttached, "Vertex buffer is not attached: nothing to draw");
-        vkCmdDraw(mDrawListState.commandBuffer, verticesCount, instancesCount, 0, 0);
+        auto &state = getDrawListState();
+        VK_TRUE_ASSERT(state.vertexBufferAttached, "Vertex buffer is not attached: nothing to draw");
+
+        if (!state.pipelineReady) {
+            state.statistics.drawsSkipped += 1;
+            return;
+        }
+
+        vkCmdDraw(state.commandBuffer, verticesCount, instancesCount, 0, 0);
     }
 
     void VulkanRenderDevice::drawListDrawIndexed(uint32 indicesCount, uint32 instancesCount) {
-        VK_TRUE_ASSERT(mDrawListState.vertexBufferAttached, "Vertex buffer is not attached: nothing to draw");
-        VK_TRUE_ASSERT(mDrawListState.indexBufferAttached, "Index buffer is not attached: nothing to draw");
-        vkCmdDrawIndexed(mDrawListState.commandBuffer, indicesCount, instancesCount, 0, 0, 0);
+        auto &state = getDrawListState();
+        VK_TRUE_ASSERT(state.vertexBufferAttached, "Vertex buffer is not attached: nothing to draw");
+        VK_TRUE_ASSERT(state.indexBufferAttached, "Index buffer is not attached: nothing to draw");
+
+        if (!state.pipelineReady) {
+            state.statistics.drawsSkipped += 1;
+            return;
+        }
+
+        vkCmdDrawIndexed(state.commandBuffer, indicesCount, instancesCount, 0, 0, 0);
+    }
+
+    void VulkanRenderDevice::setDrawListThreadsCount(uint32 threadsCount) {
+        VK_TRUE_ASSERT(threadsCount > 0, "Draw list threads count must be at least 1");
+
+        // Pools are only added, since lists of the removed threads could be still in use
+        while (mDrawListThreads.size() < threadsCount) {
+            auto graphicsFamily = mContext.familyIndices.graphicsFamily.get();
+
+            VulkanDrawListThread thread;
+            thread.reusableCommandPool = VulkanUtils::createCommandPool(0, graphicsFamily);
+
+            for (auto &pool: thread.framePools) {
+                pool.commandPool = VulkanUtils::createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, graphicsFamily);
+            }
+
+            mDrawListThreads.push_back(thread);
+        }
+    }
+
+    void VulkanRenderDevice::drawListBeginSecondary(uint32 threadIndex, bool reusable) {
+        VK_TRUE_ASSERT(threadIndex < mDrawListThreads.size(), "Invalid draw list thread index");
+        VK_TRUE_ASSERT(gThreadDrawListDevice != this, "Thread already records secondary draw list");
+
+        const auto &primary = mDrawListState;
+        VK_TRUE_ASSERT(primary.frameBufferAttached, "No framebuffer attached to primary draw list");
+        VK_TRUE_ASSERT(primary.renderPassPending || primary.secondaryContents, "Framebuffer contents are recorded inline");
+
+        auto &thread = mDrawListThreads[threadIndex];
+        auto &state = thread.state;
+
+        // Reusable lists are freed one by one, others are recycled with the pool of the frame
+        state = {};
+        state.commandBuffer = reusable ?
+                VulkanUtils::allocateCommandBuffer(thread.reusableCommandPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY) :
+                getCommandBuffer(thread.framePools[mFrameIndex], VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+        VulkanUtils::beginSecondaryCommandBuffer(state.commandBuffer, primary.renderPass, primary.framebuffer, reusable);
+        state.renderPass = primary.renderPass;
+        state.framebuffer = primary.framebuffer;
+        state.renderArea = primary.renderArea;
+        state.viewport = primary.viewport;
+        state.scissor = primary.scissor;
+        state.frameBufferAttached = true;
+        thread.reusable = reusable;
+
+        // Dynamic state is not inherited from primary list
+        vkCmdSetLineWidth(state.commandBuffer, 1);
+        vkCmdSetViewport(state.commandBuffer, 0, 1, &state.viewport);
+        vkCmdSetScissor(state.commandBuffer, 0, 1, &state.scissor);
+
+        gThreadDrawListDevice = this;
+        gThreadDrawList = &thread;
+    }
+
+    ID<DrawList> VulkanRenderDevice::drawListEndSecondary() {
+        VK_TRUE_ASSERT(gThreadDrawListDevice == this, "Thread does not record secondary draw list");
+
+        auto &thread = *gThreadDrawList;
+        auto &state = thread.state;
+        auto result = vkEndCommandBuffer(state.commandBuffer);
+        VK_RESULT_ASSERT(result, "Failed to end secondary command buffer");
+
+        gThreadDrawListDevice = nullptr;
+        gThreadDrawList = nullptr;
+
+        VulkanSecondaryDrawList drawList;
+        drawList.commandBuffer = state.commandBuffer;
+        drawList.commandPool = thread.reusable ? thread.reusableCommandPool : VK_NULL_HANDLE;
+        drawList.reusable = thread.reusable;
+        drawList.statistics = state.statistics;
+
+        std::lock_guard<std::mutex> lock(mDrawListsMutex);
+        auto id = mDrawLists.move(drawList);
+
+        // Reusable lists are destroyed explicitly, others are released with its frame
+        if (!drawList.reusable) {
+            mFrames[mFrameIndex].drawLists.push_back(id);
+        }
+
+        return id;
+    }
+
+    void VulkanRenderDevice::destroyDrawList(ID<DrawList> drawListId) {
+        VK_TRUE_ASSERT(gThreadDrawListDevice != this, "Draw list could not be destroyed while thread records secondary one");
+
+        const auto &drawList = mDrawLists.get(drawListId);
+        VK_TRUE_ASSERT(drawList.reusable, "Only reusable draw lists could be destroyed explicitly");
+
+        // List could be still executed by frames in flight
+        mFrames[mFrameIndex].reusableDrawLists.push_back({drawList.commandBuffer, drawList.commandPool});
+        mDrawLists.remove(drawListId);
+    }
+
+    void VulkanRenderDevice::drawListExecute(const std::vector<ID<DrawList>> &drawLists) {
+        VK_TRUE_ASSERT(gThreadDrawListDevice != this, "Secondary draw lists are executed only by primary draw list");
+
+        auto &state = mDrawListState;
+        VK_TRUE_ASSERT(state.frameBufferAttached, "No framebuffer attached");
+
+        if (state.renderPassPending) {
+            beginRenderPass(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        }
+
+        VK_TRUE_ASSERT(state.secondaryContents, "Framebuffer contents are recorded inline");
+
+        mExecuteBuffers.clear();
+        for (auto id: drawLists) {
+            const auto &drawList = mDrawLists.get(id);
+            mExecuteBuffers.push_back(drawList.commandBuffer);
+            addStatistics(state.statistics, drawList.statistics);
+        }
+
+        if (!mExecuteBuffers.empty()) {
+            vkCmdExecuteCommands(state.commandBuffer, (uint32) mExecuteBuffers.size(), mExecuteBuffers.data());
+        }
+    }
+
+    const IRenderDevice::DrawListStatistics &VulkanRenderDevice::getDrawListStatistics() {
+        return mDrawListState.statistics;
+    }
+
+    IRenderDevice::CommandPoolStatistics VulkanRenderDevice::getCommandPoolStatistics() {
+        CommandPoolStatistics statistics;
+        statistics.resets = mCommandPoolsResets;
+
+        auto add = [&](const VulkanCommandPool &pool) {
+            statistics.pools += 1;
+            statistics.allocatedLists += (uint32) pool.commandBuffers.size();
+            statistics.usedLists += pool.used;
+        };
+
+        for (const auto &frame: mFrames) {
+            add(frame.commandPool);
+        }
+
+        for (const auto &thread: mDrawListThreads) {
+            for (const auto &pool: thread.framePools) {
+                add(pool);
+            }
+        }
+
+        return statistics;
+    }
+
+    bool VulkanRenderDevice::setPipelineCachePath(const String &path) {
+        waitCompiledPipelines();
+        return mPipelineCache->load(path);
+    }
+
+    void VulkanRenderDevice::savePipelineCache() {
+        if (mPipelineCache->getPath().empty()) {
+            throw VulkanException("Pipeline cache path is not set");
+        }
+
+        waitCompiledPipelines();
+
+        if (!mPipelineCache->save()) {
+            throw VulkanException("Failed to write pipeline cache file");
+        }
+    }
+
+    IRenderDevice::PipelineCacheStatistics VulkanRenderDevice::getPipelineCacheStatistics() {
+        PipelineCacheStatistics statistics;
+        statistics.hits = mPipelineCache->getHits();
+        statistics.misses = mPipelineCache->getMisses();
+        statistics.concurrent = mPipelineCache->getConcurrent();
+        statistics.shared = mSharedPipelines;
+        statistics.compiling = mPipelineCompiler->getPendingCount();
+        statistics.failed = mFailedPipelines;
+        statistics.loaded = mPipelineCache->isLoaded();
+
+        return statistics;
+    }
+
+    IRenderDevice::UploadStatistics VulkanRenderDevice::getUploadStatistics() {
+        UploadStatistics statistics;
+        statistics.submittedBatches = mUploadManager->getSubmittedValue();
+        statistics.completedBatches = mUploadManager->getCompletedValue();
+        statistics.uploadedBytes = mUploadManager->getUploadedBytes();
+        statistics.stagingSize = mUploadManager->getStagingSize();
+
+        return statistics;
+    }
+
+    VulkanDrawListStateControl &VulkanRenderDevice::getDrawListState() {
+        if (gThreadDrawListDevice == this) {
+            return gThreadDrawList->state;
+        }
+
+        // Commands of the primary list are recorded inline
+        if (mDrawListState.renderPassPending) {
+            beginRenderPass(VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        VK_TRUE_ASSERT(!mDrawListState.secondaryContents, "Framebuffer contents are recorded in secondary draw lists");
+        return mDrawListState;
+    }
+
+    void VulkanRenderDevice::beginRenderPass(VkSubpassContents contents) {
+        auto &state = mDrawListState;
+
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = state.renderPass;
+        renderPassBeginInfo.renderArea = state.renderArea;
+        renderPassBeginInfo.clearValueCount = (uint32) mClearValues.size();
+        renderPassBeginInfo.pClearValues = mClearValues.data();
+        renderPassBeginInfo.framebuffer = state.framebuffer;
+
+        // Set outside of the pass, since only execute commands are allowed in pass with secondary contents
+        vkCmdSetViewport(state.commandBuffer, 0, 1, &state.viewport);
+        vkCmdSetScissor(state.commandBuffer, 0, 1, &state.scissor);
+        vkCmdBeginRenderPass(state.commandBuffer, &renderPassBeginInfo, contents);
+
+        state.renderPassPending = false;
+        state.secondaryContents = contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+    }
+
+    void VulkanRenderDevice::endRenderPass() {
+        auto &state = mDrawListState;
+
+        if (!state.frameBufferAttached)
+            return;
+
+        // Attachments of the pass without commands still must be cleared
+        if (state.renderPassPending) {
+            beginRenderPass(VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        vkCmdEndRenderPass(state.commandBuffer);
     }
 
     ID<Surface> VulkanRenderDevice::getSurface(const std::string &surfaceName) {
@@ -1213,16 +1841,22 @@ namespace ignimbrite {
     }
 
     void VulkanRenderDevice::swapBuffers(ID<Surface> surfaceId) {
-        VK_TRUE_ASSERT(mSyncQueue.empty(), "Device must be explicitly synchronized before swap buffers call");
-
         auto &surface = mSurfaces.get(surfaceId);
         auto &swapChain = surface.swapChain;
         auto imageIndex = surface.currentImageIndex;
 
+        // Ended frame is presented after its draw lists execution
+        VkSemaphore waitSemaphore = VK_NULL_HANDLE;
+
+        if (surface.renderFinishedSignaled) {
+            waitSemaphore = surface.renderFinishedSemaphores[mFrameIndex].get();
+            surface.renderFinishedSignaled = false;
+        }
+
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-        presentInfo.waitSemaphoreCount = 0;
-        presentInfo.pWaitSemaphores = nullptr;
+        presentInfo.waitSemaphoreCount = waitSemaphore != VK_NULL_HANDLE ? 1 : 0;
+        presentInfo.pWaitSemaphores = &waitSemaphore;
         presentInfo.swapchainCount = 1;
         presentInfo.pSwapchains = &swapChain.swapChainKHR;
         presentInfo.pImageIndices = &imageIndex;
@@ -1237,20 +1871,28 @@ namespace ignimbrite {
             VK_RESULT_ASSERT(result, "Failed to present image to the surface");
         }
 
-        if (surface.canPresentImages) {
+        if (!surface.canPresentImages) {
+            return;
+        }
+
+        // Next image is acquired with semaphore, when the slot of the next frame is free
+        if (mFrameEnded) {
+            surface.acquirePending = true;
+        } else {
             surface.acquireNextImage();
         }
     }
 
 
     void VulkanRenderDevice::flush() {
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+        // Uploads are submitted before the draw lists, which use uploaded resources
+        mUploadManager->submit();
 
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.waitSemaphoreCount = 0;
-        submitInfo.pWaitSemaphores = nullptr;
-        submitInfo.pWaitDstStageMask = waitStages;
+        submitInfo.waitSemaphoreCount = (uint32) mWaitSemaphores.size();
+        submitInfo.pWaitSemaphores = mWaitSemaphores.data();
+        submitInfo.pWaitDstStageMask = mWaitStages.data();
         submitInfo.commandBufferCount = (uint32) mDrawQueue.size();
         submitInfo.pCommandBuffers = mDrawQueue.data();
         submitInfo.signalSemaphoreCount = 0;
@@ -1259,20 +1901,220 @@ namespace ignimbrite {
         auto result = vkQueueSubmit(mContext.graphicsQueue, 1, &submitInfo, nullptr);
         VK_RESULT_ASSERT(result, "Failed to submit draw lists to graphics queue");
 
-        mSyncQueue.insert(mSyncQueue.end(), mDrawQueue.begin(), mDrawQueue.end());
         mDrawQueue.clear();
+        mWaitSemaphores.clear();
+        mWaitStages.clear();
     }
 
     void VulkanRenderDevice::synchronize() {
+        mUploadManager->waitIdle();
         vkQueueWaitIdle(mContext.graphicsQueue);
 
-        for (auto buffer: mSyncQueue) {
-            VulkanUtils::destroyTmpComandBuffer(buffer, mContext.graphicsTmpCommandPool);
+        // Release frames in order of its use
+        for (uint32 i = 1; i <= mFrames.size(); i++) {
+            releaseFrame((mFrameIndex + i) % (uint32) mFrames.size());
+        }
+
+        // Device is idle, therefore all the copies of the dynamic buffers could be updated
+        for (uint32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            syncDirtyBuffers(i);
+        }
+    }
+
+    void VulkanRenderDevice::beginFrame() {
+        VK_TRUE_ASSERT(!mFrameStarted, "Frame is already started");
+
+        mFrameIndex = (uint32) (mFrameNumber % mFramesInFlight);
+        mFrameNumber += 1;
+        mFrameStarted = true;
+        mFrameEnded = false;
+
+        auto &frame = mFrames[mFrameIndex];
+
+        // Wait only for the frame, which slot is reused
+        frame.fence.wait();
+        releaseFrame(mFrameIndex);
+        syncDirtyBuffers(mFrameIndex);
+        resolveCompiledPipelines();
+
+        for (auto &surface: mSurfaces) {
+            if (!surface.acquirePending)
+                continue;
+
+            auto semaphore = surface.imageAvailableSemaphores[mFrameIndex].get();
+            surface.acquirePending = false;
+
+            if (surface.acquireNextImage(semaphore)) {
+                mWaitSemaphores.push_back(semaphore);
+                mWaitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            }
+        }
+    }
+
+    void VulkanRenderDevice::endFrame() {
+        VK_TRUE_ASSERT(mFrameStarted, "Frame is not started");
+        VK_TRUE_ASSERT(mDrawQueue.empty(), "Draw lists of the frame must be flushed before frame end");
+
+        std::vector<VkSemaphore> signalSemaphores;
+
+        for (auto id: mFrameSurfaces) {
+            auto surface = mSurfaces.getPtr(id);
+
+            if (surface != nullptr && surface->canPresentImages) {
+                signalSemaphores.push_back(surface->renderFinishedSemaphores[mFrameIndex].get());
+                surface->renderFinishedSignaled = true;
+            }
+        }
+
+        // Objects, destroyed in this frame, could be referenced by not submitted uploads
+        mUploadManager->submit();
+
+        auto &frame = mFrames[mFrameIndex];
+        frame.fence.reset();
+
+        // Signal operations are executed after all the previously submitted draw lists
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = (uint32) mWaitSemaphores.size();
+        submitInfo.pWaitSemaphores = mWaitSemaphores.data();
+        submitInfo.pWaitDstStageMask = mWaitStages.data();
+        submitInfo.commandBufferCount = 0;
+        submitInfo.pCommandBuffers = nullptr;
+        submitInfo.signalSemaphoreCount = (uint32) signalSemaphores.size();
+        submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+        auto result = vkQueueSubmit(mContext.graphicsQueue, 1, &submitInfo, frame.fence.get());
+        VK_RESULT_ASSERT(result, "Failed to submit frame end to graphics queue");
+
+        mWaitSemaphores.clear();
+        mWaitStages.clear();
+        mFrameSurfaces.clear();
+        mFrameStarted = false;
+        mFrameEnded = true;
+    }
+
+    void VulkanRenderDevice::setFramesInFlight(uint32 framesCount) {
+        VK_TRUE_ASSERT(framesCount > 0 && framesCount <= MAX_FRAMES_IN_FLIGHT, "Invalid frames in flight count");
+        VK_TRUE_ASSERT(!mFrameStarted, "Frames in flight count could not be changed inside frame");
+
+        synchronize();
+
+        mFramesInFlight = framesCount;
+    }
+
+    uint32 VulkanRenderDevice::getFramesInFlight() const {
+        return mFramesInFlight;
+    }
+
+    uint32 VulkanRenderDevice::getFrameIndex() const {
+        return mFrameIndex;
+    }
+
+    VkCommandBuffer VulkanRenderDevice::getCommandBuffer(VulkanCommandPool &pool, VkCommandBufferLevel level) {
+        if (pool.used == pool.commandBuffers.size()) {
+            pool.commandBuffers.push_back(VulkanUtils::allocateCommandBuffer(pool.commandPool, level));
         }
 
-        mSyncQueue.clear();
+        return pool.commandBuffers[pool.used++];
     }
 
+    void VulkanRenderDevice::resetCommandPool(VulkanCommandPool &pool) {
+        if (pool.used == 0)
+            return;
+
+        auto result = vkResetCommandPool(mContext.device, pool.commandPool, 0);
+        VK_RESULT_ASSERT(result, "Failed to reset command pool");
+
+        pool.used = 0;
+        mCommandPoolsResets += 1;
+    }
+
+    void VulkanRenderDevice::syncDirtyBuffers(uint32 frameIndex) {
+        auto sync = [&](VulkanBufferCopies &copies) {
+            return copies.count == 1 || syncBufferCopy(copies, frameIndex);
+        };
+
+        // Buffers are removed from the lists, when all of its copies are up to date
+        auto end = std::remove_if(mDirtyVertexBuffers.begin(), mDirtyVertexBuffers.end(), [&](ID<VertexBuffer> id) {
+            auto buffer = mVertexBuffers.getPtr(id);
+            return buffer == nullptr || sync(buffer->copies);
+        });
+        mDirtyVertexBuffers.erase(end, mDirtyVertexBuffers.end());
+
+        auto endIndex = std::remove_if(mDirtyIndexBuffers.begin(), mDirtyIndexBuffers.end(), [&](ID<IndexBuffer> id) {
+            auto buffer = mIndexBuffers.getPtr(id);
+            return buffer == nullptr || sync(buffer->copies);
+        });
+        mDirtyIndexBuffers.erase(endIndex, mDirtyIndexBuffers.end());
+
+        auto endUniform = std::remove_if(mDirtyUniformBuffers.begin(), mDirtyUniformBuffers.end(), [&](ID<UniformBuffer> id) {
+            auto buffer = mUniformBuffers.getPtr(id);
+            return buffer == nullptr || sync(buffer->copies);
+        });
+        mDirtyUniformBuffers.erase(endUniform, mDirtyUniformBuffers.end());
+    }
+
+    void VulkanRenderDevice::releaseFrame(uint32 frameIndex) {
+        auto device = mContext.device;
+        auto &frame = mFrames[frameIndex];
+
+        // Lists of the frame are not freed, but recycled with pools reset
+        resetCommandPool(frame.commandPool);
+
+        for (auto &thread: mDrawListThreads) {
+            resetCommandPool(thread.framePools[frameIndex]);
+        }
+
+        for (auto id: frame.drawLists) {
+            mDrawLists.remove(id);
+        }
+
+        for (auto &drawList: frame.reusableDrawLists) {
+            VulkanUtils::destroyTmpComandBuffer(drawList.commandBuffer, drawList.commandPool);
+        }
+
+        for (auto &buffer: frame.buffers) {
+            VulkanUtils::destroyBuffer(buffer.buffer, buffer.allocation);
+        }
+
+        for (auto &image: frame.images) {
+            vkDestroyImageView(device, image.imageView, nullptr);
+            VulkanUtils::destroyImage(image.image, image.allocation);
+        }
+
+        for (auto &set: frame.uniformSets) {
+            auto layout = mUniformLayouts.getPtr(set.uniformLayout);
+
+            // Sets of already destroyed layout are freed with its pools
+            for (uint32 i = 0; layout != nullptr && i < set.descriptorSetsCount; i++) {
+                layout->allocator.freeSet(set.descriptorSets[i]);
+            }
+        }
+
+        for (auto id: frame.uniformLayouts) {
+            auto &layout = mUniformLayouts.get(id);
+            vkDestroyDescriptorSetLayout(device, layout.properties.layout, nullptr);
+            mUniformLayouts.remove(id);
+        }
+
+        for (auto &pipeline: frame.pipelines) {
+            vkDestroyPipeline(device, pipeline.pipeline, nullptr);
+            vkDestroyPipelineLayout(device, pipeline.pipelineLayout, nullptr);
+        }
+
+        for (auto framebuffer: frame.framebuffers) {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+
+        frame.drawLists.clear();
+        frame.reusableDrawLists.clear();
+        frame.buffers.clear();
+        frame.images.clear();
+        frame.uniformSets.clear();
+        frame.uniformLayouts.clear();
+        frame.pipelines.clear();
+        frame.framebuffers.clear();
+    }
 
     const std::vector<DataFormat> &VulkanRenderDevice::getSupportedTextureFormats() const {
         return mSupportedTextureDataFormats;
@@ -16,6 +16,13 @@
 #include <VulkanSurface.h>
 #include <VulkanUtils.h>
 #include <VulkanDrawList.h>
+#include <VulkanFrame.h>
+#include <VulkanUploadManager.h>
+#include <VulkanPipelineCache.h>
+#include <VulkanPipelineCompiler.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace ignimbrite {
 
@@ -59,6 +66,11 @@ namespace ignimbrite {
         void updateUniformBuffer(ID<UniformBuffer> buffer, uint32 size, uint32 offset, const void *data) override;
         void destroyUniformBuffer(ID<UniformBuffer> buffer) override;
 
+        uint8 *mapUniformBuffer(ID<UniformBuffer> buffer) override;
+
+        uint32 getUniformBufferOffsetAlignment() override;
+        uint32 getMaxPushConstantsSize() override;
+
         ID<ShaderProgram> createShaderProgram(const ProgramDesc &programDesc) override;
         void destroyShaderProgram(ID<ShaderProgram> program) override;
 
@@ -79,6 +91,11 @@ namespace ignimbrite {
                                   const PipelineSurfaceBlendStateDesc &blendStateDesc,
                                   const PipelineDepthStencilStateDesc &depthStencilStateDesc) override;
         void destroyGraphicsPipeline(ID<GraphicsPipeline> pipeline) override;
+        void setPipelineCompileThreadsCount(uint32 threadsCount) override;
+        bool isGraphicsPipelineReady(ID<GraphicsPipeline> pipeline) override;
+        bool setPipelineCachePath(const String &path) override;
+        void savePipelineCache() override;
+        PipelineCacheStatistics getPipelineCacheStatistics() override;
 
         void drawListBegin() override;
         void drawListEnd() override;
@@ -89,12 +106,23 @@ namespace ignimbrite {
                                      float32 clearDepth, uint32 clearStencil, const Region &area) override;
         void drawListBindPipeline(ID<GraphicsPipeline> graphicsPipeline) override;
         void drawListBindUniformSet(ID<UniformSet> uniformSet) override;
+        void drawListBindUniformSet(ID<UniformSet> uniformSet, const std::vector<uint32> &dynamicOffsets) override;
+        void drawListPushConstants(ShaderStageFlags flags, uint32 offset, uint32 size, const void *data) override;
         void drawListBindVertexBuffer(ID<VertexBuffer> vertexBuffer, uint32 binding, uint32 offset) override;
         void drawListBindIndexBuffer(ID<IndexBuffer> indexBuffer, IndicesType indicesType, uint32 offset) override;
 
         void drawListDraw(uint32 verticesCount, uint32 instancesCount) override;
         void drawListDrawIndexed(uint32 indicesCount, uint32 instancesCount) override;
 
+        void setDrawListThreadsCount(uint32 threadsCount) override;
+        void drawListBeginSecondary(uint32 threadIndex, bool reusable) override;
+        ID<DrawList> drawListEndSecondary() override;
+        void destroyDrawList(ID<DrawList> drawList) override;
+        void drawListExecute(const std::vector<ID<DrawList>> &drawLists) override;
+        const DrawListStatistics &getDrawListStatistics() override;
+        CommandPoolStatistics getCommandPoolStatistics() override;
+        UploadStatistics getUploadStatistics() override;
+
         ID<Surface> getSurface(const std::string &surfaceName) override;
         void getSurfaceSize(ID<Surface> surface, uint32 &width, uint32 &height) override;
         void swapBuffers(ID<Surface> surfaceId) override;
@@ -102,6 +130,12 @@ namespace ignimbrite {
         void flush() override;
         void synchronize() override;
 
+        void beginFrame() override;
+        void endFrame() override;
+        void setFramesInFlight(uint32 framesCount) override;
+        uint32 getFramesInFlight() const override;
+        uint32 getFrameIndex() const override;
+
         const std::vector<DataFormat> &getSupportedTextureFormats() const override;
         const std::vector<ShaderLanguage> &getSupportedShaderLanguages() override;
         const std::string &getDeviceName() const override;
@@ -126,12 +160,83 @@ namespace ignimbrite {
         using IRenderDevice::Surface;
         using IRenderDevice::Texture;
         using IRenderDevice::Sampler;
+        using IRenderDevice::DrawList;
+
+        /** @return State of the draw list, recorded by the calling thread */
+        VulkanDrawListStateControl &getDrawListState();
+        void beginRenderPass(VkSubpassContents contents);
+        void endRenderPass();
+
+        /** Create buffer with copy for each frame slot, if it is dynamic */
+        void createBufferCopies(VulkanBufferCopies &copies, BufferUsage usage, uint32 size, VkBufferUsageFlags usageFlags, const void *data);
+        /** Write data into copy of the current frame slot, @return True if other copies became outdated */
+        bool updateBufferCopies(VulkanBufferCopies &copies, uint32 size, uint32 offset, const void *data);
+        /** Update outdated copy of the slot from the shadow data, @return True if all copies are up to date */
+        bool syncBufferCopy(VulkanBufferCopies &copies, uint32 frameIndex);
+        void destroyBufferCopies(VulkanBufferCopies &copies);
+
+        /** @return Shared pipeline with key (its references are increased) or null ID */
+        ID<GraphicsPipeline> findGraphicsPipeline(const String &key);
+        /** Compile pipeline of the job (in background, if compile threads are set) and register it with key */
+        ID<GraphicsPipeline> addGraphicsPipeline(String key, VkPipelineLayout pipelineLayout,
+                                                 std::shared_ptr<VulkanPipelineJob> job, bool background);
+        /** Take compiled pipelines of the finished jobs (failed pipelines stay null and are counted) */
+        void resolveCompiledPipelines();
+        /** Wait for the background compilation, before objects, referenced by jobs, are destroyed */
+        void waitCompiledPipelines();
+        /** @return Pipeline to be bound, null if it is not compiled yet */
+        static VkPipeline getCompiledPipeline(const VulkanGraphicsPipeline &graphicsPipeline);
+
+        /** Update outdated copies of the frame slot for buffers, modified in previous frames */
+        void syncDirtyBuffers(uint32 frameIndex);
+        /** Release command buffers of the finished frame and objects, destroyed while it was in flight */
+        void releaseFrame(uint32 frameIndex);
+
+        /** @return Next free command buffer of the pool (allocated only if all buffers are used) */
+        static VkCommandBuffer getCommandBuffer(VulkanCommandPool &pool, VkCommandBufferLevel level);
+        void resetCommandPool(VulkanCommandPool &pool);
 
         VulkanDrawListStateControl mDrawListState;
         VulkanContext&  mContext = VulkanContext::getInstance();
         CommandBuffers  mDrawQueue;
-        CommandBuffers  mSyncQueue;
         ClearValues     mClearValues;
+        CommandBuffers  mExecuteBuffers;
+
+        /** Batched uploads of the static buffers and textures */
+        std::unique_ptr<VulkanUploadManager> mUploadManager;
+        /** Cache of all the created pipelines, persistent if its path is set */
+        std::unique_ptr<VulkanPipelineCache> mPipelineCache;
+        std::unique_ptr<VulkanPipelineCompiler> mPipelineCompiler;
+        /** Pipelines by description key, identical pipelines are shared */
+        std::unordered_map<String, ID<GraphicsPipeline>> mPipelinesByKey;
+        /** Pipelines with background jobs, which are not resolved yet */
+        std::vector<ID<GraphicsPipeline>> mCompilingPipelines;
+        uint32 mSharedPipelines = 0;
+        uint32 mFailedPipelines = 0;
+
+        /** Frame slots in order of use, objects are destroyed deferred in slot of the current frame */
+        std::vector<VulkanFrame> mFrames;
+        uint32 mFramesInFlight = 2;
+        uint32 mFrameIndex = 0;
+        uint64 mFrameNumber = 0;
+        bool mFrameStarted = false;
+        bool mFrameEnded = false;
+        uint64 mCommandPoolsResets = 0;
+        /** Surfaces, bound in current frame (presented after frame end) */
+        std::vector<ID<Surface>> mFrameSurfaces;
+        /** Acquired images semaphores, which must be waited by first flush of the frame */
+        std::vector<VkSemaphore> mWaitSemaphores;
+        std::vector<VkPipelineStageFlags> mWaitStages;
+
+        /** Dynamic buffers with outdated copies */
+        std::vector<ID<VertexBuffer>> mDirtyVertexBuffers;
+        std::vector<ID<IndexBuffer>> mDirtyIndexBuffers;
+        std::vector<ID<UniformBuffer>> mDirtyUniformBuffers;
+
+        /** Secondary draw lists are recorded concurrently, therefore added under lock */
+        std::mutex mDrawListsMutex;
+        std::vector<VulkanDrawListThread> mDrawListThreads;
+        IDBuffer<VulkanSecondaryDrawList, DrawList> mDrawLists;
 
         IDBuffer<VulkanSurface,          Surface>           mSurfaces;
         IDBuffer<VulkanVertexLayout,     VertexLayout>      mVertexLayouts;
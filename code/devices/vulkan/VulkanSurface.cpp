@@ -17,6 +17,8 @@ namespace ignimbrite {
     VulkanSurface::VulkanSurface(uint32 width, uint32 height, std::string name,
                                  VkSurfaceKHR surfaceKHR)
                                  :  name(std::move(name)), width(width), height(height), surfaceKHR(surfaceKHR) {
+        imageAvailableSemaphores.resize(IRenderDevice::MAX_FRAMES_IN_FLIGHT);
+        renderFinishedSemaphores.resize(IRenderDevice::MAX_FRAMES_IN_FLIGHT);
     }
 
     void VulkanSurface::createSwapChain() {
@@ -342,6 +344,9 @@ namespace ignimbrite {
                 return;
             }
 
+            // Framebuffers could be still used by frames in flight
+            VulkanContext::getInstance().deviceWaitIdle();
+
             destroyFramebuffers();
             destroySwapChain();
             createSwapChain();
@@ -356,27 +361,33 @@ namespace ignimbrite {
         acquireNextImage();
     }
 
-    void VulkanSurface::acquireNextImage() {
+    bool VulkanSurface::acquireNextImage(VkSemaphore semaphore) {
         auto& context = VulkanContext::getInstance();
         bool acquire = false;
+        VkFence fence = semaphore != VK_NULL_HANDLE ? VK_NULL_HANDLE : imageAvailable.get();
 
         while (!acquire) {
             auto result = vkAcquireNextImageKHR(
                     context.device,
                     swapChain.swapChainKHR,
                     UINT64_MAX,
-                    VK_NULL_HANDLE,
-                    imageAvailable.get(),
+                    semaphore,
+                    fence,
                     &currentImageIndex
             );
 
+            // Semaphore is signaled for suboptimal image, therefore surface is resized on present
+            if (result == VK_SUBOPTIMAL_KHR && semaphore != VK_NULL_HANDLE) {
+                break;
+            }
+
             if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
                 resizeSurface();
 
                 if (!canPresentImages) {
                     // if a window minimized
                     // go out and disallow rendering to the window
-                    return;
+                    return false;
                 }
 
                 continue;
@@ -388,8 +399,12 @@ namespace ignimbrite {
             acquire = true;
         }
 
-        imageAvailable.wait();
-        imageAvailable.reset();
+        if (fence != VK_NULL_HANDLE) {
+            imageAvailable.wait();
+            imageAvailable.reset();
+        }
+
+        return true;
     }
 
     void VulkanSurface::findPresentsFamily() {
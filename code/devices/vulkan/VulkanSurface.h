@@ -13,6 +13,7 @@
 #include <Types.h>
 #include <VulkanFramebuffer.h>
 #include <VulkanFence.h>
+#include <VulkanSemaphore.h>
 #include <VulkanObjects.h>
 #include <string>
 #include <vector>
@@ -57,8 +58,12 @@ namespace ignimbrite {
 
         void resizeSurface();
         void acquireFirstImage();
-        /** Get image ready for rendering and acquire next image */
-        void acquireNextImage();
+        /**
+         * Get image ready for rendering and acquire next image
+         * @param semaphore Signaled, when image is ready (if null, waits for the image on CPU)
+         * @return True if image is acquired (false if surface is minimized)
+         */
+        bool acquireNextImage(VkSemaphore semaphore = VK_NULL_HANDLE);
 
     private:
         void getSurfaceProperties(std::vector<VkSurfaceFormatKHR> &outSurfaceFormats,
@@ -82,6 +87,14 @@ namespace ignimbrite {
         uint32 currentImageIndex = 0;
         VulkanFence imageAvailable;
 
+        /** Per frame slot semaphores, if images are acquired and presented without waiting on CPU */
+        std::vector<VulkanSemaphore> imageAvailableSemaphores;
+        std::vector<VulkanSemaphore> renderFinishedSemaphores;
+        /** Next image is acquired on next frame begin */
+        bool acquirePending = false;
+        /** Render finished semaphore of the current frame slot is signaled, must be waited by present */
+        bool renderFinishedSignaled = false;
+
     };
 
 } // namespace ignimbrite
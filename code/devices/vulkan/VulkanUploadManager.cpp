@@ -0,0 +1,451 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <VulkanUploadManager.h>
+#include <VulkanUtils.h>
+#include <cstring>
+
+namespace ignimbrite {
+
+    /** Stages and accesses of the uploaded data consumers on the graphics queue */
+    static const VkPipelineStageFlags CONSUMER_STAGES =
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    static const VkAccessFlags CONSUMER_ACCESS =
+            VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    static const uint32 BUFFER_ALIGNMENT = 16;
+
+    VulkanUploadManager::VulkanUploadManager() {
+        auto graphicsFamily = mContext.familyIndices.graphicsFamily.get();
+        auto transferFamily = mContext.familyIndices.transferFamily.get();
+
+        mBatches.resize(BATCHES_COUNT);
+
+        for (auto &batch: mBatches) {
+            batch.transferPool = VulkanUtils::createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, transferFamily);
+            batch.graphicsPool = VulkanUtils::createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, graphicsFamily);
+            batch.transferCommands = VulkanUtils::allocateCommandBuffer(batch.transferPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+            batch.graphicsCommands = VulkanUtils::allocateCommandBuffer(batch.graphicsPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        }
+
+        createRing(STAGING_RING_SIZE);
+    }
+
+    VulkanUploadManager::~VulkanUploadManager() {
+        waitIdle();
+
+        for (auto &batch: mBatches) {
+            vkDestroyCommandPool(mContext.device, batch.transferPool, nullptr);
+            vkDestroyCommandPool(mContext.device, batch.graphicsPool, nullptr);
+        }
+
+        mBatches.clear();
+        destroyRing();
+    }
+
+    void VulkanUploadManager::uploadBuffer(VkBuffer buffer, uint32 size, const void *data) {
+        if (size == 0 || data == nullptr)
+            return;
+
+        bool separateFamilies = mContext.familyIndices.transferFamily.get() != mContext.familyIndices.graphicsFamily.get();
+        uint32 offset = writeStaging(size, BUFFER_ALIGNMENT, data);
+        auto &batch = beginBatch();
+
+        VkBufferCopy region = {};
+        region.srcOffset = offset;
+        region.dstOffset = 0;
+        region.size = size;
+
+        vkCmdCopyBuffer(batch.transferCommands, mRing, buffer, 1, &region);
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.buffer = buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        barrier.srcQueueFamilyIndex = separateFamilies ? mContext.familyIndices.transferFamily.get() : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = separateFamilies ? mContext.familyIndices.graphicsFamily.get() : VK_QUEUE_FAMILY_IGNORED;
+
+        // Buffer is exclusive, therefore ownership is released by transfer queue and acquired by graphics queue
+        if (separateFamilies) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+
+            vkCmdPipelineBarrier(batch.transferCommands,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                                 0, nullptr,
+                                 1, &barrier,
+                                 0, nullptr);
+        }
+
+        barrier.srcAccessMask = separateFamilies ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = CONSUMER_ACCESS;
+
+        vkCmdPipelineBarrier(batch.graphicsCommands,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, CONSUMER_STAGES, 0,
+                             0, nullptr,
+                             1, &barrier,
+                             0, nullptr);
+    }
+
+    void VulkanUploadManager::updateBuffer(VkBuffer buffer, uint32 size, uint32 offset, const void *data) {
+        if (size == 0 || data == nullptr)
+            return;
+
+        uint32 stagingOffset = writeStaging(size, BUFFER_ALIGNMENT, data);
+        auto &batch = beginBatch();
+
+        // Buffer could be read by previously submitted commands, therefore copy is done on graphics queue
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(batch.graphicsCommands,
+                             CONSUMER_STAGES | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             1, &barrier,
+                             0, nullptr,
+                             0, nullptr);
+
+        VkBufferCopy region = {};
+        region.srcOffset = stagingOffset;
+        region.dstOffset = offset;
+        region.size = size;
+
+        vkCmdCopyBuffer(batch.graphicsCommands, mRing, buffer, 1, &region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = CONSUMER_ACCESS;
+
+        vkCmdPipelineBarrier(batch.graphicsCommands,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, CONSUMER_STAGES, 0,
+                             1, &barrier,
+                             0, nullptr,
+                             0, nullptr);
+    }
+
+    void VulkanUploadManager::uploadImage(VkImage image, VkFormat format, uint32 texelSize,
+                                          uint32 width, uint32 height, uint32 depth,
+                                          uint32 mipLevels, uint32 layersCount, uint32 layerSize,
+                                          uint32 dataSize, const void *data, VkImageLayout finalLayout) {
+        bool separateFamilies = mContext.familyIndices.transferFamily.get() != mContext.familyIndices.graphicsFamily.get();
+
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.image = image;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = mipLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layersCount;
+
+        if (dataSize == 0 || data == nullptr) {
+            // Nothing to copy, image is only transitioned into final layout
+            auto &batch = beginBatch();
+
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = finalLayout;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(batch.graphicsCommands,
+                                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, CONSUMER_STAGES, 0,
+                                 0, nullptr,
+                                 0, nullptr,
+                                 1, &barrier);
+            return;
+        }
+
+        // Offset of the copy must be multiple of 4 and of the texel size
+        uint32 offset = writeStaging(dataSize, texelSize * 4, data);
+        auto &batch = beginBatch();
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(batch.transferCommands,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr,
+                             0, nullptr,
+                             1, &barrier);
+
+        std::vector<VkBufferImageCopy> regions(layersCount);
+
+        for (uint32 i = 0; i < layersCount; i++) {
+            auto &region = regions[i];
+            region = {};
+
+            region.bufferOffset = offset + i * layerSize;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            // only the first level is copied, others are generated
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = i;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = {width, height, depth};
+        }
+
+        vkCmdCopyBufferToImage(batch.transferCommands, mRing, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               (uint32) regions.size(), regions.data());
+
+        // Layout is changed on graphics queue, since blits for mipmaps are not supported by transfer queue
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = separateFamilies ? mContext.familyIndices.transferFamily.get() : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = separateFamilies ? mContext.familyIndices.graphicsFamily.get() : VK_QUEUE_FAMILY_IGNORED;
+
+        if (separateFamilies) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+
+            vkCmdPipelineBarrier(batch.transferCommands,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                                 0, nullptr,
+                                 0, nullptr,
+                                 1, &barrier);
+        }
+
+        barrier.srcAccessMask = separateFamilies ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(batch.graphicsCommands,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr,
+                             0, nullptr,
+                             1, &barrier);
+
+        if (mipLevels > 1) {
+            VulkanUtils::cmdGenerateMipmaps(batch.graphicsCommands, image, format, width, height,
+                                            mipLevels, layersCount, finalLayout);
+            return;
+        }
+
+        barrier.newLayout = finalLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(batch.graphicsCommands,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, CONSUMER_STAGES, 0,
+                             0, nullptr,
+                             0, nullptr,
+                             1, &barrier);
+    }
+
+    void VulkanUploadManager::submit() {
+        auto &batch = mBatches[mCurrentBatch];
+
+        if (!batch.recording)
+            return;
+
+        auto result = vkEndCommandBuffer(batch.transferCommands);
+        VK_RESULT_ASSERT(result, "Failed to end upload command buffer");
+
+        result = vkEndCommandBuffer(batch.graphicsCommands);
+        VK_RESULT_ASSERT(result, "Failed to end upload command buffer");
+
+        batch.fence.reset();
+
+        VkSemaphore semaphore = batch.semaphore.get();
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo transferSubmit = {};
+        transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        transferSubmit.commandBufferCount = 1;
+        transferSubmit.pCommandBuffers = &batch.transferCommands;
+        transferSubmit.signalSemaphoreCount = 1;
+        transferSubmit.pSignalSemaphores = &semaphore;
+
+        result = vkQueueSubmit(mContext.transferQueue, 1, &transferSubmit, VK_NULL_HANDLE);
+        VK_RESULT_ASSERT(result, "Failed to submit uploads to transfer queue");
+
+        // Graphics part finishes after transfer part, therefore its fence completes the batch
+        VkSubmitInfo graphicsSubmit = {};
+        graphicsSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        graphicsSubmit.waitSemaphoreCount = 1;
+        graphicsSubmit.pWaitSemaphores = &semaphore;
+        graphicsSubmit.pWaitDstStageMask = &waitStage;
+        graphicsSubmit.commandBufferCount = 1;
+        graphicsSubmit.pCommandBuffers = &batch.graphicsCommands;
+
+        result = vkQueueSubmit(mContext.graphicsQueue, 1, &graphicsSubmit, batch.fence.get());
+        VK_RESULT_ASSERT(result, "Failed to submit uploads to graphics queue");
+
+        mSubmittedValue += 1;
+
+        batch.value = mSubmittedValue;
+        batch.ringUsed = mRecordingRingUsed;
+        batch.recording = false;
+        batch.inFlight = true;
+
+        mRecordingRingUsed = 0;
+        mCurrentBatch = (mCurrentBatch + 1) % (uint32) mBatches.size();
+    }
+
+    void VulkanUploadManager::waitIdle() {
+        submit();
+
+        while (retireOldestBatch());
+    }
+
+    uint64 VulkanUploadManager::getCompletedValue() {
+        // Batches are completed in order of submission
+        for (uint32 i = 0; i < mBatches.size(); i++) {
+            auto &batch = mBatches[(mCurrentBatch + i) % mBatches.size()];
+
+            if (!batch.inFlight)
+                continue;
+            if (!batch.fence.isSignaled())
+                break;
+
+            retireBatch(batch);
+        }
+
+        return mCompletedValue;
+    }
+
+    VulkanUploadManager::Batch &VulkanUploadManager::beginBatch() {
+        auto &batch = mBatches[mCurrentBatch];
+
+        if (batch.recording)
+            return batch;
+
+        // Slot of the current batch is the oldest one
+        if (batch.inFlight) {
+            retireBatch(batch);
+        }
+
+        auto result = vkResetCommandPool(mContext.device, batch.transferPool, 0);
+        VK_RESULT_ASSERT(result, "Failed to reset upload command pool");
+
+        result = vkResetCommandPool(mContext.device, batch.graphicsPool, 0);
+        VK_RESULT_ASSERT(result, "Failed to reset upload command pool");
+
+        VulkanUtils::beginCommandBuffer(batch.transferCommands);
+        VulkanUtils::beginCommandBuffer(batch.graphicsCommands);
+
+        batch.recording = true;
+
+        return batch;
+    }
+
+    void VulkanUploadManager::retireBatch(Batch &batch) {
+        batch.fence.wait();
+
+        mRingUsed -= batch.ringUsed;
+        mCompletedValue = batch.value;
+
+        batch.ringUsed = 0;
+        batch.inFlight = false;
+    }
+
+    bool VulkanUploadManager::retireOldestBatch() {
+        for (uint32 i = 0; i < mBatches.size(); i++) {
+            auto &batch = mBatches[(mCurrentBatch + i) % mBatches.size()];
+
+            if (batch.inFlight) {
+                retireBatch(batch);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint32 VulkanUploadManager::writeStaging(uint32 size, uint32 alignment, const void *data) {
+        uint32 offset;
+
+        while (!tryAllocateStaging(size, alignment, offset)) {
+            if ((uint64) size + alignment > mRingSize) {
+                // Ring is recreated only when no batches reference it
+                uint32 ringSize = mRingSize;
+                while ((uint64) size + alignment > ringSize) {
+                    ringSize *= 2;
+                }
+
+                waitIdle();
+                destroyRing();
+                createRing(ringSize);
+                continue;
+            }
+
+            // Memory is released by the batches in flight, current batch is submitted for that
+            submit();
+
+            if (!retireOldestBatch()) {
+                throw VulkanException("Failed to allocate staging memory for upload");
+            }
+        }
+
+        std::memcpy(mRingMapped + offset, data, size);
+        mUploadedBytes += size;
+
+        return offset;
+    }
+
+    bool VulkanUploadManager::tryAllocateStaging(uint32 size, uint32 alignment, uint32 &offset) {
+        if (mRingUsed == 0) {
+            mRingHead = 0;
+        }
+
+        // Allocation consumes continuous memory from the head, including padding or the ring end
+        uint64 aligned = ((uint64) mRingHead + alignment - 1) / alignment * alignment;
+        uint64 consumed;
+
+        if (aligned + size <= mRingSize) {
+            consumed = aligned - mRingHead + size;
+        } else {
+            aligned = 0;
+            consumed = (uint64) mRingSize - mRingHead + size;
+        }
+
+        if (mRingUsed + consumed > mRingSize)
+            return false;
+
+        offset = (uint32) aligned;
+
+        mRingHead = offset + size;
+        mRingUsed += consumed;
+        mRecordingRingUsed += consumed;
+
+        return true;
+    }
+
+    void VulkanUploadManager::createRing(uint32 size) {
+        VulkanUtils::createBuffer(size,
+                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                  mRing, mRingAllocation);
+
+        void *mapped;
+        auto result = vmaMapMemory(mContext.vmAllocator, mRingAllocation.vmaAllocation, &mapped);
+        VK_RESULT_ASSERT(result, "Failed to map staging ring memory");
+
+        mRingMapped = (uint8*) mapped;
+        mRingSize = size;
+        mRingHead = 0;
+        mRingUsed = 0;
+    }
+
+    void VulkanUploadManager::destroyRing() {
+        vmaUnmapMemory(mContext.vmAllocator, mRingAllocation.vmaAllocation);
+        VulkanUtils::destroyBuffer(mRing, mRingAllocation);
+
+        mRing = VK_NULL_HANDLE;
+        mRingMapped = nullptr;
+    }
+
+} // namespace ignimbrite
@@ -0,0 +1,119 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_VULKANUPLOADMANAGER_H
+#define IGNIMBRITE_VULKANUPLOADMANAGER_H
+
+#include <VulkanObjects.h>
+#include <VulkanFence.h>
+#include <VulkanSemaphore.h>
+#include <vector>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Batched uploads through persistent staging ring
+     *
+     * Data is written into the host visible staging ring and copy commands
+     * are recorded into the current batch, therefore uploads return immediately.
+     * Batch is submitted to the transfer queue (copies) and to the graphics queue
+     * (queue ownership acquire, mipmaps generation and layout transitions),
+     * which waits for the transfer part with semaphore.
+     *
+     * Uploaded resources could be used by any commands, submitted to the graphics
+     * queue after the batch. Each batch has value, which grows with submissions,
+     * and is completed, when its fence is signaled (staging memory is reused then).
+     */
+    class VulkanUploadManager {
+    public:
+        static const uint32 STAGING_RING_SIZE = 8 * 1024 * 1024;
+        static const uint32 BATCHES_COUNT = 4;
+
+        VulkanUploadManager();
+        ~VulkanUploadManager();
+
+        /** Copy data into new device local buffer (must be created with transfer destination usage) */
+        void uploadBuffer(VkBuffer buffer, uint32 size, const void *data);
+
+        /** Copy data into region of the buffer, which could be used by previously submitted commands */
+        void updateBuffer(VkBuffer buffer, uint32 size, uint32 offset, const void *data);
+
+        /**
+         * Copy data into new image (all mip levels and layers) and transition it into final layout.
+         * Layers data is tightly packed with layerSize stride, mipmaps are generated if mipLevels > 1.
+         */
+        void uploadImage(VkImage image, VkFormat format, uint32 texelSize,
+                         uint32 width, uint32 height, uint32 depth,
+                         uint32 mipLevels, uint32 layersCount, uint32 layerSize,
+                         uint32 dataSize, const void *data, VkImageLayout finalLayout);
+
+        /** Submit recorded uploads (commands submitted to the graphics queue after see uploaded data) */
+        void submit();
+        /** Submit recorded uploads and wait for all the batches */
+        void waitIdle();
+
+        /** @return Value of the last submitted batch (recorded uploads are completed with the next value) */
+        uint64 getSubmittedValue() const { return mSubmittedValue; }
+        /** @return Value of the last completed batch */
+        uint64 getCompletedValue();
+        uint64 getUploadedBytes() const { return mUploadedBytes; }
+        uint32 getStagingSize() const { return mRingSize; }
+
+    private:
+
+        struct Batch {
+            VulkanFence fence;
+            /** Signaled by transfer part, waited by graphics part of the batch */
+            VulkanSemaphore semaphore;
+            VkCommandPool transferPool = VK_NULL_HANDLE;
+            VkCommandPool graphicsPool = VK_NULL_HANDLE;
+            VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+            VkCommandBuffer graphicsCommands = VK_NULL_HANDLE;
+            /** Staging ring memory, used by the batch (including alignment padding) */
+            uint64 ringUsed = 0;
+            uint64 value = 0;
+            bool recording = false;
+            bool inFlight = false;
+        };
+
+        /** @return Current batch in recording state */
+        Batch &beginBatch();
+        /** Wait for the batch and release its staging memory */
+        void retireBatch(Batch &batch);
+        /** Wait for the oldest batch in flight, @return False if no batches in flight */
+        bool retireOldestBatch();
+
+        /** Allocate staging memory (could submit current batch and wait for previous) and copy data */
+        uint32 writeStaging(uint32 size, uint32 alignment, const void *data);
+        bool tryAllocateStaging(uint32 size, uint32 alignment, uint32 &offset);
+        void createRing(uint32 size);
+        void destroyRing();
+
+        VulkanContext &mContext = VulkanContext::getInstance();
+
+        std::vector<Batch> mBatches;
+        uint32 mCurrentBatch = 0;
+        uint64 mSubmittedValue = 0;
+        uint64 mCompletedValue = 0;
+        uint64 mUploadedBytes = 0;
+
+        VkBuffer mRing = VK_NULL_HANDLE;
+        VulkanAllocation mRingAllocation = {};
+        uint8* mRingMapped = nullptr;
+        uint32 mRingSize = 0;
+        /** Ring is used from the oldest batch in flight up to the head offset */
+        uint32 mRingHead = 0;
+        uint64 mRingUsed = 0;
+        /** Memory of the current batch */
+        uint64 mRecordingRingUsed = 0;
+    };
+
+} // namespace ignimbrite
+
+#endif //IGNIMBRITE_VULKANUPLOADMANAGER_H
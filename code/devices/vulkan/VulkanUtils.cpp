@@ -448,14 +448,20 @@ namespace ignimbrite {
                                  uint32 mipLevels, uint32 layerCount, VkImageLayout newLayout) {
         auto& context = VulkanContext::getInstance();
 
+        VkCommandBuffer commandBuffer = beginTmpCommandBuffer(context.transferTmpCommandPool);
+        cmdGenerateMipmaps(commandBuffer, image, format, width, height, mipLevels, layerCount, newLayout);
+        endTmpCommandBuffer(commandBuffer, context.transferQueue, context.transferTmpCommandPool);
+    }
+
+    void VulkanUtils::cmdGenerateMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat format,
+                                         uint32 width, uint32 height,
+                                         uint32 mipLevels, uint32 layerCount, VkImageLayout newLayout) {
         VkFormatProperties formatProperties = getDeviceFormatProperties(format);
 
         if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
             throw VulkanException("Failed to generate mipmaps as specified format doesn't support linear blitting");
         }
 
-        VkCommandBuffer commandBuffer = beginTmpCommandBuffer(context.transferTmpCommandPool);
-
         for (uint32 layer = 0; layer < layerCount; layer++) {
 
             VkImageMemoryBarrier barrier = {};
@@ -549,8 +555,6 @@ namespace ignimbrite {
                     1, &barrier
             );
         }
-
-        endTmpCommandBuffer(commandBuffer, context.transferQueue, context.transferTmpCommandPool);
     }
 
     void VulkanUtils::createDepthStencilBuffer(uint32 width, uint32 height, uint32 depth,
@@ -641,8 +645,8 @@ namespace ignimbrite {
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = 1;
         pipelineLayoutInfo.pSetLayouts = &uniformLayout.properties.layout;
-        pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-        pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+        pipelineLayoutInfo.pushConstantRangeCount = (uint32) uniformLayout.pushConstantRanges.size();
+        pipelineLayoutInfo.pPushConstantRanges = uniformLayout.pushConstantRanges.data();
 
         result = vkCreatePipelineLayout(context.device, &pipelineLayoutInfo, nullptr, &pipelineLayout);
         VK_RESULT_ASSERT(result, "Failed to create pipeline layout");
@@ -748,11 +752,18 @@ namespace ignimbrite {
     }
 
     VkCommandBuffer VulkanUtils::beginTmpCommandBuffer(VkCommandPool commandPool) {
+        VkCommandBuffer commandBuffer = allocateCommandBuffer(commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        beginCommandBuffer(commandBuffer);
+
+        return commandBuffer;
+    }
+
+    VkCommandBuffer VulkanUtils::allocateCommandBuffer(VkCommandPool commandPool, VkCommandBufferLevel level) {
         auto& context = VulkanContext::getInstance();
 
         VkCommandBufferAllocateInfo allocInfo = {};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.level = level;
         allocInfo.commandPool = commandPool;
         allocInfo.commandBufferCount = 1;
 
@@ -760,14 +771,39 @@ namespace ignimbrite {
         VkResult result = vkAllocateCommandBuffers(context.device, &allocInfo, &commandBuffer);
         VK_RESULT_ASSERT(result, "Failed to allocate command buffer");
 
+        return commandBuffer;
+    }
+
+    void VulkanUtils::beginCommandBuffer(VkCommandBuffer commandBuffer) {
         VkCommandBufferBeginInfo beginInfo = {};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-        result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
         VK_RESULT_ASSERT(result, "Failed to begin command buffer");
+    }
 
-        return commandBuffer;
+    void VulkanUtils::beginSecondaryCommandBuffer(VkCommandBuffer commandBuffer, VkRenderPass renderPass,
+                                                  VkFramebuffer framebuffer, bool reusable) {
+        VkCommandBufferInheritanceInfo inheritanceInfo = {};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = framebuffer;
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        // Reusable buffer could be executed by several pending primary buffers
+        if (reusable)
+            beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+        else
+            beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        VK_RESULT_ASSERT(result, "Failed to begin secondary command buffer");
     }
 
     void VulkanUtils::endTmpCommandBuffer(VkCommandBuffer commandBuffer,
@@ -125,6 +125,15 @@ namespace ignimbrite {
                 VkImageLayout newLayout
         );
 
+        /** Record mipmaps generation, image mip levels must be in transfer destination layout */
+        static void cmdGenerateMipmaps(
+                VkCommandBuffer commandBuffer,
+                VkImage image, VkFormat format,
+                uint32 width, uint32 height,
+                uint32 mipLevels, uint32 layerCount,
+                VkImageLayout newLayout
+        );
+
         static void createDepthStencilBuffer(
                 uint32 width, uint32 height, uint32 depth,
                 VkImageType imageType, VkFormat format, VkImage &outImage,
@@ -198,6 +207,24 @@ namespace ignimbrite {
                 VkCommandPool commandPool
         );
 
+        static VkCommandBuffer allocateCommandBuffer(
+                VkCommandPool commandPool,
+                VkCommandBufferLevel level
+        );
+
+        /** Begin primary command buffer for single time submit */
+        static void beginCommandBuffer(
+                VkCommandBuffer commandBuffer
+        );
+
+        /** Begin secondary command buffer, which continues render pass (single time submit if not reusable) */
+        static void beginSecondaryCommandBuffer(
+                VkCommandBuffer commandBuffer,
+                VkRenderPass renderPass,
+                VkFramebuffer framebuffer,
+                bool reusable
+        );
+
         static void endTmpCommandBuffer(
                 VkCommandBuffer commandBuffer,
                 VkQueue queue,
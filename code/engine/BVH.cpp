@@ -0,0 +1,353 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <BVH.h>
+#include <limits>
+
+namespace ignimbrite {
+
+    static AABB mergeBounds(const AABB &a, const AABB &b) {
+        return AABB(glm::min(a.getMinBounds(), b.getMinBounds()), glm::max(a.getMaxBounds(), b.getMaxBounds()));
+    }
+
+    static float32 surfaceArea(const AABB &a) {
+        glm::vec3 d = a.getMaxBounds() - a.getMinBounds();
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    static bool equalBounds(const AABB &a, const AABB &b) {
+        return a.getMinBounds() == b.getMinBounds() && a.getMaxBounds() == b.getMaxBounds();
+    }
+
+    void BVH::build(const std::vector<uint32> &ids, const std::vector<AABB> &bounds) {
+        if (ids.size() != bounds.size())
+            throw std::runtime_error("Items ids and bounds count mismatch");
+
+        clear();
+
+        auto count = (uint32) ids.size();
+
+        if (count == 0)
+            return;
+
+        // Build operates on the items order, which is finally applied to the items data
+        std::vector<glm::vec3> centroids(count);
+        std::vector<uint32> order(count);
+
+        for (uint32 i = 0; i < count; i++) {
+            centroids[i] = bounds[i].getCenter();
+            order[i] = i;
+        }
+
+        mItemIDs = std::move(order);
+        mNodes.reserve(2 * (count / MAX_LEAF_SIZE + 1));
+        buildNode(INVALID_INDEX, 0, count, bounds, centroids);
+
+        // Now mItemIDs stores items permutation, replace it with actual ids
+        mItemLeaf.resize(count);
+        mPackedBounds.resize(count * 6);
+        mItemBounds.resize(count);
+
+        for (uint32 i = 0; i < count; i++) {
+            auto source = mItemIDs[i];
+            mItemIDs[i] = ids[source];
+            packItem(i, bounds[source]);
+        }
+
+        for (uint32 n = 0; n < mNodes.size(); n++) {
+            const auto& node = mNodes[n];
+
+            if (node.isLeaf()) {
+                for (uint32 i = node.first; i < node.first + node.count; i++) {
+                    mItemLeaf[i] = n;
+                }
+            }
+        }
+    }
+
+    void BVH::refit(uint32 itemIndex, const AABB &bounds) {
+        if (itemIndex >= getItemsCount())
+            throw std::runtime_error("Invalid BVH item index");
+
+        packItem(itemIndex, bounds);
+
+        auto nodeIndex = mItemLeaf[itemIndex];
+
+        while (nodeIndex != INVALID_INDEX) {
+            auto& node = mNodes[nodeIndex];
+            AABB refitted;
+
+            if (node.isLeaf()) {
+                refitted = mItemBounds[node.first];
+                for (uint32 i = node.first + 1; i < node.first + node.count; i++) {
+                    refitted = mergeBounds(refitted, mItemBounds[i]);
+                }
+            } else {
+                refitted = mergeBounds(mNodes[node.left].bounds, mNodes[node.right].bounds);
+            }
+
+            // Nodes above are not affected
+            if (equalBounds(refitted, node.bounds))
+                break;
+
+            node.bounds = refitted;
+            nodeIndex = node.parent;
+        }
+    }
+
+    void BVH::query(const Frustum &frustum, std::vector<uint32> &result) const {
+        if (mNodes.empty())
+            return;
+
+        mStack.clear();
+        mStack.push_back(0);
+
+        while (!mStack.empty()) {
+            const auto& node = mNodes[mStack.back()];
+            mStack.pop_back();
+
+            auto visibility = frustum.classify(node.bounds);
+
+            if (visibility == Frustum::Visibility::Outside)
+                continue;
+
+            // Accept the whole subtree without per-item tests
+            if (visibility == Frustum::Visibility::Inside) {
+                result.insert(result.end(), mItemIDs.begin() + node.first, mItemIDs.begin() + node.first + node.count);
+                continue;
+            }
+
+            if (node.isLeaf()) {
+                mMask.resize(node.count);
+                frustum.isInside(getPackedBoxes(node.first, node.count), mMask.data());
+
+                for (uint32 i = 0; i < node.count; i++) {
+                    if (mMask[i])
+                        result.push_back(mItemIDs[node.first + i]);
+                }
+            } else {
+                mStack.push_back(node.right);
+                mStack.push_back(node.left);
+            }
+        }
+    }
+
+    void BVH::query(const Frustum *frusta, uint32 count, std::vector<uint32> &ids, std::vector<uint32> &masks) const {
+        if (mNodes.empty() || count == 0)
+            return;
+
+        Frustum::PackedFrusta packed;
+        Frustum::pack(frusta, count, packed);
+
+        // Stack holds triples: node, frusta to test, frusta which contain the node
+        mStack.clear();
+        mStack.push_back(0);
+        mStack.push_back(count == 32 ? 0xffffffff : (1u << count) - 1);
+        mStack.push_back(0);
+
+        while (!mStack.empty()) {
+            auto inside = mStack.back(); mStack.pop_back();
+            auto active = mStack.back(); mStack.pop_back();
+            const auto& node = mNodes[mStack.back()];
+            mStack.pop_back();
+
+            Frustum::classify(packed, node.bounds, active, inside);
+
+            if (active == 0 && inside == 0)
+                continue;
+
+            // Node is inside or outside of each frustum
+            if (active == 0) {
+                ids.insert(ids.end(), mItemIDs.begin() + node.first, mItemIDs.begin() + node.first + node.count);
+                masks.insert(masks.end(), node.count, inside);
+                continue;
+            }
+
+            if (node.isLeaf()) {
+                mViewMasks.assign(node.count, inside);
+                Frustum::isInside(packed, active, getPackedBoxes(node.first, node.count), mViewMasks.data());
+
+                for (uint32 i = 0; i < node.count; i++) {
+                    if (mViewMasks[i]) {
+                        ids.push_back(mItemIDs[node.first + i]);
+                        masks.push_back(mViewMasks[i]);
+                    }
+                }
+            } else {
+                mStack.push_back(node.right);
+                mStack.push_back(active);
+                mStack.push_back(inside);
+                mStack.push_back(node.left);
+                mStack.push_back(active);
+                mStack.push_back(inside);
+            }
+        }
+    }
+
+    void BVH::clear() {
+        mNodes.clear();
+        mItemIDs.clear();
+        mItemLeaf.clear();
+        mItemBounds.clear();
+        mPackedBounds.clear();
+    }
+
+    AABB BVH::getBounds() const {
+        return mNodes.empty() ? AABB() : mNodes.front().bounds;
+    }
+
+    uint32 BVH::buildNode(uint32 parent, uint32 first, uint32 count, const std::vector<AABB> &bounds, const std::vector<glm::vec3> &centroids) {
+        auto nodeIndex = (uint32) mNodes.size();
+        mNodes.emplace_back();
+
+        auto* order = mItemIDs.data();
+
+        AABB nodeBounds = bounds[order[first]];
+        AABB centroidBounds(centroids[order[first]], centroids[order[first]]);
+
+        for (uint32 i = first + 1; i < first + count; i++) {
+            nodeBounds = mergeBounds(nodeBounds, bounds[order[i]]);
+            centroidBounds.expandToContain(centroids[order[i]]);
+        }
+
+        mNodes[nodeIndex].bounds = nodeBounds;
+        mNodes[nodeIndex].parent = parent;
+        mNodes[nodeIndex].first = first;
+        mNodes[nodeIndex].count = count;
+
+        if (count == 1)
+            return nodeIndex;
+
+        // Find best split with binned surface area heuristic
+
+        struct Bin {
+            AABB bounds;
+            uint32 count = 0;
+        };
+
+        float32 bestCost = std::numeric_limits<float32>::max();
+        uint32 bestAxis = 0;
+        uint32 bestSplit = 0;
+
+        glm::vec3 cmin = centroidBounds.getMinBounds();
+        glm::vec3 cext = centroidBounds.getMaxBounds() - cmin;
+
+        for (uint32 axis = 0; axis < 3; axis++) {
+            if (cext[axis] <= 0.0f)
+                continue;
+
+            Bin bins[BINS_COUNT];
+            float32 scale = (float32) BINS_COUNT / cext[axis];
+
+            for (uint32 i = first; i < first + count; i++) {
+                auto bin = std::min((uint32) ((centroids[order[i]][axis] - cmin[axis]) * scale), BINS_COUNT - 1);
+                bins[bin].bounds = bins[bin].count ? mergeBounds(bins[bin].bounds, bounds[order[i]]) : bounds[order[i]];
+                bins[bin].count += 1;
+            }
+
+            // Sweep from the right to get right side costs, then from the left
+            float32 rightArea[BINS_COUNT];
+            uint32 rightCount[BINS_COUNT];
+            AABB accumulated;
+            uint32 accumulatedCount = 0;
+
+            for (uint32 b = BINS_COUNT - 1; b > 0; b--) {
+                if (bins[b].count) {
+                    accumulated = accumulatedCount ? mergeBounds(accumulated, bins[b].bounds) : bins[b].bounds;
+                    accumulatedCount += bins[b].count;
+                }
+
+                rightArea[b] = accumulatedCount ? surfaceArea(accumulated) : 0.0f;
+                rightCount[b] = accumulatedCount;
+            }
+
+            accumulatedCount = 0;
+
+            for (uint32 b = 0; b < BINS_COUNT - 1; b++) {
+                if (bins[b].count) {
+                    accumulated = accumulatedCount ? mergeBounds(accumulated, bins[b].bounds) : bins[b].bounds;
+                    accumulatedCount += bins[b].count;
+                }
+
+                // Split is between b and b + 1
+                if (accumulatedCount == 0 || rightCount[b + 1] == 0)
+                    continue;
+
+                float32 cost = surfaceArea(accumulated) * (float32) accumulatedCount + rightArea[b + 1] * (float32) rightCount[b + 1];
+
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+
+        float32 leafCost = surfaceArea(nodeBounds) * (float32) count;
+        uint32 mid;
+
+        if (bestCost < std::numeric_limits<float32>::max()) {
+            // Keep as leaf, if split is not profitable
+            if (count <= MAX_LEAF_SIZE && bestCost >= leafCost)
+                return nodeIndex;
+
+            float32 scale = (float32) BINS_COUNT / cext[bestAxis];
+            auto middle = std::partition(order + first, order + first + count, [&](uint32 item) {
+                auto bin = std::min((uint32) ((centroids[item][bestAxis] - cmin[bestAxis]) * scale), BINS_COUNT - 1);
+                return bin < bestSplit;
+            });
+
+            mid = (uint32) (middle - order);
+        } else {
+            // All centroids are the same
+            if (count <= MAX_LEAF_SIZE)
+                return nodeIndex;
+
+            mid = first + count / 2;
+        }
+
+        auto left = buildNode(nodeIndex, first, mid - first, bounds, centroids);
+        auto right = buildNode(nodeIndex, mid, first + count - mid, bounds, centroids);
+
+        mNodes[nodeIndex].left = left;
+        mNodes[nodeIndex].right = right;
+
+        return nodeIndex;
+    }
+
+    void BVH::packItem(uint32 itemIndex, const AABB &bounds) {
+        auto count = getItemsCount();
+        auto center = bounds.getCenter();
+        auto extent = bounds.getExtent();
+
+        for (uint32 k = 0; k < 3; k++) {
+            mPackedBounds[(0 + k) * count + itemIndex] = center[k];
+            mPackedBounds[(3 + k) * count + itemIndex] = extent[k];
+        }
+
+        mItemBounds[itemIndex] = bounds;
+    }
+
+    Frustum::PackedBoxes BVH::getPackedBoxes(uint32 first, uint32 count) const {
+        auto itemsCount = getItemsCount();
+        const float32* packed = mPackedBounds.data();
+
+        Frustum::PackedBoxes boxes;
+        boxes.centerX = packed + 0 * itemsCount + first;
+        boxes.centerY = packed + 1 * itemsCount + first;
+        boxes.centerZ = packed + 2 * itemsCount + first;
+        boxes.extentX = packed + 3 * itemsCount + first;
+        boxes.extentY = packed + 4 * itemsCount + first;
+        boxes.extentZ = packed + 5 * itemsCount + first;
+        boxes.count = count;
+
+        return boxes;
+    }
+
+}
@@ -0,0 +1,98 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_BVH_H
+#define IGNIMBRITE_BVH_H
+
+#include <IncludeStd.h>
+#include <Frustum.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Bounding volume hierarchy for static objects
+     *
+     * Built once for the set of items (ids with bounds) with surface area heuristic.
+     * Items of each node are stored contiguously, therefore nodes, which are
+     * completely inside the frustum, are accepted without per-item tests.
+     * Bounds of items are stored packed for batched frustum tests of leaves.
+     *
+     * Item bounds could be updated with refit: affected nodes are enlarged or shrunk
+     * without changing the tree topology.
+     */
+    class BVH {
+    public:
+        static const uint32 INVALID_INDEX = 0xffffffff;
+        /** Max number of items in leaf node */
+        static const uint32 MAX_LEAF_SIZE = 8;
+        /** Number of bins for SAH evaluation */
+        static const uint32 BINS_COUNT = 16;
+
+        /** Build tree for specified items (previous content is released) */
+        void build(const std::vector<uint32> &ids, const std::vector<AABB> &bounds);
+
+        /** Update bounds of the item and refit affected nodes */
+        void refit(uint32 itemIndex, const AABB &bounds);
+
+        /** Append ids of items inside or intersecting frustum (uses internal tmp buffers, not thread-safe) */
+        void query(const Frustum &frustum, std::vector<uint32> &result) const;
+
+        /**
+         * Append ids of items inside or intersecting at least one of the frusta (up to 32)
+         * and for each item the mask of frusta (bit i for frusta[i]), which see it.
+         * Tree is traversed once for all the frusta (uses internal tmp buffers, not thread-safe).
+         */
+        void query(const Frustum* frusta, uint32 count, std::vector<uint32> &ids, std::vector<uint32> &masks) const;
+
+        void clear();
+
+        /** @return Number of items in the tree */
+        uint32 getItemsCount() const { return (uint32) mItemIDs.size(); }
+        /** @return Id of the item in the tree */
+        uint32 getItemID(uint32 itemIndex) const { return mItemIDs[itemIndex]; }
+        /** @return Bounds of the whole tree */
+        AABB getBounds() const;
+
+    private:
+
+        struct Node {
+            AABB bounds;
+            uint32 parent = INVALID_INDEX;
+            /** Child nodes (for leaf nodes are invalid) */
+            uint32 left = INVALID_INDEX;
+            uint32 right = INVALID_INDEX;
+            /** Items range of this node subtree */
+            uint32 first = 0;
+            uint32 count = 0;
+
+            bool isLeaf() const { return left == INVALID_INDEX; }
+        };
+
+        uint32 buildNode(uint32 parent, uint32 first, uint32 count, const std::vector<AABB> &bounds, const std::vector<glm::vec3> &centroids);
+        void packItem(uint32 itemIndex, const AABB &bounds);
+        Frustum::PackedBoxes getPackedBoxes(uint32 first, uint32 count) const;
+
+        std::vector<Node> mNodes;
+        /** Ids of items in the tree order */
+        std::vector<uint32> mItemIDs;
+        /** Leaf node of each item */
+        std::vector<uint32> mItemLeaf;
+        /** Bounds of items in the tree order */
+        std::vector<AABB> mItemBounds;
+        /** Centers and extents of items in the tree order (structure of arrays) */
+        std::vector<float32> mPackedBounds;
+        /** Tmp buffers for queries */
+        mutable std::vector<uint32> mStack;
+        mutable std::vector<uint8> mMask;
+        mutable std::vector<uint32> mViewMasks;
+    };
+
+}
+
+#endif //IGNIMBRITE_BVH_H
@@ -0,0 +1,66 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <CachedDrawList.h>
+
+namespace ignimbrite {
+
+    CachedDrawList::CachedDrawList(RefCounted<IRenderDevice> device)
+        : mExecuteList(1), mDevice(std::move(device)) {
+
+        if (mDevice == nullptr)
+            throw std::runtime_error("An attempt to create cached draw list with null device");
+    }
+
+    CachedDrawList::~CachedDrawList() {
+        invalidate();
+    }
+
+    bool CachedDrawList::isValid() const {
+        const auto &entry = getEntry();
+        return entry.drawList.isNotNull() && entry.key == mNextKey;
+    }
+
+    void CachedDrawList::beginRecording() {
+        mDevice->drawListBeginSecondary(0, true);
+    }
+
+    void CachedDrawList::endRecording() {
+        auto drawList = mDevice->drawListEndSecondary();
+        auto &entry = getEntry();
+
+        if (entry.drawList.isNotNull())
+            mDevice->destroyDrawList(entry.drawList);
+
+        entry.drawList = drawList;
+        entry.key.swap(mNextKey);
+    }
+
+    void CachedDrawList::execute() {
+        const auto &entry = getEntry();
+
+        if (entry.drawList.isNull())
+            throw std::runtime_error("An attempt to execute not recorded draw list");
+
+        mExecuteList[0] = entry.drawList;
+        mDevice->drawListExecute(mExecuteList);
+    }
+
+    void CachedDrawList::invalidate() {
+        for (auto &entry: mEntries) {
+            if (entry.drawList.isNotNull()) {
+                mDevice->destroyDrawList(entry.drawList);
+                entry.drawList = ID<IRenderDevice::DrawList>();
+            }
+
+            entry.key.clear();
+        }
+    }
+
+}
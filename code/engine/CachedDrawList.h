@@ -0,0 +1,77 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_CACHEDDRAWLIST_H
+#define IGNIMBRITE_CACHEDDRAWLIST_H
+
+#include <IRenderDevice.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Reusable secondary draw list with the key of its content
+     *
+     * Key is a sequence of values (objects, materials binding versions,
+     * buffers, target framebuffer), which define recorded commands.
+     * Each frame key is built anew: if it is the same as the key of the
+     * recorded list, list is executed as is, otherwise it is re-recorded.
+     *
+     * List is recorded on the calling thread (thread index 0 of the device).
+     * Each frame in flight slot has own list, since lists bind per frame
+     * copies of the dynamic device buffers.
+     */
+    class CachedDrawList {
+    public:
+
+        explicit CachedDrawList(RefCounted<IRenderDevice> device);
+        ~CachedDrawList();
+
+        /** Start building the key of the list content for current frame */
+        void beginKey() { mNextKey.clear(); }
+
+        void addKey(uint64 value) { mNextKey.push_back(value); }
+        void addKey(const void* pointer) { mNextKey.push_back((uint64) (size_t) pointer); }
+
+        template <typename T>
+        void addKey(const ID<T> &id) { mNextKey.push_back(((uint64) id.getIndex() << 32u) | id.getGeneration()); }
+
+        /** @return True if recorded list of the current frame slot matches built key and could be executed without recording */
+        bool isValid() const;
+
+        /** Begin recording of the list for built key (drawList commands go to this list) */
+        void beginRecording();
+        /** End recording, previous list of the frame slot is destroyed */
+        void endRecording();
+
+        /** Execute list in the framebuffer, bound to the primary draw list */
+        void execute();
+
+        /** Destroy recorded lists (they will be recorded on next use) */
+        void invalidate();
+
+    private:
+
+        struct Entry {
+            std::vector<uint64> key;
+            ID<IRenderDevice::DrawList> drawList;
+        };
+
+        Entry &getEntry() { return mEntries[mDevice->getFrameIndex()]; }
+        const Entry &getEntry() const { return mEntries[mDevice->getFrameIndex()]; }
+
+        Entry mEntries[IRenderDevice::MAX_FRAMES_IN_FLIGHT];
+        std::vector<uint64> mNextKey;
+        /** Single list to execute (avoids allocations) */
+        std::vector<ID<IRenderDevice::DrawList>> mExecuteList;
+        RefCounted<IRenderDevice> mDevice;
+    };
+
+}
+
+#endif //IGNIMBRITE_CACHEDDRAWLIST_H
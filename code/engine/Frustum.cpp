@@ -0,0 +1,422 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <Frustum.h>
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define IGNIMBRITE_FRUSTUM_AVX
+#elif defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define IGNIMBRITE_FRUSTUM_SSE
+#endif
+
+namespace ignimbrite {
+
+    const uint32 Frustum::MAX_PACKED_FRUSTA;
+
+    void Frustum::isInside(const PackedBoxes &boxes, uint8 *mask) const {
+        testPackedBoxes(boxes, mask, true);
+    }
+
+    void Frustum::classify(const PackedBoxes &boxes, Visibility *result) const {
+        testPackedBoxes(boxes, reinterpret_cast<uint8*>(result), false);
+    }
+
+    void Frustum::pack(const Frustum *frusta, uint32 count, PackedFrusta &packed) {
+        const uint32 size = MAX_PACKED_FRUSTA * 6;
+
+        // Zero planes of unused slots never reject boxes, these slots are excluded by active masks
+        std::fill(packed.normalX, packed.normalX + size, 0.0f);
+        std::fill(packed.normalY, packed.normalY + size, 0.0f);
+        std::fill(packed.normalZ, packed.normalZ + size, 0.0f);
+        std::fill(packed.d, packed.d + size, 0.0f);
+        std::fill(packed.absNormalX, packed.absNormalX + size, 0.0f);
+        std::fill(packed.absNormalY, packed.absNormalY + size, 0.0f);
+        std::fill(packed.absNormalZ, packed.absNormalZ + size, 0.0f);
+
+        packed.count = std::min(count, MAX_PACKED_FRUSTA);
+
+        for (uint32 i = 0; i < packed.count; i++) {
+            for (uint32 p = 0; p < 6; p++) {
+                const auto& plane = frusta[i].planes[p];
+                auto index = ((i / 4) * 6 + p) * 4 + i % 4;
+
+                packed.normalX[index] = plane.normal.x;
+                packed.normalY[index] = plane.normal.y;
+                packed.normalZ[index] = plane.normal.z;
+                packed.d[index] = plane.d;
+                packed.absNormalX[index] = glm::abs(plane.normal.x);
+                packed.absNormalY[index] = glm::abs(plane.normal.y);
+                packed.absNormalZ[index] = glm::abs(plane.normal.z);
+            }
+        }
+    }
+
+    void Frustum::classify(const PackedFrusta &frusta, const AABB &aabb, uint32 &active, uint32 &inside) {
+        auto c = aabb.getCenter();
+        auto e = aabb.getExtent();
+
+        // Box is tested against the same plane of 4 frusta at once.
+        // Operations order is the same as in scalar classify, therefore results are bit-exact
+
+#if defined(IGNIMBRITE_FRUSTUM_AVX) || defined(IGNIMBRITE_FRUSTUM_SSE)
+        const __m128 cx = _mm_set1_ps(c.x);
+        const __m128 cy = _mm_set1_ps(c.y);
+        const __m128 cz = _mm_set1_ps(c.z);
+        const __m128 ex = _mm_set1_ps(e.x);
+        const __m128 ey = _mm_set1_ps(e.y);
+        const __m128 ez = _mm_set1_ps(e.z);
+        const __m128 zero = _mm_setzero_ps();
+#endif
+
+        for (uint32 group = 0; group * 4 < frusta.count; group++) {
+            auto groupActive = (active >> (group * 4)) & 0xfu;
+
+            if (groupActive == 0)
+                continue;
+
+            uint32 outsideBits = 0;
+            uint32 partialBits = 0;
+
+#if defined(IGNIMBRITE_FRUSTUM_AVX) || defined(IGNIMBRITE_FRUSTUM_SSE)
+            __m128 outside = zero;
+            __m128 partial = zero;
+
+            for (uint32 p = 0; p < 6; p++) {
+                auto index = (group * 6 + p) * 4;
+
+                __m128 s = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                        _mm_mul_ps(_mm_loadu_ps(frusta.normalX + index), cx),
+                        _mm_mul_ps(_mm_loadu_ps(frusta.normalY + index), cy)),
+                        _mm_mul_ps(_mm_loadu_ps(frusta.normalZ + index), cz)),
+                        _mm_loadu_ps(frusta.d + index));
+                __m128 r = _mm_add_ps(_mm_add_ps(
+                        _mm_mul_ps(ex, _mm_loadu_ps(frusta.absNormalX + index)),
+                        _mm_mul_ps(ey, _mm_loadu_ps(frusta.absNormalY + index))),
+                        _mm_mul_ps(ez, _mm_loadu_ps(frusta.absNormalZ + index)));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(s, _mm_sub_ps(zero, r)));
+                partial = _mm_or_ps(partial, _mm_cmplt_ps(s, r));
+
+                // Box is rejected by all the active frusta of the group
+                if ((groupActive & ~(uint32) _mm_movemask_ps(outside)) == 0)
+                    break;
+            }
+
+            outsideBits = (uint32) _mm_movemask_ps(outside);
+            partialBits = (uint32) _mm_movemask_ps(partial);
+#else
+            for (uint32 p = 0; p < 6; p++) {
+                for (uint32 k = 0; k < 4; k++) {
+                    auto index = (group * 6 + p) * 4 + k;
+
+                    float32 s = frusta.normalX[index] * c.x + frusta.normalY[index] * c.y + frusta.normalZ[index] * c.z + frusta.d[index];
+                    float32 r = e.x * frusta.absNormalX[index] + e.y * frusta.absNormalY[index] + e.z * frusta.absNormalZ[index];
+
+                    outsideBits |= (s < -r) ? 1u << k : 0u;
+                    partialBits |= (s < r) ? 1u << k : 0u;
+                }
+            }
+#endif
+
+            auto insideBits = groupActive & ~partialBits;
+            auto intersectingBits = groupActive & partialBits & ~outsideBits;
+
+            active = (active & ~(0xfu << (group * 4))) | (intersectingBits << (group * 4));
+            inside |= insideBits << (group * 4);
+        }
+    }
+
+    void Frustum::isInside(const PackedFrusta &frusta, uint32 active, const PackedBoxes &boxes, uint32 *masks) {
+        uint32 views[MAX_PACKED_FRUSTA];
+        uint32 viewsCount = 0;
+
+        while (active) {
+            auto view = getLowestBit(active);
+            active &= ~(1u << view);
+            views[viewsCount++] = view;
+        }
+
+        uint32 i = 0;
+
+        // Each group of boxes is loaded once and tested against all the planes of the active frusta.
+        // Operations order is the same as in testPackedBoxes, therefore results are bit-exact with single frustum tests
+
+#if defined(IGNIMBRITE_FRUSTUM_AVX)
+        const uint32 width = 8;
+        const __m256 zero = _mm256_setzero_ps();
+
+        for (; i + width <= boxes.count; i += width) {
+            __m256 cx = _mm256_loadu_ps(boxes.centerX + i);
+            __m256 cy = _mm256_loadu_ps(boxes.centerY + i);
+            __m256 cz = _mm256_loadu_ps(boxes.centerZ + i);
+            __m256 ex = _mm256_loadu_ps(boxes.extentX + i);
+            __m256 ey = _mm256_loadu_ps(boxes.extentY + i);
+            __m256 ez = _mm256_loadu_ps(boxes.extentZ + i);
+
+            for (uint32 v = 0; v < viewsCount; v++) {
+                __m256 outside = zero;
+
+                for (uint32 p = 0; p < 6; p++) {
+                    auto index = ((views[v] / 4) * 6 + p) * 4 + views[v] % 4;
+
+                    __m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                            _mm256_mul_ps(_mm256_set1_ps(frusta.normalX[index]), cx),
+                            _mm256_mul_ps(_mm256_set1_ps(frusta.normalY[index]), cy)),
+                            _mm256_mul_ps(_mm256_set1_ps(frusta.normalZ[index]), cz)),
+                            _mm256_set1_ps(frusta.d[index]));
+                    __m256 r = _mm256_add_ps(_mm256_add_ps(
+                            _mm256_mul_ps(ex, _mm256_set1_ps(frusta.absNormalX[index])),
+                            _mm256_mul_ps(ey, _mm256_set1_ps(frusta.absNormalY[index]))),
+                            _mm256_mul_ps(ez, _mm256_set1_ps(frusta.absNormalZ[index])));
+
+                    outside = _mm256_or_ps(outside, _mm256_cmp_ps(s, _mm256_sub_ps(zero, r), _CMP_LT_OQ));
+                }
+
+                auto visibleBits = ~(uint32) _mm256_movemask_ps(outside) & 0xffu;
+                auto bit = 1u << views[v];
+
+                while (visibleBits) {
+                    auto k = getLowestBit(visibleBits);
+                    visibleBits &= ~(1u << k);
+                    masks[i + k] |= bit;
+                }
+            }
+        }
+#elif defined(IGNIMBRITE_FRUSTUM_SSE)
+        const uint32 width = 4;
+        const __m128 zero = _mm_setzero_ps();
+
+        for (; i + width <= boxes.count; i += width) {
+            __m128 cx = _mm_loadu_ps(boxes.centerX + i);
+            __m128 cy = _mm_loadu_ps(boxes.centerY + i);
+            __m128 cz = _mm_loadu_ps(boxes.centerZ + i);
+            __m128 ex = _mm_loadu_ps(boxes.extentX + i);
+            __m128 ey = _mm_loadu_ps(boxes.extentY + i);
+            __m128 ez = _mm_loadu_ps(boxes.extentZ + i);
+
+            for (uint32 v = 0; v < viewsCount; v++) {
+                __m128 outside = zero;
+
+                for (uint32 p = 0; p < 6; p++) {
+                    auto index = ((views[v] / 4) * 6 + p) * 4 + views[v] % 4;
+
+                    __m128 s = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                            _mm_mul_ps(_mm_set1_ps(frusta.normalX[index]), cx),
+                            _mm_mul_ps(_mm_set1_ps(frusta.normalY[index]), cy)),
+                            _mm_mul_ps(_mm_set1_ps(frusta.normalZ[index]), cz)),
+                            _mm_set1_ps(frusta.d[index]));
+                    __m128 r = _mm_add_ps(_mm_add_ps(
+                            _mm_mul_ps(ex, _mm_set1_ps(frusta.absNormalX[index])),
+                            _mm_mul_ps(ey, _mm_set1_ps(frusta.absNormalY[index]))),
+                            _mm_mul_ps(ez, _mm_set1_ps(frusta.absNormalZ[index])));
+
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(s, _mm_sub_ps(zero, r)));
+                }
+
+                auto visibleBits = ~(uint32) _mm_movemask_ps(outside) & 0xfu;
+                auto bit = 1u << views[v];
+
+                while (visibleBits) {
+                    auto k = getLowestBit(visibleBits);
+                    visibleBits &= ~(1u << k);
+                    masks[i + k] |= bit;
+                }
+            }
+        }
+#endif
+
+        // Scalar fallback and remaining boxes
+        for (; i < boxes.count; i++) {
+            for (uint32 v = 0; v < viewsCount; v++) {
+                bool outside = false;
+
+                for (uint32 p = 0; p < 6; p++) {
+                    auto index = ((views[v] / 4) * 6 + p) * 4 + views[v] % 4;
+
+                    float32 s = frusta.normalX[index] * boxes.centerX[i] + frusta.normalY[index] * boxes.centerY[i] + frusta.normalZ[index] * boxes.centerZ[i] + frusta.d[index];
+                    float32 r = boxes.extentX[i] * frusta.absNormalX[index] + boxes.extentY[i] * frusta.absNormalY[index] + boxes.extentZ[i] * frusta.absNormalZ[index];
+
+                    outside = outside || (s < -r);
+                }
+
+                masks[i] |= outside ? 0u : 1u << views[v];
+            }
+        }
+    }
+
+    uint32 Frustum::getExtrudedPlanes(const glm::vec3 &direction, glm::vec4 *result) const {
+        struct Edge {
+            uint32 a, b;
+            uint32 p0, p1;
+        };
+
+        // Vertices 0..3 are near and 4..7 are far, each edge is shared by two planes
+        static const Edge edges[12] = {
+            { 0, 1, Near, Top }, { 1, 2, Near, Left }, { 2, 3, Near, Bottom }, { 3, 0, Near, Right },
+            { 4, 5, Far, Top },  { 5, 6, Far, Left },  { 6, 7, Far, Bottom },  { 7, 4, Far, Right },
+            { 0, 4, Top, Right }, { 1, 5, Top, Left }, { 2, 6, Bottom, Left }, { 3, 7, Bottom, Right }
+        };
+
+        glm::vec3 vertices[8];
+        glm::vec3 center(0.0f);
+
+        for (uint32 i = 0; i < 4; i++) {
+            vertices[i] = mNearVertices[i];
+            vertices[i + 4] = mFarVertices[i];
+            center += mNearVertices[i] + mFarVertices[i];
+        }
+
+        center *= 1.0f / 8.0f;
+
+        // Points moved against direction stay inside planes, which do not face the direction
+        bool kept[6];
+        uint32 count = 0;
+
+        for (uint32 i = 0; i < planes.size(); i++) {
+            kept[i] = glm::dot(planes[i].normal, direction) <= 0.0f;
+
+            if (kept[i])
+                result[count++] = glm::vec4(planes[i].normal, planes[i].d);
+        }
+
+        // Silhouette edges (between kept and dropped planes) are extruded along the direction
+        for (const auto& edge: edges) {
+            if (kept[edge.p0] == kept[edge.p1])
+                continue;
+
+            const auto& a = vertices[edge.a];
+            const auto& b = vertices[edge.b];
+            auto normal = glm::cross(b - a, direction);
+            auto length = glm::length(normal);
+
+            if (length < 1e-6f)
+                continue;
+
+            normal /= length;
+
+            if (glm::dot(normal, center - a) < 0.0f)
+                normal = -normal;
+
+            result[count++] = glm::vec4(normal, -glm::dot(normal, a));
+        }
+
+        return count;
+    }
+
+    void Frustum::testPackedBoxes(const PackedBoxes &boxes, uint8 *result, bool maskOnly) const {
+        const uint8 outsideValue = (uint8) Visibility::Outside;
+        const uint8 intersectingValue = maskOnly ? 1 : (uint8) Visibility::Intersecting;
+        const uint8 insideValue = maskOnly ? 1 : (uint8) Visibility::Inside;
+
+        uint32 i = 0;
+
+        // Note: operations order in vector paths is the same as in scalar glm::dot,
+        // therefore results are bit-exact with per-object tests
+
+#if defined(IGNIMBRITE_FRUSTUM_AVX)
+        const uint32 width = 8;
+        const __m256 zero = _mm256_setzero_ps();
+
+        for (; i + width <= boxes.count; i += width) {
+            __m256 cx = _mm256_loadu_ps(boxes.centerX + i);
+            __m256 cy = _mm256_loadu_ps(boxes.centerY + i);
+            __m256 cz = _mm256_loadu_ps(boxes.centerZ + i);
+            __m256 ex = _mm256_loadu_ps(boxes.extentX + i);
+            __m256 ey = _mm256_loadu_ps(boxes.extentY + i);
+            __m256 ez = _mm256_loadu_ps(boxes.extentZ + i);
+
+            __m256 outside = zero;
+            __m256 partial = zero;
+
+            for (const auto &p: planes) {
+                __m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                        _mm256_mul_ps(_mm256_set1_ps(p.normal.x), cx),
+                        _mm256_mul_ps(_mm256_set1_ps(p.normal.y), cy)),
+                        _mm256_mul_ps(_mm256_set1_ps(p.normal.z), cz)),
+                        _mm256_set1_ps(p.d));
+                __m256 r = _mm256_add_ps(_mm256_add_ps(
+                        _mm256_mul_ps(ex, _mm256_set1_ps(glm::abs(p.normal.x))),
+                        _mm256_mul_ps(ey, _mm256_set1_ps(glm::abs(p.normal.y)))),
+                        _mm256_mul_ps(ez, _mm256_set1_ps(glm::abs(p.normal.z))));
+
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(s, _mm256_sub_ps(zero, r), _CMP_LT_OQ));
+                partial = _mm256_or_ps(partial, _mm256_cmp_ps(s, r, _CMP_LT_OQ));
+            }
+
+            auto outsideBits = (uint32) _mm256_movemask_ps(outside);
+            auto partialBits = (uint32) _mm256_movemask_ps(partial);
+
+            for (uint32 k = 0; k < width; k++) {
+                result[i + k] = (outsideBits & (1u << k)) ? outsideValue :
+                                (partialBits & (1u << k)) ? intersectingValue : insideValue;
+            }
+        }
+#elif defined(IGNIMBRITE_FRUSTUM_SSE)
+        const uint32 width = 4;
+        const __m128 zero = _mm_setzero_ps();
+
+        for (; i + width <= boxes.count; i += width) {
+            __m128 cx = _mm_loadu_ps(boxes.centerX + i);
+            __m128 cy = _mm_loadu_ps(boxes.centerY + i);
+            __m128 cz = _mm_loadu_ps(boxes.centerZ + i);
+            __m128 ex = _mm_loadu_ps(boxes.extentX + i);
+            __m128 ey = _mm_loadu_ps(boxes.extentY + i);
+            __m128 ez = _mm_loadu_ps(boxes.extentZ + i);
+
+            __m128 outside = zero;
+            __m128 partial = zero;
+
+            for (const auto &p: planes) {
+                __m128 s = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                        _mm_mul_ps(_mm_set1_ps(p.normal.x), cx),
+                        _mm_mul_ps(_mm_set1_ps(p.normal.y), cy)),
+                        _mm_mul_ps(_mm_set1_ps(p.normal.z), cz)),
+                        _mm_set1_ps(p.d));
+                __m128 r = _mm_add_ps(_mm_add_ps(
+                        _mm_mul_ps(ex, _mm_set1_ps(glm::abs(p.normal.x))),
+                        _mm_mul_ps(ey, _mm_set1_ps(glm::abs(p.normal.y)))),
+                        _mm_mul_ps(ez, _mm_set1_ps(glm::abs(p.normal.z))));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(s, _mm_sub_ps(zero, r)));
+                partial = _mm_or_ps(partial, _mm_cmplt_ps(s, r));
+            }
+
+            auto outsideBits = (uint32) _mm_movemask_ps(outside);
+            auto partialBits = (uint32) _mm_movemask_ps(partial);
+
+            for (uint32 k = 0; k < width; k++) {
+                result[i + k] = (outsideBits & (1u << k)) ? outsideValue :
+                                (partialBits & (1u << k)) ? intersectingValue : insideValue;
+            }
+        }
+#endif
+
+        // Scalar fallback and remaining boxes
+        for (; i < boxes.count; i++) {
+            glm::vec3 c(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+            glm::vec3 e(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+
+            bool outside = false;
+            bool partial = false;
+
+            for (const auto &p: planes) {
+                float32 r = glm::dot(e, glm::abs(p.normal));
+                float32 s = p.planeDot(c);
+
+                outside = outside || (s < -r);
+                partial = partial || (s < r);
+            }
+
+            result[i] = outside ? outsideValue : (partial ? intersectingValue : insideValue);
+        }
+    }
+
+}
@@ -37,6 +37,30 @@ namespace ignimbrite {
     class Frustum {
     public:
 
+        /** Result of the volume test against the frustum */
+        enum class Visibility : uint8 {
+            /** Volume is completely outside */
+            Outside = 0,
+            /** Volume intersects the frustum boundary */
+            Intersecting = 1,
+            /** Volume is completely inside */
+            Inside = 2
+        };
+
+        /**
+         * Packed boxes in structure of arrays layout for batched tests.
+         * Each array must contain count elements.
+         */
+        struct PackedBoxes {
+            const float32* centerX = nullptr;
+            const float32* centerY = nullptr;
+            const float32* centerZ = nullptr;
+            const float32* extentX = nullptr;
+            const float32* extentY = nullptr;
+            const float32* extentZ = nullptr;
+            uint32 count = 0;
+        };
+
         /** Set vectors to define orientation */
         void setViewProperties(const glm::vec3 &forward, const glm::vec3 &up) {
             mUp = glm::normalize(up);
@@ -132,6 +156,109 @@ namespace ignimbrite {
             return true;
         }
 
+        /**
+         * Does this frustum contain or intersect specified AABB?
+         * Test starts from the plane planeHint, the index of the plane, which
+         * rejects the box, is written to planeHint (useful for coherent tests).
+         */
+        bool isInside(const AABB &aabb, uint32 &planeHint) const {
+            auto first = planeHint < planes.size() ? planeHint : 0;
+
+            for (uint32 i = 0; i < planes.size(); i++) {
+                auto index = (first + i) % (uint32) planes.size();
+
+                if (!planes[index].onPositiveSideOrIntersects(aabb)) {
+                    planeHint = index;
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /** @return Whether specified AABB is inside, outside or intersects this frustum */
+        Visibility classify(const AABB &aabb) const {
+            auto c = aabb.getCenter();
+            auto e = aabb.getExtent();
+            auto result = Visibility::Inside;
+
+            for (const auto &p: planes) {
+                float32 r = glm::dot(e, glm::abs(p.normal));
+                float32 s = p.planeDot(c);
+
+                if (s < -r)
+                    return Visibility::Outside;
+                if (s < r)
+                    result = Visibility::Intersecting;
+            }
+
+            return result;
+        }
+
+        /**
+         * Batched version of isInside for packed boxes.
+         * Writes 1 into mask for boxes inside or intersecting frustum and 0 for others.
+         * @note Results are exactly the same as for isInside call for each box
+         */
+        void isInside(const PackedBoxes &boxes, uint8* mask) const;
+
+        /** Batched version of classify for packed boxes */
+        void classify(const PackedBoxes &boxes, Visibility* result) const;
+
+        /** Max number of frusta, tested at once */
+        static const uint32 MAX_PACKED_FRUSTA = 32;
+
+        /**
+         * Planes of several frusta in structure of arrays layout for tests against all of them in one pass.
+         * Frusta are packed in groups of 4: coefficient of the plane p of the frustum i is stored at ((i / 4) * 6 + p) * 4 + i % 4.
+         */
+        struct PackedFrusta {
+            float32 normalX[MAX_PACKED_FRUSTA * 6];
+            float32 normalY[MAX_PACKED_FRUSTA * 6];
+            float32 normalZ[MAX_PACKED_FRUSTA * 6];
+            float32 d[MAX_PACKED_FRUSTA * 6];
+            float32 absNormalX[MAX_PACKED_FRUSTA * 6];
+            float32 absNormalY[MAX_PACKED_FRUSTA * 6];
+            float32 absNormalZ[MAX_PACKED_FRUSTA * 6];
+            uint32 count = 0;
+        };
+
+        /** Pack planes of the frusta (up to MAX_PACKED_FRUSTA) for multi-frustum tests */
+        static void pack(const Frustum* frusta, uint32 count, PackedFrusta &packed);
+
+        /**
+         * Classify box against several frusta at once. Frusta with bits set in active mask are tested:
+         * bits of frusta, which contain the box, are moved to the inside mask, bits of frusta, which do not see it, are cleared.
+         */
+        static void classify(const PackedFrusta &frusta, const AABB &aabb, uint32 &active, uint32 &inside);
+
+        /**
+         * Batched isInside for several frusta at once.
+         * For each box bits of the frusta from the active mask, which contain or intersect the box, are added to masks.
+         */
+        static void isInside(const PackedFrusta &frusta, uint32 active, const PackedBoxes &boxes, uint32* masks);
+
+        /** Max number of planes of the extruded frustum */
+        static const uint32 MAX_EXTRUDED_PLANES = 18;
+
+        /**
+         * Get planes of this frustum extruded to infinity in the opposite to direction way,
+         * i.e. volume of points p, such that p + t * direction is inside frustum for some t >= 0.
+         * Plane is stored as (normal, d), points inside volume satisfy dot(normal, p) + d >= 0.
+         * @return Number of written planes (at most MAX_EXTRUDED_PLANES)
+         */
+        uint32 getExtrudedPlanes(const glm::vec3 &direction, glm::vec4* result) const;
+
+        /** @return Index of the lowest set bit of non-zero value */
+        static uint32 getLowestBit(uint32 value) {
+            uint32 index = 0;
+            while ((value & 1u) == 0) {
+                value >>= 1u;
+                index += 1;
+            }
+            return index;
+        }
+
         const glm::vec3 &getUp() const { return mUp; }
         const glm::vec3 &getRight() const { return mRight; }
         const glm::vec3 &getForward() const { return mForward; }
@@ -180,6 +307,9 @@ namespace ignimbrite {
             );
         }
 
+        /** Writes visibility values for packed boxes (1 or 0 instead of visibility if maskOnly) */
+        void testPackedBoxes(const PackedBoxes &boxes, uint8* result, bool maskOnly) const;
+
         void recalculateFarPlane() {
             planes[PlaneIndex::Far] = Plane(
                     mFarVertices[VertexIndex::LowerLeft],
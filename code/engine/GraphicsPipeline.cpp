@@ -123,6 +123,28 @@ namespace ignimbrite {
         if (mHandle.isNotNull())
             throw std::runtime_error("An attempt to recreate pipeline prior release");
 
+        mHandle = createHandle(mDepthStencilDesc);
+    }
+
+    void GraphicsPipeline::createDepthEqualVariant() {
+        if (mHandle.isNull())
+            throw std::runtime_error("An attempt to create variant of not created pipeline");
+
+        if (mDepthEqualHandle.isNotNull())
+            return;
+
+        // Depth is already written by pre-pass, therefore only the nearest surface passes the test
+        auto depthStencilDesc = mDepthStencilDesc;
+        depthStencilDesc.depthTestEnable = true;
+        depthStencilDesc.depthWriteEnable = false;
+        depthStencilDesc.depthCompareOp = CompareOperation::Equal;
+
+        mDepthEqualHandle = createHandle(depthStencilDesc);
+    }
+
+    ID<IRenderDevice::GraphicsPipeline> GraphicsPipeline::createHandle(const IRenderDevice::PipelineDepthStencilStateDesc &depthStencilDesc) {
+        ID<IRenderDevice::GraphicsPipeline> handle;
+
         switch (mTarget) {
 
             case TargetType::Surface: {
@@ -138,7 +160,7 @@ namespace ignimbrite {
                 blendDesc.attachment = mBlendDesc.attachments[0];
                 blendDesc.blendConstants = mBlendDesc.blendConstants;
 
-                mHandle = mDevice->createGraphicsPipeline(
+                handle = mDevice->createGraphicsPipeline(
                         mSurface,
                         mTopology,
                         mShader->getHandle(),
@@ -146,10 +168,10 @@ namespace ignimbrite {
                         mShader->getLayout(),
                         mRasterizationDesc,
                         blendDesc,
-                        mDepthStencilDesc
+                        depthStencilDesc
                 );
 
-                if (mHandle.isNull())
+                if (handle.isNull())
                     throw std::runtime_error("Failed to create graphics pipeline");
             }
             break;
@@ -160,7 +182,7 @@ namespace ignimbrite {
                 checkTargetFormatPresent();
                 createVertexLayout();
 
-                mHandle = mDevice->createGraphicsPipeline(
+                handle = mDevice->createGraphicsPipeline(
                         mTopology,
                         mShader->getHandle(),
                         mVertexLayout,
@@ -168,10 +190,10 @@ namespace ignimbrite {
                         mTargetFormat->getFormatHandle(),
                         mRasterizationDesc,
                         mBlendDesc,
-                        mDepthStencilDesc
+                        depthStencilDesc
                 );
 
-                if (mHandle.isNull())
+                if (handle.isNull())
                     throw std::runtime_error("Failed to create graphics pipeline");
             }
             break;
@@ -180,9 +202,16 @@ namespace ignimbrite {
                 throw std::runtime_error("Rendering target is not specified [TargetType::None]");
 
         }
+
+        return handle;
     }
 
     void GraphicsPipeline::releasePipeline() {
+        if (mDepthEqualHandle.isNotNull()) {
+            mDevice->destroyGraphicsPipeline(mDepthEqualHandle);
+            mDepthEqualHandle = ID<IRenderDevice::GraphicsPipeline>();
+        }
+
         if (mHandle.isNotNull()) {
             mDevice->destroyGraphicsPipeline(mHandle);
             mHandle = ID<IRenderDevice::GraphicsPipeline>();
@@ -198,6 +227,22 @@ namespace ignimbrite {
         mDevice->drawListBindPipeline(mHandle);
     }
 
+    bool GraphicsPipeline::isInstanced() const {
+        for (const auto& desc: mVertexBuffersDesc) {
+            if (desc.usage == VertexUsage::PerInstance)
+                return true;
+        }
+
+        return false;
+    }
+
+    bool GraphicsPipeline::isReady() const {
+        if (mHandle.isNull() || !mDevice->isGraphicsPipelineReady(mHandle))
+            return false;
+
+        return mDepthEqualHandle.isNull() || mDevice->isGraphicsPipelineReady(mDepthEqualHandle);
+    }
+
     void GraphicsPipeline::checkShaderPresent() const {
         if (mShader == nullptr)
             throw std::runtime_error("Shader is not specified for pipeline");
@@ -214,6 +259,10 @@ namespace ignimbrite {
     }
 
     void GraphicsPipeline::createVertexLayout() {
+        // Layout is shared by the pipeline variants
+        if (mVertexLayout.isNotNull())
+            return;
+
         mVertexLayout = mDevice->createVertexLayout(mVertexBuffersDesc);
 
         if (mVertexLayout.isNull())
@@ -57,9 +57,23 @@ namespace ignimbrite {
         void releasePipeline();
         void bindPipeline();
 
+        /**
+         * Create variant of the pipeline for drawing after depth pre-pass: depth test with
+         * EQUAL operation and without depth writes. Variant is created once (pipeline must be created).
+         */
+        void createDepthEqualVariant();
+
+        /** @return True if pipeline has vertex buffer with per-instance attributes */
+        bool isInstanced() const;
+
+        /** @return True if pipeline (and its variant) is compiled, draws are skipped by device otherwise */
+        bool isReady() const;
+
         const RefCounted<Shader> &getShader() const { return mShader; }
         const RefCounted<RenderTarget::Format> &getTargetFormat() const { return mTargetFormat; }
         const ID<IRenderDevice::GraphicsPipeline> &getHandle() const { return mHandle; }
+        /** @return Handle of the depth EQUAL variant (null if variant is not created) */
+        const ID<IRenderDevice::GraphicsPipeline> &getDepthEqualHandle() const { return mDepthEqualHandle; }
 
     private:
 
@@ -67,6 +81,7 @@ namespace ignimbrite {
         void checkSurfacePresent() const;
         void checkTargetFormatPresent() const;
         void createVertexLayout();
+        ID<IRenderDevice::GraphicsPipeline> createHandle(const IRenderDevice::PipelineDepthStencilStateDesc &depthStencilDesc);
 
         /** Types of the result targets for rendering by this pipeline */
         enum class TargetType : uint32 {
@@ -86,6 +101,7 @@ namespace ignimbrite {
         ID<IRenderDevice::Surface> mSurface;
         ID<IRenderDevice::VertexLayout> mVertexLayout;
         ID<IRenderDevice::GraphicsPipeline> mHandle;
+        ID<IRenderDevice::GraphicsPipeline> mDepthEqualHandle;
 
         RefCounted<RenderTarget::Format> mTargetFormat;
         RefCounted<ignimbrite::Shader> mShader;
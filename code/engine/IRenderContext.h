@@ -39,10 +39,17 @@ namespace ignimbrite {
         bool renderShadows() const { return mRenderShadows; }
         bool renderDebugInfo() const { return mRenderDebugInfo; }
 
+        /** @return True while depth pre-pass is rendered (objects are drawn with shadow pass calls and depth materials) */
+        bool isDepthPrepass() const { return mDepthPrepass; }
+        /** @return True if depth of the current layer objects is written by pre-pass (draw with depth EQUAL) */
+        bool isDepthPrepassDone() const { return mDepthPrepassDone; }
+
         void setRenderDevice(IRenderDevice* device) { mRenderDevice = device; }
         void setCamera(Camera* camera) { mCamera = camera; }
         void setGlobalLight(Light* light) { mGlobalLight = light; }
         void setShadowsRenderTarget(RenderTarget* target) { mShadowsRenderTarget = target; }
+        void setDepthPrepass(bool prepass) { mDepthPrepass = prepass; }
+        void setDepthPrepassDone(bool done) { mDepthPrepassDone = done; }
 
     protected:
 
@@ -65,6 +72,10 @@ namespace ignimbrite {
         bool mRenderShadows = false;
         bool mRenderDebugInfo = false;
 
+        /** Depth pre-pass state of the current layer */
+        bool mDepthPrepass = false;
+        bool mDepthPrepassDone = false;
+
         // todo: Other scene light sources
         std::vector<Light*> mSceneLights;
     };
@@ -53,6 +53,7 @@ namespace ignimbrite {
         class Surface;
         class Texture;
         class Sampler;
+        class DrawList;
 
         virtual ~IRenderDevice() = default;
 
@@ -86,12 +87,18 @@ namespace ignimbrite {
 
         virtual ID<VertexBuffer> createVertexBuffer(BufferUsage usage, uint32 size, const void *data) = 0;
 
+        /**
+         * Update region of the buffer.
+         * @note Static buffer is updated through staging memory, update is visible
+         *       to all the draw lists, which are flushed after this call.
+         */
         virtual void updateVertexBuffer(ID<VertexBuffer> buffer, uint32 size, uint32 offset, const void *data) = 0;
 
         virtual void destroyVertexBuffer(ID<VertexBuffer> buffer) = 0;
 
         virtual ID<IndexBuffer> createIndexBuffer(BufferUsage usage, uint32 size, const void *data) = 0;
 
+        /** Update region of the buffer (see updateVertexBuffer) */
         virtual void updateIndexBuffer(ID<IndexBuffer> buffer, uint32 size, uint32 offset, const void *data) = 0;
 
         virtual void destroyIndexBuffer(ID<IndexBuffer> buffer) = 0;
@@ -131,6 +138,8 @@ namespace ignimbrite {
             ShaderStageFlags flags = 0x0;
             /** Binding point in target shader */
             uint32 binding = -1;
+            /** Buffer offset is specified when uniform set is bound (see drawListBindUniformSet) */
+            bool dynamic = false;
         };
 
         struct UniformLayoutTextureDesc {
@@ -140,9 +149,18 @@ namespace ignimbrite {
             uint32 binding = -1;
         };
 
+        struct UniformLayoutPushConstantDesc {
+            /** Shader stages, which uses this range of push constants */
+            ShaderStageFlags flags = 0x0;
+            /** Offset and size of the range in bytes (must be multiple of 4) */
+            uint32 offset = 0;
+            uint32 size = 0;
+        };
+
         struct UniformLayoutDesc {
             std::vector<UniformLayoutTextureDesc> textures;
             std::vector<UniformLayoutBufferDesc> buffers;
+            std::vector<UniformLayoutPushConstantDesc> pushConstants;
         };
 
         virtual ID<UniformLayout> createUniformLayout(const UniformLayoutDesc &layoutDesc) = 0;
@@ -151,10 +169,29 @@ namespace ignimbrite {
 
         virtual ID<UniformBuffer> createUniformBuffer(BufferUsage usage, uint32 size, const void *data) = 0;
 
+        /** Update region of the buffer (see updateVertexBuffer) */
         virtual void updateUniformBuffer(ID<UniformBuffer> buffer, uint32 size, uint32 offset, const void *data) = 0;
 
         virtual void destroyUniformBuffer(ID<UniformBuffer> buffer) = 0;
 
+        /**
+         * Persistently map dynamic uniform buffer memory (buffer stays mapped until destroyed).
+         * Written data is visible to GPU without explicit update calls.
+         *
+         * @note Mapped buffer has single copy for all frames in flight, therefore the caller
+         *       is responsible for not writing the memory used by not finished frames.
+         *       Buffer must be mapped before it is used in uniform sets.
+         *
+         * @return Pointer to the buffer memory
+         */
+        virtual uint8* mapUniformBuffer(ID<UniformBuffer> buffer) = 0;
+
+        /** @return Required alignment of the uniform buffers offsets in uniform sets */
+        virtual uint32 getUniformBufferOffsetAlignment() = 0;
+
+        /** @return Max size in bytes of push constants of the uniform layout */
+        virtual uint32 getMaxPushConstantsSize() = 0;
+
         struct SamplerDesc {
             SamplerFilter min = SamplerFilter::Nearest;
             SamplerFilter mag = SamplerFilter::Nearest;
@@ -338,10 +375,57 @@ namespace ignimbrite {
         /**
          * @brief Destroys graphics pipeline
          * @error Does not allows to destroy object, if other objects depend on that or have some references to that
+         * @note Pipelines with identical description are shared: creation returns the same ID,
+         *       which must be destroyed as many times as it was created
          * @param pipeline ID of the pipeline to be destroyed
          */
         virtual void destroyGraphicsPipeline(ID<GraphicsPipeline> pipeline) = 0;
 
+        /**
+         * Set number of threads, which compile pipelines in background (0 by default).
+         * If threads are set, pipeline creation for framebuffer format returns immediately,
+         * and draws with pipeline are skipped, until it is compiled. If compilation fails,
+         * draws are always skipped and failure is counted in pipeline cache statistics.
+         * Surface pipelines are always compiled on creation.
+         */
+        virtual void setPipelineCompileThreadsCount(uint32 threadsCount) = 0;
+
+        /** @return True if pipeline is compiled and its draws are recorded */
+        virtual bool isGraphicsPipelineReady(ID<GraphicsPipeline> pipeline) = 0;
+
+        /**
+         * Set file of the pipeline cache, which is used by all pipelines creation.
+         * Cache data is loaded, if the file was written by the same device and driver,
+         * and saved on device destruction.
+         *
+         * @param path Path to the cache file (created if it does not exist)
+         * @return True if cache data was loaded from the file
+         */
+        virtual bool setPipelineCachePath(const String &path) = 0;
+
+        /** Write pipeline cache data into the file (file is replaced atomically) */
+        virtual void savePipelineCache() = 0;
+
+        struct PipelineCacheStatistics {
+            /** Pipelines, which compiled state was found in the cache */
+            uint32 hits = 0;
+            /** Pipelines, compiled from scratch */
+            uint32 misses = 0;
+            /** Pipelines, compiled at the same time with others (neither hits nor misses, since cache usage is not known) */
+            uint32 concurrent = 0;
+            /** Creations, which returned existing pipeline with identical description */
+            uint32 shared = 0;
+            /** Pipelines, compiled in background right now */
+            uint32 compiling = 0;
+            /** Pipelines, which background compilation failed (their draws are skipped) */
+            uint32 failed = 0;
+            /** True if cache data was loaded from the file */
+            bool loaded = false;
+        };
+
+        /** @return Pipeline cache hits and misses since device creation */
+        virtual PipelineCacheStatistics getPipelineCacheStatistics() = 0;
+
         struct Color {
             float32 components[4];
         };
@@ -375,7 +459,7 @@ namespace ignimbrite {
          * rendering and waits, until draw list is executed.
          *
          * @note Ended draw list won't be executed until flush() called,
-         *       followed by explicit synchronize() call.
+         *       followed by explicit synchronize() or endFrame() call.
          */
         virtual void drawListEnd() = 0;
 
@@ -394,6 +478,20 @@ namespace ignimbrite {
 
         virtual void drawListBindUniformSet(ID<UniformSet> uniformSet) = 0;
 
+        /**
+         * Bind uniform set with offsets of its dynamic buffers
+         * @param dynamicOffsets Offsets for dynamic buffers in order of their bindings
+         */
+        virtual void drawListBindUniformSet(ID<UniformSet> uniformSet, const std::vector<uint32> &dynamicOffsets) = 0;
+
+        /**
+         * Update push constants of the bound pipeline layout
+         * @param flags Shader stages of the push constants range
+         * @param offset Offset in bytes of the updated data (must be multiple of 4)
+         * @param size Size in bytes of the updated data (must be multiple of 4)
+         */
+        virtual void drawListPushConstants(ShaderStageFlags flags, uint32 offset, uint32 size, const void *data) = 0;
+
         virtual void drawListBindVertexBuffer(ID<VertexBuffer> vertexBuffer, uint32 binding, uint32 offset) = 0;
 
         virtual void drawListBindIndexBuffer(ID<IndexBuffer> indexBuffer, IndicesType indicesType, uint32 offset) = 0;
@@ -402,6 +500,99 @@ namespace ignimbrite {
 
         virtual void drawListDrawIndexed(uint32 indicesCount, uint32 instancesCount) = 0;
 
+        /**
+         * Set number of threads, which could record secondary draw lists (1 by default).
+         * Must be called outside of draw list recording.
+         */
+        virtual void setDrawListThreadsCount(uint32 threadsCount) = 0;
+
+        /**
+         * @brief Begin secondary draw list on the calling thread
+         *
+         * Secondary draw list is recorded into the framebuffer, bound to the primary
+         * draw list, and could be recorded concurrently with lists of other threads.
+         * All the drawList commands of the calling thread (except framebuffer binds)
+         * are recorded into this list until drawListEndSecondary() is called.
+         *
+         * @param threadIndex Index of the thread in [0, threadsCount), only one
+         *                    list at a time could be recorded with this index
+         * @param reusable    True if list is executed in many frames (in the same framebuffer),
+         *                    otherwise list is valid until its frame is finished
+         *
+         * @note Primary draw list must not be modified while secondary lists are recorded.
+         * @note Objects, used by reusable list, must not be destroyed until list destruction.
+         */
+        virtual void drawListBeginSecondary(uint32 threadIndex, bool reusable) = 0;
+
+        /** @return Recorded secondary draw list */
+        virtual ID<DrawList> drawListEndSecondary() = 0;
+
+        /** Destroy reusable draw list (must not be used by not finished draw lists) */
+        virtual void destroyDrawList(ID<DrawList> drawList) = 0;
+
+        /**
+         * Execute secondary draw lists in the bound framebuffer of the primary draw list.
+         * Framebuffer contents then could be recorded only with secondary draw lists.
+         */
+        virtual void drawListExecute(const std::vector<ID<DrawList>> &drawLists) = 0;
+
+        /**
+         * Binds of the draw list. Binds of already bound objects are dropped
+         * by device (counted as skipped) and are not recorded into draw list.
+         */
+        struct DrawListStatistics {
+            uint32 pipelineBinds = 0;
+            uint32 pipelineBindsSkipped = 0;
+            uint32 uniformSetBinds = 0;
+            uint32 uniformSetBindsSkipped = 0;
+            uint32 vertexBufferBinds = 0;
+            uint32 vertexBufferBindsSkipped = 0;
+            uint32 indexBufferBinds = 0;
+            uint32 indexBufferBindsSkipped = 0;
+            /** Draws with pipeline, which is not compiled yet */
+            uint32 drawsSkipped = 0;
+        };
+
+        /** @return Binds statistics of the current (or last) draw list with its executed secondary lists, reset on drawListBegin */
+        virtual const DrawListStatistics &getDrawListStatistics() = 0;
+
+        /**
+         * Draw lists of the frame are allocated from per frame (and per thread) pools.
+         * Pool is reset, when its frame is finished, and its lists are reused.
+         */
+        struct CommandPoolStatistics {
+            /** Pools of the frames and recording threads */
+            uint32 pools = 0;
+            /** Lists, owned by the pools (allocated once) */
+            uint32 allocatedLists = 0;
+            /** Lists, taken from the pools by not finished frames */
+            uint32 usedLists = 0;
+            /** Total number of pools resets */
+            uint64 resets = 0;
+        };
+
+        /** @return Usage of the draw lists pools */
+        virtual CommandPoolStatistics getCommandPoolStatistics() = 0;
+
+        /**
+         * Data of the static buffers and textures is copied through staging memory
+         * by batches. Creation returns immediately, resource is ready for the draw lists,
+         * flushed after creation. Each submitted batch increments its value.
+         */
+        struct UploadStatistics {
+            /** Value of the last submitted batch */
+            uint64 submittedBatches = 0;
+            /** Value of the last batch, finished by GPU */
+            uint64 completedBatches = 0;
+            /** Total size of the uploaded data */
+            uint64 uploadedBytes = 0;
+            /** Size of the staging memory */
+            uint32 stagingSize = 0;
+        };
+
+        /** @return Statistics of the uploads */
+        virtual UploadStatistics getUploadStatistics() = 0;
+
         /**
          * @brief Get surface id
          *
@@ -434,6 +625,8 @@ namespace ignimbrite {
          *
          * @note Before swap buffer all the draw lists must be executed.
          *       To ensure, that all the draw lists executed call synchronize() method.
+         *       If frame is ended with endFrame(), image is presented, when the frame is finished
+         *       on GPU, and next image is acquired on next beginFrame() without waiting.
          *
          * @param surface ID of the surface to swap buffers to present final image
          */
@@ -464,6 +657,33 @@ namespace ignimbrite {
          */
         virtual void synchronize() = 0;
 
+        /** Max number of the frames, which could be processed by GPU at the same time */
+        static const uint32 MAX_FRAMES_IN_FLIGHT = 3;
+
+        /**
+         * @brief Begin frame
+         *
+         * Frames are recorded by CPU, while up to frames in flight count of
+         * previous frames are executed by GPU. Begin waits only for the frame,
+         * which slot is reused, and releases objects, destroyed while it was in flight.
+         *
+         * Dynamic buffers have own copy for each frame slot, therefore their
+         * updates do not affect not finished frames.
+         *
+         * @note Frame must be ended with endFrame() after flush() of its draw lists.
+         */
+        virtual void beginFrame() = 0;
+
+        /** End frame: its slot is finished, when all submitted draw lists are executed */
+        virtual void endFrame() = 0;
+
+        /** Set number of frames in flight in [1, MAX_FRAMES_IN_FLIGHT] (2 by default), synchronizes device */
+        virtual void setFramesInFlight(uint32 framesCount) = 0;
+        virtual uint32 getFramesInFlight() const = 0;
+
+        /** @return Index of the current frame slot in [0, frames in flight) */
+        virtual uint32 getFrameIndex() const = 0;
+
         /**
          * @brief Texture data formats query
          *
@@ -36,6 +36,8 @@ namespace ignimbrite {
         virtual void setPresentationPass(RefCounted<IPresentationPass> presentationPass) = 0;
 
         virtual void addRenderable(RefCounted<IRenderable> object) = 0;
+        /** Add objects at once (storage is reserved for all of them) */
+        virtual void addRenderables(const std::vector<RefCounted<IRenderable>> &objects) = 0;
         virtual void removeRenderable(const RefCounted <IRenderable> &object) = 0;
 
         virtual void addLightSource(RefCounted<Light> light) = 0;
@@ -16,6 +16,37 @@
 
 namespace ignimbrite {
 
+    class IRenderable;
+    class Mesh;
+
+    /**
+     * @brief Renderable state changes listener
+     * Implemented by the scene (engine), which needs to track objects changes.
+     */
+    class IRenderableListener {
+    public:
+
+        enum ChangeFlagBits : uint32 {
+            /** World bounds and position of the object were changed */
+            Bounds = 1u << 0u,
+            /** Object became static or dynamic */
+            Static = 1u << 1u,
+            /** Visibility, shadows casting or culling flags were changed */
+            Flags = 1u << 2u,
+            /** Max view distance was changed */
+            MaxViewDistance = 1u << 3u,
+            /** Object was moved to other layer */
+            Layer = 1u << 4u,
+            /** Geometry buffers or materials of the object were replaced (recorded draws are not valid) */
+            DrawData = 1u << 5u
+        };
+
+        virtual ~IRenderableListener() = default;
+
+        /** Called when object state changes (changes are combination of ChangeFlagBits) */
+        virtual void onRenderableChanged(IRenderable* object, uint32 changes) = 0;
+    };
+
     /**
      * @brief Any visible object
      *
@@ -65,12 +96,61 @@ namespace ignimbrite {
         virtual Material* getRenderMaterial() = 0;
         /** @return Material for rendering in shadow pass */
         virtual Material* getShadowRenderMaterial() = 0;
+        /**
+         * @return Position-only material for depth pre-pass of the main view or null, if object is not drawn in pre-pass.
+         *         Pre-pass is drawn with shadow pass calls, while context isDepthPrepass() is true. Objects with
+         *         pre-pass depth are drawn in main pass with depth EQUAL, when context isDepthPrepassDone() is true,
+         *         therefore vertex shaders of both passes must declare invariant gl_Position.
+         */
+        virtual Material* getDepthRenderMaterial() { return nullptr; }
+        /**
+         * @param[out] transform Model matrix of the occluder mesh
+         * @return Low-poly mesh (completely inside the object), which hides other objects
+         *         in occlusion culling, or null if object is not an occluder
+         */
+        virtual const Mesh* getOccluderMesh(Mat4f &/*transform*/) const { return nullptr; }
+        /**
+         * @param shadowPass True if object is rendered to shadow map
+         * @return Key of the drawn geometry or null, if object could not be rendered with instancing.
+         *         Adjacent in render queue objects with the same key could be drawn with single call.
+         */
+        virtual const void* getInstancingKey(bool /*shadowPass*/) const { return nullptr; }
+        /** @return True if other object (with the same instancing key) could be drawn in the same instanced call */
+        virtual bool canInstanceWith(const IRenderable& /*other*/, bool /*shadowPass*/) const { return false; }
+        /** @return Model matrix of this object, written to the per-instance buffer */
+        virtual Mat4f getInstanceTransform() const { return Mat4f(1.0f); }
+        /**
+         * Called once to draw instances of the run, which starts from this object
+         * (only for objects with instancing key). Model matrices of the instances are
+         * stored in instanceBuffer from offset (in bytes) as tightly packed Mat4f.
+         */
+        virtual void onRenderInstanced(const IRenderContext& /*context*/, ID<IRenderDevice::VertexBuffer> /*instanceBuffer*/,
+                                       uint32 /*offset*/, uint32 /*instancesCount*/) { }
+        /** Called once to draw instances of the run to shadow map (see onRenderInstanced) */
+        virtual void onShadowRenderInstanced(const IRenderContext& /*context*/, ID<IRenderDevice::VertexBuffer> /*instanceBuffer*/,
+                                             uint32 /*offset*/, uint32 /*instancesCount*/) { }
+        /**
+         * @return True if draw of the object could be split into onRenderPrepare, called on the main
+         *         thread, and onRenderRecord, called on recording thread concurrently with other objects.
+         *         Materials of the object must not be shared with other objects (use material instances),
+         *         since their params are set on prepare and bound on record.
+         */
+        virtual bool canRecordInParallel(bool /*shadowPass*/) const { return false; }
+        /** Set params and update uniform data for the draw of this object or of the instanced run, which starts from it */
+        virtual void onRenderPrepare(const IRenderContext& /*context*/, bool /*shadowPass*/, bool /*instanced*/) { }
+        /**
+         * Record prepared draw (only drawList commands of the device are allowed).
+         * Instance buffer is null for the draw of single object (see onRenderInstanced).
+         */
+        virtual void onRenderRecord(const IRenderContext& /*context*/, bool /*shadowPass*/, ID<IRenderDevice::VertexBuffer> /*instanceBuffer*/,
+                                    uint32 /*offset*/, uint32 /*instancesCount*/) { }
 
-        void setCastShadows(bool set = true) { mCastShadows = set; }
-        void setVisible(bool set = true) { mIsVisible = set; }
-        void setCanApplyCulling(bool set = true) { mCanApplyCulling = set; }
-        void setMaxViewDistance(float32 distance) { mMaxViewDistance = distance; }
-        void setLayerID(uint32 layer) { mLayerID = layer; }
+        void setCastShadows(bool set = true) { mCastShadows = set; notifyChanged(IRenderableListener::Flags); }
+        void setVisible(bool set = true) { mIsVisible = set; notifyChanged(IRenderableListener::Flags); }
+        void setCanApplyCulling(bool set = true) { mCanApplyCulling = set; notifyChanged(IRenderableListener::Flags); }
+        void setMaxViewDistance(float32 distance) { mMaxViewDistance = distance; notifyChanged(IRenderableListener::MaxViewDistance); }
+        void setLayerID(uint32 layer) { mLayerID = layer; notifyChanged(IRenderableListener::Layer); }
+        void setStatic(bool set = true) { mIsStatic = set; notifyChanged(IRenderableListener::Static); }
 
         /** @return True, if object cast shadows */
         bool castShadows() const { return mCastShadows; }
@@ -84,8 +164,32 @@ namespace ignimbrite {
         float32 getMaxViewDistanceSquared() const { return mMaxViewDistance * mMaxViewDistance; }
         /** @return Layer id of this object. All the objects are grouped by its layer rendered layer by layer */
         uint32 getLayerID() const { return mLayerID; }
+        /** @return True, if object never moves (such objects are stored in static scene structures) */
+        bool isStatic() const { return mIsStatic; }
+
+    protected:
+
+        /** Must be called by implementation, when object world bounds or position are changed */
+        void notifyBoundsChanged() { notifyChanged(IRenderableListener::Bounds); }
+        /** Must be called by implementation, when object becomes or stops being occluder */
+        void notifyOccluderChanged() { notifyChanged(IRenderableListener::Flags); }
+        /** Must be called by implementation, when buffers or materials, used for drawing, are replaced */
+        void notifyDrawDataChanged() { notifyChanged(IRenderableListener::DrawData); }
 
     private:
+        friend class RenderEngine;
+
+        void notifyChanged(uint32 changes) { if (mListener) mListener->onRenderableChanged(this, changes); }
+
+        /** Scene of this object (set by the engine) */
+        IRenderableListener* mListener = nullptr;
+        /** Id of the object in the scene (set by the engine) */
+        uint32 mSceneID = 0xffffffff;
+        /** Index in the scene objects list and in the list of its layer (set by the engine) */
+        uint32 mObjectIndex = 0xffffffff;
+        uint32 mLayerIndex = 0xffffffff;
+
+        bool mIsStatic = false;
         bool mCastShadows = false;
         bool mCanApplyCulling = false;
         bool mIsVisible = false;
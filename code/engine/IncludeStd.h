@@ -15,6 +15,7 @@
 #include <memory>
 #include <vector>
 #include <algorithm>
+#include <stdexcept>
 #include <unordered_map>
 
 namespace ignimbrite {
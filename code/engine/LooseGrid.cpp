@@ -0,0 +1,376 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <LooseGrid.h>
+#include <cmath>
+
+namespace ignimbrite {
+
+    LooseGrid::LooseGrid(float32 cellSize) {
+        setCellSize(cellSize);
+    }
+
+    void LooseGrid::setCellSize(float32 cellSize) {
+        if (mObjectsCount > 0)
+            throw std::runtime_error("An attempt to change cell size of not empty grid");
+
+        if (cellSize <= 0.0f)
+            throw std::runtime_error("Grid cell size must be positive");
+
+        mCellSize = cellSize;
+        clear();
+    }
+
+    void LooseGrid::reserve(uint32 capacity) {
+        mLocations.reserve(capacity);
+    }
+
+    void LooseGrid::add(uint32 id, const AABB &bounds) {
+        if (contains(id))
+            throw std::runtime_error("Grid already contains object with such id");
+
+        if (id >= mLocations.size()) {
+            mLocations.resize(id + 1);
+        }
+
+        auto cellIndex = getCell(bounds);
+        auto& cell = mCells[cellIndex];
+        auto slot = (uint32) cell.ids.size();
+
+        cell.ids.push_back(id);
+        cell.centerX.push_back(0.0f);
+        cell.centerY.push_back(0.0f);
+        cell.centerZ.push_back(0.0f);
+        cell.extentX.push_back(0.0f);
+        cell.extentY.push_back(0.0f);
+        cell.extentZ.push_back(0.0f);
+        setSlot(cell, slot, bounds);
+
+        mLocations[id].cell = cellIndex;
+        mLocations[id].slot = slot;
+        mObjectsCount += 1;
+    }
+
+    void LooseGrid::remove(uint32 id) {
+        if (!contains(id))
+            throw std::runtime_error("Grid does not contain object with such id");
+
+        auto& location = mLocations[id];
+        auto& cell = mCells[location.cell];
+        auto slot = location.slot;
+        auto last = (uint32) cell.ids.size() - 1;
+
+        // Swap with last object in the cell
+        if (slot != last) {
+            auto moved = cell.ids[last];
+            cell.ids[slot] = moved;
+            cell.centerX[slot] = cell.centerX[last];
+            cell.centerY[slot] = cell.centerY[last];
+            cell.centerZ[slot] = cell.centerZ[last];
+            cell.extentX[slot] = cell.extentX[last];
+            cell.extentY[slot] = cell.extentY[last];
+            cell.extentZ[slot] = cell.extentZ[last];
+            mLocations[moved].slot = slot;
+        }
+
+        cell.ids.pop_back();
+        cell.centerX.pop_back();
+        cell.centerY.pop_back();
+        cell.centerZ.pop_back();
+        cell.extentX.pop_back();
+        cell.extentY.pop_back();
+        cell.extentZ.pop_back();
+
+        location = Location();
+        mObjectsCount -= 1;
+    }
+
+    void LooseGrid::update(uint32 id, const AABB &bounds) {
+        if (!contains(id))
+            throw std::runtime_error("Grid does not contain object with such id");
+
+        auto& location = mLocations[id];
+        auto cellIndex = getCell(bounds);
+
+        if (cellIndex == location.cell) {
+            setSlot(mCells[cellIndex], location.slot, bounds);
+            return;
+        }
+
+        remove(id);
+        add(id, bounds);
+    }
+
+    void LooseGrid::query(const Frustum &frustum, std::vector<uint32> &result) const {
+        testCell(mCells[LARGE_OBJECTS_CELL], frustum, result);
+
+        // Range of cells, which loose bounds could intersect frustum bounds
+        AABB frustumBounds(frustum.getNearVertices()[0], frustum.getNearVertices()[0]);
+        for (const auto& v: frustum.getNearVertices()) frustumBounds.expandToContain(v);
+        for (const auto& v: frustum.getFarVertices()) frustumBounds.expandToContain(v);
+
+        int64 rangeMin[3];
+        int64 rangeMax[3];
+
+        // Visit allocated cells or cells of the range, whichever is fewer
+        if (!getCellsRange(frustumBounds, rangeMin, rangeMax)) {
+            for (uint32 i = LARGE_OBJECTS_CELL + 1; i < mCells.size(); i++) {
+                queryCell(mCells[i], frustum, result);
+            }
+
+            return;
+        }
+
+        for (int64 x = rangeMin[0]; x <= rangeMax[0]; x++) {
+            for (int64 y = rangeMin[1]; y <= rangeMax[1]; y++) {
+                for (int64 z = rangeMin[2]; z <= rangeMax[2]; z++) {
+                    int64 coords[3] = { x, y, z };
+                    auto found = mCellsMap.find(getCellKey(coords));
+
+                    if (found != mCellsMap.end())
+                        queryCell(mCells[found->second], frustum, result);
+                }
+            }
+        }
+    }
+
+    void LooseGrid::query(const Frustum *frusta, uint32 count, std::vector<uint32> &ids, std::vector<uint32> &masks) const {
+        if (count == 0)
+            return;
+
+        Frustum::PackedFrusta packed;
+        Frustum::pack(frusta, count, packed);
+
+        uint32 allViews = count == 32 ? 0xffffffff : (1u << count) - 1;
+        testCell(mCells[LARGE_OBJECTS_CELL], packed, allViews, 0, ids, masks);
+
+        // Range of cells for each frustum, cell is tested only against frusta, which ranges contain it
+        int64 rangeMin[Frustum::MAX_PACKED_FRUSTA][3];
+        int64 rangeMax[Frustum::MAX_PACKED_FRUSTA][3];
+        uint32 unbounded = 0;
+        float64 rangesVolume = 0.0;
+
+        for (uint32 i = 0; i < count; i++) {
+            AABB frustumBounds(frusta[i].getNearVertices()[0], frusta[i].getNearVertices()[0]);
+            for (const auto& v: frusta[i].getNearVertices()) frustumBounds.expandToContain(v);
+            for (const auto& v: frusta[i].getFarVertices()) frustumBounds.expandToContain(v);
+
+            if (!getCellsRange(frustumBounds, rangeMin[i], rangeMax[i])) {
+                unbounded |= 1u << i;
+                continue;
+            }
+
+            float64 rangeVolume = 1.0;
+            for (uint32 k = 0; k < 3; k++) {
+                rangeVolume *= (float64) std::max(rangeMax[i][k] - rangeMin[i][k] + 1, (int64) 0);
+            }
+            rangesVolume += rangeVolume;
+        }
+
+        // Mask of the frusta among first viewsCount ones, which ranges contain the cell
+        auto getCellViews = [&](const int64* coords, uint32 viewsCount) {
+            uint32 views = 0;
+
+            for (uint32 i = 0; i < viewsCount; i++) {
+                if (coords[0] >= rangeMin[i][0] && coords[0] <= rangeMax[i][0] &&
+                    coords[1] >= rangeMin[i][1] && coords[1] <= rangeMax[i][1] &&
+                    coords[2] >= rangeMin[i][2] && coords[2] <= rangeMax[i][2])
+                    views |= 1u << i;
+            }
+
+            return views & ~unbounded;
+        };
+
+        // Visit allocated cells or cells of the ranges, whichever is fewer
+        if (unbounded != 0 || rangesVolume > (float64) mCells.size()) {
+            for (uint32 i = LARGE_OBJECTS_CELL + 1; i < mCells.size(); i++) {
+                queryCell(mCells[i], packed, unbounded | getCellViews(mCells[i].coords, count), ids, masks);
+            }
+
+            return;
+        }
+
+        // Ranges could overlap: cell is visited with the first frustum, which range contains it
+        for (uint32 i = 0; i < count; i++) {
+            for (int64 x = rangeMin[i][0]; x <= rangeMax[i][0]; x++) {
+                for (int64 y = rangeMin[i][1]; y <= rangeMax[i][1]; y++) {
+                    for (int64 z = rangeMin[i][2]; z <= rangeMax[i][2]; z++) {
+                        int64 coords[3] = { x, y, z };
+
+                        if (getCellViews(coords, i) != 0)
+                            continue;
+
+                        auto found = mCellsMap.find(getCellKey(coords));
+
+                        if (found != mCellsMap.end())
+                            queryCell(mCells[found->second], packed, getCellViews(coords, count), ids, masks);
+                    }
+                }
+            }
+        }
+    }
+
+    void LooseGrid::clear() {
+        mCells.clear();
+        mCellsMap.clear();
+        mLocations.clear();
+        mObjectsCount = 0;
+
+        mCells.emplace_back();
+    }
+
+    uint32 LooseGrid::getCell(const AABB &bounds) {
+        auto center = bounds.getCenter();
+        auto extent = bounds.getExtent();
+        auto halfCell = mCellSize * 0.5f;
+
+        if (extent.x > halfCell || extent.y > halfCell || extent.z > halfCell)
+            return LARGE_OBJECTS_CELL;
+
+        int64 coords[3];
+
+        for (uint32 k = 0; k < 3; k++) {
+            coords[k] = (int64) std::floor(center[k] / mCellSize);
+
+            // Out of the grid range
+            if (coords[k] < -CELLS_OFFSET || coords[k] >= CELLS_OFFSET)
+                return LARGE_OBJECTS_CELL;
+        }
+
+        auto key = getCellKey(coords);
+        auto found = mCellsMap.find(key);
+
+        if (found != mCellsMap.end())
+            return found->second;
+
+        glm::vec3 cellMin((float32) coords[0], (float32) coords[1], (float32) coords[2]);
+        cellMin *= mCellSize;
+
+        Cell cell;
+        cell.looseBounds = AABB(cellMin - glm::vec3(halfCell), cellMin + glm::vec3(mCellSize + halfCell));
+        cell.coords[0] = coords[0];
+        cell.coords[1] = coords[1];
+        cell.coords[2] = coords[2];
+
+        auto cellIndex = (uint32) mCells.size();
+        mCells.push_back(std::move(cell));
+        mCellsMap.emplace(key, cellIndex);
+
+        return cellIndex;
+    }
+
+    uint64 LooseGrid::getCellKey(const int64 *coords) {
+        // Cell coordinates are packed into 21 bit per axis
+        const int64 mask = (1 << 21) - 1;
+        uint64 key = 0;
+
+        for (uint32 k = 0; k < 3; k++) {
+            key |= (uint64) ((coords[k] + CELLS_OFFSET) & mask) << (21 * k);
+        }
+
+        return key;
+    }
+
+    void LooseGrid::queryCell(const Cell &cell, const Frustum &frustum, std::vector<uint32> &result) const {
+        if (cell.ids.empty())
+            return;
+
+        auto visibility = frustum.classify(cell.looseBounds);
+
+        if (visibility == Frustum::Visibility::Inside)
+            result.insert(result.end(), cell.ids.begin(), cell.ids.end());
+        else if (visibility == Frustum::Visibility::Intersecting)
+            testCell(cell, frustum, result);
+    }
+
+    void LooseGrid::queryCell(const Cell &cell, const Frustum::PackedFrusta &frusta, uint32 active, std::vector<uint32> &ids, std::vector<uint32> &masks) const {
+        if (cell.ids.empty() || active == 0)
+            return;
+
+        uint32 inside = 0;
+        Frustum::classify(frusta, cell.looseBounds, active, inside);
+
+        if (active != 0) {
+            testCell(cell, frusta, active, inside, ids, masks);
+        } else if (inside != 0) {
+            ids.insert(ids.end(), cell.ids.begin(), cell.ids.end());
+            masks.insert(masks.end(), cell.ids.size(), inside);
+        }
+    }
+
+    void LooseGrid::setSlot(Cell &cell, uint32 slot, const AABB &bounds) {
+        auto center = bounds.getCenter();
+        auto extent = bounds.getExtent();
+
+        cell.centerX[slot] = center.x;
+        cell.centerY[slot] = center.y;
+        cell.centerZ[slot] = center.z;
+        cell.extentX[slot] = extent.x;
+        cell.extentY[slot] = extent.y;
+        cell.extentZ[slot] = extent.z;
+    }
+
+    void LooseGrid::testCell(const Cell &cell, const Frustum &frustum, std::vector<uint32> &result) const {
+        if (cell.ids.empty())
+            return;
+
+        auto boxes = getPackedBoxes(cell);
+        mMask.resize(boxes.count);
+        frustum.isInside(boxes, mMask.data());
+
+        for (uint32 i = 0; i < boxes.count; i++) {
+            if (mMask[i])
+                result.push_back(cell.ids[i]);
+        }
+    }
+
+    void LooseGrid::testCell(const Cell &cell, const Frustum::PackedFrusta &frusta, uint32 active, uint32 inside,
+                             std::vector<uint32> &ids, std::vector<uint32> &masks) const {
+        if (cell.ids.empty())
+            return;
+
+        auto boxes = getPackedBoxes(cell);
+        mViewMasks.assign(boxes.count, inside);
+        Frustum::isInside(frusta, active, boxes, mViewMasks.data());
+
+        for (uint32 i = 0; i < boxes.count; i++) {
+            if (mViewMasks[i]) {
+                ids.push_back(cell.ids[i]);
+                masks.push_back(mViewMasks[i]);
+            }
+        }
+    }
+
+    Frustum::PackedBoxes LooseGrid::getPackedBoxes(const Cell &cell) {
+        Frustum::PackedBoxes boxes;
+        boxes.centerX = cell.centerX.data();
+        boxes.centerY = cell.centerY.data();
+        boxes.centerZ = cell.centerZ.data();
+        boxes.extentX = cell.extentX.data();
+        boxes.extentY = cell.extentY.data();
+        boxes.extentZ = cell.extentZ.data();
+        boxes.count = (uint32) cell.ids.size();
+        return boxes;
+    }
+
+    bool LooseGrid::getCellsRange(const AABB &bounds, int64 *rangeMin, int64 *rangeMax) const {
+        auto halfCell = mCellSize * 0.5f;
+        int64 offset = CELLS_OFFSET;
+        float64 rangeVolume = 1.0;
+
+        for (uint32 k = 0; k < 3; k++) {
+            rangeMin[k] = std::max((int64) std::floor((bounds.getMinBounds()[k] - halfCell) / mCellSize), -offset);
+            rangeMax[k] = std::min((int64) std::floor((bounds.getMaxBounds()[k] + halfCell) / mCellSize), offset - 1);
+            rangeVolume *= (float64) std::max(rangeMax[k] - rangeMin[k] + 1, (int64) 0);
+        }
+
+        return rangeVolume < (float64) mCellsMap.size();
+    }
+
+}
@@ -0,0 +1,105 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_LOOSEGRID_H
+#define IGNIMBRITE_LOOSEGRID_H
+
+#include <IncludeStd.h>
+#include <Frustum.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Loose uniform grid for moving objects
+     *
+     * Object is stored in the cell, which contains its bounds center.
+     * Cells bounds are loose (twice as large as the cell), therefore
+     * moved objects rarely change its cell and updates are O(1).
+     * Objects larger than the cell are stored in the separate list.
+     *
+     * Grid is sparse: only cells with objects are allocated.
+     * Object ids expected to be dense (used for direct indexing).
+     */
+    class LooseGrid {
+    public:
+        static const uint32 INVALID_INDEX = 0xffffffff;
+
+        explicit LooseGrid(float32 cellSize = 32.0f);
+
+        /** Set size of the grid cell (only for empty grid) */
+        void setCellSize(float32 cellSize);
+
+        /** Reserve storage for objects with ids less than capacity */
+        void reserve(uint32 capacity);
+        void add(uint32 id, const AABB &bounds);
+        void remove(uint32 id);
+        /** Update object bounds, moves it to the other cell if needed */
+        void update(uint32 id, const AABB &bounds);
+
+        /** Append ids of items inside or intersecting frustum (uses internal tmp buffers, not thread-safe) */
+        void query(const Frustum &frustum, std::vector<uint32> &result) const;
+
+        /**
+         * Append ids of items inside or intersecting at least one of the frusta (up to 32)
+         * and for each item the mask of frusta (bit i for frusta[i]), which see it.
+         * Each cell is visited once for all the frusta (uses internal tmp buffers, not thread-safe).
+         */
+        void query(const Frustum* frusta, uint32 count, std::vector<uint32> &ids, std::vector<uint32> &masks) const;
+
+        void clear();
+
+        bool contains(uint32 id) const { return id < mLocations.size() && mLocations[id].cell != INVALID_INDEX; }
+        uint32 getObjectsCount() const { return mObjectsCount; }
+        float32 getCellSize() const { return mCellSize; }
+
+    private:
+
+        struct Cell {
+            AABB looseBounds;
+            int64 coords[3] = { 0, 0, 0 };
+            std::vector<uint32> ids;
+            /** Packed bounds of objects for batched tests */
+            std::vector<float32> centerX, centerY, centerZ;
+            std::vector<float32> extentX, extentY, extentZ;
+        };
+
+        struct Location {
+            uint32 cell = INVALID_INDEX;
+            uint32 slot = INVALID_INDEX;
+        };
+
+        /** Cell with objects too large for the grid */
+        static const uint32 LARGE_OBJECTS_CELL = 0;
+
+        /** Range of cell coordinates is [-CELLS_OFFSET, CELLS_OFFSET) on each axis */
+        static const int64 CELLS_OFFSET = 1 << 20;
+
+        static uint64 getCellKey(const int64* coords);
+        uint32 getCell(const AABB &bounds);
+        void setSlot(Cell &cell, uint32 slot, const AABB &bounds);
+        void queryCell(const Cell &cell, const Frustum &frustum, std::vector<uint32> &result) const;
+        void testCell(const Cell &cell, const Frustum &frustum, std::vector<uint32> &result) const;
+        void queryCell(const Cell &cell, const Frustum::PackedFrusta &frusta, uint32 active, std::vector<uint32> &ids, std::vector<uint32> &masks) const;
+        void testCell(const Cell &cell, const Frustum::PackedFrusta &frusta, uint32 active, uint32 inside, std::vector<uint32> &ids, std::vector<uint32> &masks) const;
+        static Frustum::PackedBoxes getPackedBoxes(const Cell &cell);
+        /** @return False if range of cells, which could intersect bounds, is larger than number of allocated cells */
+        bool getCellsRange(const AABB &bounds, int64* rangeMin, int64* rangeMax) const;
+
+        float32 mCellSize;
+        uint32 mObjectsCount = 0;
+        std::vector<Cell> mCells;
+        std::unordered_map<uint64, uint32> mCellsMap;
+        std::vector<Location> mLocations;
+        mutable std::vector<uint8> mMask;
+        mutable std::vector<uint32> mViewMasks;
+    };
+
+}
+
+#endif //IGNIMBRITE_LOOSEGRID_H
@@ -8,7 +8,9 @@
 /**********************************************************************************/
 
 #include <Material.h>
-#include <PipelineContext.h>
+#include <MaterialInstance.h>
+#include <algorithm>
+#include <cstring>
 
 namespace ignimbrite {
 
@@ -23,69 +25,179 @@ namespace ignimbrite {
 
     void Material::setGraphicsPipeline(ignimbrite::RefCounted<ignimbrite::GraphicsPipeline> pipeline) {
         mPipeline = std::move(pipeline);
+        mBindingVersion += 1;
+    }
+
+    void Material::setUniformRing(RefCounted<UniformRingBuffer> ring) {
+        mUniformRing = std::move(ring);
     }
 
     void Material::createMaterial() {
         auto& shader = mPipeline->getShader();
 
+        if (mUniformRing != nullptr && !shader->hasDynamicBuffers())
+            throw std::runtime_error("Shader uniform layout must have dynamic buffers to use ring buffer");
+
         for (const auto& p: shader->getBuffersInfo()) {
             auto binding = p.second.binding;
             auto size = p.second.size;
 
             mUniformBuffers.emplace(binding, mDevice);
-            mUniformBuffers.at(binding).createBuffer(size);
+            mBufferBindings.push_back(binding);
+
+            if (mUniformRing != nullptr) {
+                mUniformBuffers.at(binding).createBufferOnCPU(size);
+            } else {
+                mUniformBuffers.at(binding).createBuffer(size);
+            }
+        }
+
+        // Slots of the buffers (and dynamic offsets) are specified in order of the bindings,
+        // therefore param handles are the same for the all materials with this shader
+        std::sort(mBufferBindings.begin(), mBufferBindings.end());
+
+        for (auto binding: mBufferBindings) {
+            mBufferSlots.push_back(&mUniformBuffers.at(binding));
+        }
+
+        if (mUniformRing != nullptr) {
+            mDynamicOffsets.resize(mBufferBindings.size(), 0);
+        }
+
+        uint32 pushConstantsSize = 0;
+
+        for (const auto& p: shader->getPushConstantsInfo()) {
+            IRenderDevice::UniformLayoutPushConstantDesc range;
+            range.flags = p.second.stageFlags;
+            range.offset = p.second.offset;
+            range.size = p.second.size;
+
+            mPushConstantRanges.push_back(range);
+            pushConstantsSize = std::max(pushConstantsSize, range.offset + range.size);
         }
+
+        mPushConstantData.resize(pushConstantsSize, 0);
     }
 
     void Material::releaseMaterial() {
+        if (mStaticSize > 0) {
+            mUniformRing->releaseStatic(mStaticOffset, mStaticSize);
+            mStaticSize = 0;
+        }
+
         if (mUniformSet.isNotNull()) {
             mDevice->destroyUniformSet(mUniformSet);
             mUniformSet = ID<IRenderDevice::UniformSet>();
         }
         mTextures.clear();
         mUniformBuffers.clear();
+        mBufferBindings.clear();
+        mBufferSlots.clear();
+        mDynamicOffsets.clear();
+        mPushConstantRanges.clear();
+        mPushConstantData.clear();
     }
 
     void Material::setInt(const String &name, int32 value) {
         const auto& info = mPipeline->getShader()->getParameterInfo(name);
-        auto& uniformBlock = mUniformBuffers.at(info.binding);
-        uniformBlock.updateDataOnCPU(sizeof(value), info.offset, (uint8*)&value);
-        mUniformBuffersWereModified = true;
+        setParameterData(makeParamHandle(info), sizeof(value), &value);
     }
 
     void Material::setFloat(const String &name, float32 value) {
         const auto& info = mPipeline->getShader()->getParameterInfo(name);
-        auto& uniformBlock = mUniformBuffers.at(info.binding);
-        uniformBlock.updateDataOnCPU(sizeof(value), info.offset, (uint8*)&value);
-        mUniformBuffersWereModified = true;
+        setParameterData(makeParamHandle(info), sizeof(value), &value);
     }
 
     void Material::setVec2(const String &name, const Vec2f &vec) {
         const auto& info = mPipeline->getShader()->getParameterInfo(name);
-        auto& uniformBlock = mUniformBuffers.at(info.binding);
-        uniformBlock.updateDataOnCPU(sizeof(vec), info.offset, (uint8*)&vec);
-        mUniformBuffersWereModified = true;
+        setParameterData(makeParamHandle(info), sizeof(vec), &vec);
     }
 
     void Material::setVec3(const String &name, const Vec3f &vec) {
         const auto& info = mPipeline->getShader()->getParameterInfo(name);
-        auto& uniformBlock = mUniformBuffers.at(info.binding);
-        uniformBlock.updateDataOnCPU(sizeof(vec), info.offset, (uint8*)&vec);
-        mUniformBuffersWereModified = true;
+        setParameterData(makeParamHandle(info), sizeof(vec), &vec);
     }
 
     void Material::setVec4(const String &name, const Vec4f &vec) {
         const auto& info = mPipeline->getShader()->getParameterInfo(name);
-        auto& uniformBlock = mUniformBuffers.at(info.binding);
-        uniformBlock.updateDataOnCPU(sizeof(vec), info.offset, (uint8*)&vec);
-        mUniformBuffersWereModified = true;
+        setParameterData(makeParamHandle(info), sizeof(vec), &vec);
     }
 
     void Material::setMat4(const ignimbrite::String &name, const ignimbrite::Mat4f &mat) {
         const auto& info = mPipeline->getShader()->getParameterInfo(name);
-        auto& uniformBlock = mUniformBuffers.at(info.binding);
-        uniformBlock.updateDataOnCPU(sizeof(mat), info.offset, (uint8*)&mat);
-        mUniformBuffersWereModified = true;
+        setParameterData(makeParamHandle(info), sizeof(mat), &mat);
+    }
+
+    Material::ParamHandle Material::findParam(const String &name) const {
+        const auto& params = mPipeline->getShader()->getParametersInfo();
+        auto found = params.find(name);
+
+        if (found == params.end())
+            return ParamHandle();
+
+        // Textures are set by name only
+        auto type = found->second.type;
+        if (type == Shader::DataType::Sampler2D || type == Shader::DataType::SamplerCubemap)
+            return ParamHandle();
+
+        return makeParamHandle(found->second);
+    }
+
+    void Material::setInt(const ParamHandle &param, int32 value) {
+        setParameterData(param, sizeof(value), &value);
+    }
+
+    void Material::setFloat(const ParamHandle &param, float32 value) {
+        setParameterData(param, sizeof(value), &value);
+    }
+
+    void Material::setVec2(const ParamHandle &param, const Vec2f &vec) {
+        setParameterData(param, sizeof(vec), &vec);
+    }
+
+    void Material::setVec3(const ParamHandle &param, const Vec3f &vec) {
+        setParameterData(param, sizeof(vec), &vec);
+    }
+
+    void Material::setVec4(const ParamHandle &param, const Vec4f &vec) {
+        setParameterData(param, sizeof(vec), &vec);
+    }
+
+    void Material::setMat4(const ParamHandle &param, const Mat4f &mat) {
+        setParameterData(param, sizeof(mat), &mat);
+    }
+
+    Material::ParamHandle Material::makeParamHandle(const Shader::ParameterInfo &info) const {
+        if (info.type == Shader::DataType::Sampler2D || info.type == Shader::DataType::SamplerCubemap) {
+            throw std::runtime_error("Textures parameters could not be accessed with param handle");
+        }
+
+        ParamHandle param;
+        param.offset = info.offset;
+        param.pushConstant = info.pushConstant;
+
+        if (!info.pushConstant) {
+            auto found = std::lower_bound(mBufferBindings.begin(), mBufferBindings.end(), info.binding);
+            param.slot = (uint32) (found - mBufferBindings.begin());
+        }
+
+        return param;
+    }
+
+    void Material::setParameterData(const ParamHandle &param, uint32 size, const void *data) {
+        if (param.pushConstant) {
+            // Pushed with each bind, uniform buffers are not touched
+            auto dst = mPushConstantData.data() + param.offset;
+
+            if (std::memcmp(dst, data, size) != 0) {
+                std::memcpy(dst, data, size);
+                mBindingVersion += 1;
+            }
+        } else {
+            mBufferSlots[param.slot]->updateDataOnCPU(size, param.offset, (const uint8*) data);
+            mUniformBuffersWereModified = true;
+            mDataVersion += 1;
+        }
     }
 
     void Material::setTexture(const String &name, RefCounted<Texture> texture) {
@@ -97,8 +209,13 @@ namespace ignimbrite {
             throw std::runtime_error("Texture with name " + name + " must be a cubemap and not 2D");
         }
 
-        mTextures[info.binding] = std::move(texture);
-        mUniformTexturesWereModified = true;
+        auto& current = mTextures[info.binding];
+
+        // Set is recreated only if texture is actually changed
+        if (current != texture) {
+            current = std::move(texture);
+            mUniformTexturesWereModified = true;
+        }
     }
 
     void Material::setAll2DTextures(RefCounted<Texture> defaultTexture) {
@@ -116,27 +233,44 @@ namespace ignimbrite {
         }
     }
 
-    void Material::bindGraphicsPipeline() {
-        auto pipeline = mPipeline->getHandle();
-        if (!PipelineContext::isPipelineCached(pipeline)) {
-            mDevice->drawListBindPipeline(pipeline);
-            PipelineContext::cachePipelineBinding(pipeline);
-        }
+    void Material::bindGraphicsPipeline(bool depthEqual) {
+        const auto& variant = mPipeline->getDepthEqualHandle();
+        const auto& handle = depthEqual && variant.isNotNull() ? variant : mPipeline->getHandle();
+
+        // Redundant binds are filtered by device
+        mDevice->drawListBindPipeline(handle);
     }
 
     void Material::bindUniformData() {
-        mDevice->drawListBindUniformSet(mUniformSet);
+        // Set is null, if program has only push constants
+        if (mUniformSet.isNotNull()) {
+            if (mUniformRing != nullptr)
+                mDevice->drawListBindUniformSet(mUniformSet, mDynamicOffsets);
+            else
+                mDevice->drawListBindUniformSet(mUniformSet);
+        }
+
+        for (const auto& range: mPushConstantRanges) {
+            mDevice->drawListPushConstants(range.flags, range.offset, range.size, mPushConstantData.data() + range.offset);
+        }
     }
 
     void Material::updateUniformData() {
         // Firstly, update uniform buffers on GPU if needed
-        if (mUniformBuffersWereModified) {
+        if (mUniformRing != nullptr) {
+            updateRingData();
+        } else if (mUniformBuffersWereModified) {
             for (auto& buffer: mUniformBuffers) {
                 buffer.second.updateDataOnGPU();
             }
         }
-        // If textures were modified, therefore we need to recreate uniform set
-        if (mUniformTexturesWereModified || mUniformSet.isNull()) {
+
+        bool ringChanged = mUniformRing != nullptr && mRingVersion != mUniformRing->getVersion();
+        // Program could have only push constants, which are not a part of the set
+        bool hasUniforms = !mTextures.empty() || !mUniformBuffers.empty();
+
+        // If textures were modified (or ring buffer recreated), therefore we need to recreate uniform set
+        if (hasUniforms && (mUniformTexturesWereModified || mUniformSet.isNull() || ringChanged)) {
             IRenderDevice::UniformSetDesc setDesc;
             setDesc.textures.reserve(mTextures.size());
             setDesc.buffers.reserve(mUniformBuffers.size());
@@ -155,29 +289,130 @@ namespace ignimbrite {
                 bufferDesc.binding = p.first;
                 bufferDesc.offset = 0;
                 bufferDesc.range = p.second.getBufferSize();
-                bufferDesc.buffer = p.second.getHandle();
+                bufferDesc.buffer = mUniformRing != nullptr ? mUniformRing->getHandle() : p.second.getHandle();
 
                 setDesc.buffers.push_back(bufferDesc);
             }
 
             if (mUniformSet.isNotNull()) {
-                mDevice->destroyUniformSet(mUniformSet);
+                // Set could be bound in this frame by instances of the material
+                if (mUniformRing != nullptr)
+                    mUniformRing->retireUniformSet(mUniformSet);
+                else
+                    mDevice->destroyUniformSet(mUniformSet);
             }
 
             mUniformSet = mDevice->createUniformSet(setDesc, mPipeline->getShader()->getLayout());
+            mBindingVersion += 1;
 
             if (mUniformSet.isNull()) {
                 throw std::runtime_error("Failed to create uniform set for material");
             }
+
+            if (mUniformRing != nullptr) {
+                mRingVersion = mUniformRing->getVersion();
+            }
         }
 
         mUniformBuffersWereModified = false;
         mUniformTexturesWereModified = false;
     }
 
+    void Material::updateRingData() {
+        // Data of the previous frames could be overwritten, therefore it is written at least once per frame
+        bool sameFrame = mRingFrameNumber == mUniformRing->getFrameNumber() && mRingVersion == mUniformRing->getVersion();
+
+        if (!mUniformBuffersWereModified && sameFrame)
+            return;
+
+        uint32 version;
+
+        // If ring buffer was recreated while allocation, all the data must be written to the new one
+        do {
+            version = mUniformRing->getVersion();
+
+            for (uint32 i = 0; i < mBufferSlots.size(); i++) {
+                const auto& buffer = *mBufferSlots[i];
+                auto memory = allocateRingData(mBufferSlots, i, !sameFrame);
+                std::memcpy(memory, buffer.getData().data(), buffer.getBufferSize());
+            }
+        } while (version != mUniformRing->getVersion());
+
+        mRingFrameNumber = mUniformRing->getFrameNumber();
+    }
+
+    uint8 *Material::allocateRingData(const std::vector<UniformBuffer*> &buffers, uint32 slot, bool firstWrite) {
+        // Draws of this frame could reference data of the previous writes, therefore only the first one is static
+        if (!firstWrite)
+            return mUniformRing->allocate(buffers[slot]->getBufferSize(), mDynamicOffsets[slot]);
+
+        auto alignment = mUniformRing->getAlignment();
+        auto align = [alignment](uint32 size) { return (size + alignment - 1) & ~(alignment - 1); };
+
+        if (mStaticSize == 0) {
+            for (auto buffer: buffers) {
+                mStaticSize += align(buffer->getBufferSize());
+            }
+
+            mStaticOffset = mUniformRing->allocateStatic(mStaticSize);
+        }
+
+        uint32 offset = mStaticOffset;
+        for (uint32 i = 0; i < slot; i++) {
+            offset += align(buffers[i]->getBufferSize());
+        }
+
+        return mUniformRing->getStaticData(offset, mDynamicOffsets[slot]);
+    }
+
+    bool Material::hasEqualParams(const Material &other, const String &ignoredBlock) const {
+        if (this == &other)
+            return true;
+
+        // Instances store only overrides, therefore are compared by themselves
+        if (dynamic_cast<const MaterialInstance*>(&other) != nullptr)
+            return other.hasEqualParams(*this, ignoredBlock);
+
+        if (mPipeline != other.mPipeline || mTextures.size() != other.mTextures.size())
+            return false;
+
+        for (const auto& p: mTextures) {
+            auto found = other.mTextures.find(p.first);
+
+            if (found == other.mTextures.end() || found->second != p.second)
+                return false;
+        }
+
+        const auto& buffersInfo = mPipeline->getShader()->getBuffersInfo();
+        auto ignored = buffersInfo.find(ignoredBlock);
+        auto ignoredBinding = ignored != buffersInfo.end() ? ignored->second.binding : 0xffffffff;
+
+        for (const auto& p: mUniformBuffers) {
+            if (p.first == ignoredBinding)
+                continue;
+
+            if (p.second.getData() != other.mUniformBuffers.at(p.first).getData())
+                return false;
+        }
+
+        for (const auto& p: mPipeline->getShader()->getPushConstantsInfo()) {
+            if (p.first == ignoredBlock)
+                continue;
+
+            auto offset = p.second.offset;
+            auto size = p.second.size;
+
+            if (std::memcmp(mPushConstantData.data() + offset, other.mPushConstantData.data() + offset, size) != 0)
+                return false;
+        }
+
+        return true;
+    }
+
     RefCounted<Material> Material::clone() const {
         RefCounted<Material> mat = std::make_shared<Material>(mDevice);
         mat->setGraphicsPipeline(mPipeline);
+        mat->setUniformRing(mUniformRing);
         mat->createMaterial();
 
         int expectedTextureCount = 0;
@@ -200,6 +435,8 @@ namespace ignimbrite {
             mat->mUniformBuffers.at(p.first).updateDataOnCPU(p.second.getBufferSize(), 0, p.second.getData().data());
         }
 
+        mat->mPushConstantData = mPushConstantData;
+
         mat->mUniformBuffersWereModified = true;
         mat->mUniformTexturesWereModified = true;
         mat->updateUniformData();
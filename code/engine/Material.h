@@ -16,6 +16,7 @@
 #include <Texture.h>
 #include <UniformBuffer.h>
 #include <GraphicsPipeline.h>
+#include <UniformRingBuffer.h>
 
 namespace ignimbrite {
 
@@ -44,11 +45,32 @@ namespace ignimbrite {
     class Material : public CacheItem {
     public:
 
+        /**
+         * Pre-resolved location of the uniform or push constant parameter.
+         * Handle depends only on material shader, therefore it could be reused
+         * for the all materials (and its clones) with the same shader.
+         */
+        struct ParamHandle {
+            /** Index of the uniform buffer in order of bindings */
+            uint32 slot = 0xffffffff;
+            /** Offset in the buffer or in push constants memory */
+            uint32 offset = 0;
+            bool pushConstant = false;
+
+            bool isValid() const { return pushConstant || slot != 0xffffffff; }
+        };
+
         explicit Material(RefCounted<IRenderDevice> device);
         ~Material() override;
 
         void setGraphicsPipeline(RefCounted<GraphicsPipeline> pipeline);
 
+        /**
+         * Write uniform data into per-frame ring buffer instead of own buffers (must be set before
+         * material creation). Shader uniform layout must be generated with dynamic buffers.
+         */
+        void setUniformRing(RefCounted<UniformRingBuffer> ring);
+
         void createMaterial();
         void releaseMaterial();
 
@@ -64,8 +86,20 @@ namespace ignimbrite {
         void setVec4(const String& name, const Vec4f& vec);
         /** Set mat4 value directly mapped to the GPU uniform params */
         void setMat4(const String& name, const Mat4f& mat);
+
+        /** @return Handle of the parameter (invalid if shader has no non-texture param with this name) */
+        ParamHandle findParam(const String& name) const;
+
+        /** Set values by pre-resolved handles (no name look-ups, handle must be valid) */
+        void setInt(const ParamHandle& param, int32 value);
+        void setFloat(const ParamHandle& param, float32 value);
+        void setVec2(const ParamHandle& param, const Vec2f& vec);
+        void setVec3(const ParamHandle& param, const Vec3f& vec);
+        void setVec4(const ParamHandle& param, const Vec4f& vec);
+        void setMat4(const ParamHandle& param, const Mat4f& mat);
+
         /** Set texture directly mapped to the GPU uniform params */
-        void setTexture(const String& name, RefCounted<Texture> texture);
+        virtual void setTexture(const String& name, RefCounted<Texture> texture);
 
         /**
          * Set all 2D textures in this material to specified default one.
@@ -74,28 +108,81 @@ namespace ignimbrite {
          */
         void setAll2DTextures(RefCounted<Texture> defaultTexture);
 
-        /** Bind this material graphics pipeline as active rendering target */
-        void bindGraphicsPipeline();
-        /** Bind this material graphics pipeline as active rendering target */
-        void bindUniformData();
+        /**
+         * Bind this material graphics pipeline as active rendering target
+         * @param depthEqual Bind depth EQUAL variant of the pipeline, if it is created (see GraphicsPipeline)
+         */
+        void bindGraphicsPipeline(bool depthEqual = false);
+        /** Bind uniform set and push constants of this material (pipeline must be bound) */
+        virtual void bindUniformData();
         /** Writes all the uniform data to uniform buffers on GPU */
-        void updateUniformData();
+        virtual void updateUniformData();
+
+        /**
+         * Compare materials for instanced rendering.
+         * @param ignoredBlock Name of the uniform block, which data is not compared (per-object params)
+         * @return True if materials have the same pipeline, textures and uniform data
+         */
+        virtual bool hasEqualParams(const Material& other, const String& ignoredBlock) const;
 
         /** Creates instance of this material, modifiable copy of the one */
-        RefCounted<Material> clone() const;
+        virtual RefCounted<Material> clone() const;
         const RefCounted<GraphicsPipeline> &getGraphicsPipeline() const;
+        virtual const ID<IRenderDevice::UniformSet> &getUniformSet() const { return mUniformSet; }
+
+        /**
+         * @return Version of the bound pipeline, uniform set and push constants.
+         *         Recorded binds of the material are valid while version and dynamic offsets are the same.
+         */
+        virtual uint32 getBindingVersion() const { return mBindingVersion; }
+        /**
+         * @return Offsets of the uniform buffers in the ring (empty if material has own buffers).
+         *         First data update in the frame is written into static memory of the material,
+         *         therefore offsets are the same in the same frame slot until the ring is recreated.
+         */
+        const std::vector<uint32> &getDynamicOffsets() const { return mDynamicOffsets; }
 
     private:
+        friend class MaterialInstance;
 
         bool mUniformBuffersWereModified = true;
         bool mUniformTexturesWereModified = true;
 
+        void updateRingData();
+        /** @return Memory for the data of the buffer slot: static memory for the first write in the frame, otherwise transient */
+        uint8* allocateRingData(const std::vector<UniformBuffer*> &buffers, uint32 slot, bool firstWrite);
+        ParamHandle makeParamHandle(const Shader::ParameterInfo &info) const;
+        /** Write parameter data into its uniform buffer or push constants memory */
+        virtual void setParameterData(const ParamHandle &param, uint32 size, const void *data);
+
         RefCounted<IRenderDevice> mDevice;
         RefCounted<GraphicsPipeline> mPipeline;
 
+        /** Ring buffer for uniform data (null if material has own uniform buffers) */
+        RefCounted<UniformRingBuffer> mUniformRing;
+        /** Version of the ring buffer, referenced by uniform set */
+        uint32 mRingVersion = 0;
+        /** Frame number of the last data write into ring buffer */
+        uint64 mRingFrameNumber = 0;
+        /** Current offsets of the buffers in the ring (in order of the buffer slots) */
+        std::vector<uint32> mDynamicOffsets;
+        /** Static memory for the buffers in the ring (allocated on the first write) */
+        uint32 mStaticOffset = 0;
+        uint32 mStaticSize = 0;
+
+        /** Push constants data and ranges of the shader blocks (pushed on each bind) */
+        std::vector<IRenderDevice::UniformLayoutPushConstantDesc> mPushConstantRanges;
+        std::vector<uint8> mPushConstantData;
+
         /** Data, specific for concrete material */
         ID<IRenderDevice::UniformSet> mUniformSet;
         std::unordered_map<uint32, UniformBuffer> mUniformBuffers;
+        /** Sorted bindings of the uniform buffers and the buffers in the same order (accessed by param handles) */
+        std::vector<uint32> mBufferBindings;
+        std::vector<UniformBuffer*> mBufferSlots;
+        /** Changed on each uniform buffers data modification (tracked by instances) */
+        uint32 mDataVersion = 0;
+        uint32 mBindingVersion = 0;
         std::unordered_map<uint32, RefCounted<Texture>> mTextures;
     };
 
@@ -0,0 +1,205 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <MaterialInstance.h>
+#include <algorithm>
+#include <cstring>
+
+namespace ignimbrite {
+
+    MaterialInstance::MaterialInstance(RefCounted<Material> parent)
+        : Material(parent != nullptr ? parent->mDevice : nullptr), mParent(std::move(parent)) {
+
+        if (mParent == nullptr)
+            throw std::runtime_error("An attempt to create instance of null material");
+
+        if (mParent->mUniformRing == nullptr)
+            throw std::runtime_error("Parent material must be created with uniform ring buffer");
+
+        // Layout of the params is the same, therefore param handles of the parent are valid
+        mPipeline = mParent->mPipeline;
+        mUniformRing = mParent->mUniformRing;
+        mBufferBindings = mParent->mBufferBindings;
+        mDynamicOffsets.resize(mBufferBindings.size(), 0);
+        mPushConstantRanges = mParent->mPushConstantRanges;
+    }
+
+    void MaterialInstance::setTexture(const String &name, RefCounted<Texture> texture) {
+        mParent->setTexture(name, std::move(texture));
+    }
+
+    void MaterialInstance::setParameterData(const ParamHandle &param, uint32 size, const void *data) {
+        bool modified = false;
+
+        for (auto& o: mOverrides) {
+            if (o.param.pushConstant == param.pushConstant && o.param.slot == param.slot &&
+                o.param.offset == param.offset && o.size == size) {
+                auto dst = mOverridesData.data() + o.dataOffset;
+
+                // Pushed data is recorded with binds
+                if (param.pushConstant && std::memcmp(dst, data, size) == 0)
+                    return;
+
+                std::memcpy(dst, data, size);
+                modified = true;
+                break;
+            }
+        }
+
+        if (!modified) {
+            Override o = { param, size, (uint32) mOverridesData.size() };
+            mOverrides.push_back(o);
+            mOverridesData.insert(mOverridesData.end(), (const uint8*) data, (const uint8*) data + size);
+        }
+
+        if (param.pushConstant) {
+            mBindingVersion += 1;
+        } else {
+            mUniformBuffersWereModified = true;
+        }
+    }
+
+    void MaterialInstance::bindUniformData() {
+        const auto& uniformSet = mParent->mUniformSet;
+
+        if (uniformSet.isNotNull()) {
+            mDevice->drawListBindUniformSet(uniformSet, mDynamicOffsets);
+        }
+
+        if (!mPushConstantRanges.empty()) {
+            mPushConstantData = mParent->mPushConstantData;
+
+            for (const auto& o: mOverrides) {
+                if (o.param.pushConstant)
+                    std::memcpy(mPushConstantData.data() + o.param.offset, mOverridesData.data() + o.dataOffset, o.size);
+            }
+
+            for (const auto& range: mPushConstantRanges) {
+                mDevice->drawListPushConstants(range.flags, range.offset, range.size, mPushConstantData.data() + range.offset);
+            }
+        }
+    }
+
+    void MaterialInstance::updateUniformData() {
+        const auto& ring = mUniformRing;
+
+        // Shared set and data of the parent must be valid
+        mParent->updateUniformData();
+
+        bool firstWrite = mRingFrameNumber != ring->getFrameNumber() || mRingVersion != ring->getVersion();
+
+        if (!mUniformBuffersWereModified && !firstWrite && mParentDataVersion == mParent->mDataVersion)
+            return;
+
+        uint32 version;
+
+        do {
+            version = ring->getVersion();
+
+            for (uint32 i = 0; i < mBufferBindings.size(); i++) {
+                const auto& buffer = *mParent->mBufferSlots[i];
+                auto memory = allocateRingData(mParent->mBufferSlots, i, firstWrite);
+                std::memcpy(memory, buffer.getData().data(), buffer.getBufferSize());
+
+                for (const auto& o: mOverrides) {
+                    if (!o.param.pushConstant && o.param.slot == i)
+                        std::memcpy(memory + o.param.offset, mOverridesData.data() + o.dataOffset, o.size);
+                }
+            }
+
+            // If ring buffer was recreated, parent set must reference the new one, as written data of instance
+            mParent->updateUniformData();
+        } while (version != ring->getVersion());
+
+        mRingVersion = version;
+        mRingFrameNumber = ring->getFrameNumber();
+        mParentDataVersion = mParent->mDataVersion;
+        mUniformBuffersWereModified = false;
+    }
+
+    bool MaterialInstance::hasEqualParams(const Material &other, const String &ignoredBlock) const {
+        if (this == &other)
+            return true;
+
+        auto instance = dynamic_cast<const MaterialInstance*>(&other);
+
+        if (instance == nullptr || instance->mParent != mParent)
+            return false;
+
+        const auto& shader = mPipeline->getShader();
+        const auto& buffersInfo = shader->getBuffersInfo();
+        const auto& pushConstantsInfo = shader->getPushConstantsInfo();
+
+        uint32 ignoredSlot = 0xffffffff;
+        uint32 ignoredPushBegin = 0;
+        uint32 ignoredPushEnd = 0;
+
+        auto buffer = buffersInfo.find(ignoredBlock);
+        if (buffer != buffersInfo.end()) {
+            auto found = std::lower_bound(mBufferBindings.begin(), mBufferBindings.end(), buffer->second.binding);
+            ignoredSlot = (uint32) (found - mBufferBindings.begin());
+        }
+
+        auto pushConstants = pushConstantsInfo.find(ignoredBlock);
+        if (pushConstants != pushConstantsInfo.end()) {
+            ignoredPushBegin = pushConstants->second.offset;
+            ignoredPushEnd = pushConstants->second.offset + pushConstants->second.size;
+        }
+
+        auto isIgnored = [&](const Override& o) {
+            if (o.param.pushConstant)
+                return o.param.offset >= ignoredPushBegin && o.param.offset < ignoredPushEnd;
+            else
+                return o.param.slot == ignoredSlot;
+        };
+
+        for (uint32 i = 0; i < mOverrides.size(); i++) {
+            if (!isIgnored(mOverrides[i]) && !hasEqualOverride(*instance, i))
+                return false;
+        }
+
+        for (uint32 i = 0; i < instance->mOverrides.size(); i++) {
+            if (!isIgnored(instance->mOverrides[i]) && !instance->hasEqualOverride(*this, i))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool MaterialInstance::hasEqualOverride(const MaterialInstance &other, uint32 index) const {
+        const auto& o = mOverrides[index];
+
+        for (const auto& p: other.mOverrides) {
+            if (p.param.pushConstant == o.param.pushConstant && p.param.slot == o.param.slot &&
+                p.param.offset == o.param.offset && p.size == o.size) {
+                return std::memcmp(mOverridesData.data() + o.dataOffset, other.mOverridesData.data() + p.dataOffset, o.size) == 0;
+            }
+        }
+
+        return false;
+    }
+
+    RefCounted<Material> MaterialInstance::clone() const {
+        auto instance = std::make_shared<MaterialInstance>(mParent);
+        instance->mOverrides = mOverrides;
+        instance->mOverridesData = mOverridesData;
+
+        return instance;
+    }
+
+    const ID<IRenderDevice::UniformSet> &MaterialInstance::getUniformSet() const {
+        return mParent->getUniformSet();
+    }
+
+    uint32 MaterialInstance::getBindingVersion() const {
+        // Both versions only grow, so the sum is changed with any of them
+        return mBindingVersion + mParent->getBindingVersion();
+    }
+
+}
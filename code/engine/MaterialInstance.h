@@ -0,0 +1,77 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_MATERIALINSTANCE_H
+#define IGNIMBRITE_MATERIALINSTANCE_H
+
+#include <Material.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Lightweight instance of the material
+     *
+     * Instance references parent material and shares its pipeline,
+     * textures and uniform set. Only overridden params are stored.
+     *
+     * Uniform data of the instance (parent data with applied overrides)
+     * is written into the parent uniform ring buffer and bound with
+     * instance dynamic offsets, therefore instances do not have any
+     * GPU buffers or uniform sets and are nearly free to create.
+     *
+     * Parent material must be created with uniform ring buffer.
+     * Instance is ready for rendering after construction.
+     */
+    class MaterialInstance : public Material {
+    public:
+
+        explicit MaterialInstance(RefCounted<Material> parent);
+        ~MaterialInstance() override = default;
+
+        /** Textures are shared, therefore set for the parent and all its instances (use clone of the parent for own textures) */
+        void setTexture(const String& name, RefCounted<Texture> texture) override;
+
+        void bindUniformData() override;
+        void updateUniformData() override;
+
+        /** Instances are equal if they have the same parent and the same overrides */
+        bool hasEqualParams(const Material& other, const String& ignoredBlock) const override;
+
+        /** Creates instance of the same parent with copy of the overrides */
+        RefCounted<Material> clone() const override;
+        const ID<IRenderDevice::UniformSet> &getUniformSet() const override;
+        /** Instance binds the parent set and push constants, therefore depends on the parent version */
+        uint32 getBindingVersion() const override;
+
+        const RefCounted<Material> &getParent() const { return mParent; }
+        uint32 getOverridesCount() const { return (uint32) mOverrides.size(); }
+
+    private:
+
+        void setParameterData(const ParamHandle &param, uint32 size, const void *data) override;
+        bool hasEqualOverride(const MaterialInstance &other, uint32 index) const;
+
+        struct Override {
+            ParamHandle param;
+            uint32 size;
+            /** Offset of the value in overrides data */
+            uint32 dataOffset;
+        };
+
+        /** Parent data version of the last write into ring buffer */
+        uint32 mParentDataVersion = 0;
+
+        RefCounted<Material> mParent;
+        std::vector<Override> mOverrides;
+        std::vector<uint8> mOverridesData;
+    };
+
+}
+
+#endif //IGNIMBRITE_MATERIALINSTANCE_H
@@ -0,0 +1,435 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <OcclusionBuffer.h>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define IGNIMBRITE_OCCLUSION_SSE
+#endif
+
+namespace ignimbrite {
+
+    /** Depth of pixels without occluders */
+    static const float32 FAR_DEPTH = std::numeric_limits<float32>::max();
+    /** Minimal w of vertices, which are considered to be in front of the camera */
+    static const float32 MIN_W = 1e-5f;
+    /** Maximum depth difference of the triangles, merged into quad */
+    static const float32 MAX_PLANE_DEVIATION = 1e-4f;
+
+    OcclusionBuffer::OcclusionBuffer(uint32 width, uint32 height) {
+        setResolution(width, height);
+    }
+
+    void OcclusionBuffer::setResolution(uint32 width, uint32 height) {
+        if (width == 0 || height == 0)
+            throw std::runtime_error("Occlusion buffer resolution must be non-zero");
+
+        mTilesX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+        mTilesY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+        mWidth = mTilesX * TILE_WIDTH;
+        mHeight = mTilesY * TILE_HEIGHT;
+
+        mDepth.resize(mTilesX * mTilesY * TILE_SIZE);
+        mTileMaxDepth.resize(mTilesX * mTilesY);
+
+        mPolygons.clear();
+        clearDepth();
+    }
+
+    void OcclusionBuffer::begin(const Mat4f &viewProj) {
+        mViewProj = viewProj;
+        mPolygons.clear();
+        clearDepth();
+    }
+
+    void OcclusionBuffer::addOccluder(const Mesh &mesh, const Mat4f &transform) {
+        auto m = mViewProj * transform;
+        auto stride = mesh.getStride();
+        auto data = mesh.getVertexData();
+        auto vertexCount = mesh.getVertexCount();
+
+        // Position is always the first attribute
+        mClipVertices.resize(vertexCount);
+        for (uint32 i = 0; i < vertexCount; i++) {
+            Vec3f p;
+            std::memcpy(&p, data + i * stride, sizeof(Vec3f));
+            mClipVertices[i] = m * Vec4f(p, 1.0f);
+        }
+
+        auto indices = mesh.getIndexData();
+        auto indicesCount = mesh.getIndicesCount();
+
+        for (uint32 i = 0; i + 2 < indicesCount; i += 3) {
+            Polygon polygon;
+            Polygon next;
+
+            if (!projectTriangle(indices + i, polygon))
+                continue;
+
+            // Quads are usually stored as pairs of adjacent triangles
+            if (i + 5 < indicesCount && projectTriangle(indices + i + 3, next) &&
+                mergeTriangle(polygon, indices + i, next, indices + i + 3)) {
+                i += 3;
+            }
+
+            addPolygon(polygon);
+        }
+    }
+
+    bool OcclusionBuffer::projectTriangle(const uint32 *indices, Polygon &polygon) const {
+        auto width = (float32) mWidth;
+        auto height = (float32) mHeight;
+
+        for (uint32 k = 0; k < 3; k++) {
+            const auto& c = mClipVertices[indices[k]];
+
+            // Clipping is not done: such triangles are ignored to keep culling conservative
+            if (c.w < MIN_W || c.z < -c.w)
+                return false;
+
+            auto invW = 1.0f / c.w;
+            polygon.v[k] = Vec3f((c.x * invW * 0.5f + 0.5f) * width, (c.y * invW * 0.5f + 0.5f) * height, c.z * invW);
+        }
+
+        const auto& v0 = polygon.v[0];
+        const auto& v1 = polygon.v[1];
+        const auto& v2 = polygon.v[2];
+
+        auto area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+
+        if (glm::abs(area) < 1e-8f)
+            return false;
+
+        // Depth is linear in screen space
+        polygon.count = 3;
+        polygon.dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        polygon.dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+        polygon.z0 = v0.z - polygon.dzdx * v0.x - polygon.dzdy * v0.y;
+
+        return true;
+    }
+
+    bool OcclusionBuffer::mergeTriangle(Polygon &polygon, const uint32 *indices, const Polygon &triangle, const uint32 *triangleIndices) {
+        // Find vertex of the triangle, which is not shared with polygon
+        uint32 shared = 0;
+        uint32 other = 0;
+
+        for (uint32 k = 0; k < 3; k++) {
+            auto index = triangleIndices[k];
+
+            if (index == indices[0] || index == indices[1] || index == indices[2])
+                shared += 1;
+            else
+                other = k;
+        }
+
+        if (shared != 2)
+            return false;
+
+        // Other vertex is inserted into the shared edge (j, j + 1)
+        uint32 j = 0;
+        while (!((triangleIndices[0] == indices[j] || triangleIndices[1] == indices[j] || triangleIndices[2] == indices[j]) &&
+                 (triangleIndices[0] == indices[(j + 1) % 3] || triangleIndices[1] == indices[(j + 1) % 3] || triangleIndices[2] == indices[(j + 1) % 3]))) {
+            j += 1;
+        }
+
+        Vec3f quad[4] = {
+            polygon.v[j], triangle.v[other], polygon.v[(j + 1) % 3], polygon.v[(j + 2) % 3]
+        };
+
+        // Quad must be convex: all the corners turn to the same side
+        float32 turns[4];
+        for (uint32 k = 0; k < 4; k++) {
+            const auto& a = quad[k];
+            const auto& b = quad[(k + 1) % 4];
+            const auto& c = quad[(k + 2) % 4];
+            turns[k] = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+        }
+
+        bool convex = (turns[0] > 0.0f && turns[1] > 0.0f && turns[2] > 0.0f && turns[3] > 0.0f) ||
+                      (turns[0] < 0.0f && turns[1] < 0.0f && turns[2] < 0.0f && turns[3] < 0.0f);
+
+        if (!convex)
+            return false;
+
+        // Depth of both triangles is bounded by the polygon plane, moved by the deviation of the other vertex
+        const auto& v = triangle.v[other];
+        auto deviation = v.z - (polygon.z0 + polygon.dzdx * v.x + polygon.dzdy * v.y);
+
+        if (glm::abs(deviation) > MAX_PLANE_DEVIATION)
+            return false;
+
+        for (uint32 k = 0; k < 4; k++) {
+            polygon.v[k] = quad[k];
+        }
+
+        polygon.count = 4;
+        polygon.z0 += glm::max(deviation, 0.0f);
+
+        return true;
+    }
+
+    void OcclusionBuffer::addPolygon(Polygon &polygon) {
+        auto width = (float32) mWidth;
+        auto height = (float32) mHeight;
+
+        auto minX = polygon.v[0].x;
+        auto maxX = polygon.v[0].x;
+        polygon.minY = polygon.v[0].y;
+        polygon.maxY = polygon.v[0].y;
+
+        for (uint32 k = 1; k < polygon.count; k++) {
+            minX = glm::min(minX, polygon.v[k].x);
+            maxX = glm::max(maxX, polygon.v[k].x);
+            polygon.minY = glm::min(polygon.minY, polygon.v[k].y);
+            polygon.maxY = glm::max(polygon.maxY, polygon.v[k].y);
+        }
+
+        if (maxX < 0.0f || minX >= width || polygon.maxY < 0.0f || polygon.minY >= height)
+            return;
+
+        mPolygons.push_back(polygon);
+    }
+
+    void OcclusionBuffer::rasterize(ThreadPool &threads) {
+        if (mPolygons.empty())
+            return;
+
+        auto tasksCount = (mTilesY + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+
+        threads.parallelFor(tasksCount, [&](uint32 task, uint32) {
+            auto firstRow = task * ROWS_PER_TASK;
+            auto lastRow = std::min(mTilesY, firstRow + ROWS_PER_TASK);
+            rasterizeTileRows(firstRow, lastRow);
+        });
+    }
+
+    bool OcclusionBuffer::isVisible(const AABB &box) const {
+        auto width = (float32) mWidth;
+        auto height = (float32) mHeight;
+
+        float32 minX = FAR_DEPTH, minY = FAR_DEPTH, minZ = FAR_DEPTH;
+        float32 maxX = -FAR_DEPTH, maxY = -FAR_DEPTH;
+
+        const auto& lo = box.getMinBounds();
+        const auto& hi = box.getMaxBounds();
+
+        for (uint32 i = 0; i < 8; i++) {
+            Vec4f p((i & 1u) ? hi.x : lo.x, (i & 2u) ? hi.y : lo.y, (i & 4u) ? hi.z : lo.z, 1.0f);
+            auto c = mViewProj * p;
+
+            // Box crosses near plane
+            if (c.w < MIN_W || c.z < -c.w)
+                return true;
+
+            auto invW = 1.0f / c.w;
+            auto x = (c.x * invW * 0.5f + 0.5f) * width;
+            auto y = (c.y * invW * 0.5f + 0.5f) * height;
+
+            minX = glm::min(minX, x);
+            maxX = glm::max(maxX, x);
+            minY = glm::min(minY, y);
+            maxY = glm::max(maxY, y);
+            minZ = glm::min(minZ, c.z * invW);
+        }
+
+        // Box outside of the screen is not our responsibility
+        if (maxX < 0.0f || minX >= width || maxY < 0.0f || minY >= height)
+            return true;
+
+        // All the pixels touched by the box
+        auto x0 = (uint32) glm::max(0.0f, glm::floor(minX));
+        auto x1 = (uint32) glm::min(width - 1.0f, glm::floor(maxX));
+        auto y0 = (uint32) glm::max(0.0f, glm::floor(minY));
+        auto y1 = (uint32) glm::min(height - 1.0f, glm::floor(maxY));
+
+        for (uint32 ty = y0 / TILE_HEIGHT; ty <= y1 / TILE_HEIGHT; ty++) {
+            for (uint32 tx = x0 / TILE_WIDTH; tx <= x1 / TILE_WIDTH; tx++) {
+                auto tile = ty * mTilesX + tx;
+
+                // All the tile pixels are closer than the box
+                if (mTileMaxDepth[tile] <= minZ)
+                    continue;
+
+                auto px0 = std::max(x0, tx * TILE_WIDTH);
+                auto px1 = std::min(x1, tx * TILE_WIDTH + TILE_WIDTH - 1);
+                auto py0 = std::max(y0, ty * TILE_HEIGHT);
+                auto py1 = std::min(y1, ty * TILE_HEIGHT + TILE_HEIGHT - 1);
+
+                // Box covers the whole tile, so farthest pixel is covered
+                if (px1 - px0 + 1 == TILE_WIDTH && py1 - py0 + 1 == TILE_HEIGHT)
+                    return true;
+
+                const float32* depth = mDepth.data() + tile * TILE_SIZE;
+
+                for (uint32 y = py0; y <= py1; y++) {
+                    for (uint32 x = px0; x <= px1; x++) {
+                        if (depth[(y % TILE_HEIGHT) * TILE_WIDTH + (x % TILE_WIDTH)] > minZ)
+                            return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    float32 OcclusionBuffer::getDepth(uint32 x, uint32 y) const {
+        return mDepth[getPixelIndex(x, y)];
+    }
+
+    void OcclusionBuffer::clearDepth() {
+        std::fill(mDepth.begin(), mDepth.end(), FAR_DEPTH);
+        std::fill(mTileMaxDepth.begin(), mTileMaxDepth.end(), FAR_DEPTH);
+    }
+
+    void OcclusionBuffer::rasterizeTileRows(uint32 firstRow, uint32 lastRow) {
+        auto minY = (float32) (firstRow * TILE_HEIGHT);
+        auto maxY = (float32) (lastRow * TILE_HEIGHT);
+
+        for (const auto& polygon: mPolygons) {
+            if (polygon.maxY < minY || polygon.minY >= maxY)
+                continue;
+
+            rasterizePolygon(polygon, firstRow, lastRow);
+        }
+    }
+
+    void OcclusionBuffer::rasterizePolygon(const Polygon &polygon, uint32 firstRow, uint32 lastRow) {
+        const auto count = polygon.count;
+        const auto* v = polygon.v;
+
+        float32 area = 0.0f;
+        for (uint32 i = 0; i < count; i++) {
+            area += v[i].x * v[(i + 1) % count].y - v[(i + 1) % count].x * v[i].y;
+        }
+
+        // Edge functions E(x,y) = A*x + B*y + C are non-negative inside the polygon.
+        // Functions are evaluated at pixel centers and shifted by the half pixel extent along
+        // the edge normal, so pixel passes only if it is completely inside the polygon.
+        float32 A[4], B[4], C[4];
+        float32 orientation = area > 0.0f ? 1.0f : -1.0f;
+
+        for (uint32 i = 0; i < count; i++) {
+            const auto& a = v[i];
+            const auto& b = v[(i + 1) % count];
+            A[i] = (a.y - b.y) * orientation;
+            B[i] = (b.x - a.x) * orientation;
+            C[i] = (a.x * b.y - a.y * b.x) * orientation - 0.5f * (glm::abs(A[i]) + glm::abs(B[i]));
+        }
+
+        // Pixel stores the farthest depth of its area: depth at center plus half pixel slope
+        auto dzdx = polygon.dzdx;
+        auto dzdy = polygon.dzdy;
+        auto zPixel = polygon.z0 + 0.5f * (glm::abs(dzdx) + glm::abs(dzdy));
+
+        auto minX = v[0].x;
+        auto maxX = v[0].x;
+        auto minZ = v[0].z;
+
+        for (uint32 i = 1; i < count; i++) {
+            minX = glm::min(minX, v[i].x);
+            maxX = glm::max(maxX, v[i].x);
+            minZ = glm::min(minZ, v[i].z);
+        }
+
+        auto x0 = (uint32) glm::max(0.0f, glm::floor(minX));
+        auto x1 = (uint32) glm::min((float32) mWidth - 1.0f, glm::floor(maxX));
+        auto y0 = (uint32) glm::max((float32) (firstRow * TILE_HEIGHT), glm::floor(polygon.minY));
+        auto y1 = (uint32) glm::min((float32) (lastRow * TILE_HEIGHT) - 1.0f, glm::floor(polygon.maxY));
+
+        if (x0 > x1 || y0 > y1)
+            return;
+
+        for (uint32 ty = y0 / TILE_HEIGHT; ty <= y1 / TILE_HEIGHT; ty++) {
+            for (uint32 tx = x0 / TILE_WIDTH; tx <= x1 / TILE_WIDTH; tx++) {
+                auto tile = ty * mTilesX + tx;
+
+                // Polygon is behind all the pixels of the tile
+                if (minZ >= mTileMaxDepth[tile])
+                    continue;
+
+                float32* depth = mDepth.data() + tile * TILE_SIZE;
+                auto rowFirst = std::max(y0, ty * TILE_HEIGHT);
+                auto rowLast = std::min(y1, ty * TILE_HEIGHT + TILE_HEIGHT - 1);
+                auto tileX = (float32) (tx * TILE_WIDTH);
+                bool written = false;
+
+                for (uint32 y = rowFirst; y <= rowLast; y++) {
+                    auto py = (float32) y + 0.5f;
+                    float32* row = depth + (y % TILE_HEIGHT) * TILE_WIDTH;
+
+#if defined(IGNIMBRITE_OCCLUSION_SSE)
+                    const __m128 zero = _mm_setzero_ps();
+                    const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+
+                    for (uint32 half = 0; half < TILE_WIDTH; half += 4) {
+                        __m128 px = _mm_add_ps(_mm_set1_ps(tileX + (float32) half), offsets);
+                        __m128 mask = _mm_set1_ps(0.0f);
+                        mask = _mm_cmpeq_ps(mask, mask);
+
+                        for (uint32 i = 0; i < count; i++) {
+                            __m128 e = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[i]), px), _mm_set1_ps(B[i] * py + C[i]));
+                            mask = _mm_and_ps(mask, _mm_cmpge_ps(e, zero));
+                        }
+
+                        if (_mm_movemask_ps(mask) == 0)
+                            continue;
+
+                        __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), px), _mm_set1_ps(zPixel + dzdy * py));
+                        __m128 d = _mm_loadu_ps(row + half);
+                        d = _mm_or_ps(_mm_and_ps(mask, _mm_min_ps(d, z)), _mm_andnot_ps(mask, d));
+                        _mm_storeu_ps(row + half, d);
+                        written = true;
+                    }
+#else
+                    for (uint32 i = 0; i < TILE_WIDTH; i++) {
+                        auto px = tileX + (float32) i + 0.5f;
+
+                        bool inside = true;
+                        for (uint32 e = 0; e < count; e++) {
+                            inside = inside && A[e] * px + (B[e] * py + C[e]) >= 0.0f;
+                        }
+
+                        if (!inside)
+                            continue;
+
+                        auto z = dzdx * px + (zPixel + dzdy * py);
+                        row[i] = glm::min(row[i], z);
+                        written = true;
+                    }
+#endif
+                }
+
+                if (written)
+                    updateTileDepth(tile);
+            }
+        }
+    }
+
+    void OcclusionBuffer::updateTileDepth(uint32 tile) {
+        const float32* depth = mDepth.data() + tile * TILE_SIZE;
+        float32 maxDepth = depth[0];
+
+        for (uint32 i = 1; i < TILE_SIZE; i++) {
+            maxDepth = glm::max(maxDepth, depth[i]);
+        }
+
+        mTileMaxDepth[tile] = maxDepth;
+    }
+
+    uint32 OcclusionBuffer::getPixelIndex(uint32 x, uint32 y) const {
+        auto tile = (y / TILE_HEIGHT) * mTilesX + (x / TILE_WIDTH);
+        return tile * TILE_SIZE + (y % TILE_HEIGHT) * TILE_WIDTH + (x % TILE_WIDTH);
+    }
+
+}
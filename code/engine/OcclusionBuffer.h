@@ -0,0 +1,121 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_OCCLUSIONBUFFER_H
+#define IGNIMBRITE_OCCLUSIONBUFFER_H
+
+#include <Mesh.h>
+#include <ThreadPool.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Software depth buffer for occlusion culling
+     *
+     * Occluders (low-poly meshes) are rasterized on CPU into small depth buffer,
+     * split into tiles of 8x8 pixels. Each tile stores its pixels contiguously
+     * and keeps the farthest depth of its pixels, so boxes are tested tile by
+     * tile and pixels are visited only for partially covered tiles.
+     *
+     * Rasterization is conservative: pixel is written only if triangle covers
+     * it completely, and pixel keeps the farthest depth of the triangle over it.
+     * Therefore box is hidden only by occluders, which are in front of it everywhere.
+     *
+     * Rasterization uses SSE (4 pixels at once) and rows of tiles are
+     * distributed among threads. Depth is z/w of the OpenGL style clip
+     * space (glm projection matrices), near plane is z = -w.
+     *
+     * Usage: begin frame with view projection matrix, add occluders,
+     * rasterize and then test bounds of objects with isVisible.
+     */
+    class OcclusionBuffer {
+    public:
+        static const uint32 TILE_WIDTH = 8;
+        static const uint32 TILE_HEIGHT = 8;
+        static const uint32 TILE_SIZE = TILE_WIDTH * TILE_HEIGHT;
+
+        /** Resolution is rounded up to the tile size */
+        explicit OcclusionBuffer(uint32 width = 256, uint32 height = 128);
+
+        /** Set resolution (rounded up to the tile size), clears occluders */
+        void setResolution(uint32 width, uint32 height);
+
+        /** Clear occluders for new frame with specified view projection matrix */
+        void begin(const Mat4f &viewProj);
+
+        /**
+         * Add occluder mesh triangles (only positions are used).
+         * Triangles crossing near plane are ignored. Adjacent triangles of the
+         * index buffer, which form planar convex quad, are rasterized as quad,
+         * so pixels on their shared edge are covered.
+         */
+        void addOccluder(const Mesh &mesh, const Mat4f &transform);
+
+        /** Rasterize added occluders into depth buffer (calling thread participates) */
+        void rasterize(ThreadPool &threads);
+
+        /**
+         * @return False if box is completely hidden by rasterized occluders
+         * @note Thread-safe after rasterization
+         */
+        bool isVisible(const AABB &box) const;
+
+        uint32 getWidth() const { return mWidth; }
+        uint32 getHeight() const { return mHeight; }
+        /** @return Number of triangles and merged quads to rasterize */
+        uint32 getPolygonsCount() const { return (uint32) mPolygons.size(); }
+        /** @return Depth of pixel (x,y), where y = 0 is the bottom row of the screen */
+        float32 getDepth(uint32 x, uint32 y) const;
+
+    private:
+
+        /** Convex triangle or quad in screen space (x, y in pixels, z/w depth) */
+        struct Polygon {
+            Vec3f v[4];
+            uint32 count;
+            /** Depth plane z = z0 + dzdx * x + dzdy * y (not less than polygon depth) */
+            float32 z0;
+            float32 dzdx;
+            float32 dzdy;
+            float32 minY;
+            float32 maxY;
+        };
+
+        /** @return False if triangle crosses near plane or is degenerate */
+        bool projectTriangle(const uint32 *indices, Polygon &polygon) const;
+        /** Merge triangle into polygon, if they share edge and form planar convex quad */
+        static bool mergeTriangle(Polygon &polygon, const uint32 *indices, const Polygon &triangle, const uint32 *triangleIndices);
+        void addPolygon(Polygon &polygon);
+
+        void clearDepth();
+        void rasterizeTileRows(uint32 firstRow, uint32 lastRow);
+        void rasterizePolygon(const Polygon &polygon, uint32 firstRow, uint32 lastRow);
+        void updateTileDepth(uint32 tile);
+        uint32 getPixelIndex(uint32 x, uint32 y) const;
+
+        /** Number of tile rows, rasterized by single task */
+        static const uint32 ROWS_PER_TASK = 2;
+
+        uint32 mWidth = 0;
+        uint32 mHeight = 0;
+        uint32 mTilesX = 0;
+        uint32 mTilesY = 0;
+        Mat4f mViewProj = Mat4f(1.0f);
+
+        std::vector<Polygon> mPolygons;
+        std::vector<Vec4f> mClipVertices;
+        /** Depth of pixels, grouped by tiles */
+        std::vector<float32> mDepth;
+        /** Farthest depth of each tile */
+        std::vector<float32> mTileMaxDepth;
+    };
+
+}
+
+#endif //IGNIMBRITE_OCCLUSIONBUFFER_H
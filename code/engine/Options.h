@@ -0,0 +1,20 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_OPTIONS_H
+#define IGNIMBRITE_OPTIONS_H
+
+/* #undef IGNIMBRITE_WITH_GLFW */
+/* #undef IGNIMBRITE_WITH_VULKAN */
+/* #undef IGNIMBRITE_WITH_QT */
+
+#define IGNIMBRITE_VERSION_MAJOR 
+#define IGNIMBRITE_VERSION_MINOR 
+
+#endif // IGNIMBRITE_OPTIONS_H
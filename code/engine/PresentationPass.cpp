@@ -9,7 +9,6 @@
 
 
 #include "PresentationPass.h"
-#include <PipelineContext.h>
 #include <Geometry.h>
 #include <IRenderEngine.h>
 
@@ -55,7 +54,6 @@ namespace ignimbrite {
         IRenderDevice::Color color = {0.0f, 0.0f, 0.0f, 0.0f};
 
         mDevice->drawListBindSurface(targetSurface, color, surfaceRegion);
-        PipelineContext::cacheSurfaceBinding(targetSurface);
 
         const auto &colorTexture = source->getAttachment(0);
 
@@ -8,15 +8,21 @@
 /**********************************************************************************/
 
 #include <RenderEngine.h>
-#include <PipelineContext.h>
 
 namespace ignimbrite {
 
-    RenderEngine::RenderEngine() {
+    RenderEngine::RenderEngine() : mCullingThreads(ThreadPool::getHardwareThreadsCount()) {
         mContext = std::make_shared<IRenderContext>();
+        mViews.resize(EXTRA_VIEWS_OFFSET);
     }
 
     RenderEngine::~RenderEngine() {
+        if (mInstanceBuffer.isNotNull()) {
+            mRetiredInstanceBuffers.push_back(mInstanceBuffer);
+            mInstanceBuffer = ID<IRenderDevice::VertexBuffer>();
+        }
+
+        releaseRetiredInstanceBuffers();
     }
 
     void RenderEngine::setCamera(RefCounted<Camera> camera) {
@@ -38,6 +44,16 @@ namespace ignimbrite {
         mRenderDevice = std::move(device);
         mContext->setRenderDevice(mRenderDevice.get());
 
+        // Ring has part for each possible device frame slot, therefore frames in flight count could be changed
+        uint32 frameSize = UNIFORM_RING_FRAME_SIZE;
+        uint32 framesCount = IRenderDevice::MAX_FRAMES_IN_FLIGHT;
+        mUniformRing = std::make_shared<UniformRingBuffer>(mRenderDevice, frameSize, framesCount);
+
+        // Lists are recorded by previous device
+        for (auto& view: mViews) {
+            view.cachedLists.clear();
+        }
+
         mCanvas = std::make_shared<Canvas>(mRenderDevice);
         if (mTargetSurface.isNotNull()) {
             mCanvas->setSurface(mTargetSurface);
@@ -104,32 +120,69 @@ namespace ignimbrite {
     }
 
     void RenderEngine::addRenderable(RefCounted<IRenderable> object) {
-        auto found = std::find(mRenderObjects.begin(), mRenderObjects.end(), object);
+        if (object == nullptr)
+            throw std::runtime_error("An attempt to add null renderable object");
 
-        if (found != mRenderObjects.end())
-            throw std::runtime_error("Engine already contains this renderable object");
+        auto& layer = mRenderLayers[object->getLayerID()];
+        registerRenderable(std::move(object), layer);
+    }
 
-        uint32 layer = object->getLayerID();
-        IRenderable* objectPtr = object.get();
-        mRenderLayers[layer].emplace_back(objectPtr);
+    void RenderEngine::addRenderables(const std::vector<RefCounted<IRenderable>> &objects) {
+        auto count = (uint32) objects.size();
+
+        mRenderObjects.reserve(mRenderObjects.size() + count);
+        mRegistry.reserve(mRegistry.getCapacity() + count);
+        mSpatialIndex.reserve(mRegistry.getCapacity() + count);
+
+        // Objects usually come grouped by layers, lists of the layers are not moved by the map
+        std::vector<IRenderable*>* list = nullptr;
+        uint32 listLayer = 0;
+
+        for (const auto& object: objects) {
+            if (object == nullptr)
+                throw std::runtime_error("An attempt to add null renderable object");
 
-        object->onAddToScene(*mContext);
-        mRenderObjects.emplace_back(std::move(object));
+            uint32 layer = object->getLayerID();
+
+            if (list == nullptr || listLayer != layer) {
+                list = &mRenderLayers[layer];
+                listLayer = layer;
+            }
+
+            registerRenderable(object, *list);
+        }
     }
 
     void RenderEngine::removeRenderable(const RefCounted <IRenderable> &object) {
-        auto found = std::find(mRenderObjects.begin(), mRenderObjects.end(), object);
-
-        if (found == mRenderObjects.end())
+        if (object == nullptr || object->mListener != this)
             throw std::runtime_error("Engine does not contain such renderable object");
 
-        uint32 layer = object->getLayerID();
         IRenderable* objectPtr = object.get();
-        auto& list = mRenderLayers[layer];
-        auto toRemove = std::find(list.begin(), list.end(), objectPtr);
-        list.erase(toRemove);
 
-        mRenderObjects.erase(found);
+        // Swap-remove from layer list and objects list
+        auto& list = mRenderLayers[object->getLayerID()];
+        removeFromLayer(objectPtr, list);
+
+        uint32 index = objectPtr->mObjectIndex;
+        if (index + 1 != mRenderObjects.size()) {
+            mRenderObjects[index] = std::move(mRenderObjects.back());
+            mRenderObjects[index]->mObjectIndex = index;
+        }
+
+        uint32 sceneID = objectPtr->mSceneID;
+        mSpatialIndex.remove(sceneID);
+        mRegistry.remove(sceneID);
+        markChanged(sceneID);
+
+        // Object memory could be reused by new object, therefore lists are not identified only by objects pointers
+        mDrawDataVersion += 1;
+
+        objectPtr->mSceneID = 0xffffffff;
+        objectPtr->mObjectIndex = 0xffffffff;
+        objectPtr->mListener = nullptr;
+
+        // Last reference could be there, so the object is released the last
+        mRenderObjects.pop_back();
     }
 
     void RenderEngine::addLightSource(RefCounted<Light> light) {
@@ -175,6 +228,8 @@ namespace ignimbrite {
         CHECK_SURFACE_PRESENT();
         CHECK_FINAL_PASS_PRESENT();
 
+        mOcclusionBufferReady = false;
+
         // This target will be finally presented to the screen
         RefCounted<RenderTarget> resultPostEffectsPass;
 
@@ -184,181 +239,889 @@ namespace ignimbrite {
         // 3. Run post processing on generated image
         // 4. Present image
 
+        // Waits only for the frame in flight, which slot is reused
+        mRenderDevice->beginFrame();
+        mUniformRing->beginFrame();
+
+        if (mParallelRecording)
+            mRenderDevice->setDrawListThreadsCount(mCullingThreads.getThreadsCount());
+
         mRenderDevice->drawListBegin();
 
+        mCullingStatistics = CullingStatistics();
+        mInstancingStatistics = InstancingStatistics();
+        mDrawListCacheStatistics = DrawListCacheStatistics();
+        mDepthPrepassStatistics = DepthPrepassStatistics();
+        mInstanceBufferUsed = 0;
+
         Vec3f cameraPos = mCamera->getPosition();
         const auto &frustum = mCamera->getFrustum();
 
+        // only 1 light casts shadows
+        Light* shadowLight = nullptr;
+
+        if (!mLightSources.empty() && mLightSources.front()->castShadow()) {
+            shadowLight = mLightSources.front().get();
+
+            Frustum frustumCut = frustum;
+            frustumCut.cutFrustum(mShadowDistance / mCamera->getFarClip());
+
+            shadowLight->buildViewFrustum(frustumCut);
+
+            // Casters must be inside light frustum and their shadows must reach visible receivers
+            mShadowCasterVolume.build(frustumCut, shadowLight->getDirection());
+        }
+
+        // All the views are culled with single scene traversal
+        mViews[MAIN_VIEW].frustum = &frustum;
+        mViews[SHADOW_VIEW].frustum = shadowLight ? &shadowLight->getFrustum() : nullptr;
+
+        for (uint32 i = 0; i < mExtraViews.size(); i++) {
+            mViews[EXTRA_VIEWS_OFFSET + i].frustum = &mExtraViews[i].camera->getFrustum();
+        }
+
+        collectViews();
+
+        if (mOcclusionCulling)
+            rasterizeOccluders(cameraPos);
+
         {
             IRenderDevice::Region shRegion = {0, 0,
                                               {mShadowsRenderTarget->getWidth(), mShadowsRenderTarget->getHeight()}};
             std::vector<IRenderDevice::Color> shClearColors;
 
             mRenderDevice->drawListBindFramebuffer(mShadowsRenderTarget->getHandle(), shClearColors, shRegion);
-            PipelineContext::cacheFramebufferBinding(mShadowsRenderTarget->getHandle());
-            PipelineContext::cachePipelineBinding(ID<IRenderDevice::GraphicsPipeline>());
 
-            // todo: make shadow distance variable ?
-            float shadowDistance = 10.0f;
-            Frustum frustumCut = frustum;
-            frustumCut.cutFrustum(shadowDistance / mCamera->getFarClip());
+            mViews[SHADOW_VIEW].framebuffer = mShadowsRenderTarget->getHandle();
+            mViews[SHADOW_VIEW].area = shRegion;
 
-            for (auto &light : mLightSources) {
-                if (!light->castShadow()) {
-                    break;
-                }
+            if (shadowLight) {
+                mContext->setGlobalLight(shadowLight);
+                renderView(mViews[SHADOW_VIEW], shadowLight->getPosition(), true);
+            }
+        }
 
-                mContext->setGlobalLight(light.get());
+        // Extra views are rendered before main pass, so their results could be used in it
+        for (uint32 i = 0; i < mExtraViews.size(); i++) {
+            const auto& view = mExtraViews[i];
+            const auto& target = view.target;
 
-                Vec3f lightpos = light->getPosition();
+            std::vector<IRenderDevice::Color> clearColors = {IRenderDevice::Color{0, 0, 0, 0}};
+            IRenderDevice::Region region = {0, 0, {target->getWidth(), target->getHeight()}};
 
-                light->buildViewFrustum(frustumCut);
-                const auto &lightFrustum = light->getFrustum();
+            mRenderDevice->drawListBindFramebuffer(target->getHandle(), clearColors, region);
 
-                for (const auto &layer: mRenderLayers) {
-                    const auto &list = layer.second;
+            mViews[EXTRA_VIEWS_OFFSET + i].framebuffer = target->getHandle();
+            mViews[EXTRA_VIEWS_OFFSET + i].area = region;
 
-                    if (list.empty())
-                        continue;
+            mContext->setCamera(view.camera.get());
+            renderView(mViews[EXTRA_VIEWS_OFFSET + i], view.camera->getPosition(), false);
+        }
 
-                    mCollectQueue.clear();
-                    mVisibleSortedQueue.clear();
+        mContext->setCamera(mCamera.get());
 
-                    for (auto object: list) {
-                        // object not visible at all or doesn't cast shadows
-                        if (!object->isVisible() || !object->castShadows())
-                            continue;
+        // todo: main pass
 
-                        Vec3f pos = object->getWorldPosition();
-                        float32 maxViewDistanceSq = object->getMaxViewDistanceSquared();
-                        float32 distanceSq = glm::distance2(lightpos, pos);
+        {
+            std::vector<IRenderDevice::Color> clearColors = {IRenderDevice::Color{0, 0, 0, 0}};
+            IRenderDevice::Region region = {mRenderArea.x, mRenderArea.y, {mRenderArea.w, mRenderArea.h}};
 
-                        // Object too far and we can cull it
-                        if (distanceSq > maxViewDistanceSq && object->canApplyCulling())
-                            continue;
+            //mRenderDevice->drawListBegin();
+            mRenderDevice->drawListBindFramebuffer(mOffscreenTarget1->getHandle(), clearColors, region);
 
-                        RenderQueueElement element = {};
-                        element.object = object;
-                        element.viewDistance = std::sqrt(distanceSq);
-                        element.boundingBox = object->getWorldBoundingBox();
+            mViews[MAIN_VIEW].framebuffer = mOffscreenTarget1->getHandle();
+            mViews[MAIN_VIEW].area = region;
 
-                        mCollectQueue.push_back(element);
-                    }
+            renderView(mViews[MAIN_VIEW], cameraPos, false, mOcclusionBufferReady);
+        }
 
-                    // Do frustum culling
-                    for (const auto &element: mCollectQueue) {
-                        if (lightFrustum.isInside(element.boundingBox))
-                            mVisibleSortedQueue.push_back(element);
-                    }
+        // Changes are applied to the all views caches
+        for (auto sceneID: mChangedObjects) {
+            mChangedMarks[sceneID] = 0;
+        }
 
-                    // Notify elements entered the render queue successfully and get it material for rendering
-                    for (auto &element: mVisibleSortedQueue) {
-                        element.object->onShadowRenderQueueEntered(element.viewDistance);
-                        element.material = element.object->getShadowRenderMaterial();
-                    }
+        mChangedObjects.clear();
 
-                    // Sort with distance and material predicate
-                    RenderQueueElement::SortPredicate predicate;
-                    std::sort(mVisibleSortedQueue.begin(), mVisibleSortedQueue.end(), predicate);
+        {
+            auto source = mOffscreenTarget1;
+            auto dest = mOffscreenTarget2;
 
-                    for (const auto &element: mVisibleSortedQueue) {
-                        element.object->onShadowRender(*mContext);
-                    }
+            for (auto& effect: mPostEffects) {
+                effect->execute(source, dest);
+                std::swap(source, dest);
+            }
 
-                }
+            resultPostEffectsPass = source;
+        }
 
-                // only 1 light casts shadows
-                break;
+        {
+            IRenderDevice::Region region = {mRenderArea.x, mRenderArea.y, {mRenderArea.w, mRenderArea.h}};
+            mPresentationPass->present(mTargetSurface, region, resultPostEffectsPass);
+        }
+
+        mCanvas->render();
+
+        mRenderDevice->drawListEnd();
+
+        mRenderDevice->flush();
+        mRenderDevice->endFrame();
+        mRenderDevice->swapBuffers(mTargetSurface);
+
+        releaseRetiredInstanceBuffers();
+    }
+
+    void RenderEngine::setCullingThreadsCount(uint32 count) {
+        if (count == 0)
+            throw std::runtime_error("Culling threads count must be at least 1");
+
+        mCullingThreads.setThreadsCount(count);
+    }
+
+    void RenderEngine::addView(RefCounted<Camera> camera, RefCounted<RenderTarget> target) {
+        if (camera == nullptr)
+            throw std::runtime_error("An attempt to add view with null camera");
+
+        if (target == nullptr)
+            throw std::runtime_error("An attempt to add view with null target");
+
+        if (EXTRA_VIEWS_OFFSET + mExtraViews.size() >= SpatialIndex::MAX_VIEWS)
+            throw std::runtime_error("Too many views");
+
+        for (const auto& view: mExtraViews) {
+            if (view.camera == camera)
+                throw std::runtime_error("Engine already contains view with this camera");
+        }
+
+        ExtraView view;
+        view.camera = std::move(camera);
+        view.target = std::move(target);
+
+        mExtraViews.push_back(std::move(view));
+        mViews.emplace_back();
+    }
+
+    void RenderEngine::removeView(const RefCounted<Camera> &camera) {
+        for (uint32 i = 0; i < mExtraViews.size(); i++) {
+            if (mExtraViews[i].camera == camera) {
+                mExtraViews.erase(mExtraViews.begin() + i);
+                mViews.erase(mViews.begin() + EXTRA_VIEWS_OFFSET + i);
+                return;
             }
         }
 
-        // todo: main pass
+        throw std::runtime_error("Engine does not contain view with such camera");
+    }
 
-        {
-            std::vector<IRenderDevice::Color> clearColors = {IRenderDevice::Color{0, 0, 0, 0}};
-            IRenderDevice::Region region = {mRenderArea.x, mRenderArea.y, {mRenderArea.w, mRenderArea.h}};
+    void RenderEngine::setTemporalCulling(bool enable, float32 cameraThreshold) {
+        if (cameraThreshold < 0.0f)
+            throw std::runtime_error("Temporal culling camera threshold must be non-negative");
 
-            //mRenderDevice->drawListBegin();
-            mRenderDevice->drawListBindFramebuffer(mOffscreenTarget1->getHandle(), clearColors, region);
-            PipelineContext::cacheFramebufferBinding(mOffscreenTarget1->getHandle());
+        mTemporalCulling = enable;
+        mTemporalCullingThreshold = cameraThreshold;
 
-            for (const auto &layer: mRenderLayers) {
-                const auto &list = layer.second;
+        // Changes were not tracked before, results must be recomputed
+        for (auto& view: mViews) {
+            view.cache.invalidate();
+        }
+    }
 
-                if (list.empty())
-                    continue;
+    void RenderEngine::setShadowDistance(float32 distance) {
+        if (distance <= 0.0f)
+            throw std::runtime_error("Shadow distance must be positive");
 
-                mCollectQueue.clear();
-                mVisibleSortedQueue.clear();
+        mShadowDistance = distance;
+    }
 
-                for (auto object: list) {
-                    // object not visible at all
-                    if (!object->isVisible())
-                        continue;
+    void RenderEngine::setShadowCasterCulling(bool enable) {
+        mShadowCasterCulling = enable;
+    }
 
-                    Vec3f pos = object->getWorldPosition();
-                    float32 maxViewDistanceSq = object->getMaxViewDistanceSquared();
-                    float32 distanceSq = glm::distance2(cameraPos, pos);
+    void RenderEngine::setOcclusionCulling(bool enable) {
+        mOcclusionCulling = enable;
+    }
 
-                    // Object too far and we can cull it
-                    if (distanceSq > maxViewDistanceSq && object->canApplyCulling())
-                        continue;
+    void RenderEngine::setOcclusionBufferResolution(uint32 width, uint32 height) {
+        mOcclusionBuffer.setResolution(width, height);
+    }
 
-                    RenderQueueElement element = {};
-                    element.object = object;
-                    element.viewDistance = std::sqrt(distanceSq);
-                    element.boundingBox = object->getWorldBoundingBox();
+    void RenderEngine::setAutoInstancing(bool enable) {
+        mAutoInstancing = enable;
+    }
 
-                    mCollectQueue.push_back(element);
-                }
+    void RenderEngine::setParallelRecording(bool enable) {
+        mParallelRecording = enable;
+    }
+
+    void RenderEngine::setDepthPrepass(uint32 layer, DepthPrepassMode mode) {
+        if (layer == (uint32) IRenderable::DefaultLayers::Transparent && mode != DepthPrepassMode::Disabled)
+            throw std::runtime_error("Depth pre-pass could not be used for transparent layer");
+
+        mDepthPrepassLayers[layer] = mode;
+    }
+
+    RenderEngine::DepthPrepassMode RenderEngine::getDepthPrepass(uint32 layer) const {
+        auto found = mDepthPrepassLayers.find(layer);
+        return found != mDepthPrepassLayers.end() ? found->second : DepthPrepassMode::Disabled;
+    }
+
+    void RenderEngine::setDrawListCaching(bool enable) {
+        mDrawListCaching = enable;
+
+        if (!enable) {
+            for (auto& view: mViews) {
+                view.cachedLists.clear();
+            }
+        }
+    }
+
+
+    uint64 RenderEngine::makeSortKey(uint32 layer, const RenderQueueElement &element, bool backToFront) {
+        const auto* material = element.material;
+        uint32 pipelineID = material->getGraphicsPipeline()->getHandle().getIndex();
+        uint32 uniformSetID = material->getUniformSet().getIndex();
+
+        return RenderQueueElement::makeSortKey(layer, pipelineID, uniformSetID, element.viewDistance, backToFront);
+    }
+
+    void RenderEngine::onRenderableChanged(IRenderable *object, uint32 changes) {
+        auto sceneID = object->mSceneID;
+
+        if (changes & IRenderableListener::Layer) {
+            uint32 previous = mRegistry.getLayerID(sceneID);
+            removeFromLayer(object, mRenderLayers[previous]);
+
+            auto& list = mRenderLayers[object->getLayerID()];
+            object->mLayerIndex = (uint32) list.size();
+            list.push_back(object);
+        }
+
+        mRegistry.update(sceneID, changes);
+
+        if (changes & IRenderableListener::DrawData)
+            mDrawDataVersion += 1;
+
+        if (changes & IRenderableListener::Static)
+            mSpatialIndex.setStatic(sceneID, object->isStatic());
 
-                // Do frustum culling
-                for (const auto &element: mCollectQueue) {
-                    if (frustum.isInside(element.boundingBox))
-                        mVisibleSortedQueue.push_back(element);
+        if (changes & IRenderableListener::Bounds) {
+            mSpatialIndex.update(sceneID, mRegistry.getBounds(sceneID));
+            markChanged(sceneID);
+        }
+    }
+
+    void RenderEngine::registerRenderable(RefCounted<IRenderable> object, std::vector<IRenderable*> &layer) {
+        if (object->mListener == this)
+            throw std::runtime_error("Engine already contains this renderable object");
+
+        if (object->mListener != nullptr)
+            throw std::runtime_error("Renderable object is already added to other scene");
+
+        IRenderable* objectPtr = object.get();
+        objectPtr->mLayerIndex = (uint32) layer.size();
+        layer.push_back(objectPtr);
+
+        uint32 sceneID = mRegistry.add(objectPtr);
+        objectPtr->mSceneID = sceneID;
+        objectPtr->mObjectIndex = (uint32) mRenderObjects.size();
+        objectPtr->mListener = this;
+        mSpatialIndex.add(sceneID, mRegistry.getBounds(sceneID), objectPtr->isStatic());
+        markChanged(sceneID);
+
+        objectPtr->onAddToScene(*mContext);
+        mRenderObjects.push_back(std::move(object));
+    }
+
+    void RenderEngine::removeFromLayer(IRenderable *object, std::vector<IRenderable*> &layer) {
+        uint32 index = object->mLayerIndex;
+        IRenderable* last = layer.back();
+
+        layer[index] = last;
+        last->mLayerIndex = index;
+        layer.pop_back();
+
+        object->mLayerIndex = 0xffffffff;
+    }
+
+    void RenderEngine::markChanged(uint32 sceneID) {
+        if (!mTemporalCulling)
+            return;
+
+        if (mChangedMarks.size() <= sceneID) {
+            mChangedMarks.resize(mRegistry.getCapacity(), 0);
+        }
+
+        if (mChangedMarks[sceneID] == 0) {
+            mChangedMarks[sceneID] = 1;
+            mChangedObjects.push_back(sceneID);
+        }
+    }
+
+    void RenderEngine::collectViews() {
+        auto objectsCount = mRegistry.getObjectsCount();
+        const auto& layers = mRegistry.getLayers();
+
+        mQueryFrusta.clear();
+        mQueryViews.clear();
+
+        for (uint32 i = 0; i < mViews.size(); i++) {
+            auto& view = mViews[i];
+
+            for (auto& layer: view.layerCandidates) {
+                layer.second.clear();
+            }
+
+            // View is not rendered in this frame, changes are not tracked for it
+            if (view.frustum == nullptr) {
+                view.cache.invalidate();
+                continue;
+            }
+
+            if (mTemporalCulling && view.cache.canReuse(*view.frustum, mTemporalCullingThreshold)) {
+                // Only changed objects are tested, starting from the plane, which rejected them last time
+                view.cache.update(*view.frustum, mChangedObjects, mRegistry);
+
+                for (auto sceneID: view.cache.getVisible()) {
+                    view.layerCandidates[layers[sceneID]].push_back(sceneID);
                 }
 
-                // Notify elements entered the render queue successfully and get it material for rendering
-                for (auto &element: mVisibleSortedQueue) {
+                auto retested = std::min((uint32) mChangedObjects.size(), objectsCount);
+                mCullingStatistics.retestedObjects += retested;
+                mCullingStatistics.skippedTests += objectsCount - retested;
+            } else {
+                mQueryFrusta.push_back(*view.frustum);
+                mQueryViews.push_back(i);
+                mCullingStatistics.testedObjects += objectsCount;
+            }
+        }
+
+        if (mQueryFrusta.empty())
+            return;
+
+        mQueryResult.clear();
+        mQueryMasks.clear();
+        mSpatialIndex.query(mQueryFrusta.data(), (uint32) mQueryFrusta.size(), mQueryResult, mQueryMasks);
+
+        // Distribute objects among views by visibility masks
+        for (uint32 i = 0; i < mQueryResult.size(); i++) {
+            auto sceneID = mQueryResult[i];
+            auto layer = layers[sceneID];
+            auto mask = mQueryMasks[i];
+
+            while (mask) {
+                auto bit = Frustum::getLowestBit(mask);
+                mask &= ~(1u << bit);
+                mViews[mQueryViews[bit]].layerCandidates[layer].push_back(sceneID);
+            }
+        }
+
+        if (!mTemporalCulling)
+            return;
+
+        for (uint32 bit = 0; bit < mQueryViews.size(); bit++) {
+            auto& view = mViews[mQueryViews[bit]];
+
+            mQueryViewResult.clear();
+            for (uint32 i = 0; i < mQueryResult.size(); i++) {
+                if (mQueryMasks[i] & (1u << bit))
+                    mQueryViewResult.push_back(mQueryResult[i]);
+            }
+
+            view.cache.reset(*view.frustum, mQueryViewResult, mRegistry.getCapacity());
+        }
+    }
+
+    void RenderEngine::renderView(View &view, const Vec3f &viewPosition, bool shadowPass, bool occlusionTest) {
+        for (const auto &layer: mRenderLayers) {
+            auto found = view.layerCandidates.find(layer.first);
+
+            if (found == view.layerCandidates.end() || found->second.empty())
+                continue;
+
+            cullRenderables(found->second, viewPosition, shadowPass, occlusionTest, mVisibleSortedQueue);
+
+            // Transparent objects are rendered from far to near
+            bool backToFront = !shadowPass && layer.first == (uint32) IRenderable::DefaultLayers::Transparent;
+
+            // Notify elements entered the render queue successfully and get it material for rendering
+            for (auto &element: mVisibleSortedQueue) {
+                if (shadowPass) {
+                    element.object->onShadowRenderQueueEntered(element.viewDistance);
+                    element.material = element.object->getShadowRenderMaterial();
+                } else {
                     element.object->onRenderQueueEntered(element.viewDistance);
                     element.material = element.object->getRenderMaterial();
                 }
 
-                // Sort with distance and material predicate
-                RenderQueueElement::SortPredicate predicate;
-                std::sort(mVisibleSortedQueue.begin(), mVisibleSortedQueue.end(), predicate);
+                element.instancingKey = element.object->getInstancingKey(shadowPass);
+                element.sortKey = makeSortKey(layer.first, element, backToFront);
+            }
+
+            // Sort with material and distance key
+            mQueueSorter.sort(mVisibleSortedQueue);
+
+            // Depth of the layer is written before shading, so hidden surfaces are not shaded in main pass
+            bool depthPrepass = !shadowPass && &view == &mViews[MAIN_VIEW] && needDepthPrepass(layer.first, mVisibleSortedQueue);
+
+            if (depthPrepass)
+                renderDepthPrepass(layer.first, mVisibleSortedQueue);
+
+            mContext->setDepthPrepassDone(depthPrepass);
 
+            auto queue = mVisibleSortedQueue.data();
+            auto count = (uint32) mVisibleSortedQueue.size();
+
+            if (canCacheLayer(view, layer.first, shadowPass)) {
+                // Static objects are drawn first, sorting order is preserved in both parts
+                auto dynamic = std::stable_partition(mVisibleSortedQueue.begin(), mVisibleSortedQueue.end(),
+                                                     [](const RenderQueueElement& e) { return e.object->isStatic(); });
+                auto staticCount = (uint32) (dynamic - mVisibleSortedQueue.begin());
+
+                if (staticCount > 0)
+                    renderCachedQueue(queue, staticCount, shadowPass, view, layer.first);
+
+                if (staticCount < count)
+                    renderQueue(queue + staticCount, count - staticCount, shadowPass);
+            } else {
                 // Pass to object render context and call render for each
-                for (const auto &element: mVisibleSortedQueue) {
-                    element.object->onRender(*mContext);
+                renderQueue(queue, count, shadowPass);
+            }
+
+            mContext->setDepthPrepassDone(false);
+        }
+    }
+
+    bool RenderEngine::needDepthPrepass(uint32 layer, const std::vector<RenderQueueElement> &queue) const {
+        auto found = mDepthPrepassLayers.find(layer);
+        auto mode = found != mDepthPrepassLayers.end() ? found->second : DepthPrepassMode::Disabled;
+
+        if (mode != DepthPrepassMode::Auto)
+            return mode == DepthPrepassMode::Enabled;
+
+        // Pre-pass doubles vertex work and draws count, it pays off only if pixels are shaded several times
+        auto viewProj = mCamera->getViewProjClipMatrix();
+        float32 coverage = 0.0f;
+        uint32 objects = 0;
+
+        for (const auto& element: queue) {
+            if (element.object->getDepthRenderMaterial() == nullptr)
+                continue;
+
+            objects += 1;
+            coverage += getScreenCoverage(element.object->getWorldBoundingBox(), viewProj);
+
+            if (objects >= DEPTH_PREPASS_MIN_OBJECTS && coverage >= mDepthPrepassMinCoverage)
+                return true;
+        }
+
+        return false;
+    }
+
+    void RenderEngine::renderDepthPrepass(uint32 layer, const std::vector<RenderQueueElement> &queue) {
+        mDepthQueue.clear();
+
+        for (const auto& element: queue) {
+            auto material = element.object->getDepthRenderMaterial();
+
+            if (material == nullptr)
+                continue;
+
+            // Depth materials are not instanced, objects are sorted front to back
+            auto depthElement = element;
+            depthElement.material = material;
+            depthElement.instancingKey = nullptr;
+            depthElement.sortKey = makeSortKey(layer, depthElement, false);
+
+            mDepthQueue.push_back(depthElement);
+        }
+
+        mQueueSorter.sort(mDepthQueue);
+
+        mContext->setDepthPrepass(true);
+        renderQueue(mDepthQueue.data(), (uint32) mDepthQueue.size(), true);
+        mContext->setDepthPrepass(false);
+
+        mDepthPrepassStatistics.layers += 1;
+        mDepthPrepassStatistics.objects += (uint32) mDepthQueue.size();
+    }
+
+    float32 RenderEngine::getScreenCoverage(AABB box, const Mat4f &viewProj) {
+        std::array<Vec3f, 8> vertices = {};
+        box.getVertices(vertices);
+
+        Vec2f min(1.0f);
+        Vec2f max(-1.0f);
+
+        for (const auto& v: vertices) {
+            auto p = viewProj * Vec4f(v, 1.0f);
+
+            // Box crosses the camera plane and could cover the whole screen
+            if (p.w <= 0.0f)
+                return 1.0f;
+
+            auto ndc = Vec2f(p.x, p.y) / p.w;
+            min = glm::min(min, ndc);
+            max = glm::max(max, ndc);
+        }
+
+        min = glm::clamp(min, Vec2f(-1.0f), Vec2f(1.0f));
+        max = glm::clamp(max, Vec2f(-1.0f), Vec2f(1.0f));
+
+        auto size = glm::max(max - min, Vec2f(0.0f));
+
+        // Screen is 2x2 in normalized device coordinates
+        return size.x * size.y * 0.25f;
+    }
+
+    bool RenderEngine::canCacheLayer(const View &view, uint32 layer, bool shadowPass) const {
+        if (!mDrawListCaching)
+            return false;
+
+        // Static shadow casters of all layers or static background of the main view
+        return shadowPass || (&view == &mViews[MAIN_VIEW] && layer == (uint32) IRenderable::DefaultLayers::Background);
+    }
+
+    void RenderEngine::renderQueue(const RenderQueueElement *queue, uint32 count, bool shadowPass) {
+        collectDraws(queue, count, shadowPass);
+
+        // Executed cached lists require other commands of the pass to be recorded in secondary lists
+        if (mParallelRecording || mDrawListCaching) {
+            recordSecondaryDraws(shadowPass);
+            return;
+        }
+
+        for (const auto& draw: mQueueDraws) {
+            renderDraw(draw, shadowPass);
+        }
+    }
+
+    void RenderEngine::renderCachedQueue(const RenderQueueElement *queue, uint32 count, bool shadowPass, View &view, uint32 layer) {
+        collectDraws(queue, count, shadowPass);
+
+        auto& cached = view.cachedLists[layer];
+
+        if (cached == nullptr)
+            cached = std::make_shared<CachedDrawList>(mRenderDevice);
+
+        bool canCache = true;
+
+        for (const auto& draw: mQueueDraws) {
+            canCache = canCache && draw.object->canRecordInParallel(shadowPass);
+        }
+
+        if (!canCache) {
+            cached->invalidate();
+            recordSecondaryDraws(shadowPass);
+            return;
+        }
+
+        for (const auto& draw: mQueueDraws) {
+            draw.object->onRenderPrepare(*mContext, shadowPass, draw.instanceBuffer.isNotNull());
+        }
+
+        // Recorded commands depend only on target, bound objects and materials bindings
+        cached->beginKey();
+        cached->addKey(view.framebuffer);
+        cached->addKey((uint64) mContext->isDepthPrepassDone());
+        cached->addKey(((uint64) view.area.xOffset << 32u) | view.area.yOffset);
+        cached->addKey(((uint64) view.area.extent.x << 32u) | view.area.extent.y);
+        cached->addKey((uint64) mDrawDataVersion);
+
+        for (const auto& draw: mQueueDraws) {
+            auto object = draw.object;
+            auto material = object->getRenderMaterial();
+
+            // Shadow pass calls are also used for depth pre-pass
+            if (shadowPass)
+                material = mContext->isDepthPrepass() ? object->getDepthRenderMaterial() : object->getShadowRenderMaterial();
+
+            cached->addKey(object);
+            cached->addKey(material);
+
+            if (material != nullptr) {
+                // Static ring data of the material has the same offsets in the same frame slot
+                cached->addKey((uint64) material->getBindingVersion());
+                for (auto offset: material->getDynamicOffsets()) {
+                    cached->addKey((uint64) offset);
                 }
+                cached->addKey(material->getGraphicsPipeline()->getHandle());
+                // List with skipped draws is recorded again, when pipeline is compiled
+                cached->addKey((uint64) material->getGraphicsPipeline()->isReady());
             }
+
+            cached->addKey(draw.instanceBuffer);
+            cached->addKey(((uint64) draw.offset << 32u) | draw.instancesCount);
         }
 
-        {
-            auto source = mOffscreenTarget1;
-            auto dest = mOffscreenTarget2;
+        if (cached->isValid()) {
+            mDrawListCacheStatistics.reusedLists += 1;
+        } else {
+            cached->beginRecording();
 
-            for (auto& effect: mPostEffects) {
-                effect->execute(source, dest);
-                std::swap(source, dest);
+            for (const auto& draw: mQueueDraws) {
+                draw.object->onRenderRecord(*mContext, shadowPass, draw.instanceBuffer, draw.offset, draw.instancesCount);
             }
 
-            resultPostEffectsPass = source;
+            cached->endRecording();
+            mDrawListCacheStatistics.recordedLists += 1;
         }
 
-        {
-            IRenderDevice::Region region = {mRenderArea.x, mRenderArea.y, {mRenderArea.w, mRenderArea.h}};
-            mPresentationPass->present(mTargetSurface, region, resultPostEffectsPass);
+        cached->execute();
+    }
+
+    void RenderEngine::collectDraws(const RenderQueueElement *queue, uint32 count, bool shadowPass) {
+        uint32 first = 0;
+
+        mQueueDraws.clear();
+
+        while (first < count) {
+            const auto &element = queue[first];
+            auto key = element.instancingKey;
+
+            if (key == nullptr) {
+                mQueueDraws.push_back({element.object, ID<IRenderDevice::VertexBuffer>(), 0, 1});
+                first += 1;
+                continue;
+            }
+
+            // Objects with the same geometry are adjacent, since queue is sorted by pipeline and uniform set,
+            // but materials could be different clones, therefore its params must be compared
+            uint32 last = first + 1;
+
+            while (mAutoInstancing && last < count && queue[last].instancingKey == key &&
+                   element.object->canInstanceWith(*queue[last].object, shadowPass)) {
+                last += 1;
+            }
+
+            auto instancesCount = last - first;
+            auto offset = writeInstances(&queue[first], instancesCount);
+
+            // Instance buffer could be replaced by the next runs, therefore it is stored for each draw
+            mQueueDraws.push_back({element.object, mInstanceBuffer, offset, instancesCount});
+
+            mInstancingStatistics.instancedDraws += 1;
+            mInstancingStatistics.instancedObjects += instancesCount;
+
+            first = last;
         }
+    }
 
-        mCanvas->render();
+    void RenderEngine::renderDraw(const QueueDraw &draw, bool shadowPass) {
+        auto object = draw.object;
+
+        if (draw.instanceBuffer.isNull()) {
+            if (shadowPass)
+                object->onShadowRender(*mContext);
+            else
+                object->onRender(*mContext);
+        } else {
+            if (shadowPass)
+                object->onShadowRenderInstanced(*mContext, draw.instanceBuffer, draw.offset, draw.instancesCount);
+            else
+                object->onRenderInstanced(*mContext, draw.instanceBuffer, draw.offset, draw.instancesCount);
+        }
+    }
 
-        mRenderDevice->drawListEnd();
+    void RenderEngine::recordSecondaryDraws(bool shadowPass) {
+        auto drawsCount = (uint32) mQueueDraws.size();
+        bool canSplit = mParallelRecording;
 
-        mRenderDevice->flush();
-        mRenderDevice->synchronize();
-        mRenderDevice->swapBuffers(mTargetSurface);
+        for (const auto& draw: mQueueDraws) {
+            canSplit = canSplit && draw.object->canRecordInParallel(shadowPass);
+        }
+
+        uint32 chunksCount = 1;
+
+        if (canSplit) {
+            // Materials write shared ring buffer and device objects, therefore only commands are recorded in parallel
+            for (const auto& draw: mQueueDraws) {
+                draw.object->onRenderPrepare(*mContext, shadowPass, draw.instanceBuffer.isNotNull());
+            }
+
+            chunksCount = std::min(mCullingThreads.getThreadsCount(), (drawsCount + RECORDING_CHUNK_MIN_SIZE - 1) / RECORDING_CHUNK_MIN_SIZE);
+            chunksCount = std::max(chunksCount, 1u);
+        }
+
+        auto chunkSize = (drawsCount + chunksCount - 1) / chunksCount;
+        mDrawLists.resize(chunksCount);
+
+        auto recordChunk = [&](uint32 chunk, uint32 thread) {
+            mRenderDevice->drawListBeginSecondary(thread, false);
+
+            auto first = chunk * chunkSize;
+            auto last = std::min(first + chunkSize, drawsCount);
+
+            for (auto i = first; i < last; i++) {
+                const auto& draw = mQueueDraws[i];
+
+                if (canSplit)
+                    draw.object->onRenderRecord(*mContext, shadowPass, draw.instanceBuffer, draw.offset, draw.instancesCount);
+                else
+                    renderDraw(draw, shadowPass);
+            }
+
+            mDrawLists[chunk] = mRenderDevice->drawListEndSecondary();
+        };
+
+        if (canSplit)
+            mCullingThreads.parallelFor(chunksCount, recordChunk);
+        else
+            recordChunk(0, 0);
+
+        // Lists are executed in chunks order to preserve the order of the sorted queue
+        mRenderDevice->drawListExecute(mDrawLists);
+    }
+
+    uint32 RenderEngine::writeInstances(const RenderQueueElement *elements, uint32 count) {
+        // Data of the previous runs could be still used by GPU, therefore buffer is only appended in the frame
+        if (mInstanceBufferUsed + count > mInstanceBufferCapacity) {
+            if (mInstanceBuffer.isNotNull())
+                mRetiredInstanceBuffers.push_back(mInstanceBuffer);
+
+            uint32 capacity = std::max(mInstanceBufferCapacity * 2, (uint32) INSTANCE_BUFFER_MIN_CAPACITY);
+            while (capacity < count) capacity *= 2;
+
+            mInstanceBuffer = mRenderDevice->createVertexBuffer(BufferUsage::Dynamic, capacity * sizeof(Mat4f), nullptr);
+            mInstanceBufferCapacity = capacity;
+            mInstanceBufferUsed = 0;
+        }
+
+        mInstanceTransforms.resize(count);
+        for (uint32 i = 0; i < count; i++) {
+            mInstanceTransforms[i] = elements[i].object->getInstanceTransform();
+        }
+
+        auto offset = mInstanceBufferUsed * (uint32) sizeof(Mat4f);
+        mRenderDevice->updateVertexBuffer(mInstanceBuffer, count * sizeof(Mat4f), offset, mInstanceTransforms.data());
+        mInstanceBufferUsed += count;
+
+        return offset;
+    }
+
+    void RenderEngine::releaseRetiredInstanceBuffers() {
+        for (auto& buffer: mRetiredInstanceBuffers) {
+            mRenderDevice->destroyVertexBuffer(buffer);
+        }
+
+        mRetiredInstanceBuffers.clear();
+    }
+
+    void RenderEngine::cullRenderables(const std::vector<uint32> &list, const Vec3f &viewPosition,
+                                       bool shadowPass, bool occlusionTest, std::vector<RenderQueueElement> &visible) {
+        auto objectsCount = (uint32) list.size();
+        auto threadsCount = mCullingThreads.getThreadsCount();
+        auto chunksCount = std::min(threadsCount, (objectsCount + CULLING_CHUNK_MIN_SIZE - 1) / CULLING_CHUNK_MIN_SIZE);
+        chunksCount = std::max(chunksCount, 1u);
+        auto chunkSize = (objectsCount + chunksCount - 1) / chunksCount;
+
+        if (mCollectQueues.size() < chunksCount) {
+            mCollectQueues.resize(chunksCount);
+            mRejectedCounts.resize(chunksCount);
+        }
+
+        bool casterTest = shadowPass && mShadowCasterCulling;
+
+        // Object must be visible and cast shadows for shadow pass
+        uint8 requiredFlags = RenderableRegistry::Visible | (shadowPass ? RenderableRegistry::CastShadows : 0);
+
+        const auto& objects = mRegistry.getObjects();
+        const auto& positions = mRegistry.getPositions();
+        const auto& bounds = mRegistry.getBounds();
+        const auto& maxViewDistancesSq = mRegistry.getMaxViewDistancesSquared();
+        const auto& flags = mRegistry.getFlags();
+
+        // Chunk is processed independently and only touches its own queue
+        auto cullChunk = [&](uint32 chunk, uint32) {
+            auto& queue = mCollectQueues[chunk];
+            auto& rejected = mRejectedCounts[chunk];
+            queue.clear();
+            rejected = 0;
+
+            auto first = chunk * chunkSize;
+            auto last = std::min(first + chunkSize, objectsCount);
+
+            for (auto i = first; i < last; i++) {
+                auto id = list[i];
+                auto objectFlags = flags[id];
+
+                // object not visible at all or doesn't cast shadows
+                if ((objectFlags & requiredFlags) != requiredFlags)
+                    continue;
+
+                float32 distanceSq = glm::distance2(viewPosition, positions[id]);
+
+                // Object too far and we can cull it
+                if (distanceSq > maxViewDistancesSq[id] && (objectFlags & RenderableRegistry::CanApplyCulling))
+                    continue;
+
+                // Occluders are not tested, since their proxies are inside their bounds
+                if (occlusionTest && !(objectFlags & RenderableRegistry::Occluder) && !mOcclusionBuffer.isVisible(bounds[id])) {
+                    rejected += 1;
+                    continue;
+                }
+
+                // Shadow of the object could not fall on visible receivers
+                if (casterTest && !mShadowCasterVolume.canCastShadow(bounds[id])) {
+                    rejected += 1;
+                    continue;
+                }
+
+                RenderQueueElement element = {};
+                element.object = objects[id];
+                element.viewDistance = std::sqrt(distanceSq);
+                element.boundingBox = bounds[id];
+
+                queue.push_back(element);
+            }
+        };
+
+        mCullingThreads.parallelFor(chunksCount, cullChunk);
+
+        // Merge in chunks order to preserve the order of single-threaded culling
+        visible.clear();
+        for (uint32 chunk = 0; chunk < chunksCount; chunk++) {
+            const auto& queue = mCollectQueues[chunk];
+            visible.insert(visible.end(), queue.begin(), queue.end());
+            auto& rejected = shadowPass ? mCullingStatistics.rejectedShadowCasters : mCullingStatistics.occludedObjects;
+            rejected += mRejectedCounts[chunk];
+        }
+    }
+
+    void RenderEngine::rasterizeOccluders(const Vec3f &viewPosition) {
+        mOcclusionBufferReady = false;
+        mOcclusionBuffer.begin(mCamera->getProjMatrix() * mCamera->getViewMatrix());
+
+        const auto& objects = mRegistry.getObjects();
+        const auto& positions = mRegistry.getPositions();
+        const auto& maxViewDistancesSq = mRegistry.getMaxViewDistancesSquared();
+        const auto& flags = mRegistry.getFlags();
+
+        uint8 requiredFlags = RenderableRegistry::Visible | RenderableRegistry::Occluder;
+
+        for (const auto& layer: mViews[MAIN_VIEW].layerCandidates) {
+            for (auto id: layer.second) {
+                auto objectFlags = flags[id];
+
+                if ((objectFlags & requiredFlags) != requiredFlags)
+                    continue;
+
+                // Culled occluder is not rendered, so it must not hide other objects
+                float32 distanceSq = glm::distance2(viewPosition, positions[id]);
+                if (distanceSq > maxViewDistancesSq[id] && (objectFlags & RenderableRegistry::CanApplyCulling))
+                    continue;
+
+                Mat4f transform;
+                const Mesh* mesh = objects[id]->getOccluderMesh(transform);
+
+                if (mesh != nullptr)
+                    mOcclusionBuffer.addOccluder(*mesh, transform);
+            }
+        }
+
+        if (mOcclusionBuffer.getPolygonsCount() == 0)
+            return;
+
+        mOcclusionBuffer.rasterize(mCullingThreads);
+        mOcclusionBufferReady = true;
     }
 
     const RefCounted<ignimbrite::RenderTarget::Format> &RenderEngine::getShadowTargetFormat() const {
@@ -14,13 +14,67 @@
 #include <RenderTarget.h>
 #include <IRenderEngine.h>
 #include <RenderQueueElement.h>
+#include <RenderQueueSorter.h>
 #include <Canvas.h>
+#include <ThreadPool.h>
+#include <SpatialIndex.h>
+#include <RenderableRegistry.h>
+#include <TemporalCullingCache.h>
+#include <OcclusionBuffer.h>
+#include <ShadowCasterVolume.h>
+#include <CachedDrawList.h>
 
 namespace ignimbrite {
 
-    class RenderEngine : public IRenderEngine {
+    class RenderEngine : public IRenderEngine, private IRenderableListener {
     public:
 
+        /** Frustum culling statistics of the last drawn frame (summed for all the views) */
+        struct CullingStatistics {
+            /** Objects count in the views, where frustum culling was done for the whole scene */
+            uint32 testedObjects = 0;
+            /** Objects count, tested since they were changed (temporal culling only) */
+            uint32 retestedObjects = 0;
+            /** Objects count, which frustum tests were skipped, since previous frame results were reused */
+            uint32 skippedTests = 0;
+            /** Objects count, hidden by occluders in main pass */
+            uint32 occludedObjects = 0;
+            /** Objects count in light frustum, which shadows could not reach visible receivers */
+            uint32 rejectedShadowCasters = 0;
+        };
+
+        /** Automatic instancing statistics of the last drawn frame */
+        struct InstancingStatistics {
+            /** Instanced draw calls count (including runs of single object) */
+            uint32 instancedDraws = 0;
+            /** Objects count, drawn with instanced calls */
+            uint32 instancedObjects = 0;
+        };
+
+        /** Depth pre-pass statistics of the last drawn frame */
+        struct DepthPrepassStatistics {
+            /** Layers of the main view, drawn with pre-pass */
+            uint32 layers = 0;
+            /** Objects, drawn in pre-pass */
+            uint32 objects = 0;
+        };
+
+        /** Depth pre-pass usage for the layer */
+        enum class DepthPrepassMode {
+            Disabled,
+            Enabled,
+            /** Enabled, if visible objects with depth materials cover the screen several times */
+            Auto
+        };
+
+        /** Cached draw lists statistics of the last drawn frame */
+        struct DrawListCacheStatistics {
+            /** Cached lists, executed without recording */
+            uint32 reusedLists = 0;
+            /** Cached lists, recorded in this frame, since their content was changed */
+            uint32 recordedLists = 0;
+        };
+
         RenderEngine();
 
         ~RenderEngine() override;
@@ -39,6 +93,8 @@ namespace ignimbrite {
 
         void addRenderable(RefCounted<IRenderable> object) override;
 
+        void addRenderables(const std::vector<RefCounted<IRenderable>> &objects) override;
+
         void removeRenderable(const RefCounted<IRenderable> &object) override;
 
         void addLightSource(RefCounted<Light> light) override;
@@ -67,8 +123,209 @@ namespace ignimbrite {
 
         RefCounted<Texture> getDefaultWhiteTexture() override;
 
+        /**
+         * Set number of threads used for visibility culling (1 to cull on the calling thread).
+         * By default equals to the number of hardware threads.
+         */
+        void setCullingThreadsCount(uint32 count);
+
+        /** @return Number of threads used for visibility culling */
+        uint32 getCullingThreadsCount() const { return mCullingThreads.getThreadsCount(); }
+
+        /**
+         * Enable reuse of the previous frame frustum culling results.
+         * Only moved, added and removed objects are tested, while view frustum vertices
+         * moved not further than cameraThreshold since the last full test.
+         * @note Objects, which entered frustum because of camera movement less than
+         *       threshold, are not rendered until the next full test (disabled by default)
+         */
+        void setTemporalCulling(bool enable, float32 cameraThreshold = 0.0f);
+
+        /**
+         * Add extra view (mirror, minimap, probe capture), rendered before the main pass
+         * into specified target (target must have offscreen target format).
+         * All the views are culled together with single scene traversal.
+         */
+        void addView(RefCounted<Camera> camera, RefCounted<RenderTarget> target);
+
+        void removeView(const RefCounted<Camera> &camera);
+
+        bool isTemporalCullingEnabled() const { return mTemporalCulling; }
+        const CullingStatistics &getCullingStatistics() const { return mCullingStatistics; }
+
+        /** Set distance from the camera, where shadows are rendered (10 by default) */
+        void setShadowDistance(float32 distance);
+
+        /**
+         * Enable culling of shadow casters against camera frustum swept along the light direction
+         * (enabled by default). Casters, which shadows could not be seen, are not rendered.
+         */
+        void setShadowCasterCulling(bool enable);
+
+        float32 getShadowDistance() const { return mShadowDistance; }
+        bool isShadowCasterCullingEnabled() const { return mShadowCasterCulling; }
+
+        /**
+         * Enable software occlusion culling in main pass (enabled by default).
+         * Occluder meshes of the objects in view frustum are rasterized into
+         * CPU depth buffer and objects hidden behind them are not rendered.
+         */
+        void setOcclusionCulling(bool enable);
+
+        /** Set resolution of the software occlusion depth buffer (256x128 by default) */
+        void setOcclusionBufferResolution(uint32 width, uint32 height);
+
+        bool isOcclusionCullingEnabled() const { return mOcclusionCulling; }
+
+        /**
+         * Enable automatic instancing (enabled by default). Adjacent in sorted render queue
+         * objects with the same geometry and compatible materials are drawn with single
+         * instanced call. Disabled instancing draws each instanced object with its own call.
+         */
+        void setAutoInstancing(bool enable);
+
+        bool isAutoInstancingEnabled() const { return mAutoInstancing; }
+        const InstancingStatistics &getInstancingStatistics() const { return mInstancingStatistics; }
+
+        /**
+         * Enable parallel recording of the draw lists on the culling threads (disabled by default).
+         * Sorted queue of each layer is split into chunks, which are recorded into secondary
+         * draw lists concurrently and executed in the queue order. Objects are prepared on the
+         * calling thread, queues with objects without parallel recording support are recorded
+         * on the calling thread.
+         */
+        void setParallelRecording(bool enable);
+
+        bool isParallelRecordingEnabled() const { return mParallelRecording; }
+
+        /**
+         * Set depth pre-pass mode of the opaque layer in main view (disabled by default).
+         * Objects with depth materials are drawn depth-only before the layer and then are
+         * shaded with depth test EQUAL and without depth writes, so hidden surfaces are not shaded.
+         */
+        void setDepthPrepass(uint32 layer, DepthPrepassMode mode);
+
+        DepthPrepassMode getDepthPrepass(uint32 layer) const;
+        const DepthPrepassStatistics &getDepthPrepassStatistics() const { return mDepthPrepassStatistics; }
+
+        /**
+         * Enable caching of the draw lists for static content (disabled by default).
+         * Static objects of the background layer and static shadow casters are recorded
+         * into reusable draw lists, which are executed each frame until the set of the objects,
+         * their buffers, materials bindings or target framebuffer are changed.
+         * @note All the queues are recorded into secondary draw lists, when caching is enabled
+         */
+        void setDrawListCaching(bool enable);
+
+        bool isDrawListCachingEnabled() const { return mDrawListCaching; }
+        const DrawListCacheStatistics &getDrawListCacheStatistics() const { return mDrawListCacheStatistics; }
+
+        /**
+         * Per-frame ring buffer for uniform data of the materials (created with render device).
+         * Set it to the material before creation to bind its data with dynamic offsets.
+         */
+        const RefCounted<UniformRingBuffer> &getUniformRing() const { return mUniformRing; }
+
     private:
 
+        void onRenderableChanged(IRenderable *object, uint32 changes) override;
+
+        /** Culling state of the single view (main camera, shadow light or extra camera) */
+        struct View {
+            /** View frustum in the current frame (null if view is not rendered) */
+            const Frustum* frustum = nullptr;
+            /** Results of the previous frame for temporal culling */
+            TemporalCullingCache cache;
+            /** Ids of objects inside or intersecting view frustum, grouped by layers */
+            std::unordered_map<uint32, std::vector<uint32>> layerCandidates;
+            /** Target of the view in the current frame (cached lists are recorded for it) */
+            ID<IRenderDevice::Framebuffer> framebuffer;
+            IRenderDevice::Region area = {};
+            /** Draw lists of the static objects, grouped by layers */
+            std::unordered_map<uint32, RefCounted<CachedDrawList>> cachedLists;
+        };
+
+        struct ExtraView {
+            RefCounted<Camera> camera;
+            RefCounted<RenderTarget> target;
+        };
+
+        /**
+         * Query scene objects for all the views at once and group them by layers.
+         * With temporal culling, results of the previous frame may be reused for some views.
+         */
+        void collectViews();
+
+        /** Cull, sort and render objects of the view layer by layer */
+        void renderView(View &view, const Vec3f &viewPosition, bool shadowPass, bool occlusionTest = false);
+
+        /** @return True if depth pre-pass must be drawn for the sorted queue of the main view layer */
+        bool needDepthPrepass(uint32 layer, const std::vector<RenderQueueElement> &queue) const;
+
+        /** Draw objects of the queue with depth materials into depth buffer of the bound framebuffer */
+        void renderDepthPrepass(uint32 layer, const std::vector<RenderQueueElement> &queue);
+
+        /** @return Approximate screen part, covered by the box (1 for the whole screen) */
+        static float32 getScreenCoverage(AABB box, const Mat4f &viewProj);
+
+        /** @return True if static objects of the view layer are drawn with cached list */
+        bool canCacheLayer(const View &view, uint32 layer, bool shadowPass) const;
+
+        /** Single draw of the object or of the instanced run, which starts from it */
+        struct QueueDraw {
+            IRenderable* object;
+            /** Null for single object draw */
+            ID<IRenderDevice::VertexBuffer> instanceBuffer;
+            uint32 offset;
+            uint32 instancesCount;
+        };
+
+        /** Render sorted queue, runs of the instanced objects are drawn with single call */
+        void renderQueue(const RenderQueueElement* queue, uint32 count, bool shadowPass);
+
+        /** Render sorted queue of the static objects with cached list of the view layer (re-recorded if changed) */
+        void renderCachedQueue(const RenderQueueElement* queue, uint32 count, bool shadowPass, View &view, uint32 layer);
+
+        /** Split sorted queue into draws, model matrices of the instanced runs are written to the instance buffer */
+        void collectDraws(const RenderQueueElement* queue, uint32 count, bool shadowPass);
+
+        void renderDraw(const QueueDraw &draw, bool shadowPass);
+
+        /**
+         * Record collected draws into secondary draw lists and execute them in the bound framebuffer.
+         * Draws are split into chunks, recorded in parallel, if parallel recording is enabled.
+         */
+        void recordSecondaryDraws(bool shadowPass);
+
+        /** Write model matrices of the queue elements to the instance buffer, @return Offset in bytes */
+        uint32 writeInstances(const RenderQueueElement* elements, uint32 count);
+
+        /** Destroy instance buffers, retired in the current frame */
+        void releaseRetiredInstanceBuffers();
+
+        /** Rasterize occluders of the objects, found in the main view */
+        void rasterizeOccluders(const Vec3f &viewPosition);
+
+        /** Add object to the scene structures and to the list of its layer */
+        void registerRenderable(RefCounted<IRenderable> object, std::vector<IRenderable*> &layer);
+
+        /** Swap-remove object from the list of its layer */
+        static void removeFromLayer(IRenderable* object, std::vector<IRenderable*> &layer);
+
+        /** Remember object changed for temporal culling */
+        void markChanged(uint32 sceneID);
+
+        /**
+         * Collects objects with ids from the list, which pass visibility and distance tests.
+         * The list is split into chunks, processed in parallel, and merged in the list order,
+         * so the result does not depend on the number of threads.
+         */
+        void cullRenderables(const std::vector<uint32> &list, const Vec3f &viewPosition,
+                             bool shadowPass, bool occlusionTest, std::vector<RenderQueueElement> &visible);
+
+        /** Packs sort key for element with assigned material */
+        static uint64 makeSortKey(uint32 layer, const RenderQueueElement &element, bool backToFront);
+
         void CHECK_CAMERA_PRESENT() const;
         void CHECK_DEVICE_PRESENT() const;
         void CHECK_SURFACE_PRESENT() const;
@@ -92,8 +349,16 @@ namespace ignimbrite {
         ID<IRenderDevice::Surface>      mTargetSurface;
         ID<IRenderDevice::VertexBuffer> mFullscreenQuad;
 
-        std::vector<RenderQueueElement> mCollectQueue;
+        /** Minimal number of objects per culling task */
+        static const uint32 CULLING_CHUNK_MIN_SIZE = 256;
+
+        ThreadPool mCullingThreads;
+        /** Per-chunk collected objects (merged into sorted queue in chunks order) */
+        std::vector<std::vector<RenderQueueElement>> mCollectQueues;
+        /** Per-chunk count of objects, hidden by occluders or rejected shadow casters */
+        std::vector<uint32> mRejectedCounts;
         std::vector<RenderQueueElement> mVisibleSortedQueue;
+        RenderQueueSorter mQueueSorter;
 
         std::vector<RefCounted<Light>>       mLightSources;
         std::vector<RefCounted<IRenderable>> mRenderObjects;
@@ -104,6 +369,81 @@ namespace ignimbrite {
 
         std::unordered_map<uint32, std::vector<IRenderable*>> mRenderLayers;
 
+        /** Scene objects state for culling (objects are identified by scene id) */
+        RenderableRegistry mRegistry;
+        /** Scene acceleration structure */
+        SpatialIndex mSpatialIndex;
+        static const uint32 MAIN_VIEW = 0;
+        static const uint32 SHADOW_VIEW = 1;
+        static const uint32 EXTRA_VIEWS_OFFSET = 2;
+
+        /** Main, shadow and extra views (in this order) */
+        std::vector<View> mViews;
+        std::vector<ExtraView> mExtraViews;
+
+        /** Frusta of the views, which require full test, and indices of these views */
+        std::vector<Frustum> mQueryFrusta;
+        std::vector<uint32> mQueryViews;
+        /** Ids of objects found by spatial query and masks of views, which see them */
+        std::vector<uint32> mQueryResult;
+        std::vector<uint32> mQueryMasks;
+        std::vector<uint32> mQueryViewResult;
+
+        bool mTemporalCulling = false;
+        float32 mTemporalCullingThreshold = 0.0f;
+        /** Ids of objects moved, added or removed since the last frame (temporal culling only) */
+        std::vector<uint32> mChangedObjects;
+        std::vector<uint8> mChangedMarks;
+        CullingStatistics mCullingStatistics;
+
+        float32 mShadowDistance = 10.0f;
+        bool mShadowCasterCulling = true;
+        ShadowCasterVolume mShadowCasterVolume;
+
+        bool mOcclusionCulling = true;
+        /** True if occluders were rasterized for the current main pass */
+        bool mOcclusionBufferReady = false;
+        OcclusionBuffer mOcclusionBuffer;
+
+        /** Initial capacity of the per-instance model matrices buffer */
+        static const uint32 INSTANCE_BUFFER_MIN_CAPACITY = 1024;
+
+        bool mAutoInstancing = true;
+        InstancingStatistics mInstancingStatistics;
+        /** Model matrices of the all instanced runs of the frame (ranges are not reused in the frame) */
+        ID<IRenderDevice::VertexBuffer> mInstanceBuffer;
+        uint32 mInstanceBufferCapacity = 0;
+        uint32 mInstanceBufferUsed = 0;
+        /** Buffers, replaced by bigger one in the frame (released after frame synchronization) */
+        std::vector<ID<IRenderDevice::VertexBuffer>> mRetiredInstanceBuffers;
+        std::vector<Mat4f> mInstanceTransforms;
+
+        /** Uniform data of the materials, written once per frame */
+        static const uint32 UNIFORM_RING_FRAME_SIZE = 64 * 1024;
+        RefCounted<UniformRingBuffer> mUniformRing;
+
+        /** Minimal number of draws per recording task */
+        static const uint32 RECORDING_CHUNK_MIN_SIZE = 64;
+
+        bool mParallelRecording = false;
+        std::vector<QueueDraw> mQueueDraws;
+        /** Per-chunk secondary draw lists of the queue */
+        std::vector<ID<IRenderDevice::DrawList>> mDrawLists;
+
+        /** Minimal number of objects with depth materials for automatic pre-pass */
+        static const uint32 DEPTH_PREPASS_MIN_OBJECTS = 8;
+
+        std::unordered_map<uint32, DepthPrepassMode> mDepthPrepassLayers;
+        /** Minimal screen coverage of the objects for automatic pre-pass (overdraw estimate) */
+        float32 mDepthPrepassMinCoverage = 1.5f;
+        std::vector<RenderQueueElement> mDepthQueue;
+        DepthPrepassStatistics mDepthPrepassStatistics;
+
+        bool mDrawListCaching = false;
+        /** Changed, when objects are removed or their draw data is replaced (cached lists are re-recorded) */
+        uint32 mDrawDataVersion = 0;
+        DrawListCacheStatistics mDrawListCacheStatistics;
+
     };
 
 
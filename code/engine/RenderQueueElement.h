@@ -11,6 +11,7 @@
 #define IGNIMBRITE_RENDERQUEUEELEMENT_H
 
 #include <IRenderable.h>
+#include <cstring>
 
 namespace ignimbrite {
 
@@ -19,22 +20,41 @@ namespace ignimbrite {
         Material* material   = nullptr;
         float32 viewDistance = 0.0f;
         AABB boundingBox;
+        /** Geometry key of the object for instanced rendering (null if not instanced) */
+        const void* instancingKey = nullptr;
+        /** Packed key to order elements of the visible render queue (see makeSortKey) */
+        uint64 sortKey = 0;
 
         /**
-         * Predicate to sort elements of the visible render queue,
-         * order by material and then by distance in the same material group.
+         * Creates sort key to order elements by layer, then by pipeline and uniform set
+         * and then front-to-back by distance in the same material group.
+         * For back-to-front order (transparent objects) elements are sorted by layer,
+         * then by reversed distance and then by pipeline and uniform set.
+         *
+         * Key layout (from high to low bits):
+         * - front-to-back: layer (8) | pipeline (16) | uniform set (24) | depth (16)
+         * - back-to-front: layer (8) | reversed depth (24) | pipeline (16) | uniform set (16)
+         *
+         * Material groups (and instancing runs) are formed only in front-to-back order, therefore
+         * uniform set has more bits there and depth is coarse (8 bits of mantissa).
+         * Pipelines above 2^16 and uniform sets above 2^24 alias. In back-to-front order
+         * material ids only order elements with equal depth.
          */
-        struct SortPredicate {
-            bool operator()(const RenderQueueElement& a, const RenderQueueElement& b) const {
-                auto& m1 = *a.material;
-                auto& m2 = *b.material;
-
-                if (m1.getGraphicsPipeline() != m2.getGraphicsPipeline())
-                    return m1.getGraphicsPipeline() < m2.getGraphicsPipeline();
-                else
-                    return a.viewDistance < b.viewDistance;
-            }
-        };
+        static uint64 makeSortKey(uint32 layer, uint32 pipelineID, uint32 uniformSetID, float32 viewDistance, bool backToFront) {
+            // Bits of non-negative float are ordered as the values, take 24 high bits after the sign bit
+            uint32 distanceBits;
+            float32 distance = viewDistance > 0.0f ? viewDistance : 0.0f;
+            std::memcpy(&distanceBits, &distance, sizeof(float32));
+
+            auto depth = (uint64) ((distanceBits >> 7u) & 0xffffffu);
+            auto l = (uint64) (layer & 0xffu);
+            auto p = (uint64) (pipelineID & 0xffffu);
+
+            if (backToFront)
+                return (l << 56u) | ((0xffffffu - depth) << 32u) | (p << 16u) | (uint64) (uniformSetID & 0xffffu);
+            else
+                return (l << 56u) | (p << 40u) | ((uint64) (uniformSetID & 0xffffffu) << 16u) | (depth >> 8u);
+        }
     };
 
 }
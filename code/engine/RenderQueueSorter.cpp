@@ -0,0 +1,99 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <RenderQueueSorter.h>
+
+namespace ignimbrite {
+
+    void RenderQueueSorter::sort(std::vector<RenderQueueElement> &elements) {
+        auto count = (uint32) elements.size();
+
+        if (count < 2)
+            return;
+
+        mKeys.resize(count);
+        mIndices.resize(count);
+
+        for (uint32 i = 0; i < count; i++) {
+            mKeys[i] = elements[i].sortKey;
+            mIndices[i] = i;
+        }
+
+        sort(mKeys, mIndices);
+
+        mSorted.resize(count);
+        for (uint32 i = 0; i < count; i++) {
+            mSorted[i] = elements[mIndices[i]];
+        }
+
+        elements.swap(mSorted);
+    }
+
+    void RenderQueueSorter::sort(std::vector<uint64> &keys, std::vector<uint32> &indices) {
+        if (keys.size() != indices.size())
+            throw std::runtime_error("Keys and indices count mismatch");
+
+        auto count = (uint32) keys.size();
+
+        if (count < 2)
+            return;
+
+        // Histograms of all the passes are computed in the single pass over the keys
+        uint32 histograms[PASSES_COUNT][RADIX_SIZE] = {};
+
+        for (uint32 i = 0; i < count; i++) {
+            auto key = keys[i];
+            for (uint32 pass = 0; pass < PASSES_COUNT; pass++) {
+                histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)] += 1;
+            }
+        }
+
+        mKeysTmp.resize(count);
+        mIndicesTmp.resize(count);
+
+        uint64* srcKeys = keys.data();
+        uint32* srcIndices = indices.data();
+        uint64* dstKeys = mKeysTmp.data();
+        uint32* dstIndices = mIndicesTmp.data();
+
+        for (uint32 pass = 0; pass < PASSES_COUNT; pass++) {
+            auto& histogram = histograms[pass];
+            auto shift = pass * RADIX_BITS;
+
+            // All keys have the same digit, order is not changed
+            if (histogram[(srcKeys[0] >> shift) & (RADIX_SIZE - 1)] == count)
+                continue;
+
+            uint32 offsets[RADIX_SIZE];
+            uint32 offset = 0;
+
+            for (uint32 digit = 0; digit < RADIX_SIZE; digit++) {
+                offsets[digit] = offset;
+                offset += histogram[digit];
+            }
+
+            for (uint32 i = 0; i < count; i++) {
+                auto key = srcKeys[i];
+                auto position = offsets[(key >> shift) & (RADIX_SIZE - 1)]++;
+                dstKeys[position] = key;
+                dstIndices[position] = srcIndices[i];
+            }
+
+            std::swap(srcKeys, dstKeys);
+            std::swap(srcIndices, dstIndices);
+        }
+
+        // Result must be in the input buffers
+        if (srcKeys != keys.data()) {
+            std::copy(srcKeys, srcKeys + count, keys.data());
+            std::copy(srcIndices, srcIndices + count, indices.data());
+        }
+    }
+
+}
@@ -0,0 +1,47 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_RENDERQUEUESORTER_H
+#define IGNIMBRITE_RENDERQUEUESORTER_H
+
+#include <RenderQueueElement.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Render queue sort by element keys
+     *
+     * Sorts render queue elements by its 64-bit sort keys with LSD radix sort
+     * (8 passes of 8 bits, passes with single non-empty bucket are skipped).
+     * Sort is stable and uses internal buffers, reused between calls.
+     */
+    class RenderQueueSorter {
+    public:
+
+        /** Sort elements in ascending order of sortKey */
+        void sort(std::vector<RenderQueueElement> &elements);
+
+        /** Sort keys with indices in ascending order of keys (indices are permuted with keys) */
+        void sort(std::vector<uint64> &keys, std::vector<uint32> &indices);
+
+    private:
+        static const uint32 RADIX_BITS = 8;
+        static const uint32 RADIX_SIZE = 1u << RADIX_BITS;
+        static const uint32 PASSES_COUNT = 64 / RADIX_BITS;
+
+        std::vector<uint64> mKeys;
+        std::vector<uint64> mKeysTmp;
+        std::vector<uint32> mIndices;
+        std::vector<uint32> mIndicesTmp;
+        std::vector<RenderQueueElement> mSorted;
+    };
+
+}
+
+#endif //IGNIMBRITE_RENDERQUEUESORTER_H
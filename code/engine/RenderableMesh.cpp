@@ -8,9 +8,17 @@
 /**********************************************************************************/
 
 #include <RenderableMesh.h>
+#include <MaterialInstance.h>
 
 namespace ignimbrite {
 
+    static const Material::ParamHandle& checkParam(const Material::ParamHandle &param, const char *name) {
+        if (!param.isValid())
+            throw std::runtime_error(String("Material of the mesh has no parameter: ") + name);
+
+        return param;
+    }
+
     RenderableMesh::~RenderableMesh() {
         releaseGpuBuffers();
     }
@@ -40,6 +48,7 @@ namespace ignimbrite {
         if (useAsShadowMaterial) mShadowMaterial = mRenderMaterial;
 
         markDirty();
+        notifyDrawDataChanged();
     }
     
     void RenderableMesh::setShadowRenderMesh(RefCounted<Mesh> mesh) {
@@ -56,6 +65,17 @@ namespace ignimbrite {
 
         mShadowMaterial = std::move(material);
         markDirty();
+        notifyDrawDataChanged();
+    }
+
+    void RenderableMesh::setDepthRenderMaterial(RefCounted<Material> material) {
+        mDepthMaterial = std::move(material);
+        notifyDrawDataChanged();
+    }
+
+    void RenderableMesh::setOccluderMesh(RefCounted<Mesh> mesh) {
+        mOccluderMesh = std::move(mesh);
+        notifyOccluderChanged();
     }
 
     void RenderableMesh::create() {
@@ -104,6 +124,7 @@ namespace ignimbrite {
         mAABB = AABB(vertices);
 
         markClear();
+        notifyBoundsChanged();
     }
 
     void RenderableMesh::generateGpuBuffers() {
@@ -130,6 +151,8 @@ namespace ignimbrite {
 
         ibSize = mShadowMesh->getIndicesCount() * sizeof(uint32);
         mShadowIndexBuffer = mDevice->createIndexBuffer(BufferUsage::Static, ibSize, mShadowMesh->getIndexData());
+
+        notifyDrawDataChanged();
     }
 
     void RenderableMesh::updateGpuBuffersData() {
@@ -169,73 +192,229 @@ namespace ignimbrite {
     }
 
     void RenderableMesh::onRender(const IRenderContext &context) {
+        onRenderPrepare(context, false, false);
+        onRenderRecord(context, false, ID<IRenderDevice::VertexBuffer>(), 0, 1);
+    }
+
+    void RenderableMesh::onShadowRenderQueueEntered(float32 distFromViewPoint) {
+        // Possibly select LOD, but this mesh has only LOD 0
+        // Do nothing
+    }
+
+    void RenderableMesh::onShadowRender(const IRenderContext &context) {
+        onRenderPrepare(context, true, false);
+        onRenderRecord(context, true, ID<IRenderDevice::VertexBuffer>(), 0, 1);
+    }
+
+    Vec3f RenderableMesh::getWorldPosition() const {
+        return mWorldPosition;
+    }
+
+    AABB RenderableMesh::getWorldBoundingBox() const {
+        return mAABB;
+    }
+
+    Material *RenderableMesh::getRenderMaterial() {
+        return mRenderMaterial.get();
+    }
+
+    Material *RenderableMesh::getShadowRenderMaterial() {
+        return mShadowMaterial.get();
+    }
+
+    Material *RenderableMesh::getDepthRenderMaterial() {
+        return mDepthMaterial.get();
+    }
+
+    const Mesh *RenderableMesh::getOccluderMesh(Mat4f &transform) const {
+        transform = glm::translate(mWorldPosition) * mRotation * glm::scale(mScale);
+        return mOccluderMesh.get();
+    }
+
+    const void *RenderableMesh::getInstancingKey(bool shadowPass) const {
+        // Only pipelines with per-instance model matrices could be used
+        if (shadowPass)
+            return mShadowMaterial->getGraphicsPipeline()->isInstanced() ? mShadowMesh.get() : nullptr;
+        else
+            return mRenderMaterial->getGraphicsPipeline()->isInstanced() ? mRenderMesh.get() : nullptr;
+    }
+
+    bool RenderableMesh::canInstanceWith(const IRenderable &other, bool shadowPass) const {
+        auto mesh = dynamic_cast<const RenderableMesh*>(&other);
+
+        if (mesh == nullptr)
+            return false;
+
+        // Per-object params blocks are overwritten by the first object of the run
+        if (shadowPass)
+            return mShadowMesh == mesh->mShadowMesh && mShadowMaterial->hasEqualParams(*mesh->mShadowMaterial, "ShadowParams");
+        else
+            return mRenderMesh == mesh->mRenderMesh && mRenderMaterial->hasEqualParams(*mesh->mRenderMaterial, "CommonParams");
+    }
+
+    Mat4f RenderableMesh::getInstanceTransform() const {
+        return glm::translate(mWorldPosition) * mRotation * glm::scale(mScale);
+    }
+
+    void RenderableMesh::onRenderInstanced(const IRenderContext &context, ID<IRenderDevice::VertexBuffer> instanceBuffer,
+                                           uint32 offset, uint32 instancesCount) {
+        onRenderPrepare(context, false, true);
+        onRenderRecord(context, false, instanceBuffer, offset, instancesCount);
+    }
+
+    void RenderableMesh::onShadowRenderInstanced(const IRenderContext &context, ID<IRenderDevice::VertexBuffer> instanceBuffer,
+                                                 uint32 offset, uint32 instancesCount) {
+        onRenderPrepare(context, true, true);
+        onRenderRecord(context, true, instanceBuffer, offset, instancesCount);
+    }
+
+    bool RenderableMesh::canRecordInParallel(bool shadowPass) const {
+        // Params are set on prepare and bound on record, therefore plain materials,
+        // which could be shared with other objects, are overwritten before recording
+        auto isInstance = [](const RefCounted<Material> &material) {
+            return material == nullptr || dynamic_cast<const MaterialInstance*>(material.get()) != nullptr;
+        };
+
+        // Shadow pass calls are also used for depth pre-pass
+        if (shadowPass)
+            return isInstance(mShadowMaterial) && isInstance(mDepthMaterial);
+        else
+            return isInstance(mRenderMaterial);
+    }
+
+    void RenderableMesh::onRenderPrepare(const IRenderContext &context, bool shadowPass, bool instanced) {
+        if (shadowPass && context.isDepthPrepass()) {
+            prepareDepth(context);
+            return;
+        }
+
+        // Instances model matrices are taken from instance buffer
+        if (shadowPass) {
+            auto light = context.getGlobalLight();
+            const auto& params = getShadowParams();
+
+            if (instanced) {
+                mShadowMaterial->setMat4(checkParam(params.depthVP, "ShadowParams.depthVP"), light->getViewProjClipMatrix());
+            } else {
+                auto model = glm::translate(mWorldPosition) * mRotation * glm::scale(mScale);
+                auto lightMVP = light->getViewProjClipMatrix() * model;
+                mShadowMaterial->setMat4(checkParam(params.depthMVP, "ShadowParams.depthMVP"), lightMVP);
+            }
+
+            mShadowMaterial->updateUniformData();
+        } else {
+            setCommonParams(context);
+
+            // Variant is created on the calling thread, since draws could be recorded on other threads
+            if (context.isDepthPrepassDone() && mDepthMaterial != nullptr)
+                mRenderMaterial->getGraphicsPipeline()->createDepthEqualVariant();
+
+            if (!instanced) {
+                auto model = glm::translate(mWorldPosition) * mRotation * glm::scale(mScale);
+                mRenderMaterial->setMat4(checkParam(getRenderParams().model, "CommonParams.model"), model);
+            }
+
+            mRenderMaterial->updateUniformData();
+        }
+    }
+
+    void RenderableMesh::onRenderRecord(const IRenderContext &context, bool shadowPass, ID<IRenderDevice::VertexBuffer> instanceBuffer,
+                                        uint32 offset, uint32 instancesCount) {
         auto device = context.getRenderDevice();
+
+        // Pre-pass depth must match main pass depth, therefore render mesh is drawn
+        bool depthPrepass = shadowPass && context.isDepthPrepass();
+        bool shadowMesh = shadowPass && !depthPrepass;
+        bool depthEqual = !shadowPass && context.isDepthPrepassDone() && mDepthMaterial != nullptr;
+
+        const auto& material = depthPrepass ? mDepthMaterial : (shadowPass ? mShadowMaterial : mRenderMaterial);
+        const auto& mesh = shadowMesh ? mShadowMesh : mRenderMesh;
+
+        material->bindGraphicsPipeline(depthEqual);
+        material->bindUniformData();
+
+        device->drawListBindVertexBuffer(shadowMesh ? mShadowVertexBuffer : mVertexBuffer, 0, 0);
+        if (instanceBuffer.isNotNull())
+            device->drawListBindVertexBuffer(instanceBuffer, INSTANCE_BUFFER_BINDING, offset);
+        device->drawListBindIndexBuffer(shadowMesh ? mShadowIndexBuffer : mIndexBuffer, IndicesType::Uint32, 0);
+        device->drawListDrawIndexed(mesh->getIndicesCount(), instancesCount);
+    }
+
+    void RenderableMesh::setCommonParams(const IRenderContext &context) {
         auto camera = context.getCamera();
         auto light = context.getGlobalLight();
 
-        auto model = glm::translate(mWorldPosition) * mRotation * glm::scale(mScale);
-
         auto camViewProj = camera->getViewProjClipMatrix();
+        const auto& params = getRenderParams();
 
         if (light != nullptr) {
             auto lightViewProj = light->getViewProjClipMatrix();
 
-            mRenderMaterial->setMat4("CommonParams.lightSpace", lightViewProj);
-            mRenderMaterial->setVec3("CommonParams.lightDir", light->getDirection());
+            mRenderMaterial->setMat4(checkParam(params.lightSpace, "CommonParams.lightSpace"), lightViewProj);
+            mRenderMaterial->setVec3(checkParam(params.lightDir, "CommonParams.lightDir"), light->getDirection());
             mRenderMaterial->setTexture("texShadowMap", context.getShadowMap());
         }
 
         // todo: another bindings
-        mRenderMaterial->setMat4("CommonParams.viewProj", camViewProj);
-        mRenderMaterial->setMat4("CommonParams.model", model);
-        mRenderMaterial->setVec3("CommonParams.cameraPos", camera->getPosition());
-
-        mRenderMaterial->updateUniformData();
-        mRenderMaterial->bindGraphicsPipeline();
-        mRenderMaterial->bindUniformData();
-
-        device->drawListBindVertexBuffer(mVertexBuffer, 0, 0);
-        device->drawListBindIndexBuffer(mIndexBuffer, IndicesType::Uint32, 0);
-        device->drawListDrawIndexed(mRenderMesh->getIndicesCount(), 1);
+        mRenderMaterial->setMat4(checkParam(params.viewProj, "CommonParams.viewProj"), camViewProj);
+        mRenderMaterial->setVec3(checkParam(params.cameraPos, "CommonParams.cameraPos"), camera->getPosition());
     }
 
-    void RenderableMesh::onShadowRenderQueueEntered(float32 distFromViewPoint) {
-        // Possibly select LOD, but this mesh has only LOD 0
-        // Do nothing
-    }
+    const RenderableMesh::RenderParams &RenderableMesh::getRenderParams() {
+        const auto& shader = mRenderMaterial->getGraphicsPipeline()->getShader();
+
+        if (mRenderParams.shader != shader) {
+            mRenderParams.shader = shader;
+            // Model matrix is pushed with draw call, if shader declares it as push constant
+            mRenderParams.model = mRenderMaterial->findParam("ObjectParams.model");
+            if (!mRenderParams.model.isValid())
+                mRenderParams.model = mRenderMaterial->findParam("CommonParams.model");
+            mRenderParams.viewProj = mRenderMaterial->findParam("CommonParams.viewProj");
+            mRenderParams.lightSpace = mRenderMaterial->findParam("CommonParams.lightSpace");
+            mRenderParams.lightDir = mRenderMaterial->findParam("CommonParams.lightDir");
+            mRenderParams.cameraPos = mRenderMaterial->findParam("CommonParams.cameraPos");
+        }
 
-    void RenderableMesh::onShadowRender(const IRenderContext &context) {
-        auto device = context.getRenderDevice();
-        auto light = context.getGlobalLight();
+        return mRenderParams;
+    }
 
+    void RenderableMesh::prepareDepth(const IRenderContext &context) {
         auto model = glm::translate(mWorldPosition) * mRotation * glm::scale(mScale);
-        auto lightMVP = light->getViewProjClipMatrix() * model;
+        auto viewProj = context.getCamera()->getViewProjClipMatrix();
+        const auto& params = getDepthParams();
+
+        if (params.viewProj.isValid() && params.model.isValid()) {
+            mDepthMaterial->setMat4(params.viewProj, viewProj);
+            mDepthMaterial->setMat4(params.model, model);
+        } else {
+            mDepthMaterial->setMat4(checkParam(params.depthMVP, "ShadowParams.depthMVP"), viewProj * model);
+        }
 
-        // todo: another bindings
-        mShadowMaterial->setMat4("ShadowParams.depthMVP", lightMVP);
+        mDepthMaterial->updateUniformData();
+    }
 
-        mShadowMaterial->updateUniformData();
-        mShadowMaterial->bindGraphicsPipeline();
-        mShadowMaterial->bindUniformData();
+    const RenderableMesh::ShadowParams &RenderableMesh::getShadowParams() {
+        const auto& shader = mShadowMaterial->getGraphicsPipeline()->getShader();
 
-        device->drawListBindVertexBuffer(mShadowVertexBuffer, 0, 0);
-        device->drawListBindIndexBuffer(mShadowIndexBuffer, IndicesType::Uint32, 0);
-        device->drawListDrawIndexed(mShadowMesh->getIndicesCount(), 1);
-    }
+        if (mShadowParams.shader != shader) {
+            mShadowParams.shader = shader;
+            mShadowParams.depthMVP = mShadowMaterial->findParam("ShadowParams.depthMVP");
+            mShadowParams.depthVP = mShadowMaterial->findParam("ShadowParams.depthVP");
+        }
 
-    Vec3f RenderableMesh::getWorldPosition() const {
-        return mWorldPosition;
+        return mShadowParams;
     }
 
-    AABB RenderableMesh::getWorldBoundingBox() const {
-        return mAABB;
-    }
+    const RenderableMesh::DepthParams &RenderableMesh::getDepthParams() {
+        const auto& shader = mDepthMaterial->getGraphicsPipeline()->getShader();
 
-    Material *RenderableMesh::getRenderMaterial() {
-        return mRenderMaterial.get();
-    }
+        if (mDepthParams.shader != shader) {
+            mDepthParams.shader = shader;
+            mDepthParams.viewProj = mDepthMaterial->findParam("DepthParams.viewProj");
+            mDepthParams.model = mDepthMaterial->findParam("DepthParams.model");
+            mDepthParams.depthMVP = mDepthMaterial->findParam("ShadowParams.depthMVP");
+        }
 
-    Material *RenderableMesh::getShadowRenderMaterial() {
-        return mShadowMaterial.get();
+        return mDepthParams;
     }
 }
\ No newline at end of file
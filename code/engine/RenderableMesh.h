@@ -26,16 +26,30 @@ namespace ignimbrite {
         void setRenderMaterial(RefCounted<Material> material, bool useAsShadowMaterial = false);
         void setShadowRenderMesh(RefCounted<Mesh> mesh);
         void setShadowRenderMaterial(RefCounted<Material> material);
+        /**
+         * Set material for depth pre-pass (null to disable), drawn with render mesh. Vertex transform
+         * of its shader must match the render material shader (for example PBRDepthPrepass.vert for PBR).
+         */
+        void setDepthRenderMaterial(RefCounted<Material> material);
+        /** Set low-poly mesh, used as occluder for other objects (null to disable) */
+        void setOccluderMesh(RefCounted<Mesh> mesh);
         void create();
 
         void rotate(const Vec3f& axis, float32 angle);
         void translate(const Vec3f& translation);
         void setScale(const Vec3f& scale);
+        /** Recalculate world bounds after transformations and notify the scene */
         void updateAABB();
         void generateGpuBuffers();
         void updateGpuBuffersData();
         void releaseGpuBuffers();
 
+        const RefCounted<Mesh> &getRenderMesh() const { return mRenderMesh; }
+        const RefCounted<Mesh> &getShadowRenderMesh() const { return mShadowMesh; }
+        const RefCounted<Material> &getSharedRenderMaterial() const { return mRenderMaterial; }
+        const RefCounted<Material> &getSharedShadowRenderMaterial() const { return mShadowMaterial; }
+        const RefCounted<Material> &getSharedDepthRenderMaterial() const { return mDepthMaterial; }
+
         // IRenderable
 
         void onAddToScene(const IRenderContext &context) override;
@@ -48,9 +62,57 @@ namespace ignimbrite {
         AABB getWorldBoundingBox() const override;
         Material *getRenderMaterial() override;
         Material *getShadowRenderMaterial() override;
+        Material *getDepthRenderMaterial() override;
+        const Mesh *getOccluderMesh(Mat4f &transform) const override;
+        const void *getInstancingKey(bool shadowPass) const override;
+        bool canInstanceWith(const IRenderable &other, bool shadowPass) const override;
+        Mat4f getInstanceTransform() const override;
+        void onRenderInstanced(const IRenderContext &context, ID<IRenderDevice::VertexBuffer> instanceBuffer,
+                               uint32 offset, uint32 instancesCount) override;
+        void onShadowRenderInstanced(const IRenderContext &context, ID<IRenderDevice::VertexBuffer> instanceBuffer,
+                                     uint32 offset, uint32 instancesCount) override;
+        bool canRecordInParallel(bool shadowPass) const override;
+        void onRenderPrepare(const IRenderContext &context, bool shadowPass, bool instanced) override;
+        void onRenderRecord(const IRenderContext &context, bool shadowPass, ID<IRenderDevice::VertexBuffer> instanceBuffer,
+                            uint32 offset, uint32 instancesCount) override;
 
     protected:
 
+        /** Binding of the per-instance model matrices buffer in instanced pipelines */
+        static const uint32 INSTANCE_BUFFER_BINDING = 1;
+
+        /** Handles of the per-draw params, resolved once for the material shader */
+        struct RenderParams {
+            RefCounted<Shader> shader;
+            Material::ParamHandle model;
+            Material::ParamHandle viewProj;
+            Material::ParamHandle lightSpace;
+            Material::ParamHandle lightDir;
+            Material::ParamHandle cameraPos;
+        };
+
+        struct ShadowParams {
+            RefCounted<Shader> shader;
+            Material::ParamHandle depthMVP;
+            Material::ParamHandle depthVP;
+        };
+
+        /** Pre-pass shader takes separate matrices (as main pass shaders) or the shadow MVP */
+        struct DepthParams {
+            RefCounted<Shader> shader;
+            Material::ParamHandle viewProj;
+            Material::ParamHandle model;
+            Material::ParamHandle depthMVP;
+        };
+
+        /** Set camera and light params of the render material (except model matrix) */
+        void setCommonParams(const IRenderContext &context);
+        const RenderParams &getRenderParams();
+        const ShadowParams &getShadowParams();
+        const DepthParams &getDepthParams();
+        /** Set camera params of the depth material and update its data */
+        void prepareDepth(const IRenderContext &context);
+
         bool isDirty() { return mDirty; }
         void markDirty() { mDirty = true; }
         void markClear() { mDirty = false; }
@@ -63,8 +125,13 @@ namespace ignimbrite {
 
         RefCounted<Mesh>     mRenderMesh;
         RefCounted<Mesh>     mShadowMesh;
+        RefCounted<Mesh>     mOccluderMesh;
         RefCounted<Material> mRenderMaterial;
         RefCounted<Material> mShadowMaterial;
+        RefCounted<Material> mDepthMaterial;
+        RenderParams         mRenderParams;
+        ShadowParams         mShadowParams;
+        DepthParams          mDepthParams;
 
         RefCounted<IRenderDevice>       mDevice;
         ID<IRenderDevice::IndexBuffer>  mIndexBuffer;
@@ -0,0 +1,91 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <RenderableRegistry.h>
+
+namespace ignimbrite {
+
+    void RenderableRegistry::reserve(uint32 capacity) {
+        mObjects.reserve(capacity);
+        mPositions.reserve(capacity);
+        mBounds.reserve(capacity);
+        mMaxViewDistancesSq.reserve(capacity);
+        mFlags.reserve(capacity);
+        mLayers.reserve(capacity);
+    }
+
+    uint32 RenderableRegistry::add(IRenderable *object) {
+        if (object == nullptr)
+            throw std::runtime_error("An attempt to add null object");
+
+        uint32 id;
+
+        if (mFreeIDs.empty()) {
+            id = (uint32) mObjects.size();
+            mObjects.push_back(nullptr);
+            mPositions.emplace_back();
+            mBounds.emplace_back();
+            mMaxViewDistancesSq.push_back(0.0f);
+            mFlags.push_back(0);
+            mLayers.push_back(0);
+        } else {
+            id = mFreeIDs.back();
+            mFreeIDs.pop_back();
+        }
+
+        mObjects[id] = object;
+        mFlags[id] = Present;
+
+        update(id, 0xffffffff);
+
+        return id;
+    }
+
+    void RenderableRegistry::remove(uint32 id) {
+        if (!contains(id))
+            throw std::runtime_error("Registry does not contain object with such id");
+
+        mObjects[id] = nullptr;
+        mFlags[id] = 0;
+        mFreeIDs.push_back(id);
+    }
+
+    void RenderableRegistry::update(uint32 id, uint32 changes) {
+        if (!contains(id))
+            throw std::runtime_error("Registry does not contain object with such id");
+
+        const IRenderable* object = mObjects[id];
+
+        if (changes & IRenderableListener::Bounds) {
+            mPositions[id] = object->getWorldPosition();
+            mBounds[id] = object->getWorldBoundingBox();
+        }
+
+        if (changes & (IRenderableListener::Flags | IRenderableListener::Static)) {
+            uint8 flags = Present;
+            flags |= object->isVisible() ? Visible : 0;
+            flags |= object->castShadows() ? CastShadows : 0;
+            flags |= object->canApplyCulling() ? CanApplyCulling : 0;
+            flags |= object->isStatic() ? Static : 0;
+
+            Mat4f transform;
+            flags |= object->getOccluderMesh(transform) != nullptr ? Occluder : 0;
+            mFlags[id] = flags;
+        }
+
+        if (changes & IRenderableListener::MaxViewDistance) {
+            mMaxViewDistancesSq[id] = object->getMaxViewDistanceSquared();
+        }
+
+        if (changes & IRenderableListener::Layer) {
+            mLayers[id] = object->getLayerID();
+        }
+    }
+
+}
@@ -0,0 +1,81 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_RENDERABLEREGISTRY_H
+#define IGNIMBRITE_RENDERABLEREGISTRY_H
+
+#include <IRenderable.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Scene renderables state in structure of arrays layout
+     *
+     * Keeps copy of the renderables state, required for culling, in tightly
+     * packed arrays, indexed by scene id. State is updated only when
+     * renderable notifies about its changes, therefore culling does not
+     * require any virtual calls for the objects.
+     *
+     * Ids of removed objects are reused, so arrays stay compact.
+     */
+    class RenderableRegistry {
+    public:
+        static const uint32 INVALID_ID = 0xffffffff;
+
+        enum FlagBits : uint8 {
+            /** Slot is occupied by an object */
+            Present = 1u << 0u,
+            Visible = 1u << 1u,
+            CastShadows = 1u << 2u,
+            CanApplyCulling = 1u << 3u,
+            Static = 1u << 4u,
+            /** Object provides occluder mesh */
+            Occluder = 1u << 5u
+        };
+
+        /** Reserve storage for specified number of objects */
+        void reserve(uint32 capacity);
+        /** Add object and read its state, @return Scene id of the object */
+        uint32 add(IRenderable* object);
+        void remove(uint32 id);
+        /** Read object state for specified changes (combination of IRenderableListener::ChangeFlagBits) */
+        void update(uint32 id, uint32 changes);
+
+        bool contains(uint32 id) const { return id < mFlags.size() && (mFlags[id] & Present); }
+        uint32 getObjectsCount() const { return (uint32) (mObjects.size() - mFreeIDs.size()); }
+        /** @return Number of slots in the arrays (valid ids are less than this value) */
+        uint32 getCapacity() const { return (uint32) mObjects.size(); }
+
+        IRenderable* getObject(uint32 id) const { return mObjects[id]; }
+        const Vec3f &getPosition(uint32 id) const { return mPositions[id]; }
+        const AABB &getBounds(uint32 id) const { return mBounds[id]; }
+        float32 getMaxViewDistanceSquared(uint32 id) const { return mMaxViewDistancesSq[id]; }
+        uint8 getFlags(uint32 id) const { return mFlags[id]; }
+        uint32 getLayerID(uint32 id) const { return mLayers[id]; }
+
+        const std::vector<IRenderable*> &getObjects() const { return mObjects; }
+        const std::vector<Vec3f> &getPositions() const { return mPositions; }
+        const std::vector<AABB> &getBounds() const { return mBounds; }
+        const std::vector<float32> &getMaxViewDistancesSquared() const { return mMaxViewDistancesSq; }
+        const std::vector<uint8> &getFlags() const { return mFlags; }
+        const std::vector<uint32> &getLayers() const { return mLayers; }
+
+    private:
+        std::vector<IRenderable*> mObjects;
+        std::vector<Vec3f> mPositions;
+        std::vector<AABB> mBounds;
+        std::vector<float32> mMaxViewDistancesSq;
+        std::vector<uint8> mFlags;
+        std::vector<uint32> mLayers;
+        std::vector<uint32> mFreeIDs;
+    };
+
+}
+
+#endif //IGNIMBRITE_RENDERABLEREGISTRY_H
@@ -52,9 +52,11 @@ namespace ignimbrite {
         reflection.reflect();
     }
 
-    void Shader::generateUniformLayout() {
+    void Shader::generateUniformLayout(bool dynamicBuffers) {
         if (mLayout.isNotNull()) return;
 
+        mDynamicBuffers = dynamicBuffers;
+
         IRenderDevice::UniformLayoutDesc uniformLayoutDesc{};
 
         for (const auto& pair: mVariables) {
@@ -72,9 +74,24 @@ namespace ignimbrite {
             IRenderDevice::UniformLayoutBufferDesc bufferDesc{};
             bufferDesc.binding = buffer.binding;
             bufferDesc.flags = buffer.stageFlags;
+            bufferDesc.dynamic = dynamicBuffers;
             uniformLayoutDesc.buffers.push_back(bufferDesc);
         }
 
+        for (const auto& pair: mPushConstants) {
+            const auto& block = pair.second;
+
+            if (block.offset + block.size > mDevice->getMaxPushConstantsSize()) {
+                throw std::runtime_error("Push constants block exceeds device limit: " + pair.first);
+            }
+
+            IRenderDevice::UniformLayoutPushConstantDesc pushConstantDesc{};
+            pushConstantDesc.flags = block.stageFlags;
+            pushConstantDesc.offset = block.offset;
+            pushConstantDesc.size = block.size;
+            uniformLayoutDesc.pushConstants.push_back(pushConstantDesc);
+        }
+
         mLayout = mDevice->createUniformLayout(uniformLayoutDesc);
 
         if (mLayout.isNull()) {
@@ -135,4 +152,12 @@ namespace ignimbrite {
     const std::unordered_map<String, Shader::ParameterInfo> &Shader::getParametersInfo() const {
         return mVariables;
     }
+
+    const std::unordered_map<String, Shader::PushConstantInfo> &Shader::getPushConstantsInfo() const {
+        return mPushConstants;
+    }
+
+    bool Shader::hasParameter(const String &name) const {
+        return mVariables.find(name) != mVariables.end();
+    }
 }
\ No newline at end of file
@@ -56,6 +56,8 @@ namespace ignimbrite {
             uint32           blockSize;
             DataType         type;
             ShaderStageFlags stageFlags;
+            /** True if parameter is a member of push constants block (offset in push constants memory) */
+            bool             pushConstant;
         };
 
         struct UniformBufferInfo {
@@ -65,12 +67,24 @@ namespace ignimbrite {
             std::vector<String> members;
         };
 
+        struct PushConstantInfo {
+            /** Range of the block members in push constants memory */
+            uint32              offset;
+            uint32              size;
+            ShaderStageFlags    stageFlags;
+            std::vector<String> members;
+        };
+
         explicit Shader(RefCounted<IRenderDevice> device);
         ~Shader() override;
 
         void fromSources(ShaderLanguage language, const std::vector<uint8> &vertex, const std::vector<uint8> &fragment);
         void reflectData();
-        void generateUniformLayout();
+        /**
+         * Generate uniform layout from reflected data
+         * @param dynamicBuffers True to bind all uniform buffers with dynamic offsets
+         */
+        void generateUniformLayout(bool dynamicBuffers = false);
         void releaseHandle();
         void releaseLayout();
 
@@ -82,6 +96,11 @@ namespace ignimbrite {
         const UniformBufferInfo& getBufferInfo(const String &name) const;
         const std::unordered_map<String, UniformBufferInfo> &getBuffersInfo() const;
         const std::unordered_map<String, ParameterInfo> &getParametersInfo() const;
+        const std::unordered_map<String, PushConstantInfo> &getPushConstantsInfo() const;
+        /** @return True if program has uniform or push constant parameter with specified name */
+        bool hasParameter(const String &name) const;
+        /** @return True if uniform buffers of the layout are bound with dynamic offsets */
+        bool hasDynamicBuffers() const { return mDynamicBuffers; }
 
     private:
         friend class ShaderReflection;
@@ -93,12 +112,15 @@ namespace ignimbrite {
         std::unordered_map<String, ParameterInfo> mVariables;
         /** Program uniform blocks info */
         std::unordered_map<String, UniformBufferInfo> mBuffers;
+        /** Program push constants blocks info */
+        std::unordered_map<String, PushConstantInfo> mPushConstants;
         /** Program descriptor with this shader's modules*/
         IRenderDevice::ProgramDesc mProgramDesc;
         /** Actual program handle */
         ID<IRenderDevice::ShaderProgram> mHandle;
         /** Uniform layout */
         ID<IRenderDevice::UniformLayout> mLayout;
+        bool mDynamicBuffers = false;
         /** Render device, which is used for that shader creation */
         RefCounted<IRenderDevice> mDevice;
 
@@ -9,6 +9,7 @@
 
 #include <ShaderReflection.h>
 #include <spirv_cross.hpp>
+#include <algorithm>
 #include <vector>
 #include <string>
 
@@ -185,7 +186,7 @@ namespace ignimbrite {
                           std::vector<String> &membersList,
                           ShaderStageFlags flags, const spirv_cross::Compiler &comp,
                           const spirv_cross::SPIRType &spirType, const String &baseName,
-                          uint32 baseBinding, ignimbrite::uint32 baseOffset) {
+                          uint32 baseBinding, ignimbrite::uint32 baseOffset, bool pushConstant = false) {
 
         using namespace spirv_cross;
 
@@ -200,6 +201,7 @@ namespace ignimbrite {
             Shader::ParameterInfo info = {};
             info.stageFlags = flags;
             info.blockSize = 0;
+            info.pushConstant = pushConstant;
 
             membersList.push_back(memberName);
 
@@ -218,6 +220,61 @@ namespace ignimbrite {
         }
     }
 
+    void getSpirvPushConstants(
+            const spirv_cross::Compiler &comp, const spirv_cross::ShaderResources &resources,
+            std::unordered_map<String, Shader::ParameterInfo> &params,
+            std::unordered_map<String, Shader::PushConstantInfo> &pushConstants,
+            ShaderStageFlags stageFlags) {
+        using namespace spirv_cross;
+
+        for (const auto &resource : resources.push_constant_buffers) {
+
+            const SPIRType &spirType = comp.get_type(resource.base_type_id);
+            // resource name is the instance name, but params are accessed by the block name as for uniform buffers
+            String name = comp.get_name(resource.base_type_id);
+            if (name.empty()) name = resource.name;
+
+            uint32 memberCount = spirType.member_types.size();
+
+            // block members could start with explicit offset (if other stage uses first bytes)
+            uint32 offset = 0xffffffff;
+            for (uint32 i = 0; i < memberCount; i++) {
+                offset = std::min(offset, comp.type_struct_member_offset(spirType, i));
+            }
+
+            uint32 size = (uint32) comp.get_declared_struct_size(spirType) - offset;
+
+            if (pushConstants.count(name) > 0) {
+                // if block already exists with the same name, check its range
+                auto &block = pushConstants[name];
+                if (block.offset != offset || block.size != size) {
+                    throw std::runtime_error("If push constants have same name they must have same layout too");
+                }
+
+                // if it's the same block but in another stage, update flags
+                block.stageFlags |= stageFlags;
+                continue;
+            }
+
+            for (const auto &p : pushConstants) {
+                if (offset < p.second.offset + p.second.size && p.second.offset < offset + size) {
+                    throw std::runtime_error("Push constants blocks must not overlap: " + name + " " + p.first);
+                }
+            }
+
+            pushConstants[name] = {};
+            Shader::PushConstantInfo &blockInfo = pushConstants[name];
+
+            blockInfo.stageFlags = stageFlags;
+            blockInfo.offset = offset;
+            blockInfo.size = size;
+
+            // parse block members, offsets are relative to push constants memory start
+            parseSpirvStruct(params, blockInfo.members, stageFlags, comp, spirType, name,
+                             0, 0, true);
+        }
+    }
+
     void getSpirvParams(
             const spirv_cross::Compiler &comp, const spirv_cross::ShaderResources &resources,
             std::unordered_map<String, Shader::ParameterInfo> &params,
@@ -338,6 +395,7 @@ namespace ignimbrite {
                 const spirv_cross::ShaderResources &resources = compiler.get_shader_resources();
 
                 getSpirvParams(compiler, resources, shader.mVariables, shader.mBuffers, stageFlags);
+                getSpirvPushConstants(compiler, resources, shader.mVariables, shader.mPushConstants, stageFlags);
 
                 if (desc.type == ShaderType::Vertex) {
                     getSpirvModuleInputs(compiler, resources, shader.mVertexShaderInputs);
@@ -0,0 +1,36 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <ShadowCasterVolume.h>
+
+namespace ignimbrite {
+
+    void ShadowCasterVolume::build(const Frustum &frustum, const Vec3f &lightDirection) {
+        mPlanesCount = frustum.getExtrudedPlanes(glm::normalize(lightDirection), mPlanes.data());
+    }
+
+    bool ShadowCasterVolume::canCastShadow(const AABB &box) const {
+        auto c = box.getCenter();
+        auto e = box.getExtent();
+
+        for (uint32 i = 0; i < mPlanesCount; i++) {
+            const auto& p = mPlanes[i];
+            Vec3f n(p);
+
+            float32 r = glm::dot(e, glm::abs(n));
+            float32 s = glm::dot(n, c) + p.w;
+
+            if (s < -r)
+                return false;
+        }
+
+        return true;
+    }
+
+}
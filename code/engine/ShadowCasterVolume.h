@@ -0,0 +1,47 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_SHADOWCASTERVOLUME_H
+#define IGNIMBRITE_SHADOWCASTERVOLUME_H
+
+#include <IncludeMath.h>
+#include <Frustum.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Volume of objects, which shadows could be seen
+     *
+     * Camera frustum (cut to the shadow distance) swept towards the light:
+     * only objects inside this volume could cast shadows on the visible
+     * receivers, therefore other objects are skipped in the shadow pass.
+     */
+    class ShadowCasterVolume {
+    public:
+
+        /**
+         * Build volume for directional light
+         * @param frustum Camera frustum, cut to the shadow distance
+         * @param lightDirection Direction of the light rays
+         */
+        void build(const Frustum &frustum, const Vec3f &lightDirection);
+
+        /** @return True if the box could cast shadow into the frustum */
+        bool canCastShadow(const AABB &box) const;
+
+        uint32 getPlanesCount() const { return mPlanesCount; }
+
+    private:
+        std::array<glm::vec4, Frustum::MAX_EXTRUDED_PLANES> mPlanes = {};
+        uint32 mPlanesCount = 0;
+    };
+
+}
+
+#endif //IGNIMBRITE_SHADOWCASTERVOLUME_H
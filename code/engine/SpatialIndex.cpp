@@ -0,0 +1,130 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <SpatialIndex.h>
+
+namespace ignimbrite {
+
+    void SpatialIndex::reserve(uint32 capacity) {
+        mRecords.reserve(capacity);
+        mDynamicGrid.reserve(capacity);
+    }
+
+    void SpatialIndex::add(uint32 id, const AABB &bounds, bool isStatic) {
+        if (contains(id))
+            throw std::runtime_error("Spatial index already contains object with such id");
+
+        if (id >= mRecords.size()) {
+            mRecords.resize(id + 1);
+        }
+
+        auto& record = mRecords[id];
+        record.bounds = bounds;
+        record.isStatic = isStatic;
+        record.present = true;
+        record.treeItem = BVH::INVALID_INDEX;
+
+        if (isStatic)
+            mStaticTreeDirty = true;
+        else
+            mDynamicGrid.add(id, bounds);
+    }
+
+    void SpatialIndex::remove(uint32 id) {
+        if (!contains(id))
+            throw std::runtime_error("Spatial index does not contain object with such id");
+
+        auto& record = mRecords[id];
+
+        if (record.isStatic)
+            mStaticTreeDirty = true;
+        else
+            mDynamicGrid.remove(id);
+
+        record = Record();
+    }
+
+    void SpatialIndex::update(uint32 id, const AABB &bounds) {
+        if (!contains(id))
+            throw std::runtime_error("Spatial index does not contain object with such id");
+
+        auto& record = mRecords[id];
+        record.bounds = bounds;
+
+        if (!record.isStatic) {
+            mDynamicGrid.update(id, bounds);
+            return;
+        }
+
+        // Refit only if tree is actual, otherwise new bounds will be used on rebuild
+        if (!mStaticTreeDirty && record.treeItem != BVH::INVALID_INDEX) {
+            mStaticTree.refit(record.treeItem, bounds);
+        }
+    }
+
+    void SpatialIndex::setStatic(uint32 id, bool isStatic) {
+        if (!contains(id))
+            throw std::runtime_error("Spatial index does not contain object with such id");
+
+        auto bounds = mRecords[id].bounds;
+
+        if (mRecords[id].isStatic != isStatic) {
+            remove(id);
+            add(id, bounds, isStatic);
+        }
+    }
+
+    void SpatialIndex::query(const Frustum &frustum, std::vector<uint32> &result) {
+        if (mStaticTreeDirty) {
+            rebuildStaticTree();
+        }
+
+        mStaticTree.query(frustum, result);
+        mDynamicGrid.query(frustum, result);
+    }
+
+    void SpatialIndex::query(const Frustum *frusta, uint32 count, std::vector<uint32> &ids, std::vector<uint32> &masks) {
+        if (count > MAX_VIEWS)
+            throw std::runtime_error("Too many frusta for the single query");
+
+        if (mStaticTreeDirty) {
+            rebuildStaticTree();
+        }
+
+        mStaticTree.query(frusta, count, ids, masks);
+        mDynamicGrid.query(frusta, count, ids, masks);
+    }
+
+    void SpatialIndex::setGridCellSize(float32 cellSize) {
+        mDynamicGrid.setCellSize(cellSize);
+    }
+
+    void SpatialIndex::rebuildStaticTree() {
+        std::vector<uint32> ids;
+        std::vector<AABB> bounds;
+
+        for (uint32 id = 0; id < mRecords.size(); id++) {
+            const auto& record = mRecords[id];
+
+            if (record.present && record.isStatic) {
+                ids.push_back(id);
+                bounds.push_back(record.bounds);
+            }
+        }
+
+        mStaticTree.build(ids, bounds);
+
+        for (uint32 i = 0; i < mStaticTree.getItemsCount(); i++) {
+            mRecords[mStaticTree.getItemID(i)].treeItem = i;
+        }
+
+        mStaticTreeDirty = false;
+    }
+
+}
@@ -0,0 +1,75 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_SPATIALINDEX_H
+#define IGNIMBRITE_SPATIALINDEX_H
+
+#include <BVH.h>
+#include <LooseGrid.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Scene acceleration structure for visibility queries
+     *
+     * Static objects are stored in the BVH, which is rebuilt lazily on the
+     * query after static objects set is changed, and refitted when
+     * static object bounds are updated. Dynamic objects are stored in the loose grid.
+     *
+     * Objects are identified by dense ids, provided by the user.
+     */
+    class SpatialIndex {
+    public:
+        /** Max number of frusta in the multi-view query */
+        static const uint32 MAX_VIEWS = 32;
+
+        /** Reserve storage for objects with ids less than capacity */
+        void reserve(uint32 capacity);
+        void add(uint32 id, const AABB &bounds, bool isStatic);
+        void remove(uint32 id);
+        /** Update object bounds (refit for static objects) */
+        void update(uint32 id, const AABB &bounds);
+        /** Move object between static and dynamic structures */
+        void setStatic(uint32 id, bool isStatic);
+
+        /** Append ids of objects inside or intersecting frustum */
+        void query(const Frustum &frustum, std::vector<uint32> &result);
+
+        /**
+         * Append ids of objects inside or intersecting at least one of the frusta and
+         * for each object the mask of frusta (bit i for frusta[i]), which see it.
+         * The scene is traversed once for all the frusta.
+         */
+        void query(const Frustum* frusta, uint32 count, std::vector<uint32> &ids, std::vector<uint32> &masks);
+
+        /** Set cell size of the dynamic objects grid (only for empty index) */
+        void setGridCellSize(float32 cellSize);
+
+        bool contains(uint32 id) const { return id < mRecords.size() && mRecords[id].present; }
+
+    private:
+
+        void rebuildStaticTree();
+
+        struct Record {
+            AABB bounds;
+            uint32 treeItem = BVH::INVALID_INDEX;
+            bool isStatic = false;
+            bool present = false;
+        };
+
+        std::vector<Record> mRecords;
+        BVH mStaticTree;
+        LooseGrid mDynamicGrid;
+        bool mStaticTreeDirty = false;
+    };
+
+}
+
+#endif //IGNIMBRITE_SPATIALINDEX_H
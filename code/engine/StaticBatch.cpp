@@ -0,0 +1,303 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <StaticBatch.h>
+#include <algorithm>
+#include <cstring>
+
+namespace ignimbrite {
+
+    StaticBatch::StaticBatch(RefCounted<IRenderDevice> device)
+        : mDevice(std::move(device)) {
+
+    }
+
+    void StaticBatch::setClusterSize(float32 size) {
+        if (size <= 0.0f)
+            throw std::runtime_error("Cluster size must be positive");
+
+        mClusterSize = size;
+    }
+
+    void StaticBatch::setMaxClusterVertices(uint32 count) {
+        if (count == 0)
+            throw std::runtime_error("Max cluster vertices count must be positive");
+
+        mMaxClusterVertices = count;
+    }
+
+    void StaticBatch::build(std::vector<RefCounted<RenderableMesh>> objects) {
+        if (mGrouped)
+            throw std::runtime_error("An attempt to rebuild grouped batch");
+
+        mClusters.clear();
+        mObjects = std::move(objects);
+
+        checkObjects();
+
+        struct Entry {
+            glm::ivec3 cell;
+            uint32 index;
+        };
+
+        auto count = (uint32) mObjects.size();
+        std::vector<Entry> entries(count);
+        bool sameShadowMeshes = true;
+
+        for (uint32 i = 0; i < count; i++) {
+            const auto& object = mObjects[i];
+            auto cell = glm::floor(object->getWorldPosition() / mClusterSize);
+
+            entries[i].cell = glm::ivec3(cell);
+            entries[i].index = i;
+            sameShadowMeshes = sameShadowMeshes && object->getShadowRenderMesh() == object->getRenderMesh();
+        }
+
+        // Objects of the same cell become adjacent (order in the cell is preserved)
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            if (a.cell.x != b.cell.x) return a.cell.x < b.cell.x;
+            if (a.cell.y != b.cell.y) return a.cell.y < b.cell.y;
+            if (a.cell.z != b.cell.z) return a.cell.z < b.cell.z;
+            return a.index < b.index;
+        });
+
+        std::vector<uint32> indices;
+        uint32 verticesCount = 0;
+
+        auto flush = [&]() {
+            if (indices.empty())
+                return;
+
+            Cluster cluster;
+            cluster.mesh = mergeMeshes(indices, false);
+            cluster.shadowMesh = sameShadowMeshes ? cluster.mesh : mergeMeshes(indices, true);
+            cluster.objects = std::move(indices);
+
+            mClusters.push_back(std::move(cluster));
+
+            indices.clear();
+            verticesCount = 0;
+        };
+
+        for (uint32 i = 0; i < count; i++) {
+            const auto& entry = entries[i];
+            auto objectVertices = mObjects[entry.index]->getRenderMesh()->getVertexCount();
+
+            bool newCell = i > 0 && entry.cell != entries[i - 1].cell;
+            bool overflow = verticesCount + objectVertices > mMaxClusterVertices;
+
+            if (newCell || overflow)
+                flush();
+
+            indices.push_back(entry.index);
+            verticesCount += objectVertices;
+        }
+
+        flush();
+    }
+
+    void StaticBatch::group(IRenderEngine &engine) {
+        if (mGrouped)
+            throw std::runtime_error("Batch is already grouped");
+
+        std::vector<RefCounted<IRenderable>> clusters;
+        clusters.reserve(mClusters.size());
+
+        for (auto& cluster: mClusters) {
+            if (cluster.renderable == nullptr)
+                createRenderable(cluster);
+
+            clusters.push_back(cluster.renderable);
+        }
+
+        for (const auto& object: mObjects) {
+            engine.removeRenderable(object);
+        }
+
+        engine.addRenderables(clusters);
+        mGrouped = true;
+    }
+
+    void StaticBatch::ungroup(IRenderEngine &engine) {
+        if (!mGrouped)
+            throw std::runtime_error("Batch is not grouped");
+
+        for (const auto& cluster: mClusters) {
+            engine.removeRenderable(cluster.renderable);
+        }
+
+        std::vector<RefCounted<IRenderable>> objects(mObjects.begin(), mObjects.end());
+        engine.addRenderables(objects);
+        mGrouped = false;
+    }
+
+    void StaticBatch::clear() {
+        if (mGrouped)
+            throw std::runtime_error("An attempt to clear grouped batch");
+
+        mClusters.clear();
+        mObjects.clear();
+    }
+
+    void StaticBatch::checkObjects() const {
+        if (mObjects.empty())
+            return;
+
+        const auto& first = mObjects.front();
+
+        if (first == nullptr)
+            throw std::runtime_error("An attempt to batch null object");
+
+        for (const auto& object: mObjects) {
+            if (object == nullptr)
+                throw std::runtime_error("An attempt to batch null object");
+
+            if (!object->isStatic() || !object->isVisible())
+                throw std::runtime_error("Batched objects must be static and visible");
+
+            if (object->getRenderMesh() == nullptr || object->getShadowRenderMesh() == nullptr)
+                throw std::runtime_error("Batched object has no mesh");
+
+            if (object->getRenderMesh()->getVertexFormat() != first->getRenderMesh()->getVertexFormat() ||
+                object->getShadowRenderMesh()->getVertexFormat() != first->getShadowRenderMesh()->getVertexFormat())
+                throw std::runtime_error("Batched objects must have the same vertex format");
+
+            if (object->getLayerID() != first->getLayerID() || object->castShadows() != first->castShadows())
+                throw std::runtime_error("Batched objects must have the same layer and shadows casting");
+
+            // Per-object params are set by the cluster itself
+            const auto& material = object->getSharedRenderMaterial();
+            const auto& shadowMaterial = object->getSharedShadowRenderMaterial();
+
+            if (material == nullptr || !first->getSharedRenderMaterial()->hasEqualParams(*material, "CommonParams"))
+                throw std::runtime_error("Batched objects must have the same render material");
+
+            if (shadowMaterial == nullptr || !first->getSharedShadowRenderMaterial()->hasEqualParams(*shadowMaterial, "ShadowParams"))
+                throw std::runtime_error("Batched objects must have the same shadow material");
+        }
+    }
+
+    void StaticBatch::createRenderable(Cluster &cluster) {
+        const auto& first = mObjects[cluster.objects.front()];
+
+        float32 maxViewDistance = 0.0f;
+        bool canApplyCulling = true;
+
+        for (auto index: cluster.objects) {
+            maxViewDistance = std::max(maxViewDistance, mObjects[index]->getMaxViewDistance());
+            canApplyCulling = canApplyCulling && mObjects[index]->canApplyCulling();
+        }
+
+        auto renderable = std::make_shared<RenderableMesh>();
+        renderable->setRenderDevice(mDevice);
+        renderable->setRenderMesh(cluster.mesh);
+        renderable->setRenderMaterial(first->getSharedRenderMaterial());
+        renderable->setShadowRenderMesh(cluster.shadowMesh);
+        renderable->setShadowRenderMaterial(first->getSharedShadowRenderMaterial());
+        renderable->create();
+        renderable->setStatic(true);
+        renderable->setVisible(true);
+        renderable->setCastShadows(first->castShadows());
+        renderable->setCanApplyCulling(canApplyCulling);
+        renderable->setLayerID(first->getLayerID());
+        renderable->setMaxViewDistance(maxViewDistance);
+
+        cluster.renderable = std::move(renderable);
+    }
+
+    RefCounted<Mesh> StaticBatch::mergeMeshes(const std::vector<uint32> &indices, bool shadowMeshes) const {
+        uint32 verticesCount = 0;
+        uint32 indicesCount = 0;
+
+        for (auto index: indices) {
+            const auto& mesh = shadowMeshes ? mObjects[index]->getShadowRenderMesh() : mObjects[index]->getRenderMesh();
+            verticesCount += mesh->getVertexCount();
+            indicesCount += mesh->getIndicesCount();
+        }
+
+        const auto& first = mObjects[indices.front()];
+        auto format = (shadowMeshes ? first->getShadowRenderMesh() : first->getRenderMesh())->getVertexFormat();
+        auto result = std::make_shared<Mesh>(format, verticesCount, indicesCount);
+
+        uint32 vertexOffset = 0;
+        uint32 indexOffset = 0;
+
+        for (auto index: indices) {
+            const auto& object = mObjects[index];
+            const auto& mesh = shadowMeshes ? object->getShadowRenderMesh() : object->getRenderMesh();
+
+            writeTransformed(*mesh, object->getInstanceTransform(), *result, vertexOffset, indexOffset);
+
+            vertexOffset += mesh->getVertexCount();
+            indexOffset += mesh->getIndicesCount();
+        }
+
+        result->updateBoundingVolume();
+
+        return result;
+    }
+
+    void StaticBatch::writeTransformed(const Mesh &source, const Mat4f &model, Mesh &destination,
+                                       uint32 vertexOffset, uint32 indexOffset) {
+        auto mask = (uint32) source.getVertexFormat();
+        auto stride = source.getStride();
+        auto count = source.getVertexCount();
+
+        // Attributes are packed in the order of Mesh::BasicAttributes bits
+        uint32 normalOffset = sizeof(Vec3f);
+        uint32 tangentOffset = normalOffset + ((mask & Mesh::Norm3f) ? sizeof(Vec3f) : 0) + ((mask & Mesh::TexCoords2f) ? sizeof(Vec2f) : 0);
+        uint32 bitangentOffset = tangentOffset + ((mask & Mesh::Tangent3f) ? sizeof(Vec3f) : 0);
+
+        auto directions = glm::mat3(model);
+        auto normals = glm::transpose(glm::inverse(directions));
+
+        std::vector<uint8> vertices(source.getVertexData(), source.getVertexData() + stride * count);
+
+        auto transform = [](uint8* data, const glm::mat3& m) {
+            Vec3f v;
+            std::memcpy(&v, data, sizeof(Vec3f));
+            v = m * v;
+            auto length = glm::length(v);
+            v = length > 0.0f ? v / length : v;
+            std::memcpy(data, &v, sizeof(Vec3f));
+        };
+
+        for (uint32 i = 0; i < count; i++) {
+            auto vertex = vertices.data() + i * stride;
+
+            Vec3f p;
+            std::memcpy(&p, vertex, sizeof(Vec3f));
+            p = Vec3f(model * Vec4f(p, 1.0f));
+            std::memcpy(vertex, &p, sizeof(Vec3f));
+
+            if (mask & Mesh::Norm3f) transform(vertex + normalOffset, normals);
+            if (mask & Mesh::Tangent3f) transform(vertex + tangentOffset, directions);
+            if (mask & Mesh::Bitangent3f) transform(vertex + bitangentOffset, directions);
+        }
+
+        destination.updateVertexData(vertexOffset, count, vertices.data());
+
+        std::vector<uint32> indices(source.getIndexData(), source.getIndexData() + source.getIndicesCount());
+
+        for (auto& index: indices) {
+            index += vertexOffset;
+        }
+
+        // Mirrored transform reverses winding, therefore front faces would be culled.
+        // Tangent and bitangent are transformed explicitly, so tangent frame stays valid.
+        if (glm::determinant(directions) < 0.0f) {
+            for (uint32 i = 0; i + 2 < indices.size(); i += 3) {
+                std::swap(indices[i + 1], indices[i + 2]);
+            }
+        }
+
+        destination.updateIndexData(indexOffset, (uint32) indices.size(), indices.data());
+    }
+
+}
@@ -0,0 +1,93 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_STATICBATCH_H
+#define IGNIMBRITE_STATICBATCH_H
+
+#include <IRenderEngine.h>
+#include <RenderableMesh.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Static meshes merged into spatial clusters
+     *
+     * Geometry of the static objects with the same materials is transformed
+     * to world space and merged into vertex and index buffers of the clusters.
+     * Objects are split into clusters by the cells of the uniform grid, so each
+     * cluster has compact bounds and is culled as single renderable object,
+     * which is drawn with single call.
+     *
+     * Batch replaces original objects in the engine with clusters, and
+     * could restore them back (for instance, to edit the scene).
+     */
+    class StaticBatch {
+    public:
+
+        struct Cluster {
+            /** Merged geometry of the objects in world space */
+            RefCounted<Mesh> mesh;
+            /** Merged shadow geometry (the same as mesh, if objects use render mesh for shadows) */
+            RefCounted<Mesh> shadowMesh;
+            /** Indices of the merged objects in the batch */
+            std::vector<uint32> objects;
+            /** Renderable object of the cluster (created on first grouping) */
+            RefCounted<RenderableMesh> renderable;
+        };
+
+        explicit StaticBatch(RefCounted<IRenderDevice> device);
+
+        /** Set size of the grid cell, used to split objects into clusters (10 by default) */
+        void setClusterSize(float32 size);
+        /** Set max number of vertices in cluster (object with more vertices gets its own cluster) */
+        void setMaxClusterVertices(uint32 count);
+
+        /**
+         * Merge objects into clusters. Objects must be static and visible, have the same
+         * materials (or materials with equal params), vertex formats, layer and shadows casting.
+         * @note Objects are not modified, batch must not be grouped
+         */
+        void build(std::vector<RefCounted<RenderableMesh>> objects);
+
+        /** Replace batched objects in the engine with clusters (objects must be added to the engine) */
+        void group(IRenderEngine &engine);
+        /** Replace clusters in the engine with original objects */
+        void ungroup(IRenderEngine &engine);
+        /** Release clusters and objects (batch must not be grouped) */
+        void clear();
+
+        bool isGrouped() const { return mGrouped; }
+        float32 getClusterSize() const { return mClusterSize; }
+        uint32 getMaxClusterVertices() const { return mMaxClusterVertices; }
+        const std::vector<Cluster> &getClusters() const { return mClusters; }
+        const std::vector<RefCounted<RenderableMesh>> &getObjects() const { return mObjects; }
+
+    private:
+
+        void checkObjects() const;
+        void createRenderable(Cluster &cluster);
+
+        /** Merge geometry of the objects with specified indices */
+        RefCounted<Mesh> mergeMeshes(const std::vector<uint32> &indices, bool shadowMeshes) const;
+        /** Write source mesh geometry, transformed by model matrix, to destination from specified offsets (winding is kept for mirrored matrix) */
+        static void writeTransformed(const Mesh &source, const Mat4f &model, Mesh &destination,
+                                     uint32 vertexOffset, uint32 indexOffset);
+
+        bool mGrouped = false;
+        float32 mClusterSize = 10.0f;
+        uint32 mMaxClusterVertices = 65536;
+
+        std::vector<Cluster> mClusters;
+        std::vector<RefCounted<RenderableMesh>> mObjects;
+        RefCounted<IRenderDevice> mDevice;
+    };
+
+}
+
+#endif //IGNIMBRITE_STATICBATCH_H
@@ -0,0 +1,106 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <TemporalCullingCache.h>
+
+namespace ignimbrite {
+
+    const uint32 TemporalCullingCache::NOT_VISIBLE;
+
+    static std::array<glm::vec3, 8> getVertices(const Frustum &frustum) {
+        std::array<glm::vec3, 8> vertices;
+        const auto& nearVertices = frustum.getNearVertices();
+        const auto& farVertices = frustum.getFarVertices();
+
+        for (uint32 i = 0; i < 4; i++) {
+            vertices[i] = nearVertices[i];
+            vertices[i + 4] = farVertices[i];
+        }
+
+        return vertices;
+    }
+
+    bool TemporalCullingCache::canReuse(const Frustum &frustum, float32 threshold) const {
+        if (!mValid)
+            return false;
+
+        auto vertices = getVertices(frustum);
+        auto thresholdSq = threshold * threshold;
+
+        for (uint32 i = 0; i < vertices.size(); i++) {
+            auto d = vertices[i] - mReferenceVertices[i];
+            if (glm::dot(d, d) > thresholdSq)
+                return false;
+        }
+
+        return true;
+    }
+
+    void TemporalCullingCache::reset(const Frustum &frustum, const std::vector<uint32> &visible, uint32 capacity) {
+        ensureCapacity(capacity);
+
+        for (auto id: mVisible) {
+            mVisibleIndices[id] = NOT_VISIBLE;
+        }
+
+        mVisible.clear();
+        for (auto id: visible) {
+            addVisible(id);
+        }
+
+        mReferenceVertices = getVertices(frustum);
+        mValid = true;
+    }
+
+    void TemporalCullingCache::update(const Frustum &frustum, const std::vector<uint32> &changed, const RenderableRegistry &registry) {
+        ensureCapacity(registry.getCapacity());
+
+        for (auto id: changed) {
+            bool visible = registry.contains(id) && frustum.isInside(registry.getBounds(id), mPlaneHints[id]);
+            bool wasVisible = mVisibleIndices[id] != NOT_VISIBLE;
+
+            if (visible && !wasVisible)
+                addVisible(id);
+            else if (!visible && wasVisible)
+                removeVisible(id);
+        }
+    }
+
+    void TemporalCullingCache::invalidate() {
+        for (auto id: mVisible) {
+            mVisibleIndices[id] = NOT_VISIBLE;
+        }
+
+        mVisible.clear();
+        mValid = false;
+    }
+
+    void TemporalCullingCache::ensureCapacity(uint32 capacity) {
+        if (mVisibleIndices.size() < capacity) {
+            mVisibleIndices.resize(capacity, NOT_VISIBLE);
+            mPlaneHints.resize(capacity, 0);
+        }
+    }
+
+    void TemporalCullingCache::addVisible(uint32 id) {
+        mVisibleIndices[id] = (uint32) mVisible.size();
+        mVisible.push_back(id);
+    }
+
+    void TemporalCullingCache::removeVisible(uint32 id) {
+        auto index = mVisibleIndices[id];
+        auto last = mVisible.back();
+
+        mVisible[index] = last;
+        mVisibleIndices[last] = index;
+        mVisible.pop_back();
+        mVisibleIndices[id] = NOT_VISIBLE;
+    }
+
+}
@@ -0,0 +1,71 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TEMPORALCULLINGCACHE_H
+#define IGNIMBRITE_TEMPORALCULLINGCACHE_H
+
+#include <Frustum.h>
+#include <RenderableRegistry.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Frustum culling results of the previous frame for single view
+     *
+     * Keeps ids of objects inside the view frustum and for each object the
+     * index of the frustum plane, which rejected it last time. While the view
+     * frustum stays close to the frustum of the last full test, the results are
+     * reused and only changed objects are tested (starting from the
+     * rejecting plane, since it most likely rejects the object again).
+     */
+    class TemporalCullingCache {
+    public:
+
+        /**
+         * @return True if cached results can be reused for the frustum: the cache is valid
+         *         and frustum vertices moved not further than threshold since the last full test
+         */
+        bool canReuse(const Frustum &frustum, float32 threshold) const;
+
+        /** Replace cached results with results of the full test against the frustum */
+        void reset(const Frustum &frustum, const std::vector<uint32> &visible, uint32 capacity);
+
+        /**
+         * Test changed objects against the frustum and update cached results.
+         * Objects, removed from the registry, are removed from the results.
+         */
+        void update(const Frustum &frustum, const std::vector<uint32> &changed, const RenderableRegistry &registry);
+
+        /** Drop cached results, so the next frame performs full test */
+        void invalidate();
+
+        bool isValid() const { return mValid; }
+        /** @return Ids of objects, inside the frustum (in no particular order) */
+        const std::vector<uint32> &getVisible() const { return mVisible; }
+
+    private:
+        static const uint32 NOT_VISIBLE = 0xffffffff;
+
+        void ensureCapacity(uint32 capacity);
+        void addVisible(uint32 id);
+        void removeVisible(uint32 id);
+
+        bool mValid = false;
+        /** Frustum of the last full test */
+        std::array<glm::vec3, 8> mReferenceVertices = {};
+        std::vector<uint32> mVisible;
+        /** Index in the visible list per object id (NOT_VISIBLE for rejected objects) */
+        std::vector<uint32> mVisibleIndices;
+        /** Last rejecting plane per object id */
+        std::vector<uint32> mPlaneHints;
+    };
+
+}
+
+#endif //IGNIMBRITE_TEMPORALCULLINGCACHE_H
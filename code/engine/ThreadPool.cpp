@@ -0,0 +1,128 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <ThreadPool.h>
+
+namespace ignimbrite {
+
+    ThreadPool::ThreadPool(uint32 threadsCount) : mNextTask(0) {
+        setThreadsCount(threadsCount);
+    }
+
+    ThreadPool::~ThreadPool() {
+        stopWorkers();
+    }
+
+    void ThreadPool::setThreadsCount(uint32 threadsCount) {
+        if (threadsCount == 0)
+            throw std::runtime_error("Thread pool must have at least one thread");
+
+        if (threadsCount == getThreadsCount())
+            return;
+
+        stopWorkers();
+        startWorkers(threadsCount - 1);
+    }
+
+    void ThreadPool::parallelFor(uint32 tasksCount, const Task &task) {
+        if (tasksCount == 0)
+            return;
+
+        // Nothing to distribute, run in place
+        if (mWorkers.empty() || tasksCount == 1) {
+            for (uint32 i = 0; i < tasksCount; i++) {
+                task(i, 0);
+            }
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTask = &task;
+            mTasksCount = tasksCount;
+            mNextTask.store(0);
+            mActiveWorkers = (uint32) mWorkers.size();
+            mJobGeneration += 1;
+        }
+
+        mJobStarted.notify_all();
+
+        // Calling thread has index 0
+        executeTasks(0);
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJobFinished.wait(lock, [this](){ return mActiveWorkers == 0; });
+        mTask = nullptr;
+        mTasksCount = 0;
+    }
+
+    uint32 ThreadPool::getHardwareThreadsCount() {
+        uint32 count = std::thread::hardware_concurrency();
+        return count > 0 ? count : 1;
+    }
+
+    void ThreadPool::startWorkers(uint32 workersCount) {
+        mShutdown = false;
+        mWorkers.reserve(workersCount);
+
+        for (uint32 i = 0; i < workersCount; i++) {
+            mWorkers.emplace_back(&ThreadPool::workerMain, this, i + 1, mJobGeneration);
+        }
+    }
+
+    void ThreadPool::stopWorkers() {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mShutdown = true;
+        }
+
+        mJobStarted.notify_all();
+
+        for (auto& worker: mWorkers) {
+            worker.join();
+        }
+
+        mWorkers.clear();
+    }
+
+    void ThreadPool::workerMain(uint32 threadIndex, uint64 lastGeneration) {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mJobStarted.wait(lock, [&](){ return mShutdown || mJobGeneration != lastGeneration; });
+
+                if (mShutdown)
+                    return;
+
+                lastGeneration = mJobGeneration;
+            }
+
+            executeTasks(threadIndex);
+
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mActiveWorkers -= 1;
+            }
+
+            mJobFinished.notify_one();
+        }
+    }
+
+    void ThreadPool::executeTasks(uint32 threadIndex) {
+        const Task& task = *mTask;
+        uint32 tasksCount = mTasksCount;
+        uint32 taskIndex = mNextTask.fetch_add(1);
+
+        while (taskIndex < tasksCount) {
+            task(taskIndex, threadIndex);
+            taskIndex = mNextTask.fetch_add(1);
+        }
+    }
+
+}
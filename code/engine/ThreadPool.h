@@ -0,0 +1,80 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_THREADPOOL_H
+#define IGNIMBRITE_THREADPOOL_H
+
+#include <Types.h>
+#include <IncludeStd.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Fixed size pool of worker threads
+     *
+     * Executes data parallel jobs: the job is split into a number of
+     * tasks, which are distributed among workers and the calling thread.
+     * Only one job at a time is executed, the caller is blocked until
+     * all the tasks of the job are finished.
+     */
+    class ThreadPool {
+    public:
+        using Task = std::function<void(uint32 taskIndex, uint32 threadIndex)>;
+
+        /** @param threadsCount Total number of threads (including calling thread) */
+        explicit ThreadPool(uint32 threadsCount = 1);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+
+        /** Recreate workers, so total number of threads is threadsCount (must be at least 1) */
+        void setThreadsCount(uint32 threadsCount);
+
+        /**
+         * Executes task for each index in [0, tasksCount) and waits for completion.
+         * Tasks are called with index of the thread in [0, getThreadsCount()),
+         * which could be used to access per-thread data without synchronization.
+         */
+        void parallelFor(uint32 tasksCount, const Task& task);
+
+        /** @return Total number of threads, which executes tasks (including calling thread) */
+        uint32 getThreadsCount() const { return (uint32) mWorkers.size() + 1; }
+
+        /** @return Number of hardware threads (at least 1) */
+        static uint32 getHardwareThreadsCount();
+
+    private:
+        void startWorkers(uint32 workersCount);
+        void stopWorkers();
+        void workerMain(uint32 threadIndex, uint64 lastGeneration);
+        void executeTasks(uint32 threadIndex);
+
+        std::vector<std::thread> mWorkers;
+        std::mutex mMutex;
+        std::condition_variable mJobStarted;
+        std::condition_variable mJobFinished;
+
+        /** Current job info (valid while job is in progress) */
+        const Task* mTask = nullptr;
+        uint32 mTasksCount = 0;
+        uint64 mJobGeneration = 0;
+        uint32 mActiveWorkers = 0;
+        bool mShutdown = false;
+        std::atomic<uint32> mNextTask;
+    };
+
+}
+
+#endif //IGNIMBRITE_THREADPOOL_H
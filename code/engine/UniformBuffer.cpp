@@ -31,6 +31,10 @@ namespace ignimbrite {
         }
     }
 
+    void UniformBuffer::createBufferOnCPU(uint32 size) {
+        mBuffer.resize(size);
+    }
+
     void UniformBuffer::updateData(ignimbrite::uint32 size, ignimbrite::uint32 offset, const ignimbrite::uint8 *data) {
         updateDataOnCPU(size, offset, data);
         updateDataOnGPU();
@@ -23,6 +23,8 @@ namespace ignimbrite {
         ~UniformBuffer() override;
 
         void createBuffer(uint32 size);
+        /** Create only CPU data storage (data is uploaded by the owner) */
+        void createBufferOnCPU(uint32 size);
         void updateData(uint32 size, uint32 offset, const uint8* data);
         void updateDataOnCPU(uint32 size, uint32 offset, const uint8* data);
         void updateDataOnGPU();
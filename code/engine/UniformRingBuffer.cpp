@@ -0,0 +1,167 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#include <UniformRingBuffer.h>
+
+namespace ignimbrite {
+
+    UniformRingBuffer::UniformRingBuffer(RefCounted<IRenderDevice> device, uint32 frameSize, uint32 framesCount)
+        : mFramesCount(framesCount), mDevice(std::move(device)) {
+
+        if (mDevice == nullptr)
+            throw std::runtime_error("An attempt to create ring buffer with null device");
+
+        if (frameSize == 0 || framesCount == 0)
+            throw std::runtime_error("Ring buffer frame size and frames count must be positive");
+
+        mAlignment = std::max(mDevice->getUniformBufferOffsetAlignment(), 1u);
+        createBuffer(frameSize, frameSize);
+    }
+
+    UniformRingBuffer::~UniformRingBuffer() {
+        for (auto& retired: mRetiredSets) {
+            mDevice->destroyUniformSet(retired.handle);
+        }
+
+        for (auto& retired: mRetiredBuffers) {
+            mDevice->destroyUniformBuffer(retired.handle);
+        }
+
+        mDevice->destroyUniformBuffer(mHandle);
+    }
+
+    void UniformRingBuffer::beginFrame() {
+        // Draw lists are cached per device frame slot, therefore offsets must be the same in the same slot
+        auto frameIndex = mDevice->getFrameIndex();
+
+        if (frameIndex >= mFramesCount)
+            throw std::runtime_error("Ring buffer frames count is less than device frames in flight count");
+
+        mPartIndex = frameIndex;
+        mFrameNumber += 1;
+        mUsedSize = 0;
+
+        // Sets and buffers, replaced at least framesCount frames ago, are not used by GPU
+        uint32 i = 0;
+        while (i < mRetiredSets.size()) {
+            if (mRetiredSets[i].frameNumber + mFramesCount <= mFrameNumber) {
+                mDevice->destroyUniformSet(mRetiredSets[i].handle);
+                mRetiredSets[i] = mRetiredSets.back();
+                mRetiredSets.pop_back();
+            } else {
+                i += 1;
+            }
+        }
+
+        i = 0;
+        while (i < mRetiredStatic.size()) {
+            if (mRetiredStatic[i].frameNumber + mFramesCount <= mFrameNumber) {
+                mFreeStatic.push_back(mRetiredStatic[i]);
+                mRetiredStatic[i] = mRetiredStatic.back();
+                mRetiredStatic.pop_back();
+            } else {
+                i += 1;
+            }
+        }
+
+        i = 0;
+        while (i < mRetiredBuffers.size()) {
+            if (mRetiredBuffers[i].frameNumber + mFramesCount <= mFrameNumber) {
+                mDevice->destroyUniformBuffer(mRetiredBuffers[i].handle);
+                mRetiredBuffers[i] = mRetiredBuffers.back();
+                mRetiredBuffers.pop_back();
+            } else {
+                i += 1;
+            }
+        }
+    }
+
+    uint8 *UniformRingBuffer::allocate(uint32 size, uint32 &offset) {
+        // Alignment is a power of 2
+        auto alignedSize = (size + mAlignment - 1) & ~(mAlignment - 1);
+
+        if (mUsedSize + alignedSize > mFrameSize) {
+            auto frameSize = mFrameSize * 2;
+            while (frameSize < alignedSize) frameSize *= 2;
+
+            mRetiredBuffers.push_back({mHandle, mFrameNumber});
+            createBuffer(frameSize, mStaticSize);
+        }
+
+        offset = getPartOffset() + mUsedSize;
+        mUsedSize += alignedSize;
+
+        return mMapped + offset;
+    }
+
+    uint32 UniformRingBuffer::allocateStatic(uint32 size) {
+        auto alignedSize = (size + mAlignment - 1) & ~(mAlignment - 1);
+
+        // First fit, released ranges are not merged, since the most of allocations have the same sizes
+        for (uint32 i = 0; i < mFreeStatic.size(); i++) {
+            auto& range = mFreeStatic[i];
+
+            if (range.size >= alignedSize) {
+                auto offset = range.offset;
+                range.offset += alignedSize;
+                range.size -= alignedSize;
+
+                if (range.size == 0) {
+                    range = mFreeStatic.back();
+                    mFreeStatic.pop_back();
+                }
+
+                return offset;
+            }
+        }
+
+        if (mStaticUsedSize + alignedSize > mStaticSize) {
+            auto staticSize = mStaticSize * 2;
+            while (staticSize < mStaticUsedSize + alignedSize) staticSize *= 2;
+
+            // Static offsets are preserved, data is written again after version change
+            mRetiredBuffers.push_back({mHandle, mFrameNumber});
+            createBuffer(mFrameSize, staticSize);
+        }
+
+        auto offset = mStaticUsedSize;
+        mStaticUsedSize += alignedSize;
+
+        return offset;
+    }
+
+    void UniformRingBuffer::releaseStatic(uint32 staticOffset, uint32 size) {
+        auto alignedSize = (size + mAlignment - 1) & ~(mAlignment - 1);
+        mRetiredStatic.push_back({staticOffset, alignedSize, mFrameNumber});
+    }
+
+    uint8 *UniformRingBuffer::getStaticData(uint32 staticOffset, uint32 &offset) {
+        offset = getPartOffset() + mFrameSize + staticOffset;
+        return mMapped + offset;
+    }
+
+    void UniformRingBuffer::retireUniformSet(ID<IRenderDevice::UniformSet> uniformSet) {
+        mRetiredSets.push_back({uniformSet, mFrameNumber});
+    }
+
+    void UniformRingBuffer::createBuffer(uint32 frameSize, uint32 staticSize) {
+        mFrameSize = (frameSize + mAlignment - 1) & ~(mAlignment - 1);
+        mStaticSize = (staticSize + mAlignment - 1) & ~(mAlignment - 1);
+        mUsedSize = 0;
+        mVersion += 1;
+
+        mHandle = mDevice->createUniformBuffer(BufferUsage::Dynamic, (mFrameSize + mStaticSize) * mFramesCount, nullptr);
+
+        if (mHandle.isNull())
+            throw std::runtime_error("Failed to create uniform ring buffer");
+
+        mMapped = mDevice->mapUniformBuffer(mHandle);
+    }
+
+}
@@ -0,0 +1,137 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_UNIFORMRINGBUFFER_H
+#define IGNIMBRITE_UNIFORMRINGBUFFER_H
+
+#include <IRenderDevice.h>
+
+namespace ignimbrite {
+
+    /**
+     * @brief Persistently mapped uniform buffer for per-draw data
+     *
+     * Buffer is split into equal parts for the frame slots of the device.
+     * Part of the frame is selected by the device frame index, therefore
+     * frame must be started on the device first. Uniform data of the frame is
+     * bump-allocated from the part of the frame and bound with dynamic
+     * offsets, so draws do not map memory or create uniform sets.
+     *
+     * If the frame part is exhausted, buffer is recreated with larger size,
+     * and version is changed (uniform sets must be recreated with new handle).
+     * Previous buffer is released, when its frames are completed.
+     *
+     * Each frame part also has static area. Static allocation has the same
+     * offset in the part every frame, therefore data, written there once per
+     * frame, is bound with the same dynamic offsets in the same device frame
+     * slot (draw lists, cached per slot, with such binds could be reused).
+     */
+    class UniformRingBuffer {
+    public:
+
+        /**
+         * @param frameSize Initial size of the single frame part in bytes
+         * @param framesCount Number of parts, must be not less than frames in flight count of the device
+         */
+        explicit UniformRingBuffer(RefCounted<IRenderDevice> device, uint32 frameSize = 64 * 1024,
+                                   uint32 framesCount = IRenderDevice::MAX_FRAMES_IN_FLIGHT);
+        ~UniformRingBuffer();
+
+        /** Start new frame (after device frame begin): part of its slot is reused for allocations */
+        void beginFrame();
+
+        /**
+         * Allocate memory for uniform data in current frame part
+         * @param size Size of the data in bytes
+         * @param[out] offset Offset of the allocation from the buffer start (used as dynamic offset)
+         * @return Pointer to the mapped memory for data write
+         */
+        uint8* allocate(uint32 size, uint32 &offset);
+
+        /**
+         * Allocate memory in static area of the all frame parts
+         * @param size Size of the data in bytes
+         * @return Offset of the allocation in static area
+         */
+        uint32 allocateStatic(uint32 size);
+
+        /** Release static allocation, when frames of its usage are completed */
+        void releaseStatic(uint32 staticOffset, uint32 size);
+
+        /**
+         * @param staticOffset Offset of the allocation in static area
+         * @param[out] offset Offset of the allocation in current frame part from the buffer start (used as dynamic offset)
+         * @return Pointer to the mapped memory of the static allocation in current frame part
+         */
+        uint8* getStaticData(uint32 staticOffset, uint32 &offset);
+
+        /**
+         * Release uniform set, which references ring buffer, when frames of its usage are completed.
+         * Allows to replace sets of the materials after buffer recreation in the middle of the frame.
+         */
+        void retireUniformSet(ID<IRenderDevice::UniformSet> uniformSet);
+
+        const ID<IRenderDevice::UniformBuffer> &getHandle() const { return mHandle; }
+        /** @return Version of the buffer handle (changed, when buffer is recreated) */
+        uint32 getVersion() const { return mVersion; }
+        /** @return Number of the current frame (allocations of previous frames are not valid) */
+        uint64 getFrameNumber() const { return mFrameNumber; }
+        uint32 getFrameSize() const { return mFrameSize; }
+        uint32 getFramesCount() const { return mFramesCount; }
+        uint32 getStaticSize() const { return mStaticSize; }
+        /** @return Alignment of the allocations (power of 2) */
+        uint32 getAlignment() const { return mAlignment; }
+        /** @return Bytes allocated in current frame */
+        uint32 getUsedSize() const { return mUsedSize; }
+
+    private:
+
+        void createBuffer(uint32 frameSize, uint32 staticSize);
+        uint32 getPartOffset() const { return mPartIndex * (mFrameSize + mStaticSize); }
+
+        struct RetiredBuffer {
+            ID<IRenderDevice::UniformBuffer> handle;
+            uint64 frameNumber;
+        };
+
+        struct RetiredSet {
+            ID<IRenderDevice::UniformSet> handle;
+            uint64 frameNumber;
+        };
+
+        struct StaticRange {
+            uint32 offset;
+            uint32 size;
+            uint64 frameNumber;
+        };
+
+        uint32 mFrameSize = 0;
+        uint32 mFramesCount = 0;
+        uint32 mAlignment = 1;
+        uint32 mUsedSize = 0;
+        uint32 mStaticSize = 0;
+        uint32 mStaticUsedSize = 0;
+        uint32 mVersion = 0;
+        /** Part of the current frame (device frame index) */
+        uint32 mPartIndex = 0;
+        uint64 mFrameNumber = 0;
+
+        uint8* mMapped = nullptr;
+        ID<IRenderDevice::UniformBuffer> mHandle;
+        std::vector<RetiredBuffer> mRetiredBuffers;
+        std::vector<RetiredSet> mRetiredSets;
+        /** Free ranges of static area and released ranges, which could be used by GPU */
+        std::vector<StaticRange> mFreeStatic;
+        std::vector<StaticRange> mRetiredStatic;
+        RefCounted<IRenderDevice> mDevice;
+    };
+
+}
+
+#endif //IGNIMBRITE_UNIFORMRINGBUFFER_H
@@ -12,6 +12,7 @@
 
 #include <IPostEffect.h>
 #include <Material.h>
+#include <CachedDrawList.h>
 
 
 namespace ignimbrite {
@@ -37,6 +38,8 @@ namespace ignimbrite {
         RefCounted<Material> mMaterial;
         RefCounted<IRenderDevice> mDevice;
         ID<IRenderDevice::VertexBuffer> mScreenQuad;
+        /** Pass is recorded once and re-recorded only on target or material change */
+        RefCounted<CachedDrawList> mDrawList;
 
     };
 
@@ -10,7 +10,6 @@
 #include <NoirFilter.h>
 #include <MaterialFullscreen.h>
 #include <Geometry.h>
-#include <PipelineContext.h>
 
 namespace ignimbrite {
 
@@ -33,6 +32,7 @@ namespace ignimbrite {
     void NoirFilter::onAddedToPipeline(const RefCounted<ignimbrite::RenderTarget::Format> &targetFormat) {
         mMaterial = MaterialFullscreen::noirFilter(mPrefixPath, targetFormat, mDevice);
         Geometry::createFullscreenQuad(mScreenQuad, mDevice);
+        mDrawList = std::make_shared<CachedDrawList>(mDevice);
     }
 
     void NoirFilter::execute(RefCounted<RenderTarget> &input, RefCounted<RenderTarget> &output) {
@@ -48,11 +48,22 @@ namespace ignimbrite {
         }
 
         mDevice->drawListBindFramebuffer(output->getHandle(), color, region);
-        PipelineContext::cacheFramebufferBinding(output->getHandle());
-        mMaterial->bindGraphicsPipeline();
-        mMaterial->bindUniformData();
-        mDevice->drawListBindVertexBuffer(mScreenQuad, 0, 0);
-        mDevice->drawListDraw(6, 1);
+
+        mDrawList->beginKey();
+        mDrawList->addKey(output->getHandle());
+        mDrawList->addKey((uint64) mMaterial->getBindingVersion());
+        mDrawList->addKey(mMaterial->getGraphicsPipeline()->getHandle());
+
+        if (!mDrawList->isValid()) {
+            mDrawList->beginRecording();
+            mMaterial->bindGraphicsPipeline();
+            mMaterial->bindUniformData();
+            mDevice->drawListBindVertexBuffer(mScreenQuad, 0, 0);
+            mDevice->drawListDraw(6, 1);
+            mDrawList->endRecording();
+        }
+
+        mDrawList->execute();
     }
 
 }
\ No newline at end of file
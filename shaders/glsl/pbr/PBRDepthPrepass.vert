@@ -0,0 +1,19 @@
+#version 450
+
+layout (location = 0) in vec3 inPos;
+
+// Depth must be equal to the main pass one (depth test EQUAL), therefore position is invariant
+// and transformed in the same order as in PBRShadowed.vert and MeshShadowedInstanced.vert
+invariant gl_Position;
+
+layout (binding = 0) uniform DepthParams
+{
+    mat4 viewProj;
+    mat4 model;
+} depthParams;
+
+void main()
+{
+    vec4 pos    = depthParams.model * vec4(inPos, 1.0);
+    gl_Position = depthParams.viewProj * pos;
+}
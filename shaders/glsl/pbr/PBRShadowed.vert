@@ -6,6 +6,9 @@ layout (location = 2) in vec2 inTexCoord;
 layout (location = 3) in vec3 inTangent;
 layout (location = 4) in vec3 inBitangent;
 
+// Depth must be equal to PBRDepthPrepass.vert one
+invariant gl_Position;
+
 layout (binding = 0) uniform CommonParams
 {
     mat4 viewProj;
@@ -0,0 +1,49 @@
+#version 450
+
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inTexCoord;
+layout (location = 3) in vec3 inTangent;
+layout (location = 4) in vec3 inBitangent;
+
+// Per-instance model matrix (vertex buffer with binding 1)
+layout (location = 5) in mat4 inModel;
+
+// Depth must be equal to PBRDepthPrepass.vert one
+invariant gl_Position;
+
+layout (binding = 0) uniform CommonParams 
+{
+	mat4 viewProj;
+	mat4 lightSpace;
+	vec3 lightDir;
+	vec3 cameraPos;
+} commonParams;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outCameraPos;
+layout (location = 2) out vec3 outLightVec;
+layout (location = 3) out vec4 outShadowCoord;
+layout (location = 4) out vec2 outTexCoord;
+layout (location = 5) out vec4 outPosition;
+
+const mat4 biasMat = mat4(
+	0.5, 0.0, 0.0, 0.0,
+	0.0, 0.5, 0.0, 0.0,
+	0.0, 0.0, 1.0, 0.0,
+	0.5, 0.5, 0.0, 1.0 );
+
+void main()
+{
+	vec4 pos = inModel * vec4(inPos, 1.0);
+
+	gl_Position = commonParams.viewProj * pos;
+
+	outNormal = mat3(inModel) * inNormal;
+	outLightVec = -normalize(commonParams.lightDir);
+	outCameraPos = commonParams.cameraPos;
+	outTexCoord = inTexCoord;
+	outPosition = pos;
+
+	outShadowCoord = (biasMat * commonParams.lightSpace) * pos;
+}
@@ -0,0 +1,16 @@
+#version 450
+
+layout (location = 0) in vec3 inPosition;
+
+// Per-instance model matrix (vertex buffer with binding 1)
+layout (location = 5) in mat4 inModel;
+
+layout (binding = 0) uniform ShadowParams 
+{
+	mat4 depthVP;
+} shadowParams;
+
+void main()
+{
+	gl_Position = shadowParams.depthVP * inModel * vec4(inPosition, 1.0);
+}
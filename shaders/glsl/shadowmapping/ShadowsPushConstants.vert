@@ -0,0 +1,14 @@
+#version 450
+
+layout (location = 0) in vec3 inPosition;
+
+// Per-draw matrix is pushed with draw call, no uniform buffers are updated
+layout (push_constant) uniform ShadowParams 
+{
+	mat4 depthMVP;
+} shadowParams;
+
+void main()
+{
+	gl_Position = shadowParams.depthMVP * vec4(inPosition, 1.0);
+}
@@ -0,0 +1,137 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTFRUSTUMBATCH_CPP
+#define IGNIMBRITE_TESTFRUSTUMBATCH_CPP
+
+#include <Frustum.h>
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace ignimbrite;
+
+struct TestFrustumBatch {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    struct Boxes {
+        std::vector<AABB> boxes;
+        std::vector<float32> packed;
+        Frustum::PackedBoxes view;
+    };
+
+    static Frustum createFrustum() {
+        Frustum frustum;
+        frustum.setViewProperties(glm::vec3(0.3f, -0.1f, -1.0f), glm::vec3(0, 1, 0));
+        frustum.setPosition(glm::vec3(1.0f, 2.0f, 3.0f));
+        frustum.createPerspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        return frustum;
+    }
+
+    static void createBoxes(uint32 count, Boxes &b) {
+        std::mt19937 engine(count);
+        std::uniform_real_distribution<float32> position(-120.0f, 120.0f);
+        std::uniform_real_distribution<float32> size(0.1f, 4.0f);
+
+        b.boxes.clear();
+        for (uint32 i = 0; i < count; i++) {
+            glm::vec3 p(position(engine), position(engine), position(engine));
+            glm::vec3 e(size(engine), size(engine), size(engine));
+            b.boxes.emplace_back(p - e, p + e);
+        }
+
+        b.packed.resize(count * 6);
+        for (uint32 i = 0; i < count; i++) {
+            auto c = b.boxes[i].getCenter();
+            auto e = b.boxes[i].getExtent();
+
+            for (uint32 k = 0; k < 3; k++) {
+                b.packed[(0 + k) * count + i] = c[k];
+                b.packed[(3 + k) * count + i] = e[k];
+            }
+        }
+
+        b.view.centerX = b.packed.data() + 0 * count;
+        b.view.centerY = b.packed.data() + 1 * count;
+        b.view.centerZ = b.packed.data() + 2 * count;
+        b.view.extentX = b.packed.data() + 3 * count;
+        b.view.extentY = b.packed.data() + 4 * count;
+        b.view.extentZ = b.packed.data() + 5 * count;
+        b.view.count = count;
+    }
+
+    static void test1() {
+        // Batched results must be exactly the same as per-object ones (including not aligned tail)
+        Frustum frustum = createFrustum();
+        uint32 counts[] = { 0, 1, 3, 4, 7, 8, 9, 1001 };
+
+        for (auto count: counts) {
+            Boxes b;
+            createBoxes(count, b);
+
+            std::vector<uint8> mask(count);
+            std::vector<Frustum::Visibility> visibility(count);
+            frustum.isInside(b.view, mask.data());
+            frustum.classify(b.view, visibility.data());
+
+            uint32 errors = 0;
+            for (uint32 i = 0; i < count; i++) {
+                bool expected = frustum.isInside(b.boxes[i]);
+                errors += (expected != (mask[i] != 0));
+                errors += (frustum.classify(b.boxes[i]) != visibility[i]);
+                errors += (expected != (visibility[i] != Frustum::Visibility::Outside));
+            }
+
+            printf("Boxes: %u errors: %u\n", count, errors);
+        }
+    }
+
+    static void test2() {
+        // Benchmark batched test against per-object path
+        const uint32 count = 100000;
+        const uint32 iterations = 100;
+
+        Frustum frustum = createFrustum();
+        Boxes b;
+        createBoxes(count, b);
+
+        std::vector<uint8> mask(count);
+        uint64 visibleSingle = 0;
+        uint64 visibleBatch = 0;
+
+        auto start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            for (uint32 i = 0; i < count; i++) {
+                mask[i] = frustum.isInside(b.boxes[i]) ? 1 : 0;
+            }
+            for (auto m: mask) visibleSingle += m;
+        }
+        auto single = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            frustum.isInside(b.view, mask.data());
+            for (auto m: mask) visibleBatch += m;
+        }
+        auto batch = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        printf("Per-object: %.3f ms per %u boxes (visible %llu)\n", single / iterations, count, (unsigned long long) visibleSingle / iterations);
+        printf("Batched:    %.3f ms per %u boxes (visible %llu)\n", batch / iterations, count, (unsigned long long) visibleBatch / iterations);
+        printf("Speedup:    %.2fx\n", single / batch);
+    }
+
+};
+
+int32 main() {
+    TestFrustumBatch::test1();
+    TestFrustumBatch::test2();
+}
+
+#endif //IGNIMBRITE_TESTFRUSTUMBATCH_CPP
@@ -0,0 +1,245 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTMATERIALPARAMS_CPP
+#define IGNIMBRITE_TESTMATERIALPARAMS_CPP
+
+#include <Material.h>
+#include <MaterialInstance.h>
+#include <VulkanRenderDevice.h>
+#include <chrono>
+#include <fstream>
+
+using namespace ignimbrite;
+
+struct TestMaterialParams {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    static const uint32 OBJECTS_COUNT = 10000;
+    static const uint32 FRAMES_COUNT = 20;
+
+    static RefCounted<Material> createMaterial(const RefCounted<IRenderDevice> &device,
+                                               const RefCounted<UniformRingBuffer> &ring = nullptr) {
+        std::ifstream vertFile("shaders/spirv/shadowmapping/MeshShadowed.vert.spv", std::ios::binary);
+        std::ifstream fragFile("shaders/spirv/shadowmapping/MeshShadowed.frag.spv", std::ios::binary);
+
+        std::vector<uint8> vertSpv(std::istreambuf_iterator<char>(vertFile), {});
+        std::vector<uint8> fragSpv(std::istreambuf_iterator<char>(fragFile), {});
+
+        auto shader = std::make_shared<Shader>(device);
+        shader->fromSources(ShaderLanguage::SPIRV, vertSpv, fragSpv);
+        shader->reflectData();
+        shader->generateUniformLayout(ring != nullptr);
+
+        // Pipeline itself is not created, only shader is required for params
+        auto pipeline = std::make_shared<GraphicsPipeline>(device);
+        pipeline->setShader(shader);
+
+        auto material = std::make_shared<Material>(device);
+        material->setGraphicsPipeline(pipeline);
+        material->setUniformRing(ring);
+        material->createMaterial();
+
+        return material;
+    }
+
+    static Mat4f getModel(uint32 i) {
+        return glm::translate(Vec3f((float32) i, 0.0f, -(float32) i));
+    }
+
+    static void test1(const RefCounted<IRenderDevice> &device) {
+        // Handles must write the same data as string setters (also for another material with this shader)
+        auto material = createMaterial(device);
+        auto other = std::make_shared<Material>(device);
+        other->setGraphicsPipeline(material->getGraphicsPipeline());
+        other->createMaterial();
+
+        uint32 errors = 0;
+
+        auto model = other->findParam("CommonParams.model");
+        auto cameraPos = other->findParam("CommonParams.cameraPos");
+
+        errors += !model.isValid() || !cameraPos.isValid();
+        errors += other->findParam("CommonParams.unknown").isValid();
+        errors += other->findParam("texShadowMap").isValid();
+
+        for (uint32 i = 0; i < 100; i++) {
+            material->setMat4("CommonParams.model", getModel(i));
+            material->setVec3("CommonParams.cameraPos", Vec3f(i, i, i));
+
+            other->setMat4(model, getModel(i));
+            other->setVec3(cameraPos, Vec3f(i, i, i));
+
+            errors += !material->hasEqualParams(*other, "");
+        }
+
+        printf("Handles errors: %u\n", errors);
+    }
+
+    static void test2(const RefCounted<IRenderDevice> &device) {
+        // Per-draw CPU cost of params setup, as in mesh rendering
+        auto material = createMaterial(device);
+        auto viewProj = Mat4f(1.0f);
+        auto lightSpace = Mat4f(1.0f);
+        auto lightDir = Vec3f(0.0f, -1.0f, 0.0f);
+        auto cameraPos = Vec3f(1.0f, 2.0f, 3.0f);
+
+        auto start = Clock::now();
+
+        for (uint32 frame = 0; frame < FRAMES_COUNT; frame++) {
+            for (uint32 i = 0; i < OBJECTS_COUNT; i++) {
+                material->setMat4("CommonParams.lightSpace", lightSpace);
+                material->setVec3("CommonParams.lightDir", lightDir);
+                material->setMat4("CommonParams.viewProj", viewProj);
+                material->setVec3("CommonParams.cameraPos", cameraPos);
+                material->setMat4("CommonParams.model", getModel(i));
+            }
+        }
+
+        auto namesTime = std::chrono::duration<float64, std::nano>(Clock::now() - start).count();
+
+        auto lightSpaceParam = material->findParam("CommonParams.lightSpace");
+        auto lightDirParam = material->findParam("CommonParams.lightDir");
+        auto viewProjParam = material->findParam("CommonParams.viewProj");
+        auto cameraPosParam = material->findParam("CommonParams.cameraPos");
+        auto modelParam = material->findParam("CommonParams.model");
+
+        start = Clock::now();
+
+        for (uint32 frame = 0; frame < FRAMES_COUNT; frame++) {
+            for (uint32 i = 0; i < OBJECTS_COUNT; i++) {
+                material->setMat4(lightSpaceParam, lightSpace);
+                material->setVec3(lightDirParam, lightDir);
+                material->setMat4(viewProjParam, viewProj);
+                material->setVec3(cameraPosParam, cameraPos);
+                material->setMat4(modelParam, getModel(i));
+            }
+        }
+
+        auto handlesTime = std::chrono::duration<float64, std::nano>(Clock::now() - start).count();
+        auto draws = (float64) (OBJECTS_COUNT * FRAMES_COUNT);
+
+        printf("Per-draw params: names %.1f ns handles %.1f ns\n", namesTime / draws, handlesTime / draws);
+    }
+
+    static void test3(const RefCounted<IRenderDevice> &device) {
+        // Instances store only overrides and do not create GPU objects
+        auto ring = std::make_shared<UniformRingBuffer>(device);
+        auto material = createMaterial(device, ring);
+        auto texture = std::make_shared<Texture>(device);
+        uint8 white[] = { 0xff, 0xff, 0xff, 0xff };
+        texture->setDataAsRGBA8(1, 1, white, false);
+        texture->setSampler(std::make_shared<Sampler>(device));
+        material->setTexture("texShadowMap", texture);
+
+        auto model = material->findParam("CommonParams.model");
+        uint32 errors = 0;
+
+        std::vector<RefCounted<Material>> objects(OBJECTS_COUNT);
+
+        auto start = Clock::now();
+        for (auto& object: objects) {
+            object = std::make_shared<MaterialInstance>(material);
+        }
+        auto instancesTime = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        ring->beginFrame();
+
+        for (uint32 i = 0; i < OBJECTS_COUNT; i++) {
+            objects[i]->setMat4(model, getModel(i % 2));
+            objects[i]->updateUniformData();
+
+            errors += ((MaterialInstance&) *objects[i]).getOverridesCount() != 1;
+            errors += objects[i]->getUniformSet() != material->getUniformSet();
+        }
+
+        errors += !objects[0]->hasEqualParams(*objects[2], "");
+        errors += objects[0]->hasEqualParams(*objects[1], "");
+        errors += !objects[0]->hasEqualParams(*objects[1], "CommonParams");
+        errors += objects[0]->hasEqualParams(*material, "");
+
+        start = Clock::now();
+        for (uint32 i = 0; i < OBJECTS_COUNT / 10; i++) {
+            objects[i] = material->clone();
+        }
+        auto clonesTime = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        printf("Instances errors: %u\n", errors);
+        printf("Create: %u instances %.3f ms %u clones %.3f ms\n", OBJECTS_COUNT, instancesTime, OBJECTS_COUNT / 10, clonesTime);
+    }
+
+    static void test4(const RefCounted<IRenderDevice> &device) {
+        // First write in the frame keeps the same offsets in the same device frame slot (binds of cached lists stay valid)
+        auto ring = std::make_shared<UniformRingBuffer>(device);
+        auto material = createMaterial(device, ring);
+        auto texture = std::make_shared<Texture>(device);
+        uint8 white[] = { 0xff, 0xff, 0xff, 0xff };
+        texture->setDataAsRGBA8(1, 1, white, false);
+        texture->setSampler(std::make_shared<Sampler>(device));
+        material->setTexture("texShadowMap", texture);
+
+        auto instance = std::make_shared<MaterialInstance>(material);
+        auto model = material->findParam("CommonParams.model");
+        auto framesCount = device->getFramesInFlight();
+        uint32 errors = 0;
+        uint32 version = 0;
+
+        // Frames in flight count of the device by default is less than ring frames count
+        std::vector<std::vector<uint32>> offsets(framesCount);
+
+        for (uint32 frame = 0; frame < FRAMES_COUNT; frame++) {
+            device->beginFrame();
+            ring->beginFrame();
+
+            instance->setMat4(model, getModel(frame));
+            instance->updateUniformData();
+
+            auto slot = device->getFrameIndex();
+
+            if (frame < framesCount)
+                offsets[slot] = instance->getDynamicOffsets();
+            else
+                errors += offsets[slot] != instance->getDynamicOffsets();
+
+            // Data writes do not change bound set and push constants
+            if (frame == 0)
+                version = instance->getBindingVersion();
+            else
+                errors += version != instance->getBindingVersion();
+
+            // Draws of this frame reference data of the first write, therefore it is not overwritten
+            auto first = instance->getDynamicOffsets();
+            instance->setMat4(model, getModel(frame + 1));
+            instance->updateUniformData();
+            errors += first == instance->getDynamicOffsets();
+
+            device->endFrame();
+        }
+
+        device->synchronize();
+
+        errors += offsets[0] == offsets[1];
+
+        printf("Static ring data errors: %u\n", errors);
+    }
+
+};
+
+int32 main() {
+    // Params setup does not require presentation, therefore device is created without surface extensions
+    RefCounted<IRenderDevice> device = std::make_shared<VulkanRenderDevice>(0, nullptr);
+
+    TestMaterialParams::test1(device);
+    TestMaterialParams::test2(device);
+    TestMaterialParams::test3(device);
+    TestMaterialParams::test4(device);
+}
+
+#endif //IGNIMBRITE_TESTMATERIALPARAMS_CPP
@@ -0,0 +1,240 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTOCCLUSIONBUFFER_CPP
+#define IGNIMBRITE_TESTOCCLUSIONBUFFER_CPP
+
+#include <OcclusionBuffer.h>
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace ignimbrite;
+
+struct TestOcclusionBuffer {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    /** Unit cube [-1,1]^3 with 12 triangles */
+    static Mesh createCube() {
+        Vec3f vertices[8];
+        for (uint32 i = 0; i < 8; i++) {
+            vertices[i] = Vec3f((i & 1u) ? 1.0f : -1.0f, (i & 2u) ? 1.0f : -1.0f, (i & 4u) ? 1.0f : -1.0f);
+        }
+
+        uint32 indices[36] = {
+            0, 1, 3, 0, 3, 2,
+            4, 6, 7, 4, 7, 5,
+            0, 4, 5, 0, 5, 1,
+            2, 3, 7, 2, 7, 6,
+            0, 2, 6, 0, 6, 4,
+            1, 5, 7, 1, 7, 3
+        };
+
+        Mesh mesh(Mesh::VertexFormat::P, 8, 36);
+        mesh.updateVertexData(0, 8, (const uint8*) vertices);
+        mesh.updateIndexData(0, 36, indices);
+        return mesh;
+    }
+
+    static Mat4f createViewProj() {
+        auto proj = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 500.0f);
+        auto view = glm::lookAt(Vec3f(0, 0, 0), Vec3f(0, 0, -1), Vec3f(0, 1, 0));
+        return proj * view;
+    }
+
+    static AABB box(const Vec3f &center, const Vec3f &extent) {
+        return AABB(center - extent, center + extent);
+    }
+
+    static void test1() {
+        // Wall in front of the camera hides boxes behind it
+        ThreadPool threads(4);
+        OcclusionBuffer buffer(256, 128);
+        Mesh cube = createCube();
+
+        buffer.begin(createViewProj());
+        buffer.addOccluder(cube, glm::translate(Vec3f(0, 0, -20)) * glm::scale(Vec3f(10, 10, 1)));
+        buffer.rasterize(threads);
+
+        struct Case { AABB bounds; bool visible; };
+        Case cases[] = {
+            { box(Vec3f(0, 0, -40), Vec3f(2, 2, 2)), false },    // Behind the wall
+            { box(Vec3f(5, 5, -60), Vec3f(3, 3, 3)), false },    // Behind the wall, far
+            { box(Vec3f(0, 0, -10), Vec3f(2, 2, 2)), true },     // In front of the wall
+            { box(Vec3f(30, 0, -40), Vec3f(2, 2, 2)), true },    // Beside the wall
+            { box(Vec3f(20, 0, -40), Vec3f(3, 3, 3)), true },    // Partially behind the wall
+            { box(Vec3f(0, 0, -20), Vec3f(2, 2, 4)), true },     // Intersects the wall
+            { box(Vec3f(0, 0, 0), Vec3f(1, 1, 1)), true },       // Crosses near plane
+        };
+
+        uint32 errors = 0;
+        for (const auto& c: cases) {
+            errors += buffer.isVisible(c.bounds) != c.visible;
+        }
+
+        // Depth of the wall center must be written
+        errors += buffer.getDepth(128, 64) >= 1.0f;
+        errors += buffer.getDepth(0, 0) < 1.0f;
+
+        printf("Polygons: %u errors: %u\n", buffer.getPolygonsCount(), errors);
+    }
+
+    static void test2() {
+        // Multi-threaded rasterization gives the same depth as single-threaded
+        std::mt19937 engine(1);
+        std::uniform_real_distribution<float32> position(-50.0f, 50.0f);
+        std::uniform_real_distribution<float32> depth(-200.0f, -10.0f);
+        std::uniform_real_distribution<float32> size(1.0f, 8.0f);
+
+        Mesh cube = createCube();
+        ThreadPool single(1);
+        ThreadPool multiple(4);
+        OcclusionBuffer a(320, 160), b(320, 160);
+
+        a.begin(createViewProj());
+        b.begin(createViewProj());
+
+        for (uint32 i = 0; i < 200; i++) {
+            auto transform = glm::translate(Vec3f(position(engine), position(engine) * 0.5f, depth(engine))) *
+                             glm::scale(Vec3f(size(engine), size(engine), size(engine)));
+            a.addOccluder(cube, transform);
+            b.addOccluder(cube, transform);
+        }
+
+        a.rasterize(single);
+        b.rasterize(multiple);
+
+        uint32 errors = 0;
+        for (uint32 y = 0; y < a.getHeight(); y++) {
+            for (uint32 x = 0; x < a.getWidth(); x++) {
+                errors += a.getDepth(x, y) != b.getDepth(x, y);
+            }
+        }
+
+        printf("Threads: %u depth errors: %u\n", multiple.getThreadsCount(), errors);
+    }
+
+    static void test4() {
+        // Only completely covered pixels are written, pixel keeps the farthest depth of the occluder over it
+        ThreadPool threads(1);
+        OcclusionBuffer buffer(256, 128);
+        Mesh cube = createCube();
+        auto viewProj = createViewProj();
+        auto width = (float32) buffer.getWidth();
+
+        // Front face of the wall is at z = -19, its right edge covers 3/4 of the edge pixel
+        auto edge = viewProj * Vec4f(1.0f, 0.0f, -19.0f, 1.0f);
+        auto pixelsPerUnit = edge.x / edge.w * 0.5f * width;
+        auto edgePixels = glm::floor(3.0f * pixelsPerUnit);
+        auto halfWidth = (edgePixels + 0.75f) / pixelsPerUnit;
+        auto edgeX = buffer.getWidth() / 2 + (uint32) edgePixels;
+
+        buffer.begin(viewProj);
+        buffer.addOccluder(cube, glm::translate(Vec3f(0, 0, -20)) * glm::scale(Vec3f(halfWidth, 3, 1)));
+        buffer.rasterize(threads);
+
+        uint32 errors = 0;
+        errors += buffer.getDepth(edgeX, 64) < 1.0f;
+        errors += buffer.getDepth(edgeX - 1, 64) >= 1.0f;
+
+        // Box behind the wall, which is seen in the uncovered part of the edge pixel
+        auto x0 = (edgePixels + 0.8f) / pixelsPerUnit * 21.2f / 19.0f;
+        auto x1 = (edgePixels + 0.95f) / pixelsPerUnit * 21.1f / 19.0f;
+        errors += !buffer.isVisible(AABB(Vec3f(x0, -0.5f, -21.2f), Vec3f(x1, 0.5f, -21.1f)));
+
+        // Sloped wall: stored depth is not less than the wall depth at any point of the pixel
+        auto rotation = glm::rotate(glm::radians(70.0f), Vec3f(0, 1, 0));
+        auto normal = Vec3f(rotation * Vec4f(0, 0, 1, 0));
+        auto front = Vec3f(0, 0, -20) + normal * 0.01f;
+        auto inverse = glm::inverse(viewProj);
+
+        buffer.begin(viewProj);
+        buffer.addOccluder(cube, glm::translate(Vec3f(0, 0, -20)) * rotation * glm::scale(Vec3f(10, 10, 0.01f)));
+        buffer.rasterize(threads);
+
+        for (uint32 px = 0; px < buffer.getWidth(); px++) {
+            auto depth = buffer.getDepth(px, 64);
+
+            if (depth >= 1.0f)
+                continue;
+
+            for (uint32 k = 0; k <= 4; k++) {
+                auto ndcX = ((float32) px + (float32) k * 0.25f) / width * 2.0f - 1.0f;
+                auto ndcY = 64.5f / (float32) buffer.getHeight() * 2.0f - 1.0f;
+                auto ray = inverse * Vec4f(ndcX, ndcY, 1.0f, 1.0f);
+                auto dir = Vec3f(ray) / ray.w;
+                auto hit = viewProj * Vec4f(dir * (glm::dot(front, normal) / glm::dot(dir, normal)), 1.0f);
+
+                errors += hit.z / hit.w > depth + 1e-5f;
+            }
+        }
+
+        printf("Conservative rasterization errors: %u\n", errors);
+    }
+
+    static void test3() {
+        // Benchmark: city-like grid of buildings, test many small objects
+        const uint32 buildings = 400;
+        const uint32 objects = 100000;
+        const uint32 iterations = 20;
+
+        std::mt19937 engine(2);
+        std::uniform_real_distribution<float32> position(-200.0f, 200.0f);
+        std::uniform_real_distribution<float32> depth(-400.0f, -5.0f);
+
+        Mesh cube = createCube();
+        ThreadPool threads(ThreadPool::getHardwareThreadsCount());
+        OcclusionBuffer buffer(256, 128);
+
+        std::vector<Mat4f> transforms;
+        for (uint32 i = 0; i < buildings; i++) {
+            transforms.push_back(glm::translate(Vec3f(position(engine), 0.0f, depth(engine))) * glm::scale(Vec3f(6.0f, 20.0f, 6.0f)));
+        }
+
+        std::vector<AABB> bounds;
+        for (uint32 i = 0; i < objects; i++) {
+            bounds.push_back(box(Vec3f(position(engine), 0.0f, depth(engine)), Vec3f(1.0f)));
+        }
+
+        uint32 visible = 0;
+
+        auto start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            buffer.begin(createViewProj());
+            for (const auto& t: transforms) {
+                buffer.addOccluder(cube, t);
+            }
+            buffer.rasterize(threads);
+        }
+        auto rasterization = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            visible = 0;
+            for (const auto& b: bounds) {
+                visible += buffer.isVisible(b) ? 1 : 0;
+            }
+        }
+        auto tests = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        printf("Rasterization: %.3f ms per %u occluders\n", rasterization / iterations, buildings);
+        printf("Tests:         %.3f ms per %u objects (%u visible)\n", tests / iterations, objects, visible);
+    }
+
+};
+
+int32 main() {
+    TestOcclusionBuffer::test1();
+    TestOcclusionBuffer::test2();
+    TestOcclusionBuffer::test3();
+    TestOcclusionBuffer::test4();
+}
+
+#endif //IGNIMBRITE_TESTOCCLUSIONBUFFER_CPP
@@ -9,6 +9,7 @@
 
 #include <Material.h>
 #include <MeshLoader.h>
+#include <MaterialInstance.h>
 #include <NoirFilter.h>
 #include <InverseFilter.h>
 #include <RenderEngine.h>
@@ -63,6 +64,8 @@ public:
 
     void initDevice() {
         device = std::make_shared<VulkanRenderDevice>(window.extensionsCount, window.extensions, true);
+        device->setPipelineCachePath("TestRenderEngine.pipelinecache");
+        device->setPipelineCompileThreadsCount(2);
         window.surface = VulkanExtensions::createSurfaceGLFW((VulkanRenderDevice&)*device, window.handle, window.w, window.h, window.name);
     }
 
@@ -119,6 +122,13 @@ public:
 
         shadowTarget->getDepthStencilAttachment()->setSampler(sampler);
         engine->setShadowTarget(light, shadowTarget);
+
+        // Meshes use own material instances, therefore could be recorded in parallel
+        engine->setParallelRecording(true);
+        engine->setDrawListCaching(true);
+
+        // Helmets have depth materials, plane is drawn only in main pass
+        engine->setDepthPrepass((uint32) IRenderable::DefaultLayers::Solid, RenderEngine::DepthPrepassMode::Enabled);
     }
 
     void initPostEffects() {
@@ -131,7 +141,7 @@ public:
 
     void initMeshMaterial() {
         // Shader
-        std::ifstream vertFile(MODEL3D_SHADER_PATH_VERT.c_str(), std::ios::binary);
+        std::ifstream vertFile(MODEL3D_PUSH_CONSTANTS_SHADER_PATH_VERT.c_str(), std::ios::binary);
         std::ifstream fragFile(MODEL3D_SHADER_PATH_FRAG.c_str(), std::ios::binary);
 
         std::vector<uint8> vertSpv(std::istreambuf_iterator<char>(vertFile), {});
@@ -140,10 +150,10 @@ public:
         RefCounted<Shader> shader = std::make_shared<Shader>(device);
         shader->fromSources(ShaderLanguage::SPIRV, vertSpv, fragSpv);
         shader->reflectData();
-        shader->generateUniformLayout();
+        shader->generateUniformLayout(true);
 
         // PBR shader
-        std::ifstream vertReflFile(MODEL3D_SHADER_PATH_VERT.c_str(), std::ios::binary);
+        std::ifstream vertReflFile(MODEL3D_INSTANCED_SHADER_PATH_VERT.c_str(), std::ios::binary);
         std::ifstream fragReflFile(MODEL3D_REFL_SHADER_PATH_FRAG.c_str(), std::ios::binary);
 
         std::vector<uint8> vertReflSpv(std::istreambuf_iterator<char>(vertReflFile), {});
@@ -152,7 +162,7 @@ public:
         RefCounted<Shader> reflShader = std::make_shared<Shader>(device);
         reflShader->fromSources(ShaderLanguage::SPIRV, vertReflSpv, fragReflSpv);
         reflShader->reflectData();
-        reflShader->generateUniformLayout();
+        reflShader->generateUniformLayout(true);
 
         // Shadow shader
         std::ifstream shVertFile(SHADOWS_SHADER_PATH_VERT.c_str(), std::ios::binary);
@@ -164,7 +174,31 @@ public:
         RefCounted<Shader> shadowShader = std::make_shared<Shader>(device);
         shadowShader->fromSources(ShaderLanguage::SPIRV, shVertSpv, shFragSpv);
         shadowShader->reflectData();
-        shadowShader->generateUniformLayout();
+        shadowShader->generateUniformLayout(true);
+
+        // Shadow shader with push constants
+        std::ifstream shPushVertFile(SHADOWS_PUSH_CONSTANTS_SHADER_PATH_VERT.c_str(), std::ios::binary);
+        std::ifstream shPushFragFile(SHADOWS_SHADER_PATH_FRAG.c_str(), std::ios::binary);
+
+        std::vector<uint8> shPushVertSpv(std::istreambuf_iterator<char>(shPushVertFile), {});
+        std::vector<uint8> shPushFragSpv(std::istreambuf_iterator<char>(shPushFragFile), {});
+
+        RefCounted<Shader> shadowPushShader = std::make_shared<Shader>(device);
+        shadowPushShader->fromSources(ShaderLanguage::SPIRV, shPushVertSpv, shPushFragSpv);
+        shadowPushShader->reflectData();
+        shadowPushShader->generateUniformLayout(true);
+
+        // Depth pre-pass shader (transforms position as instanced mesh shader)
+        std::ifstream depthVertFile(DEPTH_PREPASS_SHADER_PATH_VERT.c_str(), std::ios::binary);
+        std::ifstream depthFragFile(SHADOWS_SHADER_PATH_FRAG.c_str(), std::ios::binary);
+
+        std::vector<uint8> depthVertSpv(std::istreambuf_iterator<char>(depthVertFile), {});
+        std::vector<uint8> depthFragSpv(std::istreambuf_iterator<char>(depthFragFile), {});
+
+        RefCounted<Shader> depthShader = std::make_shared<Shader>(device);
+        depthShader->fromSources(ShaderLanguage::SPIRV, depthVertSpv, depthFragSpv);
+        depthShader->reflectData();
+        depthShader->generateUniformLayout(true);
 
         // Pipeline
         IRenderDevice::VertexBufferLayoutDesc vertexBufferLayoutDesc = {};
@@ -180,11 +214,20 @@ public:
         //pipeline->setPolygonMode(PolygonMode::Line);
         pipeline->createPipeline();
 
+        // Model matrices of the instanced draws (mat4 takes locations 5..8)
+        IRenderDevice::VertexBufferLayoutDesc instanceLayoutDesc = {};
+        instanceLayoutDesc.stride = sizeof(Mat4f);
+        instanceLayoutDesc.usage = VertexUsage::PerInstance;
+        for (uint32 i = 0; i < 4; i++) {
+            instanceLayoutDesc.attributes.push_back({5 + i, i * (uint32) sizeof(Vec4f), DataFormat::R32G32B32A32_SFLOAT});
+        }
+
         RefCounted<GraphicsPipeline> pbrPipeline = std::make_shared<GraphicsPipeline>(device);
         pbrPipeline->setTargetFormat(engine->getOffscreenTargetFormat());
         pbrPipeline->setShader(reflShader);
-        pbrPipeline->setVertexBuffersCount(1);
+        pbrPipeline->setVertexBuffersCount(2);
         pbrPipeline->setVertexBufferDesc(0, vertexBufferLayoutDesc);
+        pbrPipeline->setVertexBufferDesc(1, instanceLayoutDesc);
         pbrPipeline->setDepthTestEnable(true);
         pbrPipeline->setDepthWriteEnable(true);
         pbrPipeline->createPipeline();
@@ -196,6 +239,7 @@ public:
         // Material
         material = std::make_shared<Material>(device);
         material->setGraphicsPipeline(pbrPipeline);
+        material->setUniformRing(engine->getUniformRing());
         material->createMaterial();
 
         setMaterialTexture(TEXTURE_ALBEDO_PATH.c_str(), "texAlbedo", material, sampler);
@@ -210,6 +254,7 @@ public:
 
         whiteMaterial = std::make_shared<Material>(device);
         whiteMaterial->setGraphicsPipeline(pipeline);
+        whiteMaterial->setUniformRing(engine->getUniformRing());
         whiteMaterial->createMaterial();
         whiteMaterial->setTexture("texShadowMap", engine->getDefaultWhiteTexture());
         whiteMaterial->updateUniformData();
@@ -226,13 +271,51 @@ public:
         shadowsPipeline->setDepthTestEnable(true);
         shadowsPipeline->setDepthWriteEnable(true);
         shadowsPipeline->setDepthCompareOp(CompareOperation::LessOrEqual);
-        shadowsPipeline->setVertexBuffersCount(1);
+        shadowsPipeline->setVertexBuffersCount(2);
         shadowsPipeline->setVertexBufferDesc(0, vertShadowLayoutDesc);
+        shadowsPipeline->setVertexBufferDesc(1, instanceLayoutDesc);
         shadowsPipeline->createPipeline();
 
         shadowMaterial = std::make_shared<Material>(device);
         shadowMaterial->setGraphicsPipeline(shadowsPipeline);
+        shadowMaterial->setUniformRing(engine->getUniformRing());
         shadowMaterial->createMaterial();
+
+        RefCounted<GraphicsPipeline> shadowsPushPipeline = std::make_shared<GraphicsPipeline>(device);
+        shadowsPushPipeline->setTargetFormat(engine->getShadowTargetFormat());
+        shadowsPushPipeline->setShader(shadowPushShader);
+        shadowsPushPipeline->setPolygonCullMode(PolygonCullMode::Back);
+        shadowsPushPipeline->setDepthTestEnable(true);
+        shadowsPushPipeline->setDepthWriteEnable(true);
+        shadowsPushPipeline->setDepthCompareOp(CompareOperation::LessOrEqual);
+        shadowsPushPipeline->setVertexBuffersCount(1);
+        shadowsPushPipeline->setVertexBufferDesc(0, vertShadowLayoutDesc);
+        shadowsPushPipeline->createPipeline();
+
+        // Only depth is written in pre-pass
+        IRenderDevice::BlendAttachmentDesc noColorWrites = {};
+        noColorWrites.writeR = noColorWrites.writeG = noColorWrites.writeB = noColorWrites.writeA = false;
+
+        RefCounted<GraphicsPipeline> depthPipeline = std::make_shared<GraphicsPipeline>(device);
+        depthPipeline->setTargetFormat(engine->getOffscreenTargetFormat());
+        depthPipeline->setShader(depthShader);
+        depthPipeline->setBlendAttachment(0, noColorWrites);
+        depthPipeline->setDepthTestEnable(true);
+        depthPipeline->setDepthWriteEnable(true);
+        depthPipeline->setVertexBuffersCount(1);
+        depthPipeline->setVertexBufferDesc(0, vertShadowLayoutDesc);
+        depthPipeline->createPipeline();
+
+        depthMaterial = std::make_shared<Material>(device);
+        depthMaterial->setGraphicsPipeline(depthPipeline);
+        depthMaterial->setUniformRing(engine->getUniformRing());
+        depthMaterial->createMaterial();
+
+        // Plane model matrices are pushed with draw calls
+        planeShadowMaterial = std::make_shared<Material>(device);
+        planeShadowMaterial->setGraphicsPipeline(shadowsPushPipeline);
+        planeShadowMaterial->setUniformRing(engine->getUniformRing());
+        planeShadowMaterial->createMaterial();
     }
 
     void setMaterialTexture(const char *path, const char *name, RefCounted<Material> mt, RefCounted<Sampler> sampler) {
@@ -296,14 +379,16 @@ public:
         for (int32 x = -MESH_COUNT_X2; x <= MESH_COUNT_X2; x++) {
             for (int32 z = -MESH_COUNT_Z2; z <= MESH_COUNT_Z2; z++) {
                 RefCounted<RenderableMesh> mesh = std::make_shared<RenderableMesh>();
-                RefCounted<Material> mat = material->clone();
-                RefCounted<Material> shadowMat = shadowMaterial->clone();
+                RefCounted<Material> mat = std::make_shared<MaterialInstance>(material);
+                RefCounted<Material> shadowMat = std::make_shared<MaterialInstance>(shadowMaterial);
+                RefCounted<Material> depthMat = std::make_shared<MaterialInstance>(depthMaterial);
 
                 mesh->setRenderDevice(device);
                 mesh->setRenderMesh(data);
                 mesh->setRenderMaterial(mat);
                 mesh->setShadowRenderMesh(data);
                 mesh->setShadowRenderMaterial(shadowMat);
+                mesh->setDepthRenderMaterial(depthMat);
                 mesh->setCastShadows();
                 mesh->translate(Vec3f(x * MESH_STEP, 0.0f, z * MESH_STEP));
                 mesh->create();
@@ -329,8 +414,8 @@ public:
 
         MeshLoader planeMeshLoader(MESH_PLANE_PATH);
         RefCounted<Mesh> planeMeshData = planeMeshLoader.importMesh(Mesh::VertexFormat::PNTTB);
-        RefCounted<Material> mat = whiteMaterial->clone();
-        RefCounted<Material> shadowMat = shadowMaterial->clone();
+        RefCounted<Material> mat = std::make_shared<MaterialInstance>(whiteMaterial);
+        RefCounted<Material> shadowMat = std::make_shared<MaterialInstance>(planeShadowMaterial);
 
         RefCounted<RenderableMesh> planeMesh = std::make_shared<RenderableMesh>();
         planeMesh->setRenderDevice(device);
@@ -408,6 +493,11 @@ public:
     }
 
     void run() {
+        uint32 frames = 0;
+        uint32 reusedLists = 0;
+        uint32 recordedLists = 0;
+        uint32 framesWithoutReuse = 0;
+
         while (!glfwWindowShouldClose(window.handle)) {
             glfwPollEvents();
             glfwSwapBuffers(window.handle);
@@ -419,7 +509,18 @@ public:
             engine->addLine3d({0, 0, 0}, light->getUp(), {0, 1, 0, 1}, 2);
 
             engine->draw();
+
+            // With the default device frames in flight count lists of static objects must be reused after warm-up
+            auto& statistics = engine->getDrawListCacheStatistics();
+            reusedLists += statistics.reusedLists;
+            recordedLists += statistics.recordedLists;
+            frames += 1;
+
+            if (frames > IRenderDevice::MAX_FRAMES_IN_FLIGHT && statistics.reusedLists == 0)
+                framesWithoutReuse += 1;
         }
+
+        printf("Cached lists: reused %u recorded %u frames without reuse %u\n", reusedLists, recordedLists, framesWithoutReuse);
     }
 
     void shutdown() {
@@ -428,13 +529,15 @@ public:
 
 private:
     Window window;
-    RefCounted<IRenderEngine>  engine;
+    RefCounted<RenderEngine>   engine;
     RefCounted<IRenderDevice>  device;
     RefCounted<Camera>         camera;
     RefCounted<Light>          light;
     RefCounted<Material>       material;
     RefCounted<Material>       whiteMaterial;
     RefCounted<Material>       shadowMaterial;
+    RefCounted<Material>       planeShadowMaterial;
+    RefCounted<Material>       depthMaterial;
     RefCounted<Canvas>         canvas;
 
     std::vector<RefCounted<RenderableMesh>> meshes;
@@ -442,15 +545,18 @@ private:
 
     const uint32 SHADOW_MAP_SIZE = 4096;
 
-    const int32 MESH_COUNT_X2 = 0;
-    const int32 MESH_COUNT_Z2 = 0;
-    const int32 MESH_STEP     = 2;
+    const int32 MESH_COUNT_X2 = 1;
+    const int32 MESH_COUNT_Z2 = 1;
+    const int32 MESH_STEP     = 5;
 
-    String MODEL3D_SHADER_PATH_VERT = "shaders/spirv/shadowmapping/MeshShadowed.vert.spv";
+    String MODEL3D_PUSH_CONSTANTS_SHADER_PATH_VERT = "shaders/spirv/shadowmapping/MeshShadowedPushConstants.vert.spv";
     String MODEL3D_SHADER_PATH_FRAG = "shaders/spirv/shadowmapping/MeshShadowed.frag.spv";
+    String MODEL3D_INSTANCED_SHADER_PATH_VERT = "shaders/spirv/shadowmapping/MeshShadowedInstanced.vert.spv";
     String MODEL3D_REFL_SHADER_PATH_FRAG = "shaders/spirv/shadowmapping/MeshReflectiveShadowed.frag.spv";
-    String SHADOWS_SHADER_PATH_VERT = "shaders/spirv/shadowmapping/Shadows.vert.spv";
+    String SHADOWS_SHADER_PATH_VERT = "shaders/spirv/shadowmapping/ShadowsInstanced.vert.spv";
+    String SHADOWS_PUSH_CONSTANTS_SHADER_PATH_VERT = "shaders/spirv/shadowmapping/ShadowsPushConstants.vert.spv";
     String SHADOWS_SHADER_PATH_FRAG = "shaders/spirv/shadowmapping/Shadows.frag.spv";
+    String DEPTH_PREPASS_SHADER_PATH_VERT = "shaders/spirv/pbr/PBRDepthPrepass.vert.spv";
     String SHADERS_FOLDER_PATH = "shaders/spirv/";
 
     String MESH_PATH                = "assets/models/DamagedHelmet.obj";
@@ -0,0 +1,140 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTRENDERQUEUESORT_CPP
+#define IGNIMBRITE_TESTRENDERQUEUESORT_CPP
+
+#include <RenderQueueSorter.h>
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace ignimbrite;
+
+struct TestRenderQueueSort {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    static void createQueue(uint32 count, bool backToFront, std::vector<RenderQueueElement> &queue) {
+        std::mt19937 engine(count);
+        std::uniform_int_distribution<uint32> pipelines(1, 16);
+        std::uniform_int_distribution<uint32> sets(1, 1000);
+        std::uniform_real_distribution<float32> distance(0.0f, 500.0f);
+
+        queue.resize(count);
+        for (uint32 i = 0; i < count; i++) {
+            auto& e = queue[i];
+            e.viewDistance = distance(engine);
+            e.sortKey = RenderQueueElement::makeSortKey(0x20, pipelines(engine), sets(engine), e.viewDistance, backToFront);
+            // Remember initial position to check stability
+            e.object = reinterpret_cast<IRenderable*>((uintptr_t) (i + 1));
+        }
+    }
+
+    static void test1() {
+        // Radix sort must give the same order as stable comparison sort
+        uint32 counts[] = { 0, 1, 2, 10, 1000, 100000 };
+        RenderQueueSorter sorter;
+
+        for (auto count: counts) {
+            for (auto backToFront: { false, true }) {
+                std::vector<RenderQueueElement> queue;
+                createQueue(count, backToFront, queue);
+
+                auto expected = queue;
+                std::stable_sort(expected.begin(), expected.end(), [](const RenderQueueElement& a, const RenderQueueElement& b) {
+                    return a.sortKey < b.sortKey;
+                });
+
+                sorter.sort(queue);
+
+                uint32 errors = 0;
+                for (uint32 i = 0; i < count; i++) {
+                    errors += queue[i].object != expected[i].object;
+                }
+
+                // Check depth order for back-to-front (up to depth quantization)
+                uint32 orderErrors = 0;
+                for (uint32 i = 1; backToFront && i < count; i++) {
+                    orderErrors += queue[i - 1].viewDistance * 1.0001f < queue[i].viewDistance;
+                }
+
+                printf("Elements: %u back-to-front: %i errors: %u order errors: %u\n", count, backToFront, errors, orderErrors);
+            }
+        }
+    }
+
+    static void test3() {
+        // Uniform sets above 2^16 are not merged into the same material group in front-to-back order
+        const uint32 count = 1000;
+        RenderQueueSorter sorter;
+        std::vector<RenderQueueElement> queue(count);
+
+        for (uint32 i = 0; i < count; i++) {
+            auto set = 1 + (i % 2) * 65536;
+            queue[i].viewDistance = (float32) (count - i);
+            queue[i].sortKey = RenderQueueElement::makeSortKey(0x20, 1, set, queue[i].viewDistance, false);
+            queue[i].object = reinterpret_cast<IRenderable*>((uintptr_t) (set));
+        }
+
+        sorter.sort(queue);
+
+        // Elements of the same set must be adjacent and ordered front-to-back (up to depth quantization)
+        uint32 groups = 1;
+        uint32 orderErrors = 0;
+        for (uint32 i = 1; i < count; i++) {
+            if (queue[i].object != queue[i - 1].object)
+                groups += 1;
+            else
+                orderErrors += queue[i - 1].viewDistance > queue[i].viewDistance * 1.01f;
+        }
+
+        printf("Groups: %u (expected 2) order errors: %u\n", groups, orderErrors);
+    }
+
+    static void test2() {
+        // Benchmark against comparison sort
+        const uint32 count = 100000;
+        const uint32 iterations = 20;
+
+        std::vector<RenderQueueElement> source;
+        createQueue(count, false, source);
+
+        RenderQueueSorter sorter;
+        std::vector<RenderQueueElement> queue;
+
+        auto start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            queue = source;
+            std::sort(queue.begin(), queue.end(), [](const RenderQueueElement& a, const RenderQueueElement& b) {
+                return a.sortKey < b.sortKey;
+            });
+        }
+        auto comparison = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            queue = source;
+            sorter.sort(queue);
+        }
+        auto radix = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        printf("std::sort:  %.3f ms per %u elements\n", comparison / iterations, count);
+        printf("Radix sort: %.3f ms per %u elements\n", radix / iterations, count);
+    }
+
+};
+
+int32 main() {
+    TestRenderQueueSort::test1();
+    TestRenderQueueSort::test2();
+    TestRenderQueueSort::test3();
+}
+
+#endif //IGNIMBRITE_TESTRENDERQUEUESORT_CPP
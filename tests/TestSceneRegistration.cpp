@@ -0,0 +1,118 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTSCENEREGISTRATION_CPP
+#define IGNIMBRITE_TESTSCENEREGISTRATION_CPP
+
+#include <RenderEngine.h>
+#include "TestSceneUtils.h"
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace ignimbrite;
+
+struct TestSceneRegistration : TestSceneUtils {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    static std::vector<RefCounted<IRenderable>> createObjects(uint32 count) {
+        std::mt19937 engine(count);
+        std::uniform_real_distribution<float32> position(-1000.0f, 1000.0f);
+
+        std::vector<RefCounted<IRenderable>> objects(count);
+        for (uint32 i = 0; i < count; i++) {
+            auto box = std::make_shared<Box>();
+            Vec3f p(position(engine), position(engine), position(engine));
+            box->bounds = AABB(p - Vec3f(1.0f), p + Vec3f(1.0f));
+            box->setStatic(i % 2 == 0);
+            box->setLayerID(i % 3 == 0 ? (uint32) IRenderable::DefaultLayers::Background : (uint32) IRenderable::DefaultLayers::Solid);
+            objects[i] = box;
+        }
+
+        return objects;
+    }
+
+    static float64 since(Clock::time_point start) {
+        return std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+    }
+
+    static void test1() {
+        // Invalid usage is reported
+        RenderEngine engine;
+        auto objects = createObjects(2);
+        uint32 errors = 0;
+
+        engine.addRenderable(objects[0]);
+
+        try { engine.addRenderable(objects[0]); errors += 1; } catch (const std::runtime_error&) { }
+        try { engine.removeRenderable(objects[1]); errors += 1; } catch (const std::runtime_error&) { }
+
+        engine.removeRenderable(objects[0]);
+        try { engine.removeRenderable(objects[0]); errors += 1; } catch (const std::runtime_error&) { }
+
+        // Object could be added again after removal
+        engine.addRenderables(objects);
+        engine.removeRenderable(objects[1]);
+        engine.removeRenderable(objects[0]);
+
+        printf("Invalid usage errors: %u\n", errors);
+    }
+
+    static void test2() {
+        // Build and tear down large scene
+        const uint32 count = 200000;
+        auto objects = createObjects(count);
+
+        RenderEngine engine;
+
+        auto start = Clock::now();
+        engine.addRenderables(objects);
+        auto bulkAdd = since(start);
+
+        // Change layers of the objects
+        start = Clock::now();
+        for (uint32 i = 0; i < count; i += 2) {
+            objects[i]->setLayerID((uint32) IRenderable::DefaultLayers::Transparent);
+        }
+        auto layers = since(start);
+
+        // Remove in random order
+        auto order = objects;
+        std::shuffle(order.begin(), order.end(), std::mt19937(1));
+
+        start = Clock::now();
+        for (const auto& object: order) {
+            engine.removeRenderable(object);
+        }
+        auto remove = since(start);
+
+        RenderEngine other;
+
+        start = Clock::now();
+        for (const auto& object: objects) {
+            other.addRenderable(object);
+        }
+        auto add = since(start);
+
+        printf("Objects: %u\n", count);
+        printf("Bulk add:     %.3f ms\n", bulkAdd);
+        printf("Single add:   %.3f ms\n", add);
+        printf("Layer change: %.3f ms per %u objects\n", layers, count / 2);
+        printf("Remove:       %.3f ms\n", remove);
+    }
+
+};
+
+int32 main() {
+    TestSceneRegistration::test1();
+    TestSceneRegistration::test2();
+}
+
+#endif //IGNIMBRITE_TESTSCENEREGISTRATION_CPP
@@ -0,0 +1,57 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTSCENEUTILS_H
+#define IGNIMBRITE_TESTSCENEUTILS_H
+
+#include <IRenderable.h>
+#include <Frustum.h>
+#include <random>
+
+using namespace ignimbrite;
+
+/** Objects and views for the scene structures tests */
+struct TestSceneUtils {
+
+    /** Object with only bounds, does not require render device */
+    class Box : public IRenderable {
+    public:
+        void onAddToScene(const IRenderContext &/*context*/) override {}
+        void onRenderQueueEntered(float32 /*distFromViewPoint*/) override {}
+        void onRender(const IRenderContext &/*context*/) override {}
+        void onShadowRenderQueueEntered(float32 /*distFromViewPoint*/) override {}
+        void onShadowRender(const IRenderContext &/*context*/) override {}
+        Vec3f getWorldPosition() const override { return bounds.getCenter(); }
+        AABB getWorldBoundingBox() const override { return bounds; }
+        Material *getRenderMaterial() override { return nullptr; }
+        Material *getShadowRenderMaterial() override { return nullptr; }
+
+        AABB bounds;
+    };
+
+    static Frustum createFrustum(const glm::vec3 &position, const glm::vec3 &forward) {
+        Frustum frustum;
+        frustum.setViewProperties(forward, glm::vec3(0, 1, 0));
+        frustum.setPosition(position);
+        frustum.createPerspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+        return frustum;
+    }
+
+    static AABB randomBox(std::mt19937 &engine, float32 range, float32 maxSize = 4.0f) {
+        std::uniform_real_distribution<float32> position(-range, range);
+        std::uniform_real_distribution<float32> size(0.1f, maxSize);
+
+        glm::vec3 p(position(engine), position(engine), position(engine));
+        glm::vec3 e(size(engine), size(engine), size(engine));
+        return AABB(p - e, p + e);
+    }
+
+};
+
+#endif //IGNIMBRITE_TESTSCENEUTILS_H
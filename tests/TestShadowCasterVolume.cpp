@@ -0,0 +1,108 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTSHADOWCASTERVOLUME_CPP
+#define IGNIMBRITE_TESTSHADOWCASTERVOLUME_CPP
+
+#include <ShadowCasterVolume.h>
+#include <random>
+#include <iostream>
+
+using namespace ignimbrite;
+
+struct TestShadowCasterVolume {
+
+    static Frustum createFrustum() {
+        Frustum frustum;
+        frustum.setViewProperties(glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+        frustum.setPosition(glm::vec3(0, 2, 0));
+        frustum.createPerspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        frustum.cutFrustum(0.1f);
+        return frustum;
+    }
+
+    static void test1() {
+        // Simple cases for light from above
+        Frustum frustum = createFrustum();
+        Vec3f direction = glm::normalize(Vec3f(0.2f, -1.0f, 0.1f));
+
+        ShadowCasterVolume volume;
+        volume.build(frustum, direction);
+
+        struct Case { AABB box; bool expected; };
+        Case cases[] = {
+            { AABB(Vec3f(-1, 1, -6), Vec3f(1, 3, -4)), true },      // Inside frustum
+            { AABB(Vec3f(-3, 30, -8), Vec3f(-1, 32, -6)), true },   // High above, shadow falls into frustum
+            { AABB(Vec3f(-1, -20, -6), Vec3f(1, -18, -4)), false }, // Below the frustum
+            { AABB(Vec3f(-1, 1, 20), Vec3f(1, 3, 22)), false },     // Behind the camera
+            { AABB(Vec3f(60, 1, -6), Vec3f(62, 3, -4)), false },    // Far to the right
+        };
+
+        uint32 errors = 0;
+        for (const auto& c: cases) {
+            errors += volume.canCastShadow(c.box) != c.expected;
+        }
+
+        printf("Planes: %u errors: %u\n", volume.getPlanesCount(), errors);
+    }
+
+    static void test2() {
+        // Volume is conservative: boxes, which points shadows fall into frustum, are never rejected
+        std::mt19937 engine(1);
+        std::uniform_real_distribution<float32> position(-40.0f, 40.0f);
+        std::uniform_real_distribution<float32> size(0.1f, 2.0f);
+        std::uniform_real_distribution<float32> axis(-1.0f, 1.0f);
+
+        Frustum frustum = createFrustum();
+
+        uint32 errors = 0;
+        uint32 acceptedCount = 0;
+        uint32 rejected = 0;
+
+        for (uint32 light = 0; light < 10; light++) {
+            auto direction = glm::normalize(Vec3f(axis(engine), -1.0f, axis(engine)));
+
+            ShadowCasterVolume volume;
+            volume.build(frustum, direction);
+
+            for (uint32 i = 0; i < 1000; i++) {
+                Vec3f p(position(engine), position(engine), position(engine));
+                Vec3f e(size(engine), size(engine), size(engine));
+
+                bool accepted = volume.canCastShadow(AABB(p - e, p + e));
+
+                // Points of the box are swept along the light direction (point tests are exact)
+                bool reachesFrustum = false;
+                for (uint32 k = 0; k < 27 && !accepted && !reachesFrustum; k++) {
+                    Vec3f offset((float32) (k % 3) - 1.0f, (float32) ((k / 3) % 3) - 1.0f, (float32) (k / 9) - 1.0f);
+                    auto point = p + e * offset;
+
+                    for (float32 t = 0.0f; t < 100.0f && !reachesFrustum; t += 0.1f) {
+                        auto q = point + direction * t;
+                        reachesFrustum = frustum.isInside(AABB(q, q));
+                    }
+                }
+
+                acceptedCount += accepted ? 1 : 0;
+                rejected += accepted ? 0 : 1;
+                errors += reachesFrustum && !accepted;
+            }
+        }
+
+        printf("Boxes: %u accepted: %u rejected: %u errors: %u\n", 10 * 1000, acceptedCount, rejected, errors);
+    }
+
+};
+
+int32 main() {
+    TestShadowCasterVolume::test1();
+    TestShadowCasterVolume::test2();
+}
+
+#endif //IGNIMBRITE_TESTSHADOWCASTERVOLUME_CPP
@@ -0,0 +1,213 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTSPATIALINDEX_CPP
+#define IGNIMBRITE_TESTSPATIALINDEX_CPP
+
+#include <SpatialIndex.h>
+#include "TestSceneUtils.h"
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace ignimbrite;
+
+struct TestSpatialIndex : TestSceneUtils {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    /** Compare query result with brute force frustum test */
+    static uint32 compare(SpatialIndex &index, const std::vector<AABB> &boxes, const std::vector<bool> &present, const Frustum &frustum) {
+        std::vector<uint32> result;
+        index.query(frustum, result);
+        std::sort(result.begin(), result.end());
+
+        std::vector<uint32> expected;
+        for (uint32 id = 0; id < boxes.size(); id++) {
+            if (present[id] && frustum.isInside(boxes[id]))
+                expected.push_back(id);
+        }
+
+        return result == expected ? 0 : 1;
+    }
+
+    static void test1() {
+        // Static and dynamic objects, movement, removal
+        const uint32 count = 20000;
+        std::mt19937 engine(1);
+
+        SpatialIndex index;
+        std::vector<AABB> boxes(count);
+        std::vector<bool> present(count, true);
+
+        for (uint32 id = 0; id < count; id++) {
+            // Every 10th object is large
+            boxes[id] = randomBox(engine, 500.0f, id % 10 == 0 ? 40.0f : 4.0f);
+            index.add(id, boxes[id], id % 2 == 0);
+        }
+
+        Frustum views[] = {
+            createFrustum(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1)),
+            createFrustum(glm::vec3(100, 20, 50), glm::vec3(1, -0.2f, 0.3f)),
+            createFrustum(glm::vec3(-300, 0, 400), glm::vec3(0.5f, 0, -1))
+        };
+
+        uint32 errors = 0;
+
+        for (const auto& view: views)
+            errors += compare(index, boxes, present, view);
+
+        printf("Initial errors: %u\n", errors);
+
+        // Move objects (refit of static and re-insertion of dynamic)
+        std::uniform_real_distribution<float32> offset(-30.0f, 30.0f);
+        for (uint32 id = 0; id < count; id += 3) {
+            glm::vec3 delta(offset(engine), offset(engine), offset(engine));
+            boxes[id] = AABB(boxes[id].getMinBounds() + delta, boxes[id].getMaxBounds() + delta);
+            index.update(id, boxes[id]);
+        }
+
+        errors = 0;
+        for (const auto& view: views)
+            errors += compare(index, boxes, present, view);
+
+        printf("After move errors: %u\n", errors);
+
+        // Remove and change static state
+        for (uint32 id = 0; id < count; id += 7) {
+            index.remove(id);
+            present[id] = false;
+        }
+        for (uint32 id = 1; id < count; id += 11) {
+            if (present[id])
+                index.setStatic(id, true);
+        }
+
+        errors = 0;
+        for (const auto& view: views)
+            errors += compare(index, boxes, present, view);
+
+        printf("After remove errors: %u\n", errors);
+    }
+
+    static void test2() {
+        // Benchmark query against linear scan
+        const uint32 count = 200000;
+        const uint32 iterations = 20;
+        std::mt19937 engine(2);
+
+        SpatialIndex index;
+        std::vector<AABB> boxes(count);
+
+        for (uint32 id = 0; id < count; id++) {
+            boxes[id] = randomBox(engine, 2000.0f, 4.0f);
+            index.add(id, boxes[id], id % 4 != 0);
+        }
+
+        Frustum frustum = createFrustum(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1));
+        std::vector<uint32> result;
+        index.query(frustum, result);
+
+        auto start = Clock::now();
+        uint64 visibleLinear = 0;
+        for (uint32 k = 0; k < iterations; k++) {
+            for (const auto& box: boxes)
+                visibleLinear += frustum.isInside(box) ? 1 : 0;
+        }
+        auto linear = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        start = Clock::now();
+        uint64 visibleIndex = 0;
+        for (uint32 k = 0; k < iterations; k++) {
+            result.clear();
+            index.query(frustum, result);
+            visibleIndex += result.size();
+        }
+        auto indexed = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        printf("Linear: %.3f ms (visible %llu)\n", linear / iterations, (unsigned long long) visibleLinear / iterations);
+        printf("Index:  %.3f ms (visible %llu)\n", indexed / iterations, (unsigned long long) visibleIndex / iterations);
+    }
+
+    static void test3() {
+        // Multi-view query gives the same results as separate queries
+        const uint32 count = 50000;
+        std::mt19937 engine(3);
+
+        SpatialIndex index;
+        for (uint32 id = 0; id < count; id++) {
+            index.add(id, randomBox(engine, 500.0f, id % 10 == 0 ? 40.0f : 4.0f), id % 2 == 0);
+        }
+
+        std::vector<Frustum> views = {
+            createFrustum(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1)),
+            createFrustum(glm::vec3(0, 0, 0), glm::vec3(0, 0, 1)),
+            createFrustum(glm::vec3(100, 20, 50), glm::vec3(1, -0.2f, 0.3f)),
+            createFrustum(glm::vec3(-300, 0, 400), glm::vec3(0.5f, 0, -1))
+        };
+
+        std::vector<uint32> ids, masks;
+        index.query(views.data(), (uint32) views.size(), ids, masks);
+
+        uint32 errors = 0;
+        for (uint32 view = 0; view < views.size(); view++) {
+            std::vector<uint32> expected;
+            index.query(views[view], expected);
+            std::sort(expected.begin(), expected.end());
+
+            std::vector<uint32> result;
+            for (uint32 i = 0; i < ids.size(); i++) {
+                if (masks[i] & (1u << view))
+                    result.push_back(ids[i]);
+            }
+            std::sort(result.begin(), result.end());
+
+            errors += result == expected ? 0 : 1;
+        }
+
+        // Each object is reported once
+        auto unique = ids;
+        std::sort(unique.begin(), unique.end());
+        errors += std::unique(unique.begin(), unique.end()) == unique.end() ? 0 : 1;
+
+        printf("Multi-view errors: %u\n", errors);
+
+        // Benchmark: separate queries against single multi-view query
+        const uint32 iterations = 20;
+
+        auto start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            for (const auto& view: views) {
+                ids.clear();
+                index.query(view, ids);
+            }
+        }
+        auto separate = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            ids.clear();
+            masks.clear();
+            index.query(views.data(), (uint32) views.size(), ids, masks);
+        }
+        auto multiple = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        printf("Separate queries:  %.3f ms per %u views\n", separate / iterations, (uint32) views.size());
+        printf("Multi-view query:  %.3f ms per %u views\n", multiple / iterations, (uint32) views.size());
+    }
+
+};
+
+int32 main() {
+    TestSpatialIndex::test1();
+    TestSpatialIndex::test2();
+    TestSpatialIndex::test3();
+}
+
+#endif //IGNIMBRITE_TESTSPATIALINDEX_CPP
@@ -0,0 +1,237 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTSTATICBATCH_CPP
+#define IGNIMBRITE_TESTSTATICBATCH_CPP
+
+#include <StaticBatch.h>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <iostream>
+
+using namespace ignimbrite;
+
+struct TestStaticBatch {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    static RefCounted<Mesh> createBox(Mesh::VertexFormat format) {
+        // Box with per-corner normals, 8 vertices and 12 triangles
+        auto mesh = std::make_shared<Mesh>(format, 8, 36);
+        auto stride = mesh->getStride();
+        std::vector<uint8> data(stride * 8, 0);
+
+        for (uint32 i = 0; i < 8; i++) {
+            Vec3f p((i & 1u) ? 0.5f : -0.5f, (i & 2u) ? 0.5f : -0.5f, (i & 4u) ? 0.5f : -0.5f);
+            Vec3f n = glm::normalize(p);
+            std::memcpy(data.data() + i * stride, &p, sizeof(Vec3f));
+            if ((uint32) format & Mesh::Norm3f)
+                std::memcpy(data.data() + i * stride + sizeof(Vec3f), &n, sizeof(Vec3f));
+        }
+
+        uint32 indices[36] = {
+            0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5,
+            0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6,
+            0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3
+        };
+
+        mesh->updateVertexData(0, 8, data.data());
+        mesh->updateIndexData(0, 36, indices);
+        mesh->updateBoundingVolume();
+
+        return mesh;
+    }
+
+    static std::vector<RefCounted<RenderableMesh>> createObjects(uint32 count, const RefCounted<Mesh> &mesh,
+                                                                 const RefCounted<Material> &material) {
+        std::mt19937 engine(count);
+        std::uniform_real_distribution<float32> position(-100.0f, 100.0f);
+        std::uniform_real_distribution<float32> scale(0.5f, 3.0f);
+        std::uniform_real_distribution<float32> angle(0.0f, 6.0f);
+
+        std::vector<RefCounted<RenderableMesh>> objects(count);
+
+        for (auto& object: objects) {
+            object = std::make_shared<RenderableMesh>();
+            object->setRenderMesh(mesh, true);
+            object->setRenderMaterial(material, true);
+            object->translate(Vec3f(position(engine), position(engine) * 0.1f, position(engine)));
+            object->rotate(glm::normalize(Vec3f(1.0f, 2.0f, 3.0f)), angle(engine));
+            object->setScale(Vec3f(scale(engine), scale(engine), scale(engine)));
+            object->setStatic(true);
+            object->setVisible(true);
+        }
+
+        return objects;
+    }
+
+    static void test1() {
+        // Merged geometry must be equal to the transformed geometry of the objects
+        auto mesh = createBox(Mesh::VertexFormat::PN);
+        auto material = std::make_shared<Material>(nullptr);
+        auto objects = createObjects(2000, mesh, material);
+
+        StaticBatch batch(nullptr);
+        batch.setClusterSize(20.0f);
+        batch.setMaxClusterVertices(8 * 32);
+        batch.build(objects);
+
+        uint32 errors = 0;
+        std::vector<uint32> used(objects.size(), 0);
+
+        for (const auto& cluster: batch.getClusters()) {
+            const auto& merged = *cluster.mesh;
+            auto stride = merged.getStride();
+
+            errors += cluster.shadowMesh != cluster.mesh;
+            errors += merged.getVertexCount() > batch.getMaxClusterVertices();
+            errors += merged.getVertexCount() != cluster.objects.size() * mesh->getVertexCount();
+
+            auto cell = glm::floor(objects[cluster.objects.front()]->getWorldPosition() / batch.getClusterSize());
+
+            for (uint32 k = 0; k < cluster.objects.size(); k++) {
+                const auto& object = objects[cluster.objects[k]];
+                auto model = object->getInstanceTransform();
+                used[cluster.objects[k]] += 1;
+
+                errors += glm::floor(object->getWorldPosition() / batch.getClusterSize()) != cell;
+
+                for (uint32 v = 0; v < mesh->getVertexCount(); v++) {
+                    Vec3f source, result, normal;
+                    std::memcpy(&source, mesh->getVertexData() + v * stride, sizeof(Vec3f));
+                    std::memcpy(&result, merged.getVertexData() + (k * 8 + v) * stride, sizeof(Vec3f));
+                    std::memcpy(&normal, merged.getVertexData() + (k * 8 + v) * stride + sizeof(Vec3f), sizeof(Vec3f));
+
+                    errors += glm::distance(Vec3f(model * Vec4f(source, 1.0f)), result) > 1e-4f;
+                    errors += glm::abs(glm::length(normal) - 1.0f) > 1e-4f;
+                    errors += !merged.getBoundingBox().contains(result);
+                }
+
+                for (uint32 i = 0; i < mesh->getIndicesCount(); i++) {
+                    errors += merged.getIndexData()[k * 36 + i] != mesh->getIndexData()[i] + k * 8;
+                }
+            }
+        }
+
+        for (auto count: used) {
+            errors += count != 1;
+        }
+
+        printf("Objects: %u clusters: %u errors: %u\n", (uint32) objects.size(), (uint32) batch.getClusters().size(), errors);
+    }
+
+    static void test2() {
+        // Invalid objects must be rejected
+        auto mesh = createBox(Mesh::VertexFormat::PN);
+        auto otherMesh = createBox(Mesh::VertexFormat::P);
+        auto material = std::make_shared<Material>(nullptr);
+
+        uint32 errors = 0;
+        StaticBatch batch(nullptr);
+
+        auto expectThrow = [&](const std::vector<RefCounted<RenderableMesh>> &objects) {
+            try {
+                batch.build(objects);
+                errors += 1;
+            } catch (const std::runtime_error&) {
+                // Ok
+            }
+        };
+
+        auto objects = createObjects(10, mesh, material);
+        objects[5]->setStatic(false);
+        expectThrow(objects);
+
+        objects = createObjects(10, mesh, material);
+        objects[3]->setRenderMesh(otherMesh, true);
+        expectThrow(objects);
+
+        objects = createObjects(10, mesh, material);
+        objects[7]->setLayerID((uint32) IRenderable::DefaultLayers::Transparent);
+        expectThrow(objects);
+
+        objects = createObjects(10, mesh, material);
+        batch.build(objects);
+        errors += batch.getClusters().empty();
+
+        batch.clear();
+        errors += !batch.getClusters().empty() || !batch.getObjects().empty();
+
+        printf("Invalid usage errors: %u\n", errors);
+    }
+
+    static void test4() {
+        // Mirrored objects keep front faces: triangles are oriented as in the source mesh
+        auto mesh = createBox(Mesh::VertexFormat::PN);
+        auto material = std::make_shared<Material>(nullptr);
+        auto objects = createObjects(100, mesh, material);
+
+        for (uint32 i = 0; i < objects.size(); i += 2) {
+            objects[i]->setScale(Vec3f(-1.5f, 1.0f, 2.0f));
+        }
+
+        StaticBatch batch(nullptr);
+        batch.build(objects);
+
+        auto orientation = [](const Mesh &m, uint32 first, const Vec3f &center) {
+            auto stride = m.getStride();
+            Vec3f p[3];
+            for (uint32 j = 0; j < 3; j++) {
+                std::memcpy(&p[j], m.getVertexData() + m.getIndexData()[first + j] * stride, sizeof(Vec3f));
+            }
+            auto normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            return glm::dot(normal, (p[0] + p[1] + p[2]) / 3.0f - center) > 0.0f;
+        };
+
+        uint32 errors = 0;
+        uint32 mirrored = 0;
+
+        for (const auto& cluster: batch.getClusters()) {
+            const auto& merged = *cluster.mesh;
+
+            for (uint32 k = 0; k < cluster.objects.size(); k++) {
+                const auto& object = objects[cluster.objects[k]];
+                auto center = Vec3f(object->getInstanceTransform() * Vec4f(0.0f, 0.0f, 0.0f, 1.0f));
+                mirrored += glm::determinant(glm::mat3(object->getInstanceTransform())) < 0.0f;
+
+                for (uint32 i = 0; i < mesh->getIndicesCount(); i += 3) {
+                    errors += orientation(merged, k * 36 + i, center) != orientation(*mesh, i, Vec3f(0.0f));
+                }
+            }
+        }
+
+        printf("Mirrored objects: %u winding errors: %u\n", mirrored, errors);
+    }
+
+    static void test3() {
+        // Build time of the large batch
+        auto mesh = createBox(Mesh::VertexFormat::PN);
+        auto material = std::make_shared<Material>(nullptr);
+        auto objects = createObjects(50000, mesh, material);
+
+        StaticBatch batch(nullptr);
+
+        auto start = Clock::now();
+        batch.build(objects);
+        auto time = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        printf("Build: %.3f ms for %u objects into %u clusters\n", time, (uint32) objects.size(), (uint32) batch.getClusters().size());
+    }
+
+};
+
+int32 main() {
+    TestStaticBatch::test1();
+    TestStaticBatch::test2();
+    TestStaticBatch::test3();
+    TestStaticBatch::test4();
+}
+
+#endif //IGNIMBRITE_TESTSTATICBATCH_CPP
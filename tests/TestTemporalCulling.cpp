@@ -0,0 +1,178 @@
+/**********************************************************************************/
+/* This file is part of Ignimbrite project                                        */
+/* https://github.com/EgorOrachyov/Ignimbrite                                     */
+/**********************************************************************************/
+/* Licensed under MIT License                                                     */
+/* Copyright (c) 2019, 2020  Egor Orachyov                                        */
+/* Copyright (c) 2019, 2020  Sultim Tsyrendashiev                                 */
+/**********************************************************************************/
+
+#ifndef IGNIMBRITE_TESTTEMPORALCULLING_CPP
+#define IGNIMBRITE_TESTTEMPORALCULLING_CPP
+
+#include <TemporalCullingCache.h>
+#include "TestSceneUtils.h"
+#include <chrono>
+#include <random>
+#include <iostream>
+
+using namespace ignimbrite;
+
+struct TestTemporalCulling : TestSceneUtils {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    /** Compare cached results with brute force frustum test */
+    static uint32 compare(const TemporalCullingCache &cache, const RenderableRegistry &registry, const Frustum &frustum) {
+        auto result = cache.getVisible();
+        std::sort(result.begin(), result.end());
+
+        std::vector<uint32> expected;
+        for (uint32 id = 0; id < registry.getCapacity(); id++) {
+            if (registry.contains(id) && frustum.isInside(registry.getBounds(id)))
+                expected.push_back(id);
+        }
+
+        return result == expected ? 0 : 1;
+    }
+
+    static void fullTest(TemporalCullingCache &cache, const RenderableRegistry &registry, const Frustum &frustum) {
+        std::vector<uint32> visible;
+        for (uint32 id = 0; id < registry.getCapacity(); id++) {
+            if (registry.contains(id) && frustum.isInside(registry.getBounds(id)))
+                visible.push_back(id);
+        }
+
+        cache.reset(frustum, visible, registry.getCapacity());
+    }
+
+    static void test1() {
+        // Moved, removed and added objects with static camera
+        const uint32 count = 10000;
+        const uint32 frames = 20;
+        const uint32 changesPerFrame = 100;
+
+        std::mt19937 engine(1);
+        std::uniform_int_distribution<uint32> index(0, count - 1);
+
+        std::vector<Box> boxes(count);
+        RenderableRegistry registry;
+        std::vector<uint32> ids(count);
+
+        for (uint32 i = 0; i < count; i++) {
+            boxes[i].bounds = randomBox(engine, 200.0f);
+            ids[i] = registry.add(&boxes[i]);
+        }
+
+        Frustum frustum = createFrustum(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1));
+        TemporalCullingCache cache;
+        fullTest(cache, registry, frustum);
+
+        uint32 errors = compare(cache, registry, frustum);
+        uint32 retested = 0;
+
+        for (uint32 frame = 0; frame < frames; frame++) {
+            std::vector<uint32> changed;
+
+            for (uint32 k = 0; k < changesPerFrame; k++) {
+                auto i = index(engine);
+                auto id = ids[i];
+
+                if (k % 10 == 0) {
+                    // Re-add object, id will be reused
+                    registry.remove(id);
+                    changed.push_back(id);
+                    ids[i] = registry.add(&boxes[i]);
+                    changed.push_back(ids[i]);
+                } else {
+                    boxes[i].bounds = randomBox(engine, 200.0f);
+                    registry.update(id, IRenderableListener::Bounds);
+                    changed.push_back(id);
+                }
+            }
+
+            if (!cache.canReuse(frustum, 0.0f))
+                errors += 1;
+
+            cache.update(frustum, changed, registry);
+            retested += (uint32) changed.size();
+            errors += compare(cache, registry, frustum);
+        }
+
+        printf("Objects: %u frames: %u retested: %u skipped: %u errors: %u\n",
+               count, frames, retested, count * frames - retested, errors);
+    }
+
+    static void test2() {
+        // Camera movement threshold
+        Frustum frustum = createFrustum(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1));
+        Frustum moved = createFrustum(glm::vec3(0.5f, 0, 0), glm::vec3(0, 0, -1));
+        Frustum rotated = createFrustum(glm::vec3(0, 0, 0), glm::vec3(0.1f, 0, -1));
+
+        RenderableRegistry registry;
+        TemporalCullingCache cache;
+
+        uint32 errors = 0;
+        errors += cache.canReuse(frustum, 1.0f) ? 1 : 0;
+
+        fullTest(cache, registry, frustum);
+        errors += cache.canReuse(frustum, 0.0f) ? 0 : 1;
+        errors += cache.canReuse(moved, 1.0f) ? 0 : 1;
+        errors += cache.canReuse(moved, 0.1f) ? 1 : 0;
+        // Far vertices move a lot even for small rotation
+        errors += cache.canReuse(rotated, 1.0f) ? 1 : 0;
+
+        cache.invalidate();
+        errors += cache.canReuse(frustum, 1.0f) ? 1 : 0;
+
+        printf("Threshold checks errors: %u\n", errors);
+    }
+
+    static void test3() {
+        // Benchmark: full test against retest of changed objects only
+        const uint32 count = 200000;
+        const uint32 changesCount = 1000;
+        const uint32 iterations = 20;
+
+        std::mt19937 engine(2);
+        std::vector<Box> boxes(count);
+        RenderableRegistry registry;
+
+        for (uint32 i = 0; i < count; i++) {
+            boxes[i].bounds = randomBox(engine, 1000.0f);
+            registry.add(&boxes[i]);
+        }
+
+        std::vector<uint32> changed;
+        for (uint32 i = 0; i < changesCount; i++) {
+            changed.push_back(i * (count / changesCount));
+        }
+
+        Frustum frustum = createFrustum(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1));
+        TemporalCullingCache cache;
+
+        auto start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            fullTest(cache, registry, frustum);
+        }
+        auto full = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        start = Clock::now();
+        for (uint32 k = 0; k < iterations; k++) {
+            cache.update(frustum, changed, registry);
+        }
+        auto temporal = std::chrono::duration<float64, std::milli>(Clock::now() - start).count();
+
+        printf("Full test:     %.3f ms per %u objects\n", full / iterations, count);
+        printf("Changed only:  %.3f ms per %u changed objects\n", temporal / iterations, changesCount);
+    }
+
+};
+
+int32 main() {
+    TestTemporalCulling::test1();
+    TestTemporalCulling::test2();
+    TestTemporalCulling::test3();
+}
+
+#endif //IGNIMBRITE_TESTTEMPORALCULLING_CPP
@@ -7,7 +7,6 @@
 #include <UniformBuffer.h>
 #include <MeshLoader.h>
 #include <GraphicsPipeline.h>
-#include <PipelineContext.h>
 #include <Material.h>
 
 #define GLM_FORCE_RADIANS
@@ -90,7 +89,6 @@ public:
 
             pDevice->drawListBegin(); {
                 pDevice->drawListBindSurface(surface, clearColor, area);
-                PipelineContext::cacheSurfaceBinding(surface);
 
                 matData.material->bindGraphicsPipeline();
                 matData.material->bindUniformData();